@@ -0,0 +1,300 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+#ifndef ASYNC_QUEUE_HPP_
+#define ASYNC_QUEUE_HPP_
+
+#if __cplusplus < 202002L
+#error "async_queue.hpp requires C++20 coroutines (compile with -std=c++20)"
+#endif
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <functional>
+#include <exception>
+#include <coroutine>
+#include "ics_exceptions.hpp"
+#include "linked_queue.hpp"
+
+
+namespace ics {
+
+
+//A thread-safe FIFO queue whose dequeue is awaited instead of blocking:
+//    T value = co_await q.dequeue();
+//If q has a value the coroutine continues at once; otherwise it is suspended (its thread is
+//  free to run other coroutines) until some enqueue hands it a value. So thousands of
+//  consumers can wait on a handful of threads: a waiting consumer costs only its frame.
+//Waiters are served in FIFO order, and a value goes straight to the oldest waiter (it never
+//  enters the value queue). The waiter list is intrusive: each awaiter lives in its suspended
+//  coroutine's frame, so waiting allocates nothing.
+//A resumed consumer runs on the enqueuing thread (after the queue's lock is released), unless
+//  a scheduler is given: then enqueue calls scheduler(handle) instead (e.g., to submit
+//  [h]{h.resume();} to a WorkStealingPool).
+//close() resumes every waiter with an EmptyError (thrown from co_await); later dequeues of a
+//  closed, empty queue throw EmptyError too. Values already queued can still be dequeued, but
+//  enqueueing into a closed queue throws IcsError. Destroying the queue closes it first, so no
+//  waiter is left suspended forever; a consumer resumed that way must not touch the queue again.
+template<class T, class Alloc = std::allocator<T>> class AsyncQueue {
+  public:
+    typedef std::function<void(std::coroutine_handle<>)> Scheduler;
+
+    class Awaiter;
+
+    //Destructor/Constructors
+    ~AsyncQueue();             //close()s: any waiters are resumed with EmptyError
+    explicit AsyncQueue (const Scheduler& scheduler = Scheduler(), const Alloc& alloc = Alloc());
+    AsyncQueue(const AsyncQueue<T,Alloc>& to_copy)                      = delete;
+    AsyncQueue<T,Alloc>& operator = (const AsyncQueue<T,Alloc>& rhs)    = delete;
+
+
+    //Queries (a snapshot: other threads may change the queue at any time)
+    bool empty   () const;
+    int  size    () const;     //Values queued
+    int  waiting () const;     //Consumers suspended in dequeue
+    bool closed  () const;
+    std::string str () const;  //supplies useful debugging information
+
+
+    //Commands
+    int     enqueue     (const T& element);  //Throws IcsError if closed
+    Awaiter dequeue     ();                  //co_await it
+    bool    try_dequeue (T& element);        //Never suspends: false if no value is queued
+    void    close       ();
+
+
+    class Awaiter {
+      public:
+        bool await_ready   ();
+        bool await_suspend (std::coroutine_handle<> h);
+        T    await_resume  ();
+
+      private:
+        friend class AsyncQueue<T,Alloc>;
+        Awaiter(AsyncQueue<T,Alloc>* q) : queue(q) {}
+
+        AsyncQueue<T,Alloc>*     queue;
+        std::coroutine_handle<>  handle;
+        std::optional<T>         value;            //Set by the enqueue that resumes this waiter
+        Awaiter*                 next = nullptr;   //In queue's waiter list
+    };
+
+
+  private:
+    mutable std::mutex    lock;
+    LinkedQueue<T,Alloc>  values;
+    Awaiter*              waiters_front = nullptr;
+    Awaiter*              waiters_rear  = nullptr;
+    int                   waiter_count  = 0;
+    bool                  is_closed     = false;
+    Scheduler             scheduler;
+
+    //Helper methods
+    void resume (Awaiter* w);              //Call without holding lock
+};
+
+
+//The simplest coroutine return type: starts running at once and destroys its own frame
+//  when it finishes. Handy for consumer loops (an exception escaping it terminates).
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask        get_return_object   () {return DetachedTask();}
+    std::suspend_never  initial_suspend     () noexcept {return {};}
+    std::suspend_never  final_suspend       () noexcept {return {};}
+    void                return_void         () {}
+    void                unhandled_exception () {std::terminate();}
+  };
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//AsyncQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, class Alloc>
+AsyncQueue<T,Alloc>::~AsyncQueue() {
+  close();
+}
+
+
+template<class T, class Alloc>
+AsyncQueue<T,Alloc>::AsyncQueue(const Scheduler& scheduler, const Alloc& alloc)
+: values(alloc), scheduler(scheduler)
+{}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, class Alloc>
+bool AsyncQueue<T,Alloc>::empty() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return values.empty();
+}
+
+
+template<class T, class Alloc>
+int AsyncQueue<T,Alloc>::size() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return values.size();
+}
+
+
+template<class T, class Alloc>
+int AsyncQueue<T,Alloc>::waiting() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return waiter_count;
+}
+
+
+template<class T, class Alloc>
+bool AsyncQueue<T,Alloc>::closed() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return is_closed;
+}
+
+
+template<class T, class Alloc>
+std::string AsyncQueue<T,Alloc>::str() const {
+  std::lock_guard<std::mutex> guard(lock);
+  std::ostringstream answer;
+  answer << "AsyncQueue" << values.str() << "(waiting=" << waiter_count << (is_closed ? ",closed" : "") << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, class Alloc>
+int AsyncQueue<T,Alloc>::enqueue(const T& element) {
+  Awaiter* w;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (is_closed)
+      throw IcsError("AsyncQueue::enqueue: queue is closed");
+    w = waiters_front;
+    if (w == nullptr)
+      return values.enqueue(element);
+
+    //Hand the value straight to the oldest waiter
+    waiters_front = w->next;
+    if (waiters_front == nullptr)
+      waiters_rear = nullptr;
+    --waiter_count;
+    w->value.emplace(element);
+  }
+  resume(w);
+  return 1;
+}
+
+
+template<class T, class Alloc>
+auto AsyncQueue<T,Alloc>::dequeue() -> Awaiter {
+  return Awaiter(this);
+}
+
+
+template<class T, class Alloc>
+bool AsyncQueue<T,Alloc>::try_dequeue(T& element) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (values.empty())
+    return false;
+  element = values.dequeue();
+  return true;
+}
+
+
+template<class T, class Alloc>
+void AsyncQueue<T,Alloc>::close() {
+  Awaiter* w;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    is_closed = true;
+    w = waiters_front;
+    waiters_front = waiters_rear = nullptr;
+    waiter_count = 0;
+  }
+  //Each resumed waiter (with no value) throws EmptyError; read next first, since resuming
+  //  may destroy w's coroutine frame (and w with it)
+  while (w != nullptr) {
+    Awaiter* next = w->next;
+    resume(w);
+    w = next;
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, class Alloc>
+void AsyncQueue<T,Alloc>::resume(Awaiter* w) {
+  if (scheduler)
+    scheduler(w->handle);
+  else
+    w->handle.resume();
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//AsyncQueue<T,Alloc>::Awaiter class and related definitions
+
+//Fast path without suspending: a value is already queued
+template<class T, class Alloc>
+bool AsyncQueue<T,Alloc>::Awaiter::await_ready() {
+  std::lock_guard<std::mutex> guard(queue->lock);
+  if (queue->values.empty())
+    return false;
+  value.emplace(queue->values.dequeue());
+  return true;
+}
+
+
+//Check again under the lock (a value may have arrived since await_ready); returning false
+//  continues the coroutine without suspending
+template<class T, class Alloc>
+bool AsyncQueue<T,Alloc>::Awaiter::await_suspend(std::coroutine_handle<> h) {
+  std::lock_guard<std::mutex> guard(queue->lock);
+  if (!queue->values.empty()) {
+    value.emplace(queue->values.dequeue());
+    return false;
+  }
+  if (queue->is_closed)
+    return false;
+
+  handle = h;
+  if (queue->waiters_rear == nullptr)
+    queue->waiters_front = this;
+  else
+    queue->waiters_rear->next = this;
+  queue->waiters_rear = this;
+  ++queue->waiter_count;
+  return true;
+}
+
+
+template<class T, class Alloc>
+T AsyncQueue<T,Alloc>::Awaiter::await_resume() {
+  if (!value)
+    throw EmptyError("AsyncQueue::dequeue (closed)");
+  return std::move(*value);
+}
+
+}
+
+#endif /* ASYNC_QUEUE_HPP_ */
@@ -0,0 +1,89 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Many coroutine consumers on a few threads: each consumer loops on co_await q.dequeue()
+//  until the queue is closed. Producers enqueue from their own threads; consumers resume
+//  either inline on the producer's thread or on a WorkStealingPool (the scheduler).
+//
+//Usage: bench_async_queue [consumers (default 10000)] [values (default 1000000)]
+//                         [producers (default 2)] [pool threads (default 2)]
+//Build: g++ -std=c++20 -O2 -pthread -I. -I<courselib> bench_async_queue.cpp
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include "async_queue.hpp"
+#include "work_stealing_pool.hpp"
+
+
+ics::DetachedTask consume(ics::AsyncQueue<int>& q, std::atomic<long long>& sum,
+                          std::atomic<int>& consumed, std::atomic<int>& finished) {
+  try {
+    for (;;) {
+      int value = co_await q.dequeue();
+      sum.fetch_add(value, std::memory_order_relaxed);
+      consumed.fetch_add(1, std::memory_order_relaxed);
+    }
+  } catch (const ics::EmptyError&) {
+    //closed
+  }
+  finished.fetch_add(1);
+}
+
+
+void wait_until(const std::atomic<int>& counter, int target) {
+  while (counter.load() < target)
+    std::this_thread::yield();
+}
+
+
+bool run(const char* title, int consumers, int values, int producers, ics::WorkStealingPool* pool) {
+  ics::AsyncQueue<int> q(pool == nullptr ? ics::AsyncQueue<int>::Scheduler()
+                                         : [pool] (std::coroutine_handle<> h) {pool->submit([h] () {h.resume();});});
+  std::atomic<long long> sum(0);
+  std::atomic<int>       consumed(0), finished(0);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < consumers; ++i)
+    consume(q, sum, consumed, finished);
+  int suspended = q.waiting();
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p)
+    threads.push_back(std::thread([&q,p,producers,values] () {
+      for (int i = p; i < values; i += producers)
+        q.enqueue(i);
+    }));
+  for (std::thread& t : threads)
+    t.join();
+  wait_until(consumed, values);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+  q.close();
+  wait_until(finished, consumers);
+
+  long long expected = (long long)values*(values-1)/2;
+  bool ok = sum.load() == expected && suspended == consumers;
+  std::cout << title << ": " << consumers << " consumers (" << suspended << " suspended at start), "
+            << values << " values from " << producers << " producers in " << seconds << "s ("
+            << values/seconds/1e6 << "M/s) " << (ok ? "ok" : "WRONG SUM") << std::endl;
+  return ok;
+}
+
+
+int main(int argc, char* argv[]) {
+  int consumers    = argc > 1 ? std::atoi(argv[1]) : 10000;
+  int values       = argc > 2 ? std::atoi(argv[2]) : 1000000;
+  int producers    = argc > 3 ? std::atoi(argv[3]) : 2;
+  int pool_threads = argc > 4 ? std::atoi(argv[4]) : 2;
+
+  bool ok = run("inline resume", consumers, values, producers, nullptr);
+  {
+    ics::WorkStealingPool pool(pool_threads);
+    ok = run("pool resume  ", consumers, values, producers, &pool) && ok;
+  }
+  return ok ? 0 : 1;
+}
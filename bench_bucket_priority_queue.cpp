@@ -0,0 +1,71 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Discrete-class priorities: BucketPriorityQueue (O(1) per operation) against
+//  HeapPriorityQueue (O(Log N)) ordering by the same class. A steady-state scheduler loop:
+//  keep about depth values queued, dequeue one and enqueue one, ops times.
+//  The heap compares (class, sequence number) so both dequeue in the same (stable) order,
+//  and the two dequeue sequences are checked to be identical.
+//
+//Usage: bench_bucket_priority_queue [ops (default 2000000)] [depth (default 10000)]
+//Build: g++ -std=gnu++11 -O2 -I. -Iprogram3/src -I<courselib> bench_bucket_priority_queue.cpp
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include "bucket_priority_queue.hpp"
+#include "heap_priority_queue.hpp"
+
+
+struct Job {
+  int  priority_class;
+  long sequence;          //Enqueue order, so the heap can break ties FIFO
+};
+
+int  job_class (const Job& j)               {return j.priority_class;}
+bool job_gt    (const Job& a, const Job& b) {return a.priority_class > b.priority_class ||
+                                                   (a.priority_class == b.priority_class && a.sequence < b.sequence);}
+
+
+template<class Queue>
+double run(Queue& q, const std::vector<int>& classes, int depth, std::vector<long>& order) {
+  long sequence = 0;
+  for (int i = 0; i < depth; ++i, ++sequence)
+    q.enqueue(Job{classes[i], sequence});
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (std::size_t i = depth; i < classes.size(); ++i, ++sequence) {
+    order.push_back(q.dequeue().sequence);
+    q.enqueue(Job{classes[i], sequence});
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+
+int main(int argc, char* argv[]) {
+  int ops   = argc > 1 ? std::atoi(argv[1]) : 2000000;
+  int depth = argc > 2 ? std::atoi(argv[2]) : 10000;
+
+  for (int classes : {8, 64}) {
+    std::vector<int> job_classes(ops+depth);
+    std::mt19937 random(46);
+    for (int& c : job_classes)
+      c = random() % classes;
+
+    std::vector<long> bucket_order, heap_order;
+    bucket_order.reserve(ops);
+    heap_order.reserve(ops);
+
+    ics::BucketPriorityQueue<Job,job_class> bucket;
+    ics::HeapPriorityQueue<Job,job_gt>      heap;
+    double bucket_seconds = run(bucket, job_classes, depth, bucket_order);
+    double heap_seconds   = run(heap,   job_classes, depth, heap_order);
+
+    std::cout << classes << " classes, depth " << depth << ", " << ops << " dequeue+enqueue: "
+              << "bucket " << bucket_seconds/ops*1e9 << "ns, heap " << heap_seconds/ops*1e9 << "ns ("
+              << heap_seconds/bucket_seconds << "x) "
+              << (bucket_order == heap_order ? "same order" : "DIFFERENT ORDER") << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,109 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Cancelling queued jobs: enqueue n jobs, cancel most of them (in random order), then dequeue
+//  the rest, two ways:
+//  erase : find each job with an Iterator and Iterator::erase it (the only way before tokens;
+//          each search is O(N), so this runs on at most erase_n jobs)
+//  cancel: HeapPriorityQueue::cancel with the Token from enqueue_token (O(1), tombstones)
+//Reports time per job and the tombstone counters; both must dequeue the same jobs.
+//
+//Usage: bench_cancel_heap [n (default 1000000)] [cancel fraction (default 0.9)] [erase_n (default 2000)]
+//Build: g++ -std=gnu++11 -O2 -I. -Iprogram3/src -I<courselib> bench_cancel_heap.cpp
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include "heap_priority_queue.hpp"
+
+
+struct Job {
+  int priority;
+  int id;
+  bool operator == (const Job& rhs) const {return id == rhs.id;}
+  bool operator != (const Job& rhs) const {return id != rhs.id;}
+  bool operator <  (const Job& rhs) const {return id < rhs.id;}      //For operator << only
+};
+
+std::ostream& operator << (std::ostream& outs, const Job& j) {return outs << j.id;}
+
+bool job_gt (const Job& a, const Job& b) {return a.priority > b.priority || (a.priority == b.priority && a.id < b.id);}
+
+typedef ics::HeapPriorityQueue<Job,job_gt> Queue;
+
+
+//Jobs, and the order to cancel the first fraction of them in
+void make_jobs(int n, double fraction, std::vector<Job>& jobs, std::vector<int>& cancel_order) {
+  std::mt19937 random(46);
+  jobs.resize(n);
+  cancel_order.resize(n);
+  for (int i = 0; i < n; ++i) {
+    jobs[i] = Job{int(random() % 1000000), i};
+    cancel_order[i] = i;
+  }
+  std::shuffle(cancel_order.begin(), cancel_order.end(), random);
+  cancel_order.resize(int(n*fraction));
+}
+
+
+double run_erase(const std::vector<Job>& jobs, const std::vector<int>& cancel_order, std::vector<int>& dequeued) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  Queue q;
+  for (const Job& j : jobs)
+    q.enqueue(j);
+  for (int id : cancel_order)
+    for (Queue::Iterator i = q.begin(); i != q.end(); ++i)
+      if (i->id == id) {
+        i.erase();
+        break;
+      }
+  while (!q.empty())
+    dequeued.push_back(q.dequeue().id);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count() / jobs.size() * 1e9;
+}
+
+
+double run_cancel(const std::vector<Job>& jobs, const std::vector<int>& cancel_order, std::vector<int>& dequeued, Queue& q) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<Queue::Token> tokens;
+  tokens.reserve(jobs.size());
+  for (const Job& j : jobs)
+    tokens.push_back(q.enqueue_token(j));
+  for (int id : cancel_order)
+    q.cancel(tokens[id]);
+  std::cout << "    after cancelling: size=" << q.size() << " tombstones=" << q.tombstones()
+            << " ratio=" << q.tombstone_ratio() << " compactions=" << q.compactions() << std::endl;
+  while (!q.empty())
+    dequeued.push_back(q.dequeue().id);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count() / jobs.size() * 1e9;
+}
+
+
+int main(int argc, char* argv[]) {
+  int    n        = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  double fraction = argc > 2 ? std::atof(argv[2]) : 0.9;
+  int    erase_n  = argc > 3 ? std::atoi(argv[3]) : 2000;
+
+  std::vector<Job> jobs;
+  std::vector<int> cancel_order;
+  make_jobs(std::min(n, erase_n), fraction, jobs, cancel_order);
+  std::vector<int> erase_dequeued, cancel_dequeued;
+  std::cout << jobs.size() << " jobs, cancelling " << cancel_order.size() << ":" << std::endl;
+  double erase  = run_erase(jobs, cancel_order, erase_dequeued);
+  Queue  small;
+  double cancel = run_cancel(jobs, cancel_order, cancel_dequeued, small);
+  std::cout << "  erase  " << erase << "ns per job" << std::endl
+            << "  cancel " << cancel << "ns per job (" << erase/cancel << "x) "
+            << (erase_dequeued == cancel_dequeued ? "same jobs" : "DIFFERENT JOBS") << std::endl;
+
+  make_jobs(n, fraction, jobs, cancel_order);
+  cancel_dequeued.clear();
+  std::cout << n << " jobs, cancelling " << cancel_order.size() << ":" << std::endl;
+  Queue  large;
+  double large_cancel = run_cancel(jobs, cancel_order, cancel_dequeued, large);
+  std::cout << "  cancel " << large_cancel << "ns per job" << std::endl;
+  return 0;
+}
@@ -0,0 +1,79 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Deduplicating a stream of events (ints, about 3 in 4 repeats) split among 1 to 64 threads,
+//  each thread inserting its events and counting those that were new, two ways:
+//  locked     : one HashSet<int> behind a std::mutex (as the ingest threads share it now)
+//  concurrent : one ConcurrentHashSet<int> (inserting without locking)
+//For each number of threads both must count the same number of new events (the distinct ones).
+//
+//Usage: bench_concurrent_hash_set [events (default 4000000) [max threads (default 64)]]
+//Build: g++ -std=gnu++11 -O2 -pthread -I. -Iprogram4/src -I<courselib> bench_concurrent_hash_set.cpp
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <cstdlib>
+#include "hash_set.hpp"
+#include "concurrent_hash_set.hpp"
+
+
+int hash_int(const int& i) {std::hash<int> int_hash; return int_hash(i);}
+
+
+//Run insert(event) on each thread's share of events; returns the number of new events
+template<class Insert>
+int dedupe(const char* title, int threads, const std::vector<int>& events, Insert insert) {
+  std::atomic<int> fresh(0);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t)
+    workers.push_back(std::thread([&, t] () {
+      int count = 0;
+      for (std::size_t e = t; e < events.size(); e += threads)
+        count += insert(events[e]);
+      fresh += count;
+    }));
+  for (std::thread& w : workers)
+    w.join();
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  std::cout << "  " << title << ": " << events.size()/s/1e6 << "M events/s (" << fresh << " new)" << std::endl;
+  return fresh;
+}
+
+
+int main(int argc, char* argv[]) {
+  int events_count = argc > 1 ? std::atoi(argv[1]) : 4000000;
+  int max_threads  = argc > 2 ? std::atoi(argv[2]) : 64;
+
+  std::mt19937 random(46);
+  std::uniform_int_distribution<int> event(0, events_count/4);
+  std::vector<int> events(events_count);
+  for (int& e : events)
+    e = event(random);
+
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    std::cout << threads << " thread(s)" << std::endl;
+
+    ics::HashSet<int,hash_int> locked;
+    std::mutex lock;
+    int locked_new = dedupe("locked    ", threads, events, [&] (int e) {
+      std::lock_guard<std::mutex> guard(lock);
+      return locked.insert(e);
+    });
+
+    ics::ConcurrentHashSet<int,hash_int> concurrent;
+    int concurrent_new = dedupe("concurrent", threads, events, [&] (int e) {return concurrent.insert(e);});
+
+    if (locked_new != concurrent_new) {
+      std::cout << "  DISAGREE: " << locked_new << " vs " << concurrent_new << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,108 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//The k most frequent bigrams (pairs of adjacent words, the words Zipf distributed like a text's)
+//  in a stream of n words, found three ways:
+//  exact    : counting every bigram in a HashMap<std::string,int> (then sorting the counts)
+//  sketch   : one HeavyHitters (a CountMinSketch plus a heap of k candidates) over the stream
+//  threads  : one HeavyHitters per thread, each over part of the stream, merged at the end
+//For each, the time, the memory (entries for exact, fixed bytes for the sketches), how many of
+//  the true top k were found, and the largest overestimate among them.
+//
+//Usage: bench_count_min_sketch [n (default 2000000) [k (default 20) [threads (default 4)]]]
+//Build: g++ -std=gnu++11 -O2 -pthread -I. -Iprogram4/src -I<courselib> bench_count_min_sketch.cpp
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstdlib>
+#include "hash_map.hpp"
+#include "count_min_sketch.hpp"
+
+
+int hash_string(const std::string& s) {std::hash<std::string> str_hash; return str_hash(s);}
+
+typedef ics::HashMap<std::string,int,hash_string>  CountMap;
+typedef ics::HeavyHitters<std::string,hash_string> Hitters;
+typedef std::vector<Hitters::Entry>                Ranking;
+
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+
+void report(const char* title, double s, const std::string& memory, const Ranking& found, const Ranking& exact, CountMap& counts) {
+  int  hits = 0;
+  long over = 0;
+  for (const Hitters::Entry& f : found) {
+    for (const Hitters::Entry& e : exact)
+      hits += f.first == e.first;
+    over = std::max(over, f.second - counts[f.first]);
+  }
+  std::cout << title << ": " << s*1e3 << "ms, " << memory << ", found " << hits << " of the top " << exact.size()
+            << ", largest overestimate " << over << std::endl;
+}
+
+
+int main(int argc, char* argv[]) {
+  int n       = argc > 1 ? std::atoi(argv[1]) : 2000000;
+  int k       = argc > 2 ? std::atoi(argv[2]) : 20;
+  int threads = argc > 3 ? std::atoi(argv[3]) : 4;
+
+  std::mt19937 random(46);
+  std::vector<double> cumulative;                  //Word i is 1/(i+1)^1.1 as likely as word 0
+  double weight = 0;
+  for (int i = 1; i <= 50000; ++i)
+    cumulative.push_back(weight += 1.0/std::pow(i, 1.1));
+  std::uniform_real_distribution<double> pick(0, weight);
+  std::vector<std::string> bigrams(n);
+  std::string previous = "w0";
+  for (std::string& b : bigrams) {
+    std::string word = "w" + std::to_string(std::lower_bound(cumulative.begin(), cumulative.end(), pick(random)) - cumulative.begin());
+    b = previous + " " + word;
+    previous = word;
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  CountMap counts;
+  std::vector<std::string> distinct;               //HashMap's keys, to rank them
+  for (const std::string& b : bigrams)
+    if (++counts[b] == 1)
+      distinct.push_back(b);
+  Ranking exact;
+  for (const std::string& b : distinct)
+    exact.push_back(Hitters::Entry(b, counts[b]));
+  std::partial_sort(exact.begin(), exact.begin() + std::min<int>(k, exact.size()), exact.end(),
+                    [] (const Hitters::Entry& a, const Hitters::Entry& b) {return a.second > b.second;});
+  exact.resize(std::min<int>(k, exact.size()));
+  std::cout << "exact   : " << seconds_since(start)*1e3 << "ms, " << counts.size() << " entries" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  Hitters one(k);
+  for (const std::string& b : bigrams)
+    one.add(b);
+  Ranking found = one.top();
+  report("sketch  ", seconds_since(start), "about " + std::to_string(2048*4*sizeof(long)/1024) + "KB", found, exact, counts);
+
+  start = std::chrono::steady_clock::now();
+  std::vector<Hitters> parts(threads, Hitters(k));
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t)
+    workers.push_back(std::thread([&, t] () {
+      for (std::size_t b = std::size_t(t)*n/threads; b < std::size_t(t+1)*n/threads; ++b)
+        parts[t].add(bigrams[b]);
+    }));
+  for (std::thread& w : workers)
+    w.join();
+  for (int t = 1; t < threads; ++t)
+    parts[0].merge(parts[t]);
+  report("threads ", seconds_since(start), std::to_string(threads) + " sketches merged", parts[0].top(), exact, counts);
+  return 0;
+}
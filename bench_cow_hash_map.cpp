@@ -0,0 +1,106 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Copy-on-write HashMap copies (int->int, n keys). Times:
+//  copy        : copying the map (O(1): the copy shares the table)
+//  copy+1 put  : copying and then writing one key (copies the bins array and one bin)
+//  copy+n puts : copying and then writing every key (about what a deep copy cost before)
+//Then a writer keeps updating the map while reader threads each take snapshots (copies) of it
+//  and sum every value in their snapshot: every sum must be the one the writer left when that
+//  snapshot was taken (the writer keeps the sum of values fixed, so it is always n*(n-1)/2).
+//
+//Usage: bench_cow_hash_map [n (default 1000000)] [readers (default 4)] [snapshots/reader (default 20)]
+//Build: g++ -std=gnu++11 -O2 -pthread -I. -Iprogram4/src -I<courselib> bench_cow_hash_map.cpp
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include "hash_map.hpp"
+
+
+int hash_int(const int& i) {return i;}
+
+typedef ics::HashMap<int,long long,hash_int> MapType;
+
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+
+long long sum_values(const MapType& m, int n) {
+  long long sum = 0;
+  for (int k = 0; k < n; ++k)
+    sum += m[k];
+  return sum;
+}
+
+
+int main(int argc, char* argv[]) {
+  int n         = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  int readers   = argc > 2 ? std::atoi(argv[2]) : 4;
+  int snapshots = argc > 3 ? std::atoi(argv[3]) : 20;
+
+  MapType m;
+  m.reserve(n);
+  for (int k = 0; k < n; ++k)
+    m.put(k, k);
+  const long long expected = (long long)n*(n-1)/2;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  {
+    MapType c(m);
+    std::cout << "copy        : " << seconds_since(start)*1e6 << "us" << std::endl;
+    start = std::chrono::steady_clock::now();
+    c.put(0, 0);
+    std::cout << "  +1 put    : " << seconds_since(start)*1e6 << "us" << std::endl;
+  }
+  start = std::chrono::steady_clock::now();
+  {
+    MapType c(m);
+    for (int k = 0; k < n; ++k)
+      c[k] += 0;
+    std::cout << "copy+n puts : " << seconds_since(start)*1e3 << "ms" << std::endl;
+  }
+
+  //The writer moves 1 from one value to another (keeping the sum) under lock; readers copy
+  //  under the lock (O(1)) and then sum their copy without it
+  std::mutex lock;
+  std::atomic<bool> done(false);
+  std::atomic<int>  bad(0);
+  std::thread writer([&] () {
+    for (int i = 0; !done; i = (i + 7919) % n) {
+      std::lock_guard<std::mutex> guard(lock);
+      m[i] -= 1;
+      m[(i+1) % n] += 1;
+    }
+  });
+
+  start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int r = 0; r < readers; ++r)
+    threads.push_back(std::thread([&] () {
+      for (int s = 0; s < snapshots; ++s) {
+        MapType* snapshot;
+        {
+          std::lock_guard<std::mutex> guard(lock);
+          snapshot = new MapType(m);
+        }
+        if (sum_values(*snapshot, n) != expected)
+          ++bad;
+        delete snapshot;
+      }
+    }));
+  for (std::thread& t : threads)
+    t.join();
+  done = true;
+  writer.join();
+
+  std::cout << readers << " readers x " << snapshots << " snapshots: " << seconds_since(start) << "s, "
+            << (bad == 0 && sum_values(m, n) == expected ? "ok" : "WRONG") << std::endl;
+  return 0;
+}
@@ -0,0 +1,166 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//1M pending retries, due uniformly over the next few seconds, drained three ways:
+//  take   : several threads blocking in DelayQueue::take
+//  batch  : one thread blocking in DelayQueue::take_batch
+//  polling: the hand-built version (a HeapPriorityQueue under a mutex, checked every 1ms)
+//Reports enqueue rate and lateness (take time - deadline) percentiles; every retry must be
+//  taken exactly once and none early.
+//
+//Usage: bench_delay_queue [retries (default 1000000)] [spread seconds (default 2)] [takers (default 4)]
+//Build: g++ -std=gnu++11 -O2 -pthread -I. -Iprogram3/src -I<courselib> bench_delay_queue.cpp
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include "heap_priority_queue.hpp"
+#include "delay_queue.hpp"
+
+
+typedef std::chrono::steady_clock Clock;
+
+struct Retry {
+  int               id = 0;
+  Clock::time_point due;
+};
+
+bool due_earlier(const Retry& a, const Retry& b) {return a.due < b.due;}
+
+
+//Per-taker lateness samples (ns), merged at the end
+struct Results {
+  std::mutex                lock;
+  std::vector<std::int64_t> lateness;
+  std::vector<char>         seen;
+  bool                      ok = true;
+
+  explicit Results(int n) : seen(n, 0) {lateness.reserve(n);}
+
+  void add(const std::vector<std::pair<int,std::int64_t>>& taken) {
+    std::lock_guard<std::mutex> guard(lock);
+    for (const std::pair<int,std::int64_t>& t : taken) {
+      if (t.second < 0 || seen[t.first]++ != 0)
+        ok = false;
+      lateness.push_back(t.second);
+    }
+  }
+
+  void report(const char* title, double enqueue_seconds, double total_seconds) {
+    std::sort(lateness.begin(), lateness.end());
+    int n = lateness.size();
+    ok = ok && n == int(seen.size());
+    std::cout << title << ": enqueue " << n/enqueue_seconds/1e6 << "M/s, drained in " << total_seconds << "s, lateness"
+              << " p50=" << lateness[n/2]/1e3 << "us p99=" << lateness[n*99/100]/1e3 << "us max="
+              << lateness[n-1]/1e3 << "us " << (ok ? "ok" : "WRONG (lost, duplicated or early)") << std::endl;
+  }
+};
+
+
+std::int64_t late_ns(const Retry& r) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - r.due).count();
+}
+
+
+std::vector<Retry> make_retries(int n, double spread, Clock::time_point start) {
+  std::vector<Retry> answer(n);
+  std::mt19937 random(46);
+  std::uniform_real_distribution<double> delay(0, spread);
+  for (int i = 0; i < n; ++i) {
+    answer[i].id  = i;
+    answer[i].due = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(delay(random)));
+  }
+  return answer;
+}
+
+
+void run_delay_queue(const char* title, int n, double spread, int takers, bool batch) {
+  Results results(n);
+  ics::DelayQueue<Retry> q;
+  Clock::time_point start = Clock::now() + std::chrono::milliseconds(500);   //Room to enqueue first
+  std::vector<Retry> retries = make_retries(n, spread, start);
+
+  Clock::time_point enqueue_start = Clock::now();
+  for (const Retry& r : retries)
+    q.enqueue_at(r, r.due);
+  double enqueue_seconds = std::chrono::duration<double>(Clock::now()-enqueue_start).count();
+
+  std::atomic<int> remaining(n);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < (batch ? 1 : takers); ++t)
+    threads.push_back(std::thread([&] () {
+      std::vector<std::pair<int,std::int64_t>> taken;
+      try {
+        for (;;) {
+          int count = 0;
+          if (batch)
+            for (const Retry& r : q.take_batch()) {
+              taken.push_back(std::make_pair(r.id, late_ns(r)));
+              ++count;
+            }
+          else {
+            Retry r = q.take();
+            taken.push_back(std::make_pair(r.id, late_ns(r)));
+            count = 1;
+          }
+          if (remaining.fetch_sub(count) == count)     //Took the last ones: release the other takers
+            q.close();
+        }
+      } catch (const ics::EmptyError&) {
+        //closed and drained
+      }
+      results.add(taken);
+    }));
+  for (std::thread& t : threads)
+    t.join();
+  results.report(title, enqueue_seconds, std::chrono::duration<double>(Clock::now()-start).count());
+}
+
+
+void run_polling(const char* title, int n, double spread) {
+  Results results(n);
+  std::mutex lock;
+  ics::HeapPriorityQueue<Retry,due_earlier> q;
+  Clock::time_point start = Clock::now() + std::chrono::milliseconds(500);
+  std::vector<Retry> retries = make_retries(n, spread, start);
+
+  Clock::time_point enqueue_start = Clock::now();
+  for (const Retry& r : retries) {
+    std::lock_guard<std::mutex> guard(lock);
+    q.enqueue(r);
+  }
+  double enqueue_seconds = std::chrono::duration<double>(Clock::now()-enqueue_start).count();
+
+  std::vector<std::pair<int,std::int64_t>> taken;
+  while (int(taken.size()) < n) {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      Clock::time_point now = Clock::now();
+      while (!q.empty() && q.peek().due <= now) {
+        Retry r = q.dequeue();
+        taken.push_back(std::make_pair(r.id, late_ns(r)));
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  results.add(taken);
+  results.report(title, enqueue_seconds, std::chrono::duration<double>(Clock::now()-start).count());
+}
+
+
+int main(int argc, char* argv[]) {
+  int    n      = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  double spread = argc > 2 ? std::atof(argv[2]) : 2;
+  int    takers = argc > 3 ? std::atoi(argv[3]) : 4;
+
+  run_delay_queue("take    ", n, spread, takers, false);
+  run_delay_queue("batch   ", n, spread, takers, true);
+  run_polling    ("polling ", n, spread);
+  return 0;
+}
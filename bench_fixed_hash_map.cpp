@@ -0,0 +1,71 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Looking up driver command names (the set driver's 16 batch commands, plus 1 in 8 unknown
+//  names) three ways:
+//  linear : comparing the name to each entry of an allowable[]-style array in turn
+//  hash   : a HashSet<std::string> built at startup
+//  fixed  : the FixedHashSet the compiler builds (as the drivers' execute now uses)
+//All three must find the same number of names.
+//
+//Usage: bench_fixed_hash_map [lookups (default 20000000)]
+//Build: g++ -std=gnu++11 -O2 -I. -Iprogram4/src -I<courselib> bench_fixed_hash_map.cpp
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+#include "hash_set.hpp"
+#include "fixed_hash_map.hpp"
+
+
+int hash_string(const std::string& s) {std::hash<std::string> str_hash; return str_hash(s);}
+
+constexpr auto fixed_commands = ics::make_fixed_hash_set("i","I","e","E","x","R","=","m","s","c","C","<","r","f","lf","l{");
+static_assert(fixed_commands.contains("lf") && !fixed_commands.contains("q"), "built when compiling");
+
+const std::string allowable[] = {"i","I","e","E","x","R","=","m","s","c","C","<","r","f","lf","l{",""};
+
+
+bool linear_contains(const std::string& name) {
+  for (int i = 0; allowable[i] != ""; ++i)
+    if (allowable[i] == name)
+      return true;
+  return false;
+}
+
+
+template<class Contains>
+void run(const char* title, const std::vector<std::string>& names, Contains contains) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int found = 0;
+  for (const std::string& n : names)
+    found += contains(n);
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  std::cout << title << ": " << names.size()/s/1e6 << "M lookups/s (found " << found << ")" << std::endl;
+}
+
+
+int main(int argc, char* argv[]) {
+  int lookups = argc > 1 ? std::atoi(argv[1]) : 20000000;
+
+  std::mt19937 random(46);
+  std::uniform_int_distribution<int> which(0, 17);   //16 and 17: unknown names
+  std::vector<std::string> names(lookups);
+  for (std::string& n : names) {
+    int w = which(random);
+    n = w < 16 ? allowable[w] : (w == 16 ? "q" : "zz");
+  }
+
+  ics::HashSet<std::string,hash_string> hash_commands;
+  for (const char* c : fixed_commands)
+    hash_commands.insert(c);
+
+  run("linear", names, [] (const std::string& n) {return linear_contains(n);});
+  run("hash  ", names, [&] (const std::string& n) {return hash_commands.contains(n);});
+  run("fixed ", names, [] (const std::string& n) {return fixed_commands.contains(n);});
+  return 0;
+}
@@ -0,0 +1,112 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//int and long long keyed maps: HashMap (hash function pointer, abs()%bins, LN nodes) vs
+//  FlatHashMap (what AutoHashMap picks for integral keys). For n random keys times putting
+//  them all, looking up present and absent keys, and erasing half of them; both maps must
+//  find the same number of keys and sum the same values.
+//Then the worst case for FlatHashMap: long long keys whose mixed values share all their top
+//  bits, so every one has the same home slot (the last) at every capacity. 34 of them once
+//  doubled the map until it ran out of memory; now they must all be found, in bounded time.
+//
+//Usage: bench_flat_hash_map [n (default 1000000)] [lookups (default 10000000)]
+//Build: g++ -std=gnu++11 -O2 -I. -Iprogram4/src -I<courselib> bench_flat_hash_map.cpp
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <cstdint>
+#include "hash_map.hpp"
+#include "flat_hash_map.hpp"
+
+
+int hash_int (const int& i)       {return i;}
+int hash_long(const long long& l) {return int(l ^ (l >> 32));}
+
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+
+template<class Map, class KEY>
+void run(const char* title, const std::vector<KEY>& keys, const std::vector<KEY>& probes) {
+  Map m;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < keys.size(); ++i)
+    m.put(keys[i], int(i));
+  double put_s = seconds_since(start);
+
+  start = std::chrono::steady_clock::now();
+  long long found = 0, sum = 0;
+  for (const KEY& k : probes)
+    if (m.has_key(k)) {
+      ++found;
+      sum += m[k];
+    }
+  double get_s = seconds_since(start);
+
+  start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < keys.size(); i += 2)
+    if (m.has_key(keys[i]))
+      m.erase(keys[i]);
+  double erase_s = seconds_since(start);
+
+  std::cout << title << ": put " << put_s/keys.size()*1e9 << "ns, lookup " << get_s/probes.size()*1e9
+            << "ns, erase " << erase_s/(keys.size()/2)*1e9 << "ns (found " << found << ", sum " << sum
+            << ", size after " << m.size() << ")" << std::endl;
+}
+
+
+template<class KEY>
+void make_keys(int n, int lookups, std::vector<KEY>& keys, std::vector<KEY>& probes) {
+  std::mt19937_64 random(46);
+  std::uniform_int_distribution<KEY> any(-1000000000, 1000000000);
+  for (int i = 0; i < n; ++i)
+    keys.push_back(any(random));
+  std::uniform_int_distribution<int> which(0, n-1);
+  for (int i = 0; i < lookups; ++i)
+    probes.push_back(i % 4 == 3 ? any(random) : keys[which(random)]);   //1 in 4 (nearly always) absent
+}
+
+
+//Keys k with k*phi (FlatHashMap::home's multiplier, mod 2^64) = 2^64-1-i: the top bits are all
+//  1s, so home(k) is the last home slot whatever the capacity
+void colliding(int n) {
+  const std::uint64_t phi = 0x9E3779B97F4A7C15ull;
+  std::uint64_t inverse = phi;        //Newton's iteration: each step doubles the correct low bits
+  for (int i = 0; i < 5; ++i)
+    inverse *= 2 - phi*inverse;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  ics::FlatHashMap<long long,int> m;
+  for (int i = 0; i < n; ++i)
+    m.put((long long)((~0ull - i) * inverse), i);
+  int found = 0;
+  for (int i = 0; i < n; ++i)
+    found += m.has_key((long long)((~0ull - i) * inverse)) && m[(long long)((~0ull - i) * inverse)] == i;
+  std::cout << "long long FlatHashMap, " << n << " keys with one home slot: " << seconds_since(start)*1e3
+            << "ms (found " << found << (found == n && m.size() == n ? ", ok" : ", WRONG") << ")" << std::endl;
+}
+
+
+int main(int argc, char* argv[]) {
+  int n       = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  int lookups = argc > 2 ? std::atoi(argv[2]) : 10000000;
+
+  std::vector<int> int_keys, int_probes;
+  make_keys(n, lookups, int_keys, int_probes);
+  run<ics::HashMap<int,int,hash_int>>        ("int       HashMap    ", int_keys, int_probes);
+  run<ics::AutoHashMap<int,int,hash_int>>    ("int       FlatHashMap", int_keys, int_probes);
+
+  std::vector<long long> long_keys, long_probes;
+  make_keys(n, lookups, long_keys, long_probes);
+  run<ics::HashMap<long long,int,hash_long>> ("long long HashMap    ", long_keys, long_probes);
+  run<ics::AutoHashMap<long long,int>>       ("long long FlatHashMap", long_keys, long_probes);
+
+  colliding(34);
+  colliding(2000);
+  return 0;
+}
@@ -0,0 +1,110 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//A read-only string->int table (n words like those in a corpus): lookups of present and of
+//  absent keys in the HashMap itself and in its freeze(). Also checks that every key is found
+//  with its value, that no absent key is, and that int keys with colliding hash values (which
+//  the MPHF can't separate) are all still found. Reports lookups/s and index bits/key.
+//
+//Usage: bench_frozen_hash_map [n (default 1000000)] [lookups (default 10000000)]
+//Build: g++ -std=gnu++11 -O2 -I. -Iprogram4/src -I<courselib> bench_frozen_hash_map.cpp
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+#include "hash_map.hpp"
+#include "frozen_hash_map.hpp"
+
+
+int hash_string(const std::string& s) {std::hash<std::string> str_hash; return str_hash(s);}
+int hash_mod   (const int& i)         {return i % 1000;}   //Many keys share each hash value
+
+typedef ics::HashMap<std::string,int,hash_string> MapType;
+
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+
+std::string random_word(std::mt19937& random) {
+  std::uniform_int_distribution<int> length(3, 12), letter('a', 'z');
+  std::string answer;
+  for (int l = length(random); l > 0; --l)
+    answer += char(letter(random));
+  return answer;
+}
+
+
+template<class Map>
+void run(const char* title, const Map& m, const std::vector<std::string>& probes, int expected_found) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int found = 0;
+  long long sum = 0;
+  for (const std::string& p : probes)
+    if (m.has_key(p)) {
+      ++found;
+      sum += m[p];
+    }
+  double s = seconds_since(start);
+  std::cout << title << ": " << probes.size()/s/1e6 << "M lookups/s (checksum " << sum << ")"
+            << (found == expected_found ? "" : " WRONG (found count)") << std::endl;
+}
+
+
+int main(int argc, char* argv[]) {
+  int n       = argc > 1 ? std::atoi(argv[1]) : 1000000;
+  int lookups = argc > 2 ? std::atoi(argv[2]) : 10000000;
+
+  std::mt19937 random(46);
+  MapType m;
+  m.reserve(n);
+  std::vector<std::string> keys;
+  while (int(keys.size()) < n) {
+    std::string w = random_word(random);
+    if (!m.has_key(w)) {
+      m.put(w, keys.size());
+      keys.push_back(w);
+    }
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  ics::FrozenHashMap<std::string,int,hash_string> f = m.freeze();
+  std::cout << "freeze  : " << seconds_since(start) << "s for " << f.size() << " keys, index "
+            << f.index_bits_per_key() << " bits/key, " << f.overflows() << " overflows" << std::endl;
+
+  bool ok = f.size() == n;
+  for (int i = 0; i < n; ++i)
+    ok = ok && f[keys[i]] == i;
+  for (const ics::pair<std::string,int>& kv : f)
+    ok = ok && keys[kv.second] == kv.first;
+
+  std::uniform_int_distribution<int> which(0, n-1);
+  std::vector<std::string> present(lookups), absent;
+  for (int i = 0; i < lookups; ++i)
+    present[i] = keys[which(random)];
+  while (int(absent.size()) < lookups/10) {
+    std::string w = random_word(random) + "#";   //Never a key
+    absent.push_back(w);
+  }
+
+  run("HashMap  present", m, present, lookups);
+  run("Frozen   present", f, present, lookups);
+  run("HashMap  absent ", m, absent,  0);
+  run("Frozen   absent ", f, absent,  0);
+
+  std::vector<ics::pair<int,int>> colliding;
+  for (int i = 0; i < 20000; ++i)
+    colliding.push_back(ics::make_pair(i, -i));
+  colliding.push_back(ics::make_pair(7, 70));     //A later duplicate replaces the earlier value
+  ics::FrozenHashMap<int,int> c(colliding, hash_mod);
+  ok = ok && c.size() == 20000 && c[7] == 70 && !c.has_key(20000) && !c.has_key(-1);
+  for (int i = 0; i < 20000; ++i)
+    ok = ok && c[i] == (i == 7 ? 70 : -i);
+  std::cout << "colliding hash values: " << c.overflows() << " overflows, " << (ok ? "ok" : "WRONG") << std::endl;
+  return 0;
+}
@@ -0,0 +1,67 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Counting the occurrences of n keys (strings, with about 1 distinct key per 4) in a HashMap:
+//  growing : starting with 1 bin and rehashing as it grows
+//  sketched: first a HyperLogLog pre-scan of the keys, then constructing the map with its
+//            expected_size (the time includes the pre-scan)
+//  exact   : constructing it with the true number of distinct keys (known only afterwards)
+//All three must end with the same number of keys.
+//
+//Usage: bench_hyper_log_log [n (default 2000000)]
+//Build: g++ -std=gnu++11 -O2 -I. -Iprogram4/src -I<courselib> bench_hyper_log_log.cpp
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+#include "hash_map.hpp"
+#include "hyper_log_log.hpp"
+
+
+int hash_string(const std::string& s) {std::hash<std::string> str_hash; return str_hash(s);}
+
+typedef ics::HashMap<std::string,int,hash_string> CountMap;
+
+
+template<class MakeMap>
+int count(const char* title, const std::vector<std::string>& keys, MakeMap make_map) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  CountMap counts = make_map();
+  for (const std::string& k : keys)
+    ++counts[k];
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  std::cout << title << ": " << s*1e3 << "ms (" << counts.size() << " keys)" << std::endl;
+  return counts.size();
+}
+
+
+int main(int argc, char* argv[]) {
+  int n = argc > 1 ? std::atoi(argv[1]) : 2000000;
+
+  std::mt19937 random(46);
+  std::uniform_int_distribution<int> key(0, n/4);
+  std::vector<std::string> keys(n);
+  for (std::string& k : keys)
+    k = "key" + std::to_string(key(random));
+
+  int distinct = count("growing ", keys, [] () {return CountMap();});
+
+  ics::HyperLogLog<std::string,hash_string> sketch;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  sketch.add_all(keys);
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  std::cout << "pre-scan: " << s*1e3 << "ms, estimate " << sketch.estimate() << " (expected_size "
+            << sketch.expected_size().size << ", in " << sketch.bytes() << " bytes)" << std::endl;
+
+  int sketched = count("sketched", keys, [&keys] () {
+    ics::HyperLogLog<std::string,hash_string> pre_scan;
+    pre_scan.add_all(keys);
+    return CountMap(pre_scan.expected_size());
+  });
+  int exact = count("exact   ", keys, [distinct] () {return CountMap(ics::ExpectedSize(distinct));});
+  return sketched == distinct && exact == distinct ? 0 : 1;
+}
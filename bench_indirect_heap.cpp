@@ -0,0 +1,99 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Heavy elements: priority-ordering n CorpusEntry-like values (a word-sequence prefix and its
+//  follow set, as in wordgenerator.cpp; 2-5 and 1-20 strings) by follow-set size (then prefix, id),
+//  enqueueing all then dequeueing all, three ways:
+//  values  : HeapPriorityQueue<CorpusEntry> (every percolate swap moves whole entries)
+//  indexes : IndirectHeapPriorityQueue<CorpusEntry> over the vector (4-byte entries)
+//  keyed   : the same with the follow-set size cached beside each index (8-byte entries; gt
+//            is called only for equal sizes)
+//The three dequeue orders must be identical.
+//
+//Usage: bench_indirect_heap [n (default 200000)]
+//Build: g++ -std=gnu++11 -O2 -I. -Iprogram3/src -I<courselib> bench_indirect_heap.cpp
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include "heap_priority_queue.hpp"
+#include "indirect_heap_priority_queue.hpp"
+
+
+struct CorpusEntry {
+  std::vector<std::string> prefix;
+  std::vector<std::string> follows;
+  int                      id = 0;       //Position in the corpus vector, to compare orders
+};
+
+std::ostream& operator << (std::ostream& outs, const CorpusEntry& e) {return outs << e.id;}
+
+bool CorpusEntry_gt (const CorpusEntry& a, const CorpusEntry& b) {
+  if (a.follows.size() != b.follows.size())
+    return a.follows.size() > b.follows.size();
+  return a.prefix < b.prefix || (a.prefix == b.prefix && a.id < b.id);   //id: a total order, so one right answer
+}
+
+int follows_size (const CorpusEntry& e) {return e.follows.size();}
+
+
+std::vector<CorpusEntry> make_corpus(int n) {
+  std::mt19937 random(46);
+  std::vector<CorpusEntry> corpus(n);
+  auto word = [&random] () {return std::string("word") + std::to_string(random() % 5000);};
+  for (int i = 0; i < n; ++i) {
+    corpus[i].id = i;
+    for (int w = 2 + random() % 4; w > 0; --w)
+      corpus[i].prefix.push_back(word());
+    for (int w = 1 + random() % 20; w > 0; --w)
+      corpus[i].follows.push_back(word());
+  }
+  return corpus;
+}
+
+
+template<class Enqueue_All_Then_Dequeue_All>
+double time_ns(const char* title, int n, std::vector<int>& order, Enqueue_All_Then_Dequeue_All run) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  run(order);
+  double ns = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count() / n * 1e9;
+  std::cout << "  " << title << ns << "ns per element" << std::endl;
+  return ns;
+}
+
+
+int main(int argc, char* argv[]) {
+  int n = argc > 1 ? std::atoi(argv[1]) : 200000;
+  std::vector<CorpusEntry> corpus = make_corpus(n);
+  std::vector<int> values_order, indexes_order, keyed_order;
+
+  std::cout << n << " CorpusEntry values, enqueue all + dequeue all:" << std::endl;
+  double values = time_ns("values  ", n, values_order, [&] (std::vector<int>& order) {
+    ics::HeapPriorityQueue<CorpusEntry,CorpusEntry_gt> pq;
+    for (const CorpusEntry& e : corpus)
+      pq.enqueue(e);
+    while (!pq.empty())
+      order.push_back(pq.dequeue().id);
+  });
+  double indexes = time_ns("indexes ", n, indexes_order, [&] (std::vector<int>& order) {
+    ics::IndirectHeapPriorityQueue<CorpusEntry,CorpusEntry_gt> pq(corpus.data(), n);
+    for (int i = 0; i < n; ++i)
+      pq.enqueue(i);
+    while (!pq.empty())
+      order.push_back(pq.dequeue());
+  });
+  double keyed = time_ns("keyed   ", n, keyed_order, [&] (std::vector<int>& order) {
+    ics::IndirectHeapPriorityQueue<CorpusEntry,CorpusEntry_gt,int> pq(corpus.data(), n, nullptr, follows_size);
+    for (int i = 0; i < n; ++i)
+      pq.enqueue(i);
+    while (!pq.empty())
+      order.push_back(pq.dequeue());
+  });
+
+  std::cout << "  indexes " << values/indexes << "x, keyed " << values/keyed << "x faster than values; "
+            << (values_order == indexes_order && values_order == keyed_order ? "same order" : "DIFFERENT ORDER") << std::endl;
+  return 0;
+}
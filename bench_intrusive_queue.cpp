@@ -0,0 +1,135 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Pooled events through queues:
+//  1) one thread: LinkedQueue<Event> (allocates an LN and copies the Event per enqueue)
+//     against IntrusiveQueue<Event> (relinks the pooled Event's own hook)
+//  2) log/event aggregation: P producer threads each push their own pooled Events to one
+//     consumer, through a mutex-protected LinkedQueue<Event*> and through an MPSCQueue<Event>
+//
+//Usage: bench_intrusive_queue [events (default 2000000)] [producers (default 4)]
+//Build: g++ -std=gnu++11 -O2 -pthread -I. -I<courselib> bench_intrusive_queue.cpp
+
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include "linked_queue.hpp"
+#include "intrusive_queue.hpp"
+
+
+struct Event : ics::IntrusiveQueueHook<>, ics::MPSCQueueHook<> {
+  int       source = 0;
+  long long value  = 0;
+  char      payload[48];     //A typical small log record
+};
+
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now()-start).count();
+}
+
+
+void report(const char* title, int events, double seconds, bool ok) {
+  std::cout << title << seconds << "s (" << events/seconds/1e6 << "M events/s) "
+            << (ok ? "ok" : "WRONG SUM") << std::endl;
+}
+
+
+//Enqueue/dequeue in bursts of 64 so the queue is never long (like a real event loop)
+void single_thread(std::vector<Event>& pool, long long expected) {
+  int n = pool.size();
+  {
+    ics::LinkedQueue<Event> q;
+    long long sum = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < n; i += 64) {
+      for (int j = i; j < i+64 && j < n; ++j)
+        q.enqueue(pool[j]);
+      while (!q.empty())
+        sum += q.dequeue().value;
+    }
+    report("LinkedQueue<Event>         ", n, seconds_since(start), sum == expected);
+  }
+  {
+    ics::IntrusiveQueue<Event> q;
+    long long sum = 0;
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < n; i += 64) {
+      for (int j = i; j < i+64 && j < n; ++j)
+        q.enqueue(pool[j]);
+      while (!q.empty())
+        sum += q.dequeue().value;
+    }
+    report("IntrusiveQueue<Event>      ", n, seconds_since(start), sum == expected);
+  }
+}
+
+
+//Each producer owns pool[p], pool[p+producers], ...
+template<class Push, class Pop>
+void aggregate(const char* title, std::vector<Event>& pool, int producers, long long expected, Push push, Pop pop) {
+  int n = pool.size();
+  std::vector<long long> per_source(producers, 0);
+  Clock::time_point start = Clock::now();
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p)
+    threads.push_back(std::thread([&pool,&push,p,producers,n] () {
+      for (int i = p; i < n; i += producers)
+        push(pool[i]);
+    }));
+
+  long long sum = 0;
+  for (int received = 0; received < n; ) {
+    Event* e = pop();
+    if (e == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    per_source[e->source] += e->value;
+    sum += e->value;
+    ++received;
+  }
+  for (std::thread& t : threads)
+    t.join();
+  report(title, n, seconds_since(start), sum == expected);
+}
+
+
+int main(int argc, char* argv[]) {
+  int n         = argc > 1 ? std::atoi(argv[1]) : 2000000;
+  int producers = argc > 2 ? std::atoi(argv[2]) : 4;
+
+  std::vector<Event> pool(n);
+  long long expected = 0;
+  for (int i = 0; i < n; ++i) {
+    pool[i].source = i % producers;
+    pool[i].value  = i;
+    expected += i;
+  }
+
+  std::cout << "single thread, " << n << " events" << std::endl;
+  single_thread(pool, expected);
+
+  std::cout << producers << " producers -> 1 consumer, " << n << " events" << std::endl;
+  {
+    std::mutex lock;
+    ics::LinkedQueue<Event*> q;
+    aggregate("mutex + LinkedQueue<Event*>", pool, producers, expected,
+              [&] (Event& e) {std::lock_guard<std::mutex> guard(lock); q.enqueue(&e);},
+              [&] () -> Event* {std::lock_guard<std::mutex> guard(lock); return q.empty() ? nullptr : q.dequeue();});
+  }
+  {
+    ics::MPSCQueue<Event> q;
+    aggregate("MPSCQueue<Event>           ", pool, producers, expected,
+              [&] (Event& e) {q.enqueue(e);},
+              [&] () {return q.dequeue();});
+  }
+  return 0;
+}
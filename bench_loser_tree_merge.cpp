@@ -0,0 +1,95 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//k-way merge of k sorted runs (n values in all), two ways:
+//  heap       : a HeapPriorityQueue of (value, run) pairs: dequeue the smallest, enqueue the
+//               next value from its run (the usual way, ~2 Log2 k comparisons per value)
+//  loser tree : LoserTreeMerge over the runs (Log2 k comparisons per value)
+//Reports ns and comparisons per value; the merged outputs must be identical.
+//
+//Usage: bench_loser_tree_merge [n (default 4000000)]
+//Build: g++ -std=gnu++11 -O2 -I. -Iprogram3/src -I<courselib> bench_loser_tree_merge.cpp
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include "heap_priority_queue.hpp"
+#include "loser_tree_merge.hpp"
+
+
+long comparisons = 0;
+
+struct Head {
+  int value;
+  int run;
+};
+
+//Both come out smallest first; ties by run, so both merges are stable and must agree
+bool head_gt (const Head& a, const Head& b) {++comparisons; return a.value < b.value || (a.value == b.value && a.run < b.run);}
+bool int_lt  (const int& a, const int& b)   {++comparisons; return a < b;}
+
+
+std::vector<std::vector<int>> make_runs(int n, int k) {
+  std::mt19937 random(46);
+  std::vector<std::vector<int>> runs(k);
+  for (int i = 0; i < n; ++i)
+    runs[random() % k].push_back(random() % 1000000);
+  for (std::vector<int>& r : runs)
+    std::sort(r.begin(), r.end());
+  return runs;
+}
+
+
+double merge_heap(const std::vector<std::vector<int>>& runs, std::vector<int>& out) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<int> next(runs.size(), 0);
+  ics::HeapPriorityQueue<Head,head_gt> pq;
+  for (int r = 0; r < int(runs.size()); ++r)
+    if (!runs[r].empty())
+      pq.enqueue(Head{runs[r][next[r]++], r});
+  while (!pq.empty()) {
+    Head h = pq.dequeue();
+    out.push_back(h.value);
+    if (next[h.run] < int(runs[h.run].size()))
+      pq.enqueue(Head{runs[h.run][next[h.run]++], h.run});
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+
+double merge_loser_tree(const std::vector<std::vector<int>>& runs, std::vector<int>& out) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  ics::LoserTreeMerge<int,int_lt> merge;
+  for (const std::vector<int>& r : runs)
+    merge.add_all(r);
+  for (int v : merge)
+    out.push_back(v);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+
+int main(int argc, char* argv[]) {
+  int n = argc > 1 ? std::atoi(argv[1]) : 4000000;
+
+  for (int k : {4, 16, 64, 256, 1024}) {
+    std::vector<std::vector<int>> runs = make_runs(n, k);
+    std::vector<int> heap_out, tree_out;
+    heap_out.reserve(n);
+    tree_out.reserve(n);
+
+    comparisons = 0;
+    double heap_seconds = merge_heap(runs, heap_out);
+    double heap_compares = double(comparisons)/n;
+    comparisons = 0;
+    double tree_seconds = merge_loser_tree(runs, tree_out);
+    double tree_compares = double(comparisons)/n;
+
+    std::cout << "k=" << k << ": heap " << heap_seconds/n*1e9 << "ns " << heap_compares << " compares/value, "
+              << "loser tree " << tree_seconds/n*1e9 << "ns " << tree_compares << " compares/value ("
+              << heap_seconds/tree_seconds << "x) " << (heap_out == tree_out ? "same output" : "DIFFERENT OUTPUT") << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,122 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//A bounded priority queue: at most capacity jobs are kept; enqueueing into a full queue evicts
+//  the lowest priority job. Random enqueues (and a dequeue of the highest after every few) are
+//  timed two ways:
+//  min-max  : one MinMaxHeap (dequeue_lowest evicts)
+//  two heaps: a HeapPriorityQueue for each end, with lazy deletion (a job removed from one heap
+//             is marked, and skipped when it later reaches the top of the other)
+//The two must dequeue and evict the same sequences of priorities.
+//
+//Usage: bench_min_max_heap [ops (default 2000000)] [capacity (default both 100 and 10000)]
+//Build: g++ -std=gnu++11 -O2 -I. -Iprogram3/src -I<courselib> bench_min_max_heap.cpp
+
+#include <iostream>
+#include <vector>
+#include <initializer_list>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include "heap_priority_queue.hpp"
+#include "min_max_heap.hpp"
+
+
+struct Job {
+  int priority;
+  int id;
+};
+
+bool job_gt (const Job& a, const Job& b) {return a.priority > b.priority || (a.priority == b.priority && a.id < b.id);}
+bool job_lt (const Job& a, const Job& b) {return job_gt(b, a);}
+
+
+class MinMaxBounded {
+  public:
+    explicit MinMaxBounded(int capacity) : capacity(capacity) {}
+    void enqueue(const Job& j, std::vector<int>& evicted) {
+      heap.enqueue(j);
+      if (heap.size() > capacity)
+        evicted.push_back(heap.dequeue_lowest().priority);
+    }
+    int dequeue() {return heap.dequeue().priority;}
+  private:
+    int                         capacity;
+    ics::MinMaxHeap<Job,job_gt> heap;
+};
+
+
+class TwoHeapBounded {
+  public:
+    explicit TwoHeapBounded(int capacity) : capacity(capacity) {}
+    void enqueue(const Job& j, std::vector<int>& evicted) {
+      highest.enqueue(j);
+      lowest.enqueue(j);
+      removed.push_back(false);
+      if (++size > capacity)
+        evicted.push_back(pop(lowest).priority);
+    }
+    int dequeue() {return pop(highest).priority;}
+  private:
+    template<class Heap>
+    Job pop(Heap& h) {
+      for (;;) {
+        Job j = h.dequeue();
+        if (!removed[j.id]) {
+          removed[j.id] = true;
+          --size;
+          return j;
+        }
+      }
+    }
+
+    int                                 capacity;
+    int                                 size = 0;
+    std::vector<bool>                   removed;     //Indexed by Job::id
+    ics::HeapPriorityQueue<Job,job_gt>  highest;
+    ics::HeapPriorityQueue<Job,job_lt>  lowest;
+};
+
+
+template<class Bounded>
+double run(const std::vector<int>& priorities, int capacity, std::vector<int>& dequeued, std::vector<int>& evicted) {
+  Bounded q(capacity);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < int(priorities.size()); ++i) {
+    q.enqueue(Job{priorities[i], i}, evicted);
+    if (i % 4 == 3)
+      dequeued.push_back(q.dequeue());
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  return seconds / priorities.size() * 1e9;
+}
+
+
+//Both ways with this capacity, over ops random priorities
+void compare(int ops, int capacity) {
+  std::vector<int> priorities(ops);
+  std::mt19937 random(46);
+  for (int& p : priorities)
+    p = random() % 1000000;
+
+  std::vector<int> min_max_dequeued, min_max_evicted, two_dequeued, two_evicted;
+  double min_max = run<MinMaxBounded> (priorities, capacity, min_max_dequeued, min_max_evicted);
+  double two     = run<TwoHeapBounded>(priorities, capacity, two_dequeued,     two_evicted);
+
+  std::cout << ops << " bounded enqueues (capacity " << capacity << ", " << min_max_evicted.size() << " evictions):" << std::endl
+            << "  min-max   " << min_max << "ns" << std::endl
+            << "  two heaps " << two << "ns (" << two/min_max << "x) "
+            << (min_max_dequeued == two_dequeued && min_max_evicted == two_evicted ? "same results" : "DIFFERENT RESULTS") << std::endl;
+}
+
+
+int main(int argc, char* argv[]) {
+  int ops = argc > 1 ? std::atoi(argv[1]) : 2000000;
+
+  if (argc > 2)
+    compare(ops, std::atoi(argv[2]));
+  else
+    for (int capacity : {100, 10000})
+      compare(ops, capacity);
+  return 0;
+}
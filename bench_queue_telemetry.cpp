@@ -0,0 +1,98 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Queue telemetry under load: a producer thread enqueues in bursts, a consumer thread dequeues
+//  with a fixed service time, and a monitor thread prints a telemetry snapshot every interval
+//  (without stopping either of them). Then the cost of telemetry itself is measured.
+//
+//Usage: bench_queue_telemetry [seconds (default 1)] [service us (default 2)]
+//Build: g++ -std=gnu++11 -O2 -pthread -I. -I<courselib> bench_queue_telemetry.cpp
+
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include "linked_queue.hpp"
+#include "queue_telemetry.hpp"
+
+
+typedef ics::TelemetryQueue<ics::LinkedQueue<int>> Queue;
+
+
+void spin_for_us(double us) {
+  std::int64_t until = ics::QueueTelemetry::now_ns() + std::int64_t(us*1000);
+  while (ics::QueueTelemetry::now_ns() < until)
+    ;
+}
+
+
+double time_ops(Queue& q, int n) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (int i = 0; i < n; i += 64) {
+    for (int j = 0; j < 64; ++j)
+      q.enqueue(j);
+    while (!q.empty())
+      q.dequeue();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count() / (2.0*n) * 1e9;
+}
+
+
+int main(int argc, char* argv[]) {
+  double seconds    = argc > 1 ? std::atof(argv[1]) : 1;
+  double service_us = argc > 2 ? std::atof(argv[2]) : 2;
+
+  ics::QueueTelemetry telemetry;
+  Queue              q(&telemetry);
+  std::mutex         lock;
+  std::atomic<bool>  done(false);
+
+  std::thread producer([&] () {
+    for (int burst = 0; !done.load(); ++burst) {
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        for (int i = 0; i < (burst % 10 == 0 ? 500 : 20); ++i)
+          q.enqueue(i);
+      }
+      spin_for_us(50);
+    }
+  });
+
+  std::thread consumer([&] () {
+    while (!done.load()) {
+      bool got;
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        got = !q.empty();
+        if (got)
+          q.dequeue();
+      }
+      if (got)
+        spin_for_us(service_us);
+      else
+        std::this_thread::yield();
+    }
+  });
+
+  //The monitor reads telemetry without taking the queue's lock
+  ics::QueueTelemetry::Snapshot previous = telemetry.snapshot();
+  for (int tick = 0; tick < 5; ++tick) {
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds/5));
+    ics::QueueTelemetry::Snapshot now = telemetry.snapshot();
+    std::cout << now.since(previous).str() << std::endl;
+    previous = now;
+  }
+  done.store(true);
+  producer.join();
+  consumer.join();
+  std::cout << "total: " << telemetry.snapshot().str() << std::endl;
+
+  const int n = 4000000;
+  ics::QueueTelemetry quiet;
+  Queue plain(nullptr), measured(&quiet);
+  std::cout << "per operation: telemetry off " << time_ops(plain, n) << "ns, on "
+            << time_ops(measured, n) << "ns" << std::endl;
+  return 0;
+}
@@ -0,0 +1,103 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Sets of dense integer ids (n ids drawn from a range of 2n, so about half are present) as a
+//  HashSet<int> and as a RoaringSet<int>: the time to build each set, look up n random ids,
+//  and intersect/unite two such sets (retain_all/insert_all on a copy), plus the memory each
+//  set uses (the HashSet's counted by its allocator; the RoaringSet's by bytes()).
+//Both kinds of set must agree on every count.
+//
+//Usage: bench_roaring_set [n (default 1000000)]
+//Build: g++ -std=gnu++11 -O2 -I. -Iprogram4/src -I<courselib> bench_roaring_set.cpp
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+#include "hash_set.hpp"
+#include "roaring_set.hpp"
+
+
+long allocated = 0;   //Bytes currently allocated through CountingAllocator
+
+template<class T> class CountingAllocator {
+  public:
+    typedef T value_type;
+
+    CountingAllocator () = default;
+    template<class U> CountingAllocator (const CountingAllocator<U>&) {}
+
+    T* allocate (std::size_t n) {
+      allocated += n*sizeof(T);
+      return static_cast<T*>(::operator new(n*sizeof(T)));
+    }
+
+    void deallocate (T* p, std::size_t n) {
+      allocated -= n*sizeof(T);
+      ::operator delete(p);
+    }
+
+    template<class U> bool operator == (const CountingAllocator<U>&) const {return true;}
+    template<class U> bool operator != (const CountingAllocator<U>&) const {return false;}
+};
+
+
+int hash_int(const int& i) {std::hash<int> int_hash; return int_hash(i);}
+
+typedef ics::HashSet<int,hash_int,CountingAllocator<int>> HashSetType;
+typedef ics::RoaringSet<int>                              RoaringSetType;
+
+
+//Memory a set uses: what its allocator allocated, or what it reports
+long footprint(const HashSetType&,    long heap) {return heap;}
+long footprint(const RoaringSetType& s, long)    {return s.bytes();}
+
+
+template<class Work>
+double seconds(Work work) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  work();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+}
+
+
+template<class SetType>
+void run(const char* title, const std::vector<int>& ids_a, const std::vector<int>& ids_b, const std::vector<int>& probes) {
+  SetType a, b;
+  long    before = allocated;
+  double  build  = seconds([&] () {a.insert_all(ids_a);});
+  long    heap   = allocated - before;
+  b.insert_all(ids_b);
+
+  int    found  = 0;
+  double lookup = seconds([&] () {for (int p : probes) found += a.contains(p);});
+
+  SetType both(a), either(a);
+  double intersect = seconds([&] () {both.retain_all(b);});
+  double unite     = seconds([&] () {either.insert_all(b);});
+
+  std::cout << title << ": build " << ids_a.size()/build/1e6 << "M/s, contains " << probes.size()/lookup/1e6 << "M/s, "
+            << "retain_all " << intersect*1e3 << "ms, insert_all " << unite*1e3 << "ms" << std::endl
+            << "        size " << a.size() << " (found " << found << ", both " << both.size() << ", either " << either.size() << "), "
+            << double(footprint(a,heap))/a.size() << " bytes/element" << std::endl;
+}
+
+
+int main(int argc, char* argv[]) {
+  int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+  std::mt19937 random(46);
+  std::uniform_int_distribution<int> id(0, 2*n-1);
+  std::vector<int> ids_a(n), ids_b(n), probes(n);
+  for (int i = 0; i < n; ++i) {
+    ids_a[i]  = id(random);
+    ids_b[i]  = id(random);
+    probes[i] = id(random);
+  }
+
+  run<HashSetType>("hash   ", ids_a, ids_b, probes);
+  run<RoaringSetType>("roaring", ids_a, ids_b, probes);
+  return 0;
+}
@@ -0,0 +1,100 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Stable (FIFO among equal priorities) heaps: the cost of stability. A steady-state scheduler
+//  loop (keep about depth values queued, dequeue one and enqueue one) with few distinct
+//  priorities, so most comparisons are ties, three ways:
+//  unstable  : HeapPriorityQueue (ties come out in no particular order)
+//  stable    : StableHeapPriorityQueue (a sequence number stored beside each value)
+//  workaround: HeapPriorityQueue over (priority, sequence) values with a two-field gt
+//Both stable versions are checked to dequeue equal priorities in enqueue order.
+//
+//Usage: bench_stable_heap [ops (default 2000000)] [depth (default 10000)] [priorities (default both 8 and 64)]
+//Build: g++ -std=gnu++11 -O2 -I. -Iprogram3/src -I<courselib> bench_stable_heap.cpp
+
+#include <iostream>
+#include <vector>
+#include <initializer_list>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include "heap_priority_queue.hpp"
+
+
+struct Job {
+  int  priority;
+  long id;                //Enqueue order; not compared by job_gt
+};
+
+struct SequencedJob {
+  Job  job;
+  long sequence;          //The workaround: the caller numbers the values itself
+};
+
+bool job_gt       (const Job& a, const Job& b)                   {return a.priority > b.priority;}
+bool sequenced_gt (const SequencedJob& a, const SequencedJob& b) {return a.job.priority > b.job.priority ||
+                                                                         (a.job.priority == b.job.priority && a.sequence < b.sequence);}
+
+Job          unwrap (const Job& j)          {return j;}
+Job          unwrap (const SequencedJob& j) {return j.job;}
+void         wrap   (Job& to, const Job& j, long)                   {to = j;}
+void         wrap   (SequencedJob& to, const Job& j, long sequence) {to.job = j; to.sequence = sequence;}
+
+
+//Returns ns per dequeue+enqueue; fifo is set false if equal priorities come out of enqueue order
+template<class Queue, class Value>
+double run(const std::vector<int>& priorities, int depth, bool& fifo) {
+  Queue q;
+  Value v;
+  long  id = 0;
+  for (int i = 0; i < depth; ++i, ++id) {
+    wrap(v, Job{priorities[i], id}, id);
+    q.enqueue(v);
+  }
+
+  std::vector<long> last_id(priorities.size(), -1);   //Per priority: the id last dequeued
+  fifo = true;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (std::size_t i = depth; i < priorities.size(); ++i, ++id) {
+    Job j = unwrap(q.dequeue());
+    if (j.id < last_id[j.priority])
+      fifo = false;
+    last_id[j.priority] = j.id;
+    wrap(v, Job{priorities[i], id}, id);
+    q.enqueue(v);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  return seconds / (priorities.size()-depth) * 1e9;
+}
+
+
+//One line per variant, for ops dequeue+enqueue at this depth with this many priorities
+void compare(int ops, int depth, int priorities) {
+  std::vector<int> job_priorities(ops+depth);
+  std::mt19937 random(46);
+  for (int& p : job_priorities)
+    p = random() % priorities;
+
+  bool unstable_fifo, stable_fifo, workaround_fifo;
+  double unstable   = run<ics::HeapPriorityQueue<Job,job_gt>,                 Job>         (job_priorities, depth, unstable_fifo);
+  double stable     = run<ics::StableHeapPriorityQueue<Job,job_gt>,           Job>         (job_priorities, depth, stable_fifo);
+  double workaround = run<ics::HeapPriorityQueue<SequencedJob,sequenced_gt>,  SequencedJob>(job_priorities, depth, workaround_fifo);
+
+  std::cout << priorities << " priorities, depth " << depth << ", " << ops << " dequeue+enqueue:" << std::endl
+            << "  unstable   " << unstable   << "ns " << (unstable_fifo   ? "(happened to be fifo)" : "(not fifo)") << std::endl
+            << "  stable     " << stable     << "ns (" << stable/unstable     << "x) " << (stable_fifo     ? "fifo" : "NOT FIFO") << std::endl
+            << "  workaround " << workaround << "ns (" << workaround/unstable << "x) " << (workaround_fifo ? "fifo" : "NOT FIFO") << std::endl;
+}
+
+
+int main(int argc, char* argv[]) {
+  int ops   = argc > 1 ? std::atoi(argv[1]) : 2000000;
+  int depth = argc > 2 ? std::atoi(argv[2]) : 10000;
+
+  if (argc > 3)
+    compare(ops, depth, std::atoi(argv[3]));
+  else
+    for (int priorities : {8, 64})
+      compare(ops, depth, priorities);
+  return 0;
+}
@@ -0,0 +1,68 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//A reconciliation loop over a string->string map of n entries: each round checks has_value for
+//  a few values (present and absent) and then puts or erases an entry. Runs it on a HashMap and
+//  a BSTMap, each without and with index_values, which must all count the same values found.
+//  Reports rounds/s and the value index's memory (bytes, and bytes per entry).
+//
+//Usage: bench_value_index [n (default 100000)] [rounds (default 2000)]
+//Build: g++ -std=gnu++11 -O2 -I. -Iprogram4/src -Iprogram3/src -I<courselib> bench_value_index.cpp
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <cstdlib>
+#include "hash_map.hpp"
+#include "bst_map.hpp"
+
+
+int  hash_string(const std::string& s) {std::hash<std::string> str_hash; return str_hash(s);}
+bool lt_string  (const std::string& a, const std::string& b) {return a < b;}
+
+typedef ics::HashMap<std::string,std::string,hash_string> HashMapType;
+typedef ics::BSTMap <std::string,std::string,lt_string>   BSTMapType;
+
+
+template<class Map>
+void run(const char* title, int n, int rounds, bool indexed) {
+  std::mt19937 random(46);    //The same keys, values, and rounds for every map
+  std::uniform_int_distribution<int> key(0, n-1), value(0, n/2);   //About 2 keys per value
+  Map m;
+  for (int i = 0; i < n; ++i)
+    m.put("k" + std::to_string(key(random)), "v" + std::to_string(value(random)));
+  if (indexed)
+    m.index_values(hash_string);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  int found = 0;
+  for (int r = 0; r < rounds; ++r) {
+    for (int probe = 0; probe < 4; ++probe)
+      found += m.has_value("v" + std::to_string(value(random) + (probe == 3 ? n : 0)));  //1 in 4 absent
+    std::string k = "k" + std::to_string(key(random));
+    if (r % 2 == 0)
+      m.put(k, "v" + std::to_string(value(random)));   //not m[k] = ...: a T& from operator [] stops indexing
+    else if (m.has_key(k))
+      m.erase(k);
+  }
+  double s = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  std::cout << title << ": " << rounds/s << " rounds/s (found " << found << ")";
+  if (indexed)
+    std::cout << ", index " << m.value_index_bytes() << " bytes (" << double(m.value_index_bytes())/m.size() << "/entry)";
+  std::cout << std::endl;
+}
+
+
+int main(int argc, char* argv[]) {
+  int n      = argc > 1 ? std::atoi(argv[1]) : 100000;
+  int rounds = argc > 2 ? std::atoi(argv[2]) : 2000;
+
+  run<HashMapType>("HashMap scan   ", n, rounds, false);
+  run<HashMapType>("HashMap indexed", n, rounds, true);
+  run<BSTMapType> ("BSTMap  scan   ", n, rounds, false);
+  run<BSTMapType> ("BSTMap  indexed", n, rounds, true);
+  return 0;
+}
@@ -0,0 +1,264 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Fork-join benchmark: a WorkStealingPool against a pool whose workers all share one
+//  mutex-protected LinkedQueue (how a thread pool over our queues would look without stealing).
+//
+//  heapify: parallel bottom-up heap construction. Both subtrees of a node are independent
+//           heaps, so heapify(i) forks heapify(left), does heapify(right) itself, joins, and
+//           percolates i down (sequential below a cutoff). The result is checked.
+//  tree   : a fine-grained binary fork tree (one tiny task per leaf), which stresses the
+//           scheduler itself rather than the memory system.
+//
+//Usage: bench_work_stealing [elements (default 4000000)] [max threads (default 8)]
+//Build: g++ -std=gnu++11 -O2 -pthread -I. -I<courselib> bench_work_stealing.cpp
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include "linked_queue.hpp"
+#include "work_stealing_pool.hpp"
+
+
+//The baseline: every submit and every take goes through the same lock
+class SharedQueuePool {
+  public:
+    typedef std::function<void()> Task;
+
+    ~SharedQueuePool() {
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        wake.notify_all();
+      }
+      for (std::thread& t : threads)
+        t.join();
+    }
+
+    explicit SharedQueuePool(int n) {
+      for (int i = 0; i < n; ++i)
+        threads.push_back(std::thread([this] () {
+          for (;;) {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [this] () {return stopping || !tasks.empty();});
+            if (tasks.empty())
+              return;
+            Task* t = tasks.dequeue();
+            guard.unlock();
+            (*t)();
+            delete t;
+          }
+        }));
+    }
+
+    void submit(const Task& task) {
+      std::lock_guard<std::mutex> guard(lock);
+      tasks.enqueue(new Task(task));
+      wake.notify_one();
+    }
+
+    bool run_one() {
+      std::unique_lock<std::mutex> guard(lock);
+      if (tasks.empty())
+        return false;
+      Task* t = tasks.dequeue();
+      guard.unlock();
+      (*t)();
+      delete t;
+      return true;
+    }
+
+  private:
+    std::vector<std::thread>  threads;
+    std::mutex                lock;
+    std::condition_variable   wake;
+    ics::LinkedQueue<Task*>   tasks;
+    bool                      stopping = false;
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Workloads
+
+const int heapify_cutoff = 1 << 14;     //Subtrees at most this big are heapified sequentially
+const int tree_grain     = 256;         //Loop iterations per leaf of the fork tree
+
+
+void percolate_down(std::vector<int>& h, int i) {
+  int n = h.size();
+  int value = h[i];
+  for (int child = 2*i+1; child < n; child = 2*i+1) {
+    if (child+1 < n && h[child+1] > h[child])
+      ++child;
+    if (h[child] <= value)
+      break;
+    h[i] = h[child];
+    i = child;
+  }
+  h[i] = value;
+}
+
+
+//Number of nodes in the subtree rooted at i (for the cutoff)
+long long subtree_size(int n, int i) {
+  long long size = 0;
+  for (long long first = i, width = 1; first < n; first = 2*first+1, width *= 2)
+    size += std::min<long long>(width, n-first);
+  return size;
+}
+
+
+void sequential_heapify(std::vector<int>& h, int i) {
+  if (i >= int(h.size()))
+    return;
+  sequential_heapify(h, 2*i+1);
+  sequential_heapify(h, 2*i+2);
+  percolate_down(h, i);
+}
+
+
+template<class Pool>
+void parallel_heapify(Pool& pool, std::vector<int>& h, int i) {
+  if (subtree_size(h.size(), i) <= heapify_cutoff) {
+    sequential_heapify(h, i);
+    return;
+  }
+  ics::TaskGroup<Pool> children(pool);
+  children.run([&pool,&h,i] () {parallel_heapify(pool, h, 2*i+1);});
+  parallel_heapify(pool, h, 2*i+2);
+  children.wait();
+  percolate_down(h, i);
+}
+
+
+bool is_heap(const std::vector<int>& h) {
+  for (int i = 1; i < int(h.size()); ++i)
+    if (h[(i-1)/2] < h[i])
+      return false;
+  return true;
+}
+
+
+template<class Pool>
+void fork_tree(Pool& pool, int low, int high, std::atomic<long long>& sum) {
+  if (high - low <= tree_grain) {
+    long long local = 0;
+    for (int i = low; i < high; ++i)
+      local += (i * 2654435761u) >> 16;
+    sum.fetch_add(local, std::memory_order_relaxed);
+    return;
+  }
+  int mid = low + (high-low)/2;
+  ics::TaskGroup<Pool> children(pool);
+  children.run([&pool,low,mid,&sum] () {fork_tree(pool, low, mid, sum);});
+  fork_tree(pool, mid, high, sum);
+  children.wait();
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Timing
+
+typedef std::chrono::steady_clock Clock;
+
+double seconds_since(Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now()-start).count();
+}
+
+
+//The root task is submitted from main (an outside thread), like a real caller would
+template<class Pool>
+double time_heapify(Pool& pool, const std::vector<int>& input, bool& ok) {
+  std::vector<int> h(input);
+  Clock::time_point start = Clock::now();
+  {
+    ics::TaskGroup<Pool> root(pool);
+    root.run([&pool,&h] () {parallel_heapify(pool, h, 0);});
+    root.wait();
+  }
+  double answer = seconds_since(start);
+  ok = ok && is_heap(h);
+  return answer;
+}
+
+
+template<class Pool>
+double time_tree(Pool& pool, int n, long long expected, bool& ok) {
+  std::atomic<long long> sum(0);
+  Clock::time_point start = Clock::now();
+  {
+    ics::TaskGroup<Pool> root(pool);
+    root.run([&pool,n,&sum] () {fork_tree(pool, 0, n, sum);});
+    root.wait();
+  }
+  double answer = seconds_since(start);
+  ok = ok && sum.load() == expected;
+  return answer;
+}
+
+
+int main(int argc, char* argv[]) {
+  int n           = argc > 1 ? std::atoi(argv[1]) : 4000000;
+  int max_threads = argc > 2 ? std::atoi(argv[2]) : 8;
+
+  std::vector<int> input(n);
+  std::mt19937 random(46);
+  for (int& x : input)
+    x = random();
+
+  long long expected = 0;
+  for (int i = 0; i < n; ++i)
+    expected += (i * 2654435761u) >> 16;
+
+  std::cout << "elements=" << n << "  hardware threads=" << std::thread::hardware_concurrency() << std::endl;
+  std::cout << std::left << std::setw(8) << "threads"
+            << std::setw(14) << "heap:shared" << std::setw(14) << "heap:steal" << std::setw(10) << "speedup"
+            << std::setw(14) << "tree:shared" << std::setw(14) << "tree:steal" << std::setw(10) << "speedup"
+            << "steals" << std::endl;
+
+  bool ok = true;
+  double heap_base = 0, tree_base = 0;
+  for (int threads = 1; threads <= max_threads; threads *= 2) {
+    double heap_shared, tree_shared, heap_steal, tree_steal;
+    long long steals;
+    {
+      SharedQueuePool pool(threads);
+      heap_shared = time_heapify(pool, input, ok);
+      tree_shared = time_tree(pool, n, expected, ok);
+    }
+    {
+      ics::WorkStealingPool pool(threads);
+      heap_steal = time_heapify(pool, input, ok);
+      tree_steal = time_tree(pool, n, expected, ok);
+      steals = pool.steals();
+    }
+    if (threads == 1) {
+      heap_base = heap_steal;
+      tree_base = tree_steal;
+    }
+    std::cout << std::fixed << std::setprecision(4) << std::setw(8) << threads
+              << std::setw(14) << heap_shared << std::setw(14) << heap_steal
+              << std::setprecision(2) << std::setw(10) << heap_base/heap_steal
+              << std::setprecision(4) << std::setw(14) << tree_shared << std::setw(14) << tree_steal
+              << std::setprecision(2) << std::setw(10) << tree_base/tree_steal
+              << steals << std::endl;
+  }
+
+  std::cout << (ok ? "all results verified" : "WRONG RESULT") << std::endl;
+  return ok ? 0 : 1;
+}
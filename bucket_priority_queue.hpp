@@ -0,0 +1,624 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+#ifndef BUCKET_PRIORITY_QUEUE_HPP_
+#define BUCKET_PRIORITY_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>             //For std::allocator/std::allocator_traits
+#if __cplusplus >= 201703L
+#include <memory_resource>    //For std::pmr::polymorphic_allocator
+#endif
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//A priority queue for values whose priority is one of a few discrete classes: 0 (lowest) to
+//  Classes-1 (highest), Classes <= 64. Each class is a FIFO linked list (front/rear, as in
+//  LinkedQueue), and one 64-bit word has bit c set iff class c is non-empty, so the highest
+//  non-empty class is one count-leading-zeros instruction away: enqueue, dequeue, and peek are
+//  all O(1), not HeapPriorityQueue's O(Log N). Values of the same class are dequeued in the
+//  order they were enqueued (stable).
+//Dequeued nodes go on a free list shared by all classes and are reused by later enqueues, so a
+//  queue at a steady depth stops allocating; clear and the destructor give them all back.
+//Instantiate the templated class supplying tpriority(a): a's class (0 <= class < Classes).
+//If tpriority is defaulted to nullptr in the template, then a constructor must supply cpriority.
+//If both tpriority and cpriority are supplied, then they must be the same (by ==) function.
+//If neither is supplied, or both are supplied but different, TemplateFunctionError is raised
+//  (by the first enqueue that needs it: enqueue(v,c) names v's class c itself, so a queue that
+//  only uses it needs no priority function); a class out of range raises IcsError.
+//Alloc is any std::allocator-compatible allocator of T; it is rebound to allocate the nodes.
+template<class T, int (*tpriority)(const T& a) = nullptr, int Classes = 64, class Alloc = std::allocator<T>> class BucketPriorityQueue {
+  public:
+    static_assert(0 < Classes && Classes <= 64, "BucketPriorityQueue: Classes must be in [1,64]");
+
+    //Destructor/Constructors
+    ~BucketPriorityQueue();
+
+    BucketPriorityQueue          (int (*cpriority)(const T& a) = nullptr, const Alloc& alloc = Alloc());
+    BucketPriorityQueue          (const BucketPriorityQueue<T,tpriority,Classes,Alloc>& to_copy);
+    explicit BucketPriorityQueue (const std::initializer_list<T>& il, int (*cpriority)(const T& a) = nullptr, const Alloc& alloc = Alloc());
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit BucketPriorityQueue (const Iterable& i, int (*cpriority)(const T& a) = nullptr, const Alloc& alloc = Alloc());
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    int  size       (int priority_class) const;   //Values in one class
+    int  top_class  () const;                     //Class of peek(); -1 if empty
+    T&   peek       () const;
+    Alloc get_allocator () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue (const T& element);
+    int  enqueue (const T& element, int priority_class);
+    T    dequeue ();
+    void clear   ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    BucketPriorityQueue<T,tpriority,Classes,Alloc>& operator = (const BucketPriorityQueue<T,tpriority,Classes,Alloc>& rhs);
+    bool operator == (const BucketPriorityQueue<T,tpriority,Classes,Alloc>& rhs) const;
+    bool operator != (const BucketPriorityQueue<T,tpriority,Classes,Alloc>& rhs) const;
+
+    template<class T2, int (*tpriority2)(const T2& a), int Classes2, class Alloc2>
+    friend std::ostream& operator << (std::ostream& outs, const BucketPriorityQueue<T2,tpriority2,Classes2,Alloc2>& pq);
+
+
+
+  private:
+    class LN;
+
+  public:
+    //Iterates in dequeue order: highest class first, FIFO within a class
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of BucketPriorityQueue
+        ~Iterator();
+        T           erase();
+        std::string str  () const;
+        Iterator& operator ++ ();
+        Iterator  operator ++ (int);
+        bool operator == (const Iterator& rhs) const;
+        bool operator != (const Iterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+
+        friend Iterator BucketPriorityQueue<T,tpriority,Classes,Alloc>::begin () const;
+        friend Iterator BucketPriorityQueue<T,tpriority,Classes,Alloc>::end   () const;
+
+      private:
+        //If can_erase is false, current indexes the "next" value (must ++ to reach it)
+        BucketPriorityQueue<T,tpriority,Classes,Alloc>* ref_pq;
+        int  current_class;              //-1 at the end
+        LN*  prev    = nullptr;          //if nullptr, current at front of its class
+        LN*  current = nullptr;          //current == prev->next (if prev != nullptr)
+        int  expected_mod_count;
+        bool can_erase = true;
+
+        //Called in friends begin/end
+        Iterator(BucketPriorityQueue<T,tpriority,Classes,Alloc>* iterate_over, int initial_class);
+
+        void next_class ();              //When current runs off the end of its class
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    class LN {
+      public:
+        LN (const T& v) : value(v) {}
+
+        T   value;
+        LN* next = nullptr;
+    };
+
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<LN> NodeAlloc;
+    typedef std::allocator_traits<NodeAlloc>                                 NodeTraits;
+
+    int (*priority_of) (const T& a);      //The priority function (from template or constructor)
+    NodeAlloc     node_alloc;             //Allocates every LN (see new_node/delete_node)
+    LN*           front[Classes];         //front[c]/rear[c]: class c's FIFO (nullptr if empty)
+    LN*           rear [Classes];
+    int           class_used[Classes];
+    LN*           free_list  = nullptr;   //Unconstructed nodes for reuse, linked through their first bytes
+    std::uint64_t non_empty  = 0;         //Bit c is set iff class c is not empty
+    int used      = 0;
+    int mod_count = 0;                    //For sensing concurrent modification
+
+    //Helper methods
+    static int highest_class (std::uint64_t bits);   //-1 if bits == 0
+    int  class_of            (const T& element) const;
+    LN*  new_node            (const T& v);           //Reuses a free_list node if there is one
+    void delete_node         (LN* ln);               //Destroys ln's value; puts it on free_list
+    void release_nodes       ();                     //Deallocates every node (and the free list)
+    void unlink              (int c, LN* prev, LN* ln);
+};
+
+
+#if __cplusplus >= 201703L
+namespace pmr {
+  template<class T, int (*tpriority)(const T& a) = nullptr, int Classes = 64>
+  using BucketPriorityQueue = ics::BucketPriorityQueue<T,tpriority,Classes,std::pmr::polymorphic_allocator<T>>;
+}
+#endif
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//BucketPriorityQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+BucketPriorityQueue<T,tpriority,Classes,Alloc>::~BucketPriorityQueue() {
+  release_nodes();
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+BucketPriorityQueue<T,tpriority,Classes,Alloc>::BucketPriorityQueue(int (*cpriority)(const T& a), const Alloc& alloc)
+: priority_of(tpriority != nullptr ? tpriority : cpriority), node_alloc(alloc)
+{
+  if (tpriority != nullptr && cpriority != nullptr && tpriority != cpriority)
+    throw TemplateFunctionError("BucketPriorityQueue::default constructor: both specified and different");
+  for (int c = 0; c < Classes; ++c) {
+    front[c] = rear[c] = nullptr;
+    class_used[c] = 0;
+  }
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+BucketPriorityQueue<T,tpriority,Classes,Alloc>::BucketPriorityQueue(const BucketPriorityQueue<T,tpriority,Classes,Alloc>& to_copy)
+: BucketPriorityQueue(to_copy.priority_of, NodeTraits::select_on_container_copy_construction(to_copy.node_alloc))
+{
+  for (std::uint64_t bits = to_copy.non_empty; bits != 0; bits &= bits-1) {
+    int c = highest_class(bits & -bits);
+    for (LN* p = to_copy.front[c]; p != nullptr; p = p->next)
+      enqueue(p->value, c);
+  }
+  mod_count = 0;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+BucketPriorityQueue<T,tpriority,Classes,Alloc>::BucketPriorityQueue(const std::initializer_list<T>& il, int (*cpriority)(const T& a), const Alloc& alloc)
+: BucketPriorityQueue(cpriority, alloc)
+{
+  for (const T& v : il)
+    enqueue(v);
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+template<class Iterable>
+BucketPriorityQueue<T,tpriority,Classes,Alloc>::BucketPriorityQueue(const Iterable& i, int (*cpriority)(const T& a), const Alloc& alloc)
+: BucketPriorityQueue(cpriority, alloc)
+{
+  for (const T& v : i)
+    enqueue(v);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+bool BucketPriorityQueue<T,tpriority,Classes,Alloc>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+int BucketPriorityQueue<T,tpriority,Classes,Alloc>::size() const {
+  return used;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+int BucketPriorityQueue<T,tpriority,Classes,Alloc>::size(int priority_class) const {
+  if (priority_class < 0 || priority_class >= Classes)
+    throw IcsError("BucketPriorityQueue::size: class out of range");
+  return class_used[priority_class];
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+int BucketPriorityQueue<T,tpriority,Classes,Alloc>::top_class() const {
+  return highest_class(non_empty);
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+T& BucketPriorityQueue<T,tpriority,Classes,Alloc>::peek () const {
+  if (empty())
+    throw EmptyError("BucketPriorityQueue::peek");
+  return front[highest_class(non_empty)]->value;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+Alloc BucketPriorityQueue<T,tpriority,Classes,Alloc>::get_allocator() const {
+  return Alloc(node_alloc);
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+std::string BucketPriorityQueue<T,tpriority,Classes,Alloc>::str() const {
+  std::ostringstream answer;
+  answer << "BucketPriorityQueue[";
+  bool first = true;
+  for (int c = Classes-1; c >= 0; --c)
+    if (front[c] != nullptr) {
+      answer << (first ? "" : ",") << c << ":";
+      for (LN* p = front[c]; p != nullptr; p = p->next)
+        answer << p->value << (p->next == nullptr ? "" : "->");
+      first = false;
+    }
+  answer << "](used=" << used << ",non_empty=" << std::hex << non_empty << std::dec
+         << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+int BucketPriorityQueue<T,tpriority,Classes,Alloc>::enqueue(const T& element) {
+  return enqueue(element, class_of(element));
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+int BucketPriorityQueue<T,tpriority,Classes,Alloc>::enqueue(const T& element, int priority_class) {
+  if (priority_class < 0 || priority_class >= Classes)
+    throw IcsError("BucketPriorityQueue::enqueue: class out of range");
+  LN* ln = new_node(element);
+  if (rear[priority_class] == nullptr)
+    front[priority_class] = ln;
+  else
+    rear[priority_class]->next = ln;
+  rear[priority_class] = ln;
+  ++class_used[priority_class];
+  non_empty |= std::uint64_t(1) << priority_class;
+  ++used;
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+T BucketPriorityQueue<T,tpriority,Classes,Alloc>::dequeue() {
+  if (empty())
+    throw EmptyError("BucketPriorityQueue::dequeue");
+  int c = highest_class(non_empty);
+  LN* ln = front[c];
+  T answer = ln->value;
+  unlink(c, nullptr, ln);
+  delete_node(ln);
+  ++mod_count;
+  return answer;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+void BucketPriorityQueue<T,tpriority,Classes,Alloc>::clear() {
+  release_nodes();
+  ++mod_count;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+template<class Iterable>
+int BucketPriorityQueue<T,tpriority,Classes,Alloc>::enqueue_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    count += enqueue(v);
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+BucketPriorityQueue<T,tpriority,Classes,Alloc>& BucketPriorityQueue<T,tpriority,Classes,Alloc>::operator = (const BucketPriorityQueue<T,tpriority,Classes,Alloc>& rhs) {
+  if (this == &rhs)
+    return *this;
+  clear();
+  priority_of = rhs.priority_of;
+  for (std::uint64_t bits = rhs.non_empty; bits != 0; bits &= bits-1) {
+    int c = highest_class(bits & -bits);
+    for (LN* p = rhs.front[c]; p != nullptr; p = p->next)
+      enqueue(p->value, c);
+  }
+  return *this;
+}
+
+
+//Same priority function and, class by class, the same values in the same order
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+bool BucketPriorityQueue<T,tpriority,Classes,Alloc>::operator == (const BucketPriorityQueue<T,tpriority,Classes,Alloc>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (priority_of != rhs.priority_of || used != rhs.used || non_empty != rhs.non_empty)
+    return false;
+  for (std::uint64_t bits = non_empty; bits != 0; bits &= bits-1) {
+    int c = highest_class(bits & -bits);
+    if (class_used[c] != rhs.class_used[c])
+      return false;
+    for (LN *l = front[c], *r = rhs.front[c]; l != nullptr; l = l->next, r = r->next)
+      if (l->value != r->value)
+        return false;
+  }
+  return true;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+bool BucketPriorityQueue<T,tpriority,Classes,Alloc>::operator != (const BucketPriorityQueue<T,tpriority,Classes,Alloc>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+//Like HeapPriorityQueue: highest priority shown last (rightmost)
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+std::ostream& operator << (std::ostream& outs, const BucketPriorityQueue<T,tpriority,Classes,Alloc>& pq) {
+  std::vector<const T*> values;
+  for (const T& v : pq)
+    values.push_back(&v);
+  outs << "priority_queue[";
+  for (int i = int(values.size())-1; i >= 0; --i)
+    outs << *values[i] << (i == 0 ? "" : ",");
+  outs << "]:highest";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+auto BucketPriorityQueue<T,tpriority,Classes,Alloc>::begin () const -> BucketPriorityQueue<T,tpriority,Classes,Alloc>::Iterator {
+  return Iterator(const_cast<BucketPriorityQueue<T,tpriority,Classes,Alloc>*>(this), highest_class(non_empty));
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+auto BucketPriorityQueue<T,tpriority,Classes,Alloc>::end () const -> BucketPriorityQueue<T,tpriority,Classes,Alloc>::Iterator {
+  return Iterator(const_cast<BucketPriorityQueue<T,tpriority,Classes,Alloc>*>(this), -1);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+int BucketPriorityQueue<T,tpriority,Classes,Alloc>::highest_class(std::uint64_t bits) {
+  return bits == 0 ? -1 : 63 - __builtin_clzll(bits);
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+int BucketPriorityQueue<T,tpriority,Classes,Alloc>::class_of(const T& element) const {
+  if (priority_of == nullptr)
+    throw TemplateFunctionError("BucketPriorityQueue::enqueue: neither specified");
+  return priority_of(element);
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+auto BucketPriorityQueue<T,tpriority,Classes,Alloc>::new_node(const T& v) -> LN* {
+  LN* ln = free_list;
+  if (ln != nullptr)
+    free_list = *reinterpret_cast<LN**>(ln);
+  else
+    ln = NodeTraits::allocate(node_alloc, 1);
+  try {
+    NodeTraits::construct(node_alloc, ln, v);
+  } catch (...) {
+    *reinterpret_cast<LN**>(ln) = free_list;
+    free_list = ln;
+    throw;
+  }
+  return ln;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+void BucketPriorityQueue<T,tpriority,Classes,Alloc>::delete_node(LN* ln) {
+  NodeTraits::destroy(node_alloc, ln);
+  *reinterpret_cast<LN**>(ln) = free_list;
+  free_list = ln;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+void BucketPriorityQueue<T,tpriority,Classes,Alloc>::release_nodes() {
+  for (std::uint64_t bits = non_empty; bits != 0; bits &= bits-1) {
+    int c = highest_class(bits & -bits);
+    for (LN* p = front[c]; p != nullptr; ) {
+      LN* to_delete = p;
+      p = p->next;
+      NodeTraits::destroy(node_alloc, to_delete);
+      NodeTraits::deallocate(node_alloc, to_delete, 1);
+    }
+    front[c] = rear[c] = nullptr;
+    class_used[c] = 0;
+  }
+  while (free_list != nullptr) {
+    LN* to_delete = free_list;
+    free_list = *reinterpret_cast<LN**>(free_list);
+    NodeTraits::deallocate(node_alloc, to_delete, 1);
+  }
+  non_empty = 0;
+  used = 0;
+}
+
+
+//Unlink ln (== prev->next, or front[c] if prev is nullptr) from class c; the caller deletes it
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+void BucketPriorityQueue<T,tpriority,Classes,Alloc>::unlink(int c, LN* prev, LN* ln) {
+  if (prev == nullptr)
+    front[c] = ln->next;
+  else
+    prev->next = ln->next;
+  if (rear[c] == ln)
+    rear[c] = prev;
+  if (--class_used[c] == 0)
+    non_empty &= ~(std::uint64_t(1) << c);
+  --used;
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+BucketPriorityQueue<T,tpriority,Classes,Alloc>::Iterator::Iterator(BucketPriorityQueue<T,tpriority,Classes,Alloc>* iterate_over, int initial_class)
+: ref_pq(iterate_over), current_class(initial_class),
+  current(initial_class == -1 ? nullptr : iterate_over->front[initial_class]),
+  expected_mod_count(iterate_over->mod_count)
+{}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+BucketPriorityQueue<T,tpriority,Classes,Alloc>::Iterator::~Iterator()
+{}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+T BucketPriorityQueue<T,tpriority,Classes,Alloc>::Iterator::erase() {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("BucketPriorityQueue::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("BucketPriorityQueue::Iterator::erase Iterator cursor already erased");
+  if (current == nullptr)
+    throw CannotEraseError("BucketPriorityQueue::Iterator::erase Iterator cursor beyond data structure");
+
+  can_erase = false;
+  LN* to_delete = current;
+  T answer = to_delete->value;
+  current = to_delete->next;
+  ref_pq->unlink(current_class, prev, to_delete);
+  ref_pq->delete_node(to_delete);
+  if (current == nullptr)          //Erased the last value in its class: next is in a lower class
+    next_class();
+  return answer;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+std::string BucketPriorityQueue<T,tpriority,Classes,Alloc>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_pq->str() << "/class=" << current_class << "/current=" << current
+         << "/expected_mod_count=" << expected_mod_count << "/can_erase=" << can_erase;
+  return answer.str();
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+auto BucketPriorityQueue<T,tpriority,Classes,Alloc>::Iterator::operator ++ () -> Iterator& {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("BucketPriorityQueue::Iterator::operator ++");
+  if (current == nullptr)
+    return *this;
+
+  if (!can_erase)
+    can_erase = true;
+  else {
+    prev = current;
+    current = current->next;
+    if (current == nullptr)
+      next_class();
+  }
+  return *this;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+auto BucketPriorityQueue<T,tpriority,Classes,Alloc>::Iterator::operator ++ (int) -> Iterator {
+  Iterator to_return(*this);
+  ++(*this);
+  return to_return;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+bool BucketPriorityQueue<T,tpriority,Classes,Alloc>::Iterator::operator == (const Iterator& rhs) const {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("BucketPriorityQueue::Iterator::operator ==");
+  if (ref_pq != rhs.ref_pq)
+    throw ComparingDifferentIteratorsError("BucketPriorityQueue::Iterator::operator ==");
+  return current == rhs.current;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+bool BucketPriorityQueue<T,tpriority,Classes,Alloc>::Iterator::operator != (const Iterator& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+T& BucketPriorityQueue<T,tpriority,Classes,Alloc>::Iterator::operator *() const {
+  if (expected_mod_count != ref_pq->mod_count)
+    throw ConcurrentModificationError("BucketPriorityQueue::Iterator::operator *");
+  if (!can_erase || current == nullptr)
+    throw IteratorPositionIllegal("BucketPriorityQueue::Iterator::operator * Iterator illegal: exhausted or erased");
+  return current->value;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+T* BucketPriorityQueue<T,tpriority,Classes,Alloc>::Iterator::operator ->() const {
+  return &**this;
+}
+
+
+template<class T, int (*tpriority)(const T& a), int Classes, class Alloc>
+void BucketPriorityQueue<T,tpriority,Classes,Alloc>::Iterator::next_class() {
+  current_class = highest_class(ref_pq->non_empty & ((std::uint64_t(1) << current_class) - 1));
+  prev    = nullptr;
+  current = (current_class == -1 ? nullptr : ref_pq->front[current_class]);
+}
+
+}
+
+#endif /* BUCKET_PRIORITY_QUEUE_HPP_ */
@@ -0,0 +1,195 @@
+#ifndef BULK_LOAD_HPP_
+#define BULK_LOAD_HPP_
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <functional>         //For std::hash
+#include "ics_exceptions.hpp"
+#include "pair.hpp"
+#include "hyper_log_log.hpp"
+
+
+namespace ics {
+
+//Bulk loading for the drivers' "lf" command. The whole file is read with one read, split in
+//  place (memchr, no per-line std::vector), the container is reserved (when it has a reserve
+//  method) for the number of distinct keys a HyperLogLog estimates in the lines (so files with
+//  many repeated keys do not get a bin per line), and then filled with its bulk put_all/insert_all.
+//  Lines end in \n or \r\n; a map line is key;value (a line without ; maps the key to "").
+//  Empty lines are skipped.
+//  Kept in the repository root: program3's map driver and program4's map/set drivers share it.
+
+struct BulkLoadTimes {
+  int    lines          = 0;    //Entries parsed (not necessarily new to the container)
+  double read_seconds   = 0;
+  double parse_seconds  = 0;
+  double insert_seconds = 0;
+
+  std::string str() const;
+};
+
+std::string read_whole_file(const std::string& file_name);   //Throws FileOpenError
+
+//Call line(begin,end) for each non-empty line in contents; returns the number of lines
+template<class LineFunction>
+int for_each_line(const std::string& contents, LineFunction line);
+
+std::vector<pair<std::string,std::string>> parse_entries(const std::string& contents, char separator = ';');
+std::vector<std::string>                   parse_values (const std::string& contents);
+
+template<class MapType>
+BulkLoadTimes bulk_load_map(MapType& m, const std::string& file_name);
+
+template<class SetType>
+BulkLoadTimes bulk_load_set(SetType& s, const std::string& file_name);
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Implementation
+
+inline std::string BulkLoadTimes::str() const {
+  std::ostringstream answer;
+  answer << "loaded " << lines << " lines: read " << read_seconds << "s, parse " << parse_seconds
+         << "s, insert " << insert_seconds << "s";
+  return answer.str();
+}
+
+
+inline std::string read_whole_file(const std::string& file_name) {
+  std::ifstream in(file_name.c_str(), std::ios::binary | std::ios::ate);
+  if (in.fail())
+    throw FileOpenError(file_name);
+  std::string contents(std::size_t(in.tellg()), '\0');
+  in.seekg(0);
+  if (!contents.empty())
+    in.read(&contents[0], contents.size());
+  return contents;
+}
+
+
+template<class LineFunction>
+int for_each_line(const std::string& contents, LineFunction line) {
+  int count = 0;
+  const char* p   = contents.data();
+  const char* end = p + contents.size();
+  while (p < end) {
+    const char* eol  = static_cast<const char*>(std::memchr(p, '\n', end-p));
+    const char* next = (eol == nullptr ? end : eol+1);
+    if (eol == nullptr)
+      eol = end;
+    if (eol > p && eol[-1] == '\r')
+      --eol;
+    if (eol > p) {
+      line(p, eol);
+      ++count;
+    }
+    p = next;
+  }
+  return count;
+}
+
+
+inline std::vector<pair<std::string,std::string>> parse_entries(const std::string& contents, char separator) {
+  std::vector<pair<std::string,std::string>> answer;
+  answer.reserve(std::count(contents.begin(), contents.end(), '\n') + 1);
+  for_each_line(contents, [&answer,separator] (const char* b, const char* e) {
+    const char* sep = static_cast<const char*>(std::memchr(b, separator, e-b));
+    if (sep == nullptr)
+      answer.push_back(pair<std::string,std::string>(std::string(b,e), std::string()));
+    else
+      answer.push_back(pair<std::string,std::string>(std::string(b,sep), std::string(sep+1,e)));
+  });
+  return answer;
+}
+
+
+inline std::vector<std::string> parse_values(const std::string& contents) {
+  std::vector<std::string> answer;
+  answer.reserve(std::count(contents.begin(), contents.end(), '\n') + 1);
+  for_each_line(contents, [&answer] (const char* b, const char* e) {answer.push_back(std::string(b,e));});
+  return answer;
+}
+
+
+namespace bulk_detail {
+  typedef std::chrono::steady_clock Clock;
+
+  inline double seconds_since(Clock::time_point& start) {
+    Clock::time_point now = Clock::now();
+    double answer = std::chrono::duration<double>(now-start).count();
+    start = now;
+    return answer;
+  }
+
+  //Call c.reserve(size()) if C has one (HashMap/HashSet); otherwise (e.g., BSTMap) do nothing,
+  //  not even computing size()
+  template<class C, class Size>
+  auto reserve(C& c, Size size, int) -> decltype(c.reserve(0), void()) {c.reserve(size());}
+
+  template<class C, class Size>
+  void reserve(C&, Size, long) {}
+
+  inline int hash_key(const std::string& s) {std::hash<std::string> str_hash; return str_hash(s);}
+
+  //The number of distinct key(x) for x in xs: estimated (but never more than xs.size())
+  template<class Values, class Key>
+  int distinct(const Values& xs, Key key) {
+    HyperLogLog<std::string,hash_key> keys;
+    for (const auto& x : xs)
+      keys.add(key(x));
+    return std::min(keys.expected_size().size, int(xs.size()));
+  }
+}
+
+
+template<class MapType>
+BulkLoadTimes bulk_load_map(MapType& m, const std::string& file_name) {
+  BulkLoadTimes times;
+  bulk_detail::Clock::time_point start = bulk_detail::Clock::now();
+  std::string contents = read_whole_file(file_name);
+  times.read_seconds = bulk_detail::seconds_since(start);
+
+  std::vector<pair<std::string,std::string>> entries = parse_entries(contents);
+  times.lines = entries.size();
+  times.parse_seconds = bulk_detail::seconds_since(start);
+
+  bulk_detail::reserve(m, [&m,&entries] () {
+    return m.size() + bulk_detail::distinct(entries, [] (const pair<std::string,std::string>& e) -> const std::string& {return e.first;});
+  }, 0);
+  m.put_all(entries);
+  times.insert_seconds = bulk_detail::seconds_since(start);
+  return times;
+}
+
+
+template<class SetType>
+BulkLoadTimes bulk_load_set(SetType& s, const std::string& file_name) {
+  BulkLoadTimes times;
+  bulk_detail::Clock::time_point start = bulk_detail::Clock::now();
+  std::string contents = read_whole_file(file_name);
+  times.read_seconds = bulk_detail::seconds_since(start);
+
+  std::vector<std::string> values = parse_values(contents);
+  times.lines = values.size();
+  times.parse_seconds = bulk_detail::seconds_since(start);
+
+  bulk_detail::reserve(s, [&s,&values] () {
+    return s.size() + bulk_detail::distinct(values, [] (const std::string& v) -> const std::string& {return v;});
+  }, 0);
+  s.insert_all(values);
+  times.insert_seconds = bulk_detail::seconds_since(start);
+  return times;
+}
+
+}
+
+#endif /* BULK_LOAD_HPP_ */
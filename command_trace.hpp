@@ -0,0 +1,241 @@
+#ifndef COMMAND_TRACE_HPP_
+#define COMMAND_TRACE_HPP_
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cstdint>
+#include "ics46goody.hpp"
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+//A Command is one driver menu command plus the values it would have prompted for:
+//  {"p",{"a","1"}} is the map driver's put("a","1"); {"P",{"a","1","b","2"}} is put_all of {a->1,b->2}
+//Program3's and program4's drivers (and replay_trace) all read and write Commands: this one copy
+//  serves them, so each project's include path must reach this directory.
+struct Command {
+  std::string              name;
+  std::vector<std::string> args;
+};
+
+typedef std::vector<Command> CommandScript;
+
+
+//Text scripts: one command per line, its name and arguments separated by ';' (as in loadmap.txt)
+//  Blank lines and lines starting with # are skipped. Example (map driver):
+//    p;a;1
+//    g;a
+//    e;a
+CommandScript read_command_script (std::istream& in);
+void          write_command_script(std::ostream& out, const CommandScript& script);
+
+//Binary traces: the magic bytes "ICST", then for each command
+//  u8 name length, name bytes, u16 argument count, and for each argument u32 length, argument bytes
+//  (all integers little endian). Avoids splitting/parsing text when replaying long traces.
+CommandScript read_command_trace (std::istream& in);
+void          write_command_trace(std::ostream& out, const CommandScript& script);
+
+//Read file_name as a binary trace if it starts with "ICST", otherwise as a text script
+CommandScript load_commands(const std::string& file_name);
+
+
+//Accumulates the wall-clock latency of each executed command, by command name
+class CommandLatency {
+  public:
+    void record(const std::string& command, std::chrono::steady_clock::duration elapsed, bool failed);
+    std::string str() const;  //Table: command, count, errors, total/mean/max time
+
+  private:
+    struct Stats {
+      long                     count  = 0;
+      long                     errors = 0;
+      std::chrono::nanoseconds total  = std::chrono::nanoseconds(0);
+      std::chrono::nanoseconds max    = std::chrono::nanoseconds(0);
+    };
+    std::map<std::string,Stats> by_command;
+    Stats                       all;
+};
+
+
+//Return argument i of c, throwing an IcsError (so the command counts as failed) if it is missing
+const std::string& command_arg(const Command& c, unsigned i);
+
+
+//Execute every command in script (until a "q" command) by calling execute(command) and time each one.
+//  execute returns false for a command it does not know; those are counted as errors,
+//  as are commands that throw an IcsError (the script continues with the next command).
+template<class Execute>
+CommandLatency run_commands(const CommandScript& script, Execute execute);
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Implementation
+
+inline CommandScript read_command_script(std::istream& in) {
+  CommandScript script;
+  std::string line;
+  while (getline(in,line)) {
+    if (!line.empty() && line[line.size()-1] == '\r')
+      line.erase(line.size()-1);
+    if (line.empty() || line[0] == '#')
+      continue;
+    std::vector<std::string> fields = ics::split(line,";");
+    Command c;
+    c.name = fields[0];
+    c.args.assign(fields.begin()+1,fields.end());
+    script.push_back(c);
+  }
+  return script;
+}
+
+
+inline void write_command_script(std::ostream& out, const CommandScript& script) {
+  for (const Command& c : script) {
+    out << c.name;
+    for (const std::string& a : c.args)
+      out << ';' << a;
+    out << '\n';
+  }
+}
+
+
+namespace trace_detail {
+  inline void write_uint(std::ostream& out, std::uint32_t value, int bytes) {
+    for (int b=0; b<bytes; ++b)
+      out.put(char((value >> 8*b) & 0xff));
+  }
+
+  inline std::uint32_t read_uint(std::istream& in, int bytes) {
+    std::uint32_t value = 0;
+    for (int b=0; b<bytes; ++b) {
+      int c = in.get();
+      if (c == EOF)
+        throw IcsError("read_command_trace: trace truncated");
+      value |= std::uint32_t(c) << 8*b;
+    }
+    return value;
+  }
+
+  inline std::string read_bytes(std::istream& in, std::uint32_t length) {
+    std::string answer(length,'\0');
+    if (length != 0 && !in.read(&answer[0],length))
+      throw IcsError("read_command_trace: trace truncated");
+    return answer;
+  }
+}
+
+
+inline CommandScript read_command_trace(std::istream& in) {
+  if (trace_detail::read_bytes(in,4) != "ICST")
+    throw IcsError("read_command_trace: missing ICST magic");
+  CommandScript script;
+  while (in.peek() != EOF) {
+    Command c;
+    c.name = trace_detail::read_bytes(in,trace_detail::read_uint(in,1));
+    for (std::uint32_t argc = trace_detail::read_uint(in,2); argc > 0; --argc)
+      c.args.push_back(trace_detail::read_bytes(in,trace_detail::read_uint(in,4)));
+    script.push_back(c);
+  }
+  return script;
+}
+
+
+inline void write_command_trace(std::ostream& out, const CommandScript& script) {
+  out.write("ICST",4);
+  for (const Command& c : script) {
+    if (c.name.size() > 0xff || c.args.size() > 0xffff)
+      throw IcsError("write_command_trace: command \""+c.name+"\" too large for a trace record");
+    trace_detail::write_uint(out,c.name.size(),1);
+    out.write(c.name.data(),c.name.size());
+    trace_detail::write_uint(out,c.args.size(),2);
+    for (const std::string& a : c.args) {
+      trace_detail::write_uint(out,a.size(),4);
+      out.write(a.data(),a.size());
+    }
+  }
+}
+
+
+inline CommandScript load_commands(const std::string& file_name) {
+  std::ifstream in(file_name.c_str(),std::ios::binary);
+  if (in.fail())
+    throw FileOpenError(file_name);
+  char magic[4] = {0,0,0,0};
+  in.read(magic,4);
+  bool binary = in.gcount() == 4 && std::string(magic,4) == "ICST";
+  in.clear();
+  in.seekg(0);
+  return binary ? read_command_trace(in) : read_command_script(in);
+}
+
+
+inline const std::string& command_arg(const Command& c, unsigned i) {
+  if (i >= c.args.size()) {
+    std::ostringstream answer;
+    answer << "command_arg: command \"" << c.name << "\" needs argument #" << i+1;
+    throw IcsError(answer.str());
+  }
+  return c.args[i];
+}
+
+
+inline void CommandLatency::record(const std::string& command, std::chrono::steady_clock::duration elapsed, bool failed) {
+  std::chrono::nanoseconds ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+  for (Stats* s : {&by_command[command], &all}) {
+    ++s->count;
+    s->errors += failed;
+    s->total  += ns;
+    if (ns > s->max)
+      s->max = ns;
+  }
+}
+
+
+inline std::string CommandLatency::str() const {
+  std::ostringstream answer;
+  auto row = [&answer] (const std::string& name, const Stats& s) {
+    answer << std::setw(8)  << name     << std::setw(10) << s.count << std::setw(8) << s.errors
+           << std::setw(14) << s.total.count()/1000
+           << std::setw(12) << (s.count == 0 ? 0 : s.total.count()/s.count)
+           << std::setw(12) << s.max.count() << std::endl;
+  };
+  answer << std::setw(8)  << "command"  << std::setw(10) << "count" << std::setw(8) << "errors"
+         << std::setw(14) << "total(us)" << std::setw(12) << "mean(ns)" << std::setw(12) << "max(ns)" << std::endl;
+  for (const std::pair<const std::string,Stats>& kv : by_command)
+    row(kv.first,kv.second);
+  row("TOTAL",all);
+  return answer.str();
+}
+
+
+template<class Execute>
+CommandLatency run_commands(const CommandScript& script, Execute execute) {
+  CommandLatency latency;
+  for (const Command& c : script) {
+    if (c.name == "q")
+      break;
+    bool failed = false;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    try {
+      failed = !execute(c);
+    } catch (ics::IcsError&) {
+      failed = true;
+    }
+    latency.record(c.name, std::chrono::steady_clock::now()-start, failed);
+  }
+  return latency;
+}
+
+}
+
+#endif /* COMMAND_TRACE_HPP_ */
@@ -0,0 +1,20 @@
+#ifndef EXPECTED_SIZE_HPP_
+#define EXPECTED_SIZE_HPP_
+
+
+namespace ics {
+
+
+//The number of distinct keys/elements a HashMap/HashSet is expected to hold: constructed with
+//  one, it starts with enough bins for that many (so filling it never rehashes). Often made by
+//  HyperLogLog::expected_size, when the number is not known in advance.
+//Its own header, so the containers that accept one need not include hyper_log_log.hpp.
+struct ExpectedSize {
+  explicit ExpectedSize (int n) : size(n) {}
+
+  int size;
+};
+
+}
+
+#endif /* EXPECTED_SIZE_HPP_ */
@@ -0,0 +1,354 @@
+#ifndef FIXED_HASH_MAP_HPP_
+#define FIXED_HASH_MAP_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <cstdint>
+#include <type_traits>
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//Fixed (never modified) sets and maps of keys known when compiling: keyword and command
+//  tables. The table is built by the compiler (every constructor is constexpr), so declaring
+//  one constexpr costs nothing at startup, e.g.,
+//    constexpr auto commands = make_fixed_hash_set("i","I","e","x");
+//    constexpr auto codes    = make_fixed_hash_map(fixed_entry("i",1), fixed_entry("e",2));
+//    static_assert(commands.contains("e"), "...");  //lookups with literals can be constexpr too
+//KEY is const char* (from string literals; look up with a std::string or a const char*) or an
+//  integral type. The hash function is built in (not thash/chash): building the table searches
+//  for a seed under which every key gets its own slot, so a lookup is one hash, one slot, and
+//  one key comparison (no probing, no chains). Slots number about N*N/2 (2 bytes each) and
+//  filling them takes about N*N*N/2 compile-time steps, so these are for tables of tens of
+//  keys (about 100 at most with the compiler's default limits): use FrozenHashMap for more.
+//Duplicate keys (or, astronomically rarely, no good seed) fail to compile in a constexpr
+//  declaration (and throw KeyError when built at runtime).
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Hashing and comparing keys: constexpr for const char*/integral keys, runtime for std::string
+
+constexpr std::uint32_t fixed_xorshift(std::uint32_t h, int s) {return h ^ (h >> s);}
+
+//The 32-bit MurmurHash3 finalizer
+constexpr std::uint32_t fixed_mix(std::uint32_t h) {
+  return fixed_xorshift(fixed_xorshift(fixed_xorshift(h,16)*0x85ebca6bu,13)*0xc2b2ae35u,16);
+}
+
+//FNV-1a over the characters (up to the '\0')
+constexpr std::uint32_t fixed_fnv(const char* s, std::uint32_t h) {
+  return *s == '\0' ? h : fixed_fnv(s+1, (h ^ std::uint8_t(*s)) * 16777619u);
+}
+
+constexpr std::uint32_t fixed_key_hash(const char* key, std::uint32_t seed) {
+  return fixed_mix(fixed_fnv(key, 2166136261u ^ fixed_mix(seed)));
+}
+
+//Must compute the same value as the const char* version
+inline std::uint32_t fixed_key_hash(const std::string& key, std::uint32_t seed) {
+  std::uint32_t h = 2166136261u ^ fixed_mix(seed);
+  for (char c : key)
+    h = (h ^ std::uint8_t(c)) * 16777619u;
+  return fixed_mix(h);
+}
+
+template<class I, class = typename std::enable_if<std::is_integral<I>::value>::type>
+constexpr std::uint32_t fixed_key_hash(I key, std::uint32_t seed) {
+  return fixed_mix(fixed_mix(std::uint32_t(std::uint64_t(key)) ^ fixed_mix(seed)) ^ std::uint32_t(std::uint64_t(key) >> 32));
+}
+
+
+constexpr bool fixed_key_equal(const char* a, const char* b) {
+  return *a == *b && (*a == '\0' || fixed_key_equal(a+1, b+1));
+}
+
+inline bool fixed_key_equal(const char* a, const std::string& b) {
+  return b == a;
+}
+
+template<class I, class J, class = typename std::enable_if<std::is_integral<I>::value && std::is_integral<J>::value>::type>
+constexpr bool fixed_key_equal(I a, J b) {
+  return a == b;
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Building the table (each a single return, as C++11 constexpr functions must be)
+
+//Compile-time lists of indexes 0..N-1 (made by halving, so only Log2 N templates deep)
+template<int... I> struct FixedIndexes {};
+
+template<class A, class B> struct FixedIndexesCat;
+template<int... A, int... B> struct FixedIndexesCat<FixedIndexes<A...>,FixedIndexes<B...>> {
+  typedef FixedIndexes<A..., int(sizeof...(A))+B...> type;
+};
+
+template<int N> struct MakeFixedIndexes {
+  typedef typename FixedIndexesCat<typename MakeFixedIndexes<N/2>::type, typename MakeFixedIndexes<N-N/2>::type>::type type;
+};
+template<> struct MakeFixedIndexes<0> {typedef FixedIndexes<>  type;};
+template<> struct MakeFixedIndexes<1> {typedef FixedIndexes<0> type;};
+
+
+//The smallest power of 2 >= max(n,n*n/2): n keys then share no slot for about 1 seed in 3 (or better)
+constexpr int fixed_table_size(int n, int m = 1) {
+  return m >= n && m >= n*n/2 ? m : fixed_table_size(n, 2*m);
+}
+
+template<class KEY, int N> struct FixedKeyList {
+  KEY key[N];
+};
+
+//Every key's slot under one seed: hashed once, then only these ints are compared
+template<int N> struct FixedSlotList {
+  int slot[N];
+};
+
+template<class KEY, int N, int... I>
+constexpr FixedSlotList<N> fixed_slots(const FixedKeyList<KEY,N>& keys, FixedIndexes<I...>, std::uint32_t seed, int mask) {
+  return FixedSlotList<N>{{int(fixed_key_hash(keys.key[I], seed)) & mask...}};
+}
+
+//No key after i shares key i's slot (the recursion is only about 2N deep: N here, N below)
+template<int N>
+constexpr bool fixed_none_share(const FixedSlotList<N>& slots, int i, int j) {
+  return j >= N || (slots.slot[i] != slots.slot[j] && fixed_none_share(slots, i, j+1));
+}
+
+template<int N>
+constexpr bool fixed_all_distinct(const FixedSlotList<N>& slots, int i = 0) {
+  return i >= N || (fixed_none_share(slots, i, i+1) && fixed_all_distinct(slots, i+1));
+}
+
+const std::uint32_t fixed_max_seeds = 64;
+
+template<class KEY, int N, int... I>
+constexpr std::uint32_t fixed_find_seed(const FixedKeyList<KEY,N>& keys, FixedIndexes<I...> k, int mask, std::uint32_t seed = 0) {
+  return seed == fixed_max_seeds ? throw KeyError("fixed hash table: duplicate keys (or no seed gives every key its own slot)")
+       : fixed_all_distinct(fixed_slots(keys, k, seed, mask)) ? seed
+       : fixed_find_seed(keys, k, mask, seed+1);
+}
+
+//The index of the key in slot s, or N if s is empty
+template<int N>
+constexpr int fixed_owner(const FixedSlotList<N>& slots, int s, int i = 0) {
+  return i >= N || slots.slot[i] == s ? i : fixed_owner(slots, s, i+1);
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//FixedHashSet class and related definitions
+
+template<class KEY, int N> class FixedHashSet {
+  static_assert(N >= 1, "FixedHashSet: needs at least one key");
+  static_assert(N < 65535, "FixedHashSet: slots store key indexes in 16 bits");
+
+  public:
+    static constexpr int table_size = fixed_table_size(N);
+
+    //Constructors
+    template<class... Keys>
+    constexpr explicit FixedHashSet (Keys... keys)
+    : FixedHashSet(typename MakeFixedIndexes<table_size>::type(), FixedKeyList<KEY,N>{{KEY(keys)...}}) {}
+
+
+    //Queries (Lookup is KEY or anything fixed_key_hash/fixed_key_equal accept with it, e.g. std::string for const char*)
+    constexpr bool empty () const {return false;}
+    constexpr int  size  () const {return N;}
+
+    template<class Lookup>
+    constexpr int  index_of (const Lookup& key) const;    //Position of key in the constructor's list, or -1 if not there
+
+    template<class Lookup>
+    constexpr bool contains (const Lookup& key) const {return index_of(key) != -1;}
+
+    constexpr const KEY& key (int i) const {return keys.key[i];}  //The constructor's ith key
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+    template<class KEY2, int N2>
+    friend std::ostream& operator << (std::ostream& outs, const FixedHashSet<KEY2,N2>& s);
+
+
+    //Iterates over the keys in the order the constructor listed them
+    const KEY* begin () const {return keys.key;}
+    const KEY* end   () const {return keys.key + N;}
+
+
+  private:
+    FixedKeyList<KEY,N> keys;
+    std::uint32_t       seed;
+    std::uint16_t       slot[table_size];   //slot[s]: index in keys of the key hashing to s, or N if none
+
+    typedef typename MakeFixedIndexes<N>::type KeyIndexes;
+
+    template<int... S>
+    constexpr FixedHashSet (FixedIndexes<S...> slots, const FixedKeyList<KEY,N>& keys)
+    : FixedHashSet(slots, keys, fixed_find_seed(keys, KeyIndexes(), table_size-1)) {}
+
+    template<int... S>
+    constexpr FixedHashSet (FixedIndexes<S...> slots, const FixedKeyList<KEY,N>& keys, std::uint32_t seed)
+    : FixedHashSet(slots, keys, seed, fixed_slots(keys, KeyIndexes(), seed, table_size-1)) {}
+
+    template<int... S>
+    constexpr FixedHashSet (FixedIndexes<S...>, const FixedKeyList<KEY,N>& keys, std::uint32_t seed, const FixedSlotList<N>& slots)
+    : keys(keys), seed(seed), slot{std::uint16_t(fixed_owner(slots, S))...} {}
+
+    template<class Lookup>
+    constexpr int index_at (int i, const Lookup& key) const {
+      return i != N && fixed_key_equal(keys.key[i], key) ? i : -1;
+    }
+};
+
+
+template<class KEY, int N>
+constexpr int FixedHashSet<KEY,N>::table_size;
+
+
+template<class KEY, int N>
+template<class Lookup>
+constexpr int FixedHashSet<KEY,N>::index_of(const Lookup& key) const {
+  return index_at(slot[fixed_key_hash(key, seed) & (table_size-1)], key);
+}
+
+
+template<class KEY, int N>
+std::string FixedHashSet<KEY,N>::str() const {
+  std::ostringstream answer;
+  answer << "FixedHashSet[";
+  bool first = true;
+  for (int s = 0; s < table_size; ++s)
+    if (slot[s] != N) {
+      answer << (first ? "" : ",") << s << ":" << keys.key[slot[s]];
+      first = false;
+    }
+  answer << "](size=" << N << ",table_size=" << table_size << ",seed=" << seed << ")";
+  return answer.str();
+}
+
+
+template<class KEY, int N>
+std::ostream& operator << (std::ostream& outs, const FixedHashSet<KEY,N>& s) {
+  outs << "set[";
+  for (int i = 0; i < N; ++i)
+    outs << (i == 0 ? "" : ",") << s.keys.key[i];
+  outs << "]";
+  return outs;
+}
+
+
+template<class KEY, class... Keys>
+constexpr FixedHashSet<KEY,1+sizeof...(Keys)> make_fixed_hash_set(KEY key, Keys... keys) {
+  return FixedHashSet<KEY,1+sizeof...(Keys)>(key, keys...);
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//FixedHashMap class and related definitions
+
+template<class KEY, class T> struct FixedEntry {
+  KEY key;
+  T   value;
+};
+
+template<class KEY, class T>
+constexpr FixedEntry<KEY,T> fixed_entry(KEY key, T value) {
+  return FixedEntry<KEY,T>{key, value};
+}
+
+
+//A FixedHashSet of the keys plus their values in the same order: T must be a literal type
+//  (e.g., an int, an enum, a const char*, or a function pointer) for a constexpr map
+template<class KEY, class T, int N> class FixedHashMap {
+  public:
+    //Constructors
+    template<class... Entries>
+    constexpr explicit FixedHashMap (Entries... entries) : keys(entries.key...), values{entries.value...} {}
+
+
+    //Queries
+    constexpr bool empty () const {return false;}
+    constexpr int  size  () const {return N;}
+
+    template<class Lookup>
+    constexpr bool has_key (const Lookup& key) const {return keys.contains(key);}
+
+    template<class Lookup>
+    constexpr const T* find (const Lookup& key) const {return value_at(keys.index_of(key));}  //nullptr if not a key
+
+    constexpr const FixedHashSet<KEY,N>& key_set () const {return keys;}
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Operators
+    template<class Lookup>
+    const T& operator [] (const Lookup& key) const;  //Throws KeyError if not a key
+
+    template<class KEY2, class T2, int N2>
+    friend std::ostream& operator << (std::ostream& outs, const FixedHashMap<KEY2,T2,N2>& m);
+
+
+  private:
+    FixedHashSet<KEY,N> keys;
+    T                   values[N];    //values[i]: the value of keys.key(i)
+
+    constexpr const T* value_at (int i) const {return i == -1 ? nullptr : &values[i];}
+};
+
+
+template<class KEY, class T, int N>
+std::string FixedHashMap<KEY,T,N>::str() const {
+  std::ostringstream answer;
+  answer << "FixedHashMap[";
+  for (int i = 0; i < N; ++i)
+    answer << (i == 0 ? "" : ",") << keys.key(i) << "->" << values[i];
+  answer << "](keys=" << keys.str() << ")";
+  return answer.str();
+}
+
+
+template<class KEY, class T, int N>
+template<class Lookup>
+const T& FixedHashMap<KEY,T,N>::operator [] (const Lookup& key) const {
+  const T* value = find(key);
+  if (value != nullptr)
+    return *value;
+
+  std::ostringstream answer;
+  answer << "FixedHashMap::operator []: key(" << key << ") not in Map";
+  throw KeyError(answer.str());
+}
+
+
+template<class KEY, class T, int N>
+std::ostream& operator << (std::ostream& outs, const FixedHashMap<KEY,T,N>& m) {
+  outs << "map[";
+  for (int i = 0; i < N; ++i)
+    outs << (i == 0 ? "" : ",") << m.keys.key(i) << "->" << m.values[i];
+  outs << "]";
+  return outs;
+}
+
+
+template<class KEY, class T, class... Entries>
+constexpr FixedHashMap<KEY,T,1+sizeof...(Entries)> make_fixed_hash_map(FixedEntry<KEY,T> entry, Entries... entries) {
+  return FixedHashMap<KEY,T,1+sizeof...(Entries)>(entry, entries...);
+}
+
+}
+
+#endif /* FIXED_HASH_MAP_HPP_ */
@@ -0,0 +1,189 @@
+#ifndef HYPER_LOG_LOG_HPP_
+#define HYPER_LOG_LOG_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cmath>
+#include <algorithm>          //For std::max
+#include <cstdint>
+#include "ics_exceptions.hpp"
+#include "expected_size.hpp"
+
+
+namespace ics {
+
+
+//Estimates how many distinct values have been added, in a fixed 2^precision bytes (4KB for the
+//  default precision 12), with a standard error of about 1.04/sqrt(2^precision) (1.6% for 12).
+//  For a cheap pre-scan of keys (e.g., lines of a file) before building a map of them.
+//thash/chash are as in HashSet. Each hash value is mixed into 64 bits: its first precision bits
+//  choose a register, which keeps the longest run of leading 0s seen in the rest. Sketches of
+//  the same precision and hash (e.g., one per thread, or per file) can be merged.
+//  (In the repository root: bulk_load.hpp uses it for both program3 and program4.)
+template<class T, int (*thash)(const T& a) = nullptr> class HyperLogLog {
+  public:
+    //Destructor/Constructors
+    ~HyperLogLog ();
+    explicit HyperLogLog (int the_precision = 12, int (*chash)(const T& a) = nullptr);
+
+
+    //Queries
+    double       estimate      () const;   //Distinct values added (approximately)
+    ExpectedSize expected_size () const;   //estimate plus 3 standard errors: rarely too small
+    int          precision     () const;
+    int          bytes         () const;   //Memory used (this object and its registers)
+    std::string  str           () const;   //supplies useful debugging information
+
+
+    //Commands
+    void add   (const T& value);
+    void merge (const HyperLogLog<T,thash>& other);   //Now estimates the values added to either
+    void clear ();
+
+    //Iterable class must support "for" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    void add_all (const Iterable& i);
+
+
+  private:
+    int (*hash)(const T& value);
+    int bits;                            //precision: registers.size() == 2^bits
+    std::vector<std::uint8_t> registers; //1 + the most leading 0s seen (0 if none added)
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//HyperLogLog class and related definitions
+
+//Destructor/Constructors
+
+template<class T, int (*thash)(const T& a)>
+HyperLogLog<T,thash>::~HyperLogLog() {
+}
+
+
+template<class T, int (*thash)(const T& a)>
+HyperLogLog<T,thash>::HyperLogLog(int the_precision, int (*chash)(const T& a))
+: hash(thash != nullptr ? thash : chash), bits(the_precision) {
+  if (hash == nullptr)
+    throw TemplateFunctionError("HyperLogLog::constructor: neither specified");
+  if (thash != nullptr && chash != nullptr && thash != chash)
+    throw TemplateFunctionError("HyperLogLog::constructor: both specified and different");
+  if (bits < 4 || bits > 16)
+    throw IcsError("HyperLogLog::constructor: precision must be in [4,16]");
+  registers.assign(std::size_t(1) << bits, 0);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+//The harmonic mean of 2^register, scaled; when that is small (many registers still 0),
+//  counting the 0 registers is more accurate
+template<class T, int (*thash)(const T& a)>
+double HyperLogLog<T,thash>::estimate() const {
+  double m     = registers.size();
+  double alpha = bits == 4 ? 0.673 : bits == 5 ? 0.697 : bits == 6 ? 0.709 : 0.7213/(1.0 + 1.079/m);
+  double sum   = 0.0;
+  int    zeros = 0;
+  for (std::uint8_t r : registers) {
+    sum += std::ldexp(1.0, -r);
+    zeros += r == 0;
+  }
+  double answer = alpha*m*m/sum;
+  if (answer <= 2.5*m && zeros > 0)
+    answer = m*std::log(m/zeros);
+  return answer;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+ExpectedSize HyperLogLog<T,thash>::expected_size() const {
+  double e = estimate();
+  return ExpectedSize(int(std::ceil(e*(1.0 + 3*1.04/std::sqrt(double(registers.size()))))));
+}
+
+
+template<class T, int (*thash)(const T& a)>
+int HyperLogLog<T,thash>::precision() const {
+  return bits;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+int HyperLogLog<T,thash>::bytes() const {
+  return sizeof(HyperLogLog<T,thash>) + registers.capacity();
+}
+
+
+template<class T, int (*thash)(const T& a)>
+std::string HyperLogLog<T,thash>::str() const {
+  std::ostringstream answer;
+  int zeros = 0, most = 0;
+  for (std::uint8_t r : registers) {
+    zeros += r == 0;
+    most = std::max(most, int(r));
+  }
+  answer << "HyperLogLog(precision=" << bits << ",registers=" << registers.size() << ",zero=" << zeros
+         << ",max=" << most << ",estimate=" << estimate() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+//The hash is mixed (splitmix64's finalizer) so that poor hash values (e.g., i for int i) still
+//  spread over the registers and their leading 0s
+template<class T, int (*thash)(const T& a)>
+void HyperLogLog<T,thash>::add(const T& value) {
+  std::uint64_t h = unsigned(hash(value));
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+  h ^= h >> 31;
+
+  std::uint64_t rest = (h << bits) | (std::uint64_t(1) << (bits-1));   //a 1 stops the count of 0s
+  int rank = 1;
+  while (!(rest & (std::uint64_t(1) << 63))) {
+    rest <<= 1;
+    ++rank;
+  }
+  std::uint8_t& r = registers[h >> (64-bits)];
+  if (r < rank)
+    r = rank;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+void HyperLogLog<T,thash>::merge(const HyperLogLog<T,thash>& other) {
+  if (other.bits != bits || other.hash != hash)
+    throw IcsError("HyperLogLog::merge: different precision or hash");
+  for (std::size_t i = 0; i < registers.size(); ++i)
+    if (registers[i] < other.registers[i])
+      registers[i] = other.registers[i];
+}
+
+
+template<class T, int (*thash)(const T& a)>
+void HyperLogLog<T,thash>::clear() {
+  registers.assign(registers.size(), 0);
+}
+
+
+template<class T, int (*thash)(const T& a)>
+template<class Iterable>
+void HyperLogLog<T,thash>::add_all(const Iterable& i) {
+  for (const T& v : i)
+    add(v);
+}
+
+}
+
+#endif /* HYPER_LOG_LOG_HPP_ */
@@ -0,0 +1,386 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+#ifndef INTRUSIVE_QUEUE_HPP_
+#define INTRUSIVE_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <atomic>
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//Intrusive queues: T carries its own next pointer by deriving from a hook, so enqueue and
+//  dequeue only relink pointers; they never allocate, copy, or destroy a T. The queues do not
+//  own their elements: the caller keeps each object alive (e.g., in its own pool) while it is
+//  queued, and an object may be in at most one queue per hook at a time.
+//An object that must be in two queues at once derives from two hooks with different Tags:
+//    struct Job : IntrusiveQueueHook<>, IntrusiveQueueHook<struct Retry> {...};
+//    IntrusiveQueue<Job> ready;    IntrusiveQueue<Job,Retry> retries;
+//Copying an object does not copy its links: the copy starts out unqueued.
+template<class Tag = void> struct IntrusiveQueueHook {
+  IntrusiveQueueHook ()                                              {}
+  IntrusiveQueueHook (const IntrusiveQueueHook&)                     {}
+  IntrusiveQueueHook& operator = (const IntrusiveQueueHook&)         {return *this;}
+
+  IntrusiveQueueHook* next = nullptr;
+};
+
+template<class Tag = void> struct MPSCQueueHook {
+  MPSCQueueHook ()                                                   {}
+  MPSCQueueHook (const MPSCQueueHook&)                               {}
+  MPSCQueueHook& operator = (const MPSCQueueHook&)                   {return *this;}
+
+  std::atomic<MPSCQueueHook*> next{nullptr};
+};
+
+
+//A single-threaded FIFO queue of T&s (the LinkedQueue interface, minus the copying)
+template<class T, class Tag = void> class IntrusiveQueue {
+  public:
+    typedef IntrusiveQueueHook<Tag> Hook;
+
+    //Destructor/Constructors
+    ~IntrusiveQueue();         //Unlinks (but does not destroy) any remaining elements
+    IntrusiveQueue ();
+    IntrusiveQueue (const IntrusiveQueue<T,Tag>& to_copy)                   = delete;
+    IntrusiveQueue<T,Tag>& operator = (const IntrusiveQueue<T,Tag>& rhs)    = delete;
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    T&   peek       () const;
+    std::string str () const; //supplies useful debugging information
+
+
+    //Commands
+    int  enqueue (T& element);      //Throws IcsError if element is already queued here
+    T&   dequeue ();
+    void clear   ();                //Unlinks every element
+
+    //Moves all of other's elements to the rear of this queue in O(1)
+    void splice  (IntrusiveQueue<T,Tag>& other);
+
+
+    class Iterator {
+      public:
+        T&  operator *  () const;
+        T*  operator -> () const;
+        Iterator& operator ++ ();
+        bool operator == (const Iterator& rhs) const {return current == rhs.current;}
+        bool operator != (const Iterator& rhs) const {return current != rhs.current;}
+
+      private:
+        friend class IntrusiveQueue<T,Tag>;
+        Iterator(const IntrusiveQueue<T,Tag>* q, Hook* initial)
+          : ref_queue(q), current(initial), expected_mod_count(q->mod_count) {}
+
+        const IntrusiveQueue<T,Tag>* ref_queue;
+        Hook*                        current;
+        int                          expected_mod_count;
+    };
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    Hook* front     = nullptr;
+    Hook* rear      = nullptr;
+    int   used      = 0;
+    int   mod_count = 0;
+
+    static T*    to_T    (Hook* h)  {return static_cast<T*>(h);}
+    static Hook* to_hook (T& t)     {return static_cast<Hook*>(&t);}
+};
+
+
+//Dmitry Vyukov's intrusive multi-producer/single-consumer queue (1024cores.net).
+//Any number of threads may enqueue concurrently: each enqueue is one atomic exchange plus one
+//  store, wait-free, with no lock and no allocation. Only one thread may dequeue.
+//dequeue returns nullptr when the queue is empty, and also (briefly) when a producer has
+//  exchanged itself in but not yet linked its predecessor to it; the consumer just tries again
+//  later (the element is never lost). A stub hook inside the queue keeps it non-empty, so a
+//  single atomic exchange is enough to enqueue.
+template<class T, class Tag = void> class MPSCQueue {
+  public:
+    typedef MPSCQueueHook<Tag> Hook;
+
+    //Destructor/Constructors
+    ~MPSCQueue();
+    MPSCQueue ();
+    MPSCQueue (const MPSCQueue<T,Tag>& to_copy)                   = delete;
+    MPSCQueue<T,Tag>& operator = (const MPSCQueue<T,Tag>& rhs)    = delete;
+
+
+    //Queries
+    bool empty () const;       //Consumer only: no element could be dequeued right now
+
+
+    //Commands
+    void enqueue (T& element);  //Any thread
+    T*   dequeue ();            //Consumer only: nullptr if nothing is ready
+
+
+  private:
+    std::atomic<Hook*> head;    //Most recently enqueued (producers exchange here)
+    char               head_pad[64];
+    Hook*              tail;    //Next to dequeue (consumer only)
+    Hook               stub;
+
+    void push (Hook* h);
+    static T* to_T (Hook* h)    {return static_cast<T*>(h);}
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//IntrusiveQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, class Tag>
+IntrusiveQueue<T,Tag>::~IntrusiveQueue() {
+  clear();
+}
+
+
+template<class T, class Tag>
+IntrusiveQueue<T,Tag>::IntrusiveQueue() {
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, class Tag>
+bool IntrusiveQueue<T,Tag>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, class Tag>
+int IntrusiveQueue<T,Tag>::size() const {
+  return used;
+}
+
+
+template<class T, class Tag>
+T& IntrusiveQueue<T,Tag>::peek() const {
+  if (empty())
+    throw EmptyError("IntrusiveQueue::peek");
+  return *to_T(front);
+}
+
+
+template<class T, class Tag>
+std::string IntrusiveQueue<T,Tag>::str() const {
+  std::ostringstream answer;
+  answer << "IntrusiveQueue[";
+  for (Hook* h = front; h != nullptr; h = h->next)
+    answer << *to_T(h) << (h->next == nullptr ? "" : "->");
+  answer << "](used=" << used << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, class Tag>
+int IntrusiveQueue<T,Tag>::enqueue(T& element) {
+  Hook* h = to_hook(element);
+  //Every queued hook but rear has a non-nullptr next: a cheap check for double enqueue
+  if (h->next != nullptr || h == rear)
+    throw IcsError("IntrusiveQueue::enqueue: element is already in a queue");
+  if (rear == nullptr)
+    front = h;
+  else
+    rear->next = h;
+  rear = h;
+  ++used;
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, class Tag>
+T& IntrusiveQueue<T,Tag>::dequeue() {
+  if (empty())
+    throw EmptyError("IntrusiveQueue::dequeue");
+  Hook* h = front;
+  front = h->next;
+  if (front == nullptr)
+    rear = nullptr;
+  h->next = nullptr;
+  --used;
+  ++mod_count;
+  return *to_T(h);
+}
+
+
+template<class T, class Tag>
+void IntrusiveQueue<T,Tag>::clear() {
+  while (front != nullptr) {
+    Hook* h = front;
+    front = h->next;
+    h->next = nullptr;
+  }
+  rear = nullptr;
+  used = 0;
+  ++mod_count;
+}
+
+
+template<class T, class Tag>
+void IntrusiveQueue<T,Tag>::splice(IntrusiveQueue<T,Tag>& other) {
+  if (&other == this || other.empty())
+    return;
+  if (rear == nullptr)
+    front = other.front;
+  else
+    rear->next = other.front;
+  rear  = other.rear;
+  used += other.used;
+  other.front = other.rear = nullptr;
+  other.used  = 0;
+  ++mod_count;
+  ++other.mod_count;
+}
+
+
+template<class T, class Tag>
+auto IntrusiveQueue<T,Tag>::begin() const -> Iterator {
+  return Iterator(this, front);
+}
+
+
+template<class T, class Tag>
+auto IntrusiveQueue<T,Tag>::end() const -> Iterator {
+  return Iterator(this, nullptr);
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//IntrusiveQueue<T,Tag>::Iterator class and related definitions
+
+template<class T, class Tag>
+T& IntrusiveQueue<T,Tag>::Iterator::operator *() const {
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("IntrusiveQueue::Iterator::operator *");
+  if (current == nullptr)
+    throw IteratorPositionIllegal("IntrusiveQueue::Iterator::operator * Iterator illegal: end");
+  return *to_T(current);
+}
+
+
+template<class T, class Tag>
+T* IntrusiveQueue<T,Tag>::Iterator::operator ->() const {
+  return &**this;
+}
+
+
+template<class T, class Tag>
+auto IntrusiveQueue<T,Tag>::Iterator::operator ++() -> Iterator& {
+  if (expected_mod_count != ref_queue->mod_count)
+    throw ConcurrentModificationError("IntrusiveQueue::Iterator::operator ++");
+  if (current != nullptr)
+    current = current->next;
+  return *this;
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//MPSCQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, class Tag>
+MPSCQueue<T,Tag>::~MPSCQueue() {
+}
+
+
+template<class T, class Tag>
+MPSCQueue<T,Tag>::MPSCQueue()
+: head(&stub), tail(&stub)
+{}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, class Tag>
+bool MPSCQueue<T,Tag>::empty() const {
+  return tail == &stub && stub.next.load(std::memory_order_acquire) == nullptr;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, class Tag>
+void MPSCQueue<T,Tag>::enqueue(T& element) {
+  push(static_cast<Hook*>(&element));
+}
+
+
+template<class T, class Tag>
+T* MPSCQueue<T,Tag>::dequeue() {
+  Hook* t    = tail;
+  Hook* next = t->next.load(std::memory_order_acquire);
+  if (t == &stub) {                     //Skip over the stub
+    if (next == nullptr)
+      return nullptr;
+    tail = t = next;
+    next = next->next.load(std::memory_order_acquire);
+  }
+  if (next != nullptr) {
+    tail = next;
+    return to_T(t);
+  }
+
+  //t is the last linked element: if a producer is mid-enqueue, wait for it (nullptr)
+  if (t != head.load(std::memory_order_acquire))
+    return nullptr;
+
+  //Otherwise re-insert the stub behind t, so t can be taken without emptying the list
+  push(&stub);
+  next = t->next.load(std::memory_order_acquire);
+  if (next == nullptr)
+    return nullptr;
+  tail = next;
+  return to_T(t);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, class Tag>
+void MPSCQueue<T,Tag>::push(Hook* h) {
+  h->next.store(nullptr, std::memory_order_relaxed);
+  Hook* prev = head.exchange(h, std::memory_order_acq_rel);
+  prev->next.store(h, std::memory_order_release);         //Links h for the consumer
+}
+
+}
+
+#endif /* INTRUSIVE_QUEUE_HPP_ */
@@ -8,30 +8,39 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <memory>             //For std::allocator/std::allocator_traits
+#if __cplusplus >= 201703L
+#include <memory_resource>    //For std::pmr::polymorphic_allocator
+#endif
 #include "ics_exceptions.hpp"
 
 
 namespace ics {
 
 
-template<class T> class LinkedQueue {
+//Alloc is any std::allocator-compatible allocator of T; it is rebound to allocate the LN nodes.
+//Stateful allocators (arenas, std::pmr::polymorphic_allocator) are passed to the constructors
+//and are kept by copies (select_on_container_copy_construction) but not by operator =.
+template<class T, class Alloc = std::allocator<T>> class LinkedQueue {
   public:
     //Destructor/Constructors
     ~LinkedQueue();
 
     LinkedQueue          ();
-    LinkedQueue          (const LinkedQueue<T>& to_copy);
-    explicit LinkedQueue (const std::initializer_list<T>& il);
+    explicit LinkedQueue (const Alloc& alloc);
+    LinkedQueue          (const LinkedQueue<T,Alloc>& to_copy);
+    explicit LinkedQueue (const std::initializer_list<T>& il, const Alloc& alloc = Alloc());
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
-    explicit LinkedQueue (const Iterable& i);
+    explicit LinkedQueue (const Iterable& i, const Alloc& alloc = Alloc());
 
 
     //Queries
     bool empty      () const;
     int  size       () const;
     T&   peek       () const;
+    Alloc get_allocator () const;
     std::string str () const; //supplies useful debugging information; contrast to operator <<
 
 
@@ -46,12 +55,12 @@ template<class T> class LinkedQueue {
 
 
     //Operators
-    LinkedQueue<T>& operator = (const LinkedQueue<T>& rhs);
-    bool operator == (const LinkedQueue<T>& rhs) const;
-    bool operator != (const LinkedQueue<T>& rhs) const;
+    LinkedQueue<T,Alloc>& operator = (const LinkedQueue<T,Alloc>& rhs);
+    bool operator == (const LinkedQueue<T,Alloc>& rhs) const;
+    bool operator != (const LinkedQueue<T,Alloc>& rhs) const;
 
-    template<class T2>
-    friend std::ostream& operator << (std::ostream& outs, const LinkedQueue<T2>& q);
+    template<class T2, class Alloc2>
+    friend std::ostream& operator << (std::ostream& outs, const LinkedQueue<T2,Alloc2>& q);
 
 
 
@@ -61,33 +70,33 @@ template<class T> class LinkedQueue {
   public:
     class Iterator {
       public:
-        //Private constructor called in begin/end, which are friends of LinkedQueue<T>
+        //Private constructor called in begin/end, which are friends of LinkedQueue<T,Alloc>
         ~Iterator();
         T           erase();
         std::string str  () const;
-        LinkedQueue<T>::Iterator& operator ++ ();
-        LinkedQueue<T>::Iterator  operator ++ (int);
-        bool operator == (const LinkedQueue<T>::Iterator& rhs) const;
-        bool operator != (const LinkedQueue<T>::Iterator& rhs) const;
+        LinkedQueue<T,Alloc>::Iterator& operator ++ ();
+        LinkedQueue<T,Alloc>::Iterator  operator ++ (int);
+        bool operator == (const LinkedQueue<T,Alloc>::Iterator& rhs) const;
+        bool operator != (const LinkedQueue<T,Alloc>::Iterator& rhs) const;
         T& operator *  () const;
         T* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const LinkedQueue<T>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const LinkedQueue<T,Alloc>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
-        friend Iterator LinkedQueue<T>::begin () const;
-        friend Iterator LinkedQueue<T>::end   () const;
+        friend Iterator LinkedQueue<T,Alloc>::begin () const;
+        friend Iterator LinkedQueue<T,Alloc>::end   () const;
 
       private:
         //If can_erase is false, current indexes the "next" value (must ++ to reach it)
         LN*             prev = nullptr;  //if nullptr, current at front of list
         LN*             current;         //current == prev->next (if prev != nullptr)
-        LinkedQueue<T>* ref_queue;		//NO. THIS IS A ITERATOR
+        LinkedQueue<T,Alloc>* ref_queue;		//NO. THIS IS A ITERATOR
         int             expected_mod_count;
         bool            can_erase = true;
 
         //Called in friends begin/end
-        Iterator(LinkedQueue<T>* iterate_over, LN* initial);
+        Iterator(LinkedQueue<T,Alloc>* iterate_over, LN* initial);
     };
 
 
@@ -106,13 +115,18 @@ template<class T> class LinkedQueue {
         LN* next = nullptr;
     };
 
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<LN> NodeAlloc;
+    typedef std::allocator_traits<NodeAlloc>                                 NodeTraits;
 
+    NodeAlloc node_alloc;          //Allocates/constructs every LN (see new_node/delete_node)
     LN* front     =  nullptr;
     LN* rear      =  nullptr;
     int used      =  0;            //Cache for number of values in linked list
     int mod_count =  0;            //For sensing of a concurrent modification
 
     //Helper methods
+    LN*  new_node   (const T& v, LN* n = nullptr);  //Allocate and construct an LN with node_alloc
+    void delete_node(LN* ln);                       //Destroy and deallocate an LN with node_alloc
     void delete_list(LN*& front);  //Deallocate all LNs, and set front's argument to nullptr;
 };
 
@@ -126,25 +140,33 @@ template<class T> class LinkedQueue {
 
 //Destructor/Constructors
 
-template<class T>
-LinkedQueue<T>::~LinkedQueue() {
+template<class T, class Alloc>
+LinkedQueue<T,Alloc>::~LinkedQueue() {
 	//how to delete all lonked nodes
 	clear();
 }
 
 
-template<class T>
-LinkedQueue<T>::LinkedQueue() {
+template<class T, class Alloc>
+LinkedQueue<T,Alloc>::LinkedQueue() {
 }
 
 
-template<class T>
-LinkedQueue<T>::LinkedQueue(const LinkedQueue<T>& to_copy) {
+template<class T, class Alloc>
+LinkedQueue<T,Alloc>::LinkedQueue(const Alloc& alloc)
+: node_alloc(alloc)
+{
+}
+
+
+template<class T, class Alloc>
+LinkedQueue<T,Alloc>::LinkedQueue(const LinkedQueue<T,Alloc>& to_copy)
+: node_alloc(NodeTraits::select_on_container_copy_construction(to_copy.node_alloc))
+{
 
 
 	for (LN* temp = to_copy.front ; temp != nullptr;)
 	{
-		std::cout<<"HELP. ME. "<<temp<<"\n\n";
 		enqueue(temp->value);
 		temp = temp->next;
 	}
@@ -153,8 +175,9 @@ LinkedQueue<T>::LinkedQueue(const LinkedQueue<T>& to_copy) {
  }
 
 
-template<class T>
-LinkedQueue<T>::LinkedQueue(const std::initializer_list<T>& il)
+template<class T, class Alloc>
+LinkedQueue<T,Alloc>::LinkedQueue(const std::initializer_list<T>& il, const Alloc& alloc)
+: node_alloc(alloc)
 {
 	for (const T& it_var : il)	//straight from the array_queue
 		enqueue(it_var);
@@ -162,10 +185,10 @@ LinkedQueue<T>::LinkedQueue(const std::initializer_list<T>& il)
 
 // ics::LinkedQueue<int> q({1,2,3});
 
-template<class T>
+template<class T, class Alloc>
 template<class Iterable>
-LinkedQueue<T>::LinkedQueue(const Iterable& i)
-: used (i.size())
+LinkedQueue<T,Alloc>::LinkedQueue(const Iterable& i, const Alloc& alloc)
+: node_alloc(alloc)
 {
 	for (const T& v :i)
 		enqueue(v);
@@ -176,8 +199,8 @@ LinkedQueue<T>::LinkedQueue(const Iterable& i)
 //
 //Queries
 
-template<class T>
-bool LinkedQueue<T>::empty() const {
+template<class T, class Alloc>
+bool LinkedQueue<T,Alloc>::empty() const {
 //	return front ==nullptr;	//WHOOPS CHANGED FROM FRONT == NULLPTR TO THIS
 	return used == 0 ;
 	//i CHANGED IT BACK
@@ -185,14 +208,14 @@ bool LinkedQueue<T>::empty() const {
 
 
 
-template<class T>
-int LinkedQueue<T>::size() const {
+template<class T, class Alloc>
+int LinkedQueue<T,Alloc>::size() const {
 	return used;
 }
 
 
-template<class T>
-T& LinkedQueue<T>::peek () const {
+template<class T, class Alloc>
+T& LinkedQueue<T,Alloc>::peek () const {
 	if (this->empty())
 		throw EmptyError("LinkedQueue::peek");
 	return front->value; // dont use a variable to store the reference value
@@ -201,8 +224,14 @@ T& LinkedQueue<T>::peek () const {
 }
 
 
-template<class T>
-std::string LinkedQueue<T>::str() const {
+template<class T, class Alloc>
+Alloc LinkedQueue<T,Alloc>::get_allocator() const {
+	return Alloc(node_alloc);
+}
+
+
+template<class T, class Alloc>
+std::string LinkedQueue<T,Alloc>::str() const {
 	std::ostringstream answer ;
 	answer <<"queue[";
 
@@ -224,9 +253,9 @@ std::string LinkedQueue<T>::str() const {
 //
 //Commands
 
-template<class T>
-int LinkedQueue<T>::enqueue(const T& element) {
-	LN* list_to_add = new LN(element,nullptr);	//using new creates the variable in th GLOBAL SCOPE. THAT'S WHAT NEW IS FOR
+template<class T, class Alloc>
+int LinkedQueue<T,Alloc>::enqueue(const T& element) {
+	LN* list_to_add = new_node(element,nullptr);	//using new creates the variable in th GLOBAL SCOPE. THAT'S WHAT NEW IS FOR
  	if (front == nullptr && rear == nullptr)
  		rear = front =  list_to_add; // got em
 	else
@@ -241,21 +270,25 @@ int LinkedQueue<T>::enqueue(const T& element) {
 }
 
 
-template<class T>
-T LinkedQueue<T>::dequeue() {
+template<class T, class Alloc>
+T LinkedQueue<T,Alloc>::dequeue() {
 	if (this->empty())
 		throw EmptyError("LinkedQueue::dequeue");
 
 	T answer = front->value;
+	LN* to_delete = front;
 	front = front->next;
+	delete_node(to_delete);	//was leaking every dequeued node
+	if (front == nullptr)	//queue is empty again: enqueue checks front/rear for nullptr
+		rear = nullptr;
 	mod_count++;
 	used--;
 	return answer;
 }
 
 
-template<class T>
-void LinkedQueue<T>::clear() {	//This is a queue in linked list format. Not an array queue.
+template<class T, class Alloc>
+void LinkedQueue<T,Alloc>::clear() {	//This is a queue in linked list format. Not an array queue.
 	delete_list(front);
 	mod_count++;
 }
@@ -272,9 +305,9 @@ auto x = *i;
 do something with x
 
 */
-template<class T>
+template<class T, class Alloc>
 template<class Iterable>
-int LinkedQueue<T>::enqueue_all(const Iterable& i) {
+int LinkedQueue<T,Alloc>::enqueue_all(const Iterable& i) {
 	int count =0;
 	for (const T& v: i)
 		count += enqueue(v);
@@ -286,8 +319,8 @@ int LinkedQueue<T>::enqueue_all(const Iterable& i) {
 //
 //Operators
 
-template<class T>
-LinkedQueue<T>& LinkedQueue<T>::operator = (const LinkedQueue<T>& rhs) {
+template<class T, class Alloc>
+LinkedQueue<T,Alloc>& LinkedQueue<T,Alloc>::operator = (const LinkedQueue<T,Alloc>& rhs) {
 	if (this == &rhs)
 		return *this;
 
@@ -306,8 +339,8 @@ LinkedQueue<T>& LinkedQueue<T>::operator = (const LinkedQueue<T>& rhs) {
 //	rear =nullptr;
 
 
-template<class T>
-bool LinkedQueue<T>::operator == (const LinkedQueue<T>& rhs) const {
+template<class T, class Alloc>
+bool LinkedQueue<T,Alloc>::operator == (const LinkedQueue<T,Alloc>& rhs) const {
 	if (this == &rhs)
 		return true;
 
@@ -325,14 +358,14 @@ bool LinkedQueue<T>::operator == (const LinkedQueue<T>& rhs) const {
 }
 
 
-template<class T>
-bool LinkedQueue<T>::operator != (const LinkedQueue<T>& rhs) const {
+template<class T, class Alloc>
+bool LinkedQueue<T,Alloc>::operator != (const LinkedQueue<T,Alloc>& rhs) const {
 	return !(*this == rhs);
 }
 
 
-template<class T>
-std::ostream& operator << (std::ostream& outs, const LinkedQueue<T>& q) {
+template<class T, class Alloc>
+std::ostream& operator << (std::ostream& outs, const LinkedQueue<T,Alloc>& q) {
 	outs<<"queue[";
 
 	if (!q.empty())// checks if empty
@@ -350,14 +383,14 @@ std::ostream& operator << (std::ostream& outs, const LinkedQueue<T>& q) {
 //
 //Iterator constructors
 
-template<class T>
-auto LinkedQueue<T>::begin () const -> LinkedQueue<T>::Iterator {
-	return  Iterator(const_cast<LinkedQueue<T>*>(this), front );	//remember igor saying now to return local values. Does this count?
+template<class T, class Alloc>
+auto LinkedQueue<T,Alloc>::begin () const -> LinkedQueue<T,Alloc>::Iterator {
+	return  Iterator(const_cast<LinkedQueue<T,Alloc>*>(this), front );	//remember igor saying now to return local values. Does this count?
 }
 
-template<class T>
-auto LinkedQueue<T>::end () const -> LinkedQueue<T>::Iterator {
-	return  Iterator(const_cast<LinkedQueue<T>*>(this), nullptr);
+template<class T, class Alloc>
+auto LinkedQueue<T,Alloc>::end () const -> LinkedQueue<T,Alloc>::Iterator {
+	return  Iterator(const_cast<LinkedQueue<T,Alloc>*>(this), nullptr);
 }
 
 
@@ -365,13 +398,33 @@ auto LinkedQueue<T>::end () const -> LinkedQueue<T>::Iterator {
 //
 //Private helper methods
 
-template<class T>
-void LinkedQueue<T>::delete_list(LN*& front) {
+template<class T, class Alloc>
+auto LinkedQueue<T,Alloc>::new_node(const T& v, LN* n) -> LN* {
+	LN* ln = NodeTraits::allocate(node_alloc, 1);
+	try {
+		NodeTraits::construct(node_alloc, ln, v, n);
+	} catch (...) {
+		NodeTraits::deallocate(node_alloc, ln, 1);
+		throw;
+	}
+	return ln;
+}
+
+
+template<class T, class Alloc>
+void LinkedQueue<T,Alloc>::delete_node(LN* ln) {
+	NodeTraits::destroy(node_alloc, ln);
+	NodeTraits::deallocate(node_alloc, ln, 1);
+}
+
+
+template<class T, class Alloc>
+void LinkedQueue<T,Alloc>::delete_list(LN*& front) {
 	while (front != nullptr)
 	{
 		auto to_delete = front;
 		front = front->next;
-		delete to_delete;
+		delete_node(to_delete);
 	}
 	front = rear = nullptr;
 	used = 0;
@@ -385,20 +438,20 @@ void LinkedQueue<T>::delete_list(LN*& front) {
 //
 //Iterator class definitions
 
-template<class T>
-LinkedQueue<T>::Iterator::Iterator(LinkedQueue<T>* iterate_over, LN* initial)
+template<class T, class Alloc>
+LinkedQueue<T,Alloc>::Iterator::Iterator(LinkedQueue<T,Alloc>* iterate_over, LN* initial)
 : current (initial), ref_queue(iterate_over), expected_mod_count(ref_queue->mod_count)
 {	//That's it.
 }
 
 
-template<class T>
-LinkedQueue<T>::Iterator::~Iterator()
+template<class T, class Alloc>
+LinkedQueue<T,Alloc>::Iterator::~Iterator()
 {}
 
 
-template<class T>
-T LinkedQueue<T>::Iterator::erase() {
+template<class T, class Alloc>
+T LinkedQueue<T,Alloc>::Iterator::erase() {
 
 	//haven't even touched this one.
 	if (expected_mod_count != ref_queue->mod_count)
@@ -413,15 +466,18 @@ T LinkedQueue<T>::Iterator::erase() {
 
 	T return_value = current->value;
 
+	if (current == ref_queue->rear)	//erasing the last node: rear moves back to prev (nullptr if it was the only one)
+		ref_queue->rear = prev;
+
 	if (prev == nullptr)	//if it is the beginning of the array, start off with pointing the ref_queue
 	{
 		ref_queue->front = current->next;
-		delete current;
+		ref_queue->delete_node(current);
 		current = ref_queue->front;
 	}
 	else{
 		prev->next = current->next;
-		delete current;
+		ref_queue->delete_node(current);
 		current = prev->next;
 	}
 
@@ -432,16 +488,16 @@ T LinkedQueue<T>::Iterator::erase() {
 }
 
 
-template<class T>
-std::string LinkedQueue<T>::Iterator::str() const {
+template<class T, class Alloc>
+std::string LinkedQueue<T,Alloc>::Iterator::str() const {
 	std::ostringstream answer;
 	answer << ref_queue->str() << "(current=" << current << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
 	return answer.str();
 }
 
 
-template<class T>
-auto LinkedQueue<T>::Iterator::operator ++ () -> LinkedQueue<T>::Iterator& {
+template<class T, class Alloc>
+auto LinkedQueue<T,Alloc>::Iterator::operator ++ () -> LinkedQueue<T,Alloc>::Iterator& {
 
 	if (expected_mod_count != ref_queue->mod_count)
 		throw ConcurrentModificationError("LinkedQueue::Iterator::operator ++");
@@ -461,8 +517,8 @@ auto LinkedQueue<T>::Iterator::operator ++ () -> LinkedQueue<T>::Iterator& {
 }
 
 
-template<class T>
-auto LinkedQueue<T>::Iterator::operator ++ (int) -> LinkedQueue<T>::Iterator {
+template<class T, class Alloc>
+auto LinkedQueue<T,Alloc>::Iterator::operator ++ (int) -> LinkedQueue<T,Alloc>::Iterator {
 
 	if (expected_mod_count != ref_queue->mod_count)		// uhhh ,makes sure the iterator doesn't go out of bound?
 		throw ConcurrentModificationError("LinkedQueue::Iterator::operator ++");
@@ -483,8 +539,8 @@ auto LinkedQueue<T>::Iterator::operator ++ (int) -> LinkedQueue<T>::Iterator {
 }
 
 
-template<class T>
-bool LinkedQueue<T>::Iterator::operator == (const LinkedQueue<T>::Iterator& rhs) const {
+template<class T, class Alloc>
+bool LinkedQueue<T,Alloc>::Iterator::operator == (const LinkedQueue<T,Alloc>::Iterator& rhs) const {
 	if (expected_mod_count != ref_queue->mod_count)
 		throw ConcurrentModificationError ("Iterator::operator ==");
 	if (ref_queue != rhs.ref_queue)
@@ -495,8 +551,8 @@ bool LinkedQueue<T>::Iterator::operator == (const LinkedQueue<T>::Iterator& rhs)
 }
 
 
-template<class T>
-bool LinkedQueue<T>::Iterator::operator != (const LinkedQueue<T>::Iterator& rhs) const {
+template<class T, class Alloc>
+bool LinkedQueue<T,Alloc>::Iterator::operator != (const LinkedQueue<T,Alloc>::Iterator& rhs) const {
 	  if (expected_mod_count != ref_queue->mod_count)
 	    throw ConcurrentModificationError("ArrayQueue::Iterator::operator !=");
 	  if (ref_queue != rhs.ref_queue)
@@ -506,8 +562,8 @@ bool LinkedQueue<T>::Iterator::operator != (const LinkedQueue<T>::Iterator& rhs)
 }
 
 
-template<class T>
-T& LinkedQueue<T>::Iterator::operator *() const {
+template<class T, class Alloc>
+T& LinkedQueue<T,Alloc>::Iterator::operator *() const {
 	//straight from arrayQueue
 
   if (expected_mod_count != ref_queue->mod_count)
@@ -524,8 +580,8 @@ T& LinkedQueue<T>::Iterator::operator *() const {
 }
 
 
-template<class T>
-T* LinkedQueue<T>::Iterator::operator ->() const {
+template<class T, class Alloc>
+T* LinkedQueue<T,Alloc>::Iterator::operator ->() const {
 	//I don't even know what the hell this is.
 	//straight from arrayQueue
 
@@ -544,6 +600,16 @@ T* LinkedQueue<T>::Iterator::operator ->() const {
 }
 
 
+
+#if __cplusplus >= 201703L
+namespace pmr {
+  //LinkedQueue whose nodes come from a std::pmr::memory_resource: construct it with
+  //  std::pmr::polymorphic_allocator<T>(&resource)
+  template<class T>
+  using LinkedQueue = ics::LinkedQueue<T,std::pmr::polymorphic_allocator<T>>;
+}
+#endif
+
 }
 
 #endif /* LINKED_QUEUE_HPP_ */
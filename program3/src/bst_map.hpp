@@ -8,9 +8,14 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <memory>             //For std::allocator/std::allocator_traits
+#if __cplusplus >= 201703L
+#include <memory_resource>    //For std::pmr::polymorphic_allocator
+#endif
 #include "ics_exceptions.hpp"
 #include "pair.hpp"
 #include "array_queue.hpp"   //For traversal
+#include "value_index.hpp"    //In the repository root (shared with program4's HashMap)
 
 
 namespace ics {
@@ -19,20 +24,28 @@ namespace ics {
 //Instantiate such that tlt(a,b) is true, iff a is in the left subtree rooted by b
 //With a tlt specified in the template, the constructor cannot specify a clt.
 //If a tlt is defaulted, then the constructor must supply a clt (they cannot both be nullptr)
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> class BSTMap {
+//Alloc is any std::allocator-compatible allocator of Entry; it is rebound to allocate the TN nodes.
+//has_value searches the whole tree, unless index_values was called: then the map also keeps a
+//  ValueIndex (value -> number of keys with it), making has_value O(1) at the cost of
+//  value_index_bytes more memory. Copies keep indexing values (building their own index as they
+//  are made, so has_value only reads). An Iterator walks a queue of copies of the entries (in lt
+//  order), so writing through it does not change the map; but a T& from operator [] may be
+//  written at any later time, unseen: so once one is handed out the map drops its index
+//  (has_value searches again) until clear or operator = replaces its nodes.
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr, class Alloc = std::allocator<pair<KEY,T>>> class BSTMap {
   public:
     typedef pair<KEY,T> Entry;
 
     //Destructor/Constructors
     ~BSTMap();
 
-    BSTMap          (bool (*clt)(const KEY& a, const KEY& b) = nullptr);
-    BSTMap          (const BSTMap<KEY,T,tlt>& to_copy, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
-    explicit BSTMap (const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+    BSTMap          (bool (*clt)(const KEY& a, const KEY& b) = nullptr, const Alloc& alloc = Alloc());
+    BSTMap          (const BSTMap<KEY,T,tlt,Alloc>& to_copy, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+    explicit BSTMap (const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b) = nullptr, const Alloc& alloc = Alloc());
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
-    explicit BSTMap (const Iterable& i, bool (*clt)(const KEY& a, const KEY& b) = nullptr);
+    explicit BSTMap (const Iterable& i, bool (*clt)(const KEY& a, const KEY& b) = nullptr, const Alloc& alloc = Alloc());
 
 
     //Queries
@@ -40,6 +53,7 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> c
     int  size       () const;
     bool has_key    (const KEY& key) const;
     bool has_value  (const T& value) const;
+    Alloc get_allocator () const;
     std::string str () const; //supplies useful debugging information; contrast to operator <<
 
 
@@ -47,6 +61,8 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> c
     T    put   (const KEY& key, const T& value);
     T    erase (const KEY& key);
     void clear ();
+    void index_values (int (*vhash)(const T& v), double load_threshold = 0.5); //has_value by a ValueIndex (vhash == nullptr: stop)
+    int  value_index_bytes () const;  //Memory the value index uses (0 if none, or after operator [])
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
@@ -57,12 +73,12 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> c
 
     T&       operator [] (const KEY&);
     const T& operator [] (const KEY&) const;
-    BSTMap<KEY,T,tlt>& operator = (const BSTMap<KEY,T,tlt>& rhs);
-    bool operator == (const BSTMap<KEY,T,tlt>& rhs) const;
-    bool operator != (const BSTMap<KEY,T,tlt>& rhs) const;
+    BSTMap<KEY,T,tlt,Alloc>& operator = (const BSTMap<KEY,T,tlt,Alloc>& rhs);
+    bool operator == (const BSTMap<KEY,T,tlt,Alloc>& rhs) const;
+    bool operator != (const BSTMap<KEY,T,tlt,Alloc>& rhs) const;
 
-    template<class KEY2,class T2, bool (*lt2)(const KEY2& a, const KEY2& b)>
-    friend std::ostream& operator << (std::ostream& outs, const BSTMap<KEY2,T2,lt2>& m);
+    template<class KEY2,class T2, bool (*lt2)(const KEY2& a, const KEY2& b), class Alloc2>
+    friend std::ostream& operator << (std::ostream& outs, const BSTMap<KEY2,T2,lt2,Alloc2>& m);
 
 
 
@@ -72,28 +88,28 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> c
         ~Iterator();
         Entry       erase();
         std::string str  () const;
-        BSTMap<KEY,T,tlt>::Iterator& operator ++ ();
-        BSTMap<KEY,T,tlt>::Iterator  operator ++ (int);
-        bool operator == (const BSTMap<KEY,T,tlt>::Iterator& rhs) const;
-        bool operator != (const BSTMap<KEY,T,tlt>::Iterator& rhs) const;
+        BSTMap<KEY,T,tlt,Alloc>::Iterator& operator ++ ();
+        BSTMap<KEY,T,tlt,Alloc>::Iterator  operator ++ (int);
+        bool operator == (const BSTMap<KEY,T,tlt,Alloc>::Iterator& rhs) const;
+        bool operator != (const BSTMap<KEY,T,tlt,Alloc>::Iterator& rhs) const;
         Entry& operator *  () const;
         Entry* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt,Alloc>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
-        friend Iterator BSTMap<KEY,T,tlt>::begin () const;
-        friend Iterator BSTMap<KEY,T,tlt>::end   () const;
+        friend Iterator BSTMap<KEY,T,tlt,Alloc>::begin () const;
+        friend Iterator BSTMap<KEY,T,tlt,Alloc>::end   () const;
 
       private:
         //If can_erase is false, the value has been removed from "it" (++ does nothing)
         ArrayQueue<Entry> it;                 //Queue of all associations (from begin), to use as iterator via dequeue
-        BSTMap<KEY,T,tlt>* ref_map;
+        BSTMap<KEY,T,tlt,Alloc>* ref_map;
         int               expected_mod_count;
         bool              can_erase = true;
 
         //Called in friends begin/end
-        Iterator(BSTMap<KEY,T,tlt>* iterate_over, bool from_begin);
+        Iterator(BSTMap<KEY,T,tlt,Alloc>* iterate_over, bool from_begin);
     };
 
 
@@ -114,17 +130,33 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> c
         TN*   right;
     };
 
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<TN> NodeAlloc;
+  typedef std::allocator_traits<NodeAlloc>                                 NodeTraits;
+
   bool (*lt) (const KEY& a, const KEY& b); // The lt used for searching BST (from template or constructor)
+  NodeAlloc node_alloc;                    // Allocates/constructs every TN (see new_TN/delete_TN)
   TN* map       = nullptr;
   int used      = 0;                       //Cache for number of key->value pairs in the BST
   int mod_count = 0;                       //For sensing concurrent modification
+  bool leaked   = false;                   //operator [] handed out a T& into this tree: values may change unseen
+
+  //Reverse index for has_value (see index_values): built whenever value_hash != nullptr and !leaked
+  typedef ValueIndex<T,Alloc>                                                          ValueIndexType;
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<ValueIndexType> IndexAlloc;
+  typedef std::allocator_traits<IndexAlloc>                                            IndexTraits;
+
+  int (*value_hash)(const T& v) = nullptr;
+  double value_load_threshold   = 0.5;
+  ValueIndexType* value_index = nullptr;
 
   //Helper methods (find_key written iteratively, the rest recursively)
+  TN*   new_TN              (const Entry& v, TN* l = nullptr, TN* r = nullptr); //Allocate and construct a TN with node_alloc
+  void  delete_TN           (TN* tn);                                           //Destroy and deallocate a TN with node_alloc
   TN*   find_key            (TN*  root, const KEY& key)                 const; //Returns reference to key's node or nullptr
   bool  has_value           (TN*  root, const T& value)                 const; //Returns whether value is is root's tree
-  TN*   copy                (TN*  root)                                 const; //Copy the keys/values in root's tree (identical structure)
+  TN*   copy                (TN*  root);                                       //Copy the keys/values in root's tree (identical structure)
   void  copy_to_queue       (TN* root, ArrayQueue<Entry>& q)            const; //Fill queue with root's tree value
-  bool  equals              (TN*  root, const BSTMap<KEY,T,tlt>& other) const; //Returns whether root's keys/value are all in other
+  bool  equals              (TN*  root, const BSTMap<KEY,T,tlt,Alloc>& other) const; //Returns whether root's keys/value are all in other
   std::string string_rotated(TN* root, std::string indent)              const; //Returns string representing root's tree
 
   T     insert              (TN*& root, const KEY& key, const T& value);       //Put key->value, returning key's old value (or new one's, if key absent)
@@ -132,6 +164,10 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> c
   Entry remove_closest      (TN*& root);                                       //Helper for remove
   T     remove              (TN*& root, const KEY& key);                       //Remove key->value from root's tree
   void  delete_BST          (TN*& root);                                       //Deallocate all TN in tree; root == nullptr
+
+  void  build_values        ();                                                //Index every value (if value_hash != nullptr and not leaked)
+  void  drop_values         ();                                                //Delete the value index
+  void  index_tree          (TN* root, ValueIndexType* index)           const; //Add every value in root's tree to index
 };
 
 
@@ -143,40 +179,60 @@ template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr> c
 
 //Destructor/Constructors
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>	//1
-BSTMap<KEY,T,tlt>::~BSTMap() {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>	//1
+BSTMap<KEY,T,tlt,Alloc>::~BSTMap() {
+	drop_values();
 	delete_BST(map);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>	//2
-BSTMap<KEY,T,tlt>::BSTMap(bool (*clt)(const KEY& a, const KEY& b))
-: lt( tlt != nullptr ? tlt : clt)
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>	//2
+BSTMap<KEY,T,tlt,Alloc>::BSTMap(bool (*clt)(const KEY& a, const KEY& b), const Alloc& alloc)
+: lt( tlt != nullptr ? tlt : clt), node_alloc(alloc)
 {
-		if ( lt == clt)	//I think I might need to revise this
-			throw TemplateFunctionError ("BSTMap::default constructor: clt was specified when tlt was already given");
-		if (tlt == nullptr && clt == nullptr)
-			throw TemplateFunctionError ("BSTMap::defaul constructor: both lt were not specified");
-
+	if (lt == nullptr)
+		throw TemplateFunctionError("BSTMap::default constructor: neither specified");
+	if (tlt != nullptr && clt != nullptr && tlt != clt)
+		throw TemplateFunctionError("BSTMap::default constructor: both specified and different");
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>	//3
-BSTMap<KEY,T,tlt>::BSTMap(const BSTMap<KEY,T,tlt>& to_copy, bool (*clt)(const KEY& a, const KEY& b))
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>	//3
+BSTMap<KEY,T,tlt,Alloc>::BSTMap(const BSTMap<KEY,T,tlt,Alloc>& to_copy, bool (*clt)(const KEY& a, const KEY& b))
+: lt(tlt != nullptr ? tlt : clt), node_alloc(NodeTraits::select_on_container_copy_construction(to_copy.node_alloc)),
+  value_hash(to_copy.value_hash), value_load_threshold(to_copy.value_load_threshold)
 {
+	if (lt == nullptr)
+		lt = to_copy.lt;
+	if (tlt != nullptr && clt != nullptr && tlt != clt)
+		throw TemplateFunctionError("BSTMap::copy constructor: both specified and different");
+
+	if (lt == to_copy.lt) {	//Same order: copy the tree node for node
+		map  = copy(to_copy.map);
+		used = to_copy.used;
+	}
+	else	//Different order: every key must be reinserted (insert counts used)
+		for (const Entry& kv : to_copy)
+			insert(map, kv.first, kv.second);
+	build_values();	//now, not in has_value: a const map is only read
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>	//4
-BSTMap<KEY,T,tlt>::BSTMap(const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b))
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>	//4
+BSTMap<KEY,T,tlt,Alloc>::BSTMap(const std::initializer_list<Entry>& il, bool (*clt)(const KEY& a, const KEY& b), const Alloc& alloc)
+: BSTMap(clt, alloc)
 {
+	for (const Entry& kv : il)
+		put(kv.first, kv.second);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>	//5
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>	//5
 template <class Iterable>
-BSTMap<KEY,T,tlt>::BSTMap(const Iterable& i, bool (*clt)(const KEY& a, const KEY& b))
+BSTMap<KEY,T,tlt,Alloc>::BSTMap(const Iterable& i, bool (*clt)(const KEY& a, const KEY& b), const Alloc& alloc)
+: BSTMap(clt, alloc)
 {
+	put_all(i);
 }
 
 
@@ -184,32 +240,45 @@ BSTMap<KEY,T,tlt>::BSTMap(const Iterable& i, bool (*clt)(const KEY& a, const KEY
 //
 //Queries
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::empty() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+bool BSTMap<KEY,T,tlt,Alloc>::empty() const {
 	return used == 0;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-int BSTMap<KEY,T,tlt>::size() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+int BSTMap<KEY,T,tlt,Alloc>::size() const {
 	return used;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::has_key (const KEY& key) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+bool BSTMap<KEY,T,tlt,Alloc>::has_key (const KEY& key) const {
 	return find_key( map, key) != nullptr;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::has_value (const T& value) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+bool BSTMap<KEY,T,tlt,Alloc>::has_value (const T& value) const {
+	if (value_index != nullptr)	//one probe of the index, not a search of the tree
+		return value_index->contains(value);
 	return has_value(map, value);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-std::string BSTMap<KEY,T,tlt>::str() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+Alloc BSTMap<KEY,T,tlt,Alloc>::get_allocator() const {
+	return Alloc(node_alloc);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+std::string BSTMap<KEY,T,tlt,Alloc>::str() const {
+	//the tree rotated 90 degrees counterclockwise (root at the left), then the bookkeeping
+	std::ostringstream answer;
+	answer << "bst_map[" << (map == nullptr ? "" : "\n") << string_rotated(map, "")
+	       << "](used=" << used << ",mod_count=" << mod_count << ")";
+	return answer.str();
 }
 
 
@@ -217,26 +286,71 @@ std::string BSTMap<KEY,T,tlt>::str() const {
 //
 //Commands
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T BSTMap<KEY,T,tlt>::put(const KEY& key, const T& value) {//NEED TO MAKE OPERATOR [] WORK AFTER INSERT
-	return insert (map, key , value);
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+T BSTMap<KEY,T,tlt,Alloc>::put(const KEY& key, const T& value) {//NEED TO MAKE OPERATOR [] WORK AFTER INSERT
+	ValueIndexType* index = value_index;
+	if (index == nullptr)
+		return insert (map, key , value);
 
+	bool had_key = find_key(map, key) != nullptr;
+	T answer = insert (map, key , value);
+	if (had_key)
+		index->remove(answer);	//answer is the old value
+	index->add(value);
+	return answer;
+
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+T BSTMap<KEY,T,tlt,Alloc>::erase(const KEY& key) {
+	ValueIndexType* index = value_index;
+	T answer = remove(map, key);	//throws KeyError if key is not in the map
+	--used;
+	++mod_count;
+	if (index != nullptr)
+		index->remove(answer);
+	return answer;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T BSTMap<KEY,T,tlt>::erase(const KEY& key) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+void BSTMap<KEY,T,tlt,Alloc>::clear() {
+	delete_BST(map);
+	used   = 0;
+	leaked = false;	//every node a T& could refer to is gone
+	if (value_index != nullptr)
+		value_index->clear();
+	else
+		build_values();	//(re)start indexing, if the map was leaked
+	++mod_count;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-void BSTMap<KEY,T,tlt>::clear() {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+void BSTMap<KEY,T,tlt,Alloc>::index_values(int (*vhash)(const T& v), double load_threshold) {
+	drop_values();
+	value_hash           = vhash;
+	value_load_threshold = load_threshold;
+	build_values();	//a bad load_threshold throws here
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+int BSTMap<KEY,T,tlt,Alloc>::value_index_bytes() const {
+	return value_index == nullptr ? 0 : value_index->bytes();
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
 template<class Iterable>
-int BSTMap<KEY,T,tlt>::put_all(const Iterable& i) {
+int BSTMap<KEY,T,tlt,Alloc>::put_all(const Iterable& i) {
+	int count = 0;
+	for (const Entry& kv : i) {	//each put is O(height); there is nothing to pre-size in a BST
+		++count;
+		put(kv.first, kv.second);
+	}
+	return count;
 }
 
 
@@ -244,45 +358,70 @@ int BSTMap<KEY,T,tlt>::put_all(const Iterable& i) {
 //
 //Operators
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T& BSTMap<KEY,T,tlt>::operator [] (const KEY& key) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+T& BSTMap<KEY,T,tlt,Alloc>::operator [] (const KEY& key) {
+	leaked = true;	//the T& may be written at any later time: an index of the values
+	drop_values();	//  could not see it
+	return find_addempty(map, key);	//one search: adds key->T() if key is absent (counting used/mod_count)
+}
 
-	TN* val_index = find_key( map , key);
-	if (val_index != nullptr) //so if the search isn't nothing.
-		return val_index->value.second;	// going to assume that val_index already is an address to the node. Make changes here if wrong
 
-	++used;
-	++mod_count;
-	//so if you just called that index value, with a map to it, do what you would do for a python map.
-	insert(map, key, T());		//WHAT THE HELL IS THIS???
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+const T& BSTMap<KEY,T,tlt,Alloc>::operator [] (const KEY& key) const {
+	TN* val_index = find_key(map, key);
+	if (val_index != nullptr)
+		return val_index->value.second;
 
-	//OKAY, THIS WORKS
-	//DONT RETURN ANY VALUE AT THE END OF THIS FUNCTION. insert WILL NOT GIVE BACK  T's address!
+	std::ostringstream answer;
+	answer << "BSTMap::operator []: key(" << key << ") not in Map";
+	throw KeyError(answer.str());
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-const T& BSTMap<KEY,T,tlt>::operator [] (const KEY& key) const {
-}
-
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+BSTMap<KEY,T,tlt,Alloc>& BSTMap<KEY,T,tlt,Alloc>::operator = (const BSTMap<KEY,T,tlt,Alloc>& rhs) {
+	if (this == &rhs)
+		return *this;
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-BSTMap<KEY,T,tlt>& BSTMap<KEY,T,tlt>::operator = (const BSTMap<KEY,T,tlt>& rhs) {
+	TN* new_map = copy(rhs.map);	//first: if it throws, this map is unchanged
+	drop_values();	//this map keeps its own choice of indexing: rebuilt below
+	delete_BST(map);
+	lt   = rhs.lt;	//the copy has rhs's structure, so it must be searched with rhs's lt
+	map  = new_map;
+	used = rhs.used;
+	leaked = false;
+	build_values();
+	++mod_count;
+	return *this;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::operator == (const BSTMap<KEY,T,tlt>& rhs) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+bool BSTMap<KEY,T,tlt,Alloc>::operator == (const BSTMap<KEY,T,tlt,Alloc>& rhs) const {
+	if (this == &rhs)
+		return true;
+	if (used != rhs.used)
+		return false;
+	return equals(map, rhs);	//same size, so every key in rhs matching is enough
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::operator != (const BSTMap<KEY,T,tlt>& rhs) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+bool BSTMap<KEY,T,tlt,Alloc>::operator != (const BSTMap<KEY,T,tlt,Alloc>& rhs) const {
+	return !(*this == rhs);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt>& m) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt,Alloc>& m) {
+	outs << "map[";
+	bool first = true;
+	for (const pair<KEY,T>& kv : m) {	//in order of lt
+		outs << (first ? "" : ",") << kv.first << "->" << kv.second;
+		first = false;
+	}
+	outs << "]";
+	return outs;
 }
 
 
@@ -290,13 +429,14 @@ std::ostream& operator << (std::ostream& outs, const BSTMap<KEY,T,tlt>& m) {
 //
 //Iterator constructors
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto BSTMap<KEY,T,tlt>::begin () const -> BSTMap<KEY,T,tlt>::Iterator {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+auto BSTMap<KEY,T,tlt,Alloc>::begin () const -> BSTMap<KEY,T,tlt,Alloc>::Iterator {
+	return Iterator(const_cast<BSTMap<KEY,T,tlt,Alloc>*>(this),true);
 }
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto BSTMap<KEY,T,tlt>::end () const -> BSTMap<KEY,T,tlt>::Iterator {
- //insert code here
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+auto BSTMap<KEY,T,tlt,Alloc>::end () const -> BSTMap<KEY,T,tlt,Alloc>::Iterator {
+	return Iterator(const_cast<BSTMap<KEY,T,tlt,Alloc>*>(this),false);
 }
 
 
@@ -305,8 +445,28 @@ auto BSTMap<KEY,T,tlt>::end () const -> BSTMap<KEY,T,tlt>::Iterator {
 //
 //Private helper methods
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-typename BSTMap<KEY,T,tlt>::TN* BSTMap<KEY,T,tlt>::find_key (TN* root, const KEY& key) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+typename BSTMap<KEY,T,tlt,Alloc>::TN* BSTMap<KEY,T,tlt,Alloc>::new_TN (const Entry& v, TN* l, TN* r) {
+	TN* tn = NodeTraits::allocate(node_alloc, 1);
+	try {
+		NodeTraits::construct(node_alloc, tn, v, l, r);
+	} catch (...) {
+		NodeTraits::deallocate(node_alloc, tn, 1);
+		throw;
+	}
+	return tn;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+void BSTMap<KEY,T,tlt,Alloc>::delete_TN (TN* tn) {
+	NodeTraits::destroy(node_alloc, tn);
+	NodeTraits::deallocate(node_alloc, tn, 1);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+typename BSTMap<KEY,T,tlt,Alloc>::TN* BSTMap<KEY,T,tlt,Alloc>::find_key (TN* root, const KEY& key) const {
 	for (TN* currNode = root; currNode != nullptr; // so set a pointer to a tree node, ends if tree node is nullptr
 			currNode = lt (key,  currNode->value.first) ? currNode->left : currNode->right) // new tree node is determined by comp function. Goes to left branch or goes to right branch depending on function
 		if ( key == currNode->value.first )// if this nodes entry key is equal to target, return current node
@@ -318,8 +478,8 @@ typename BSTMap<KEY,T,tlt>::TN* BSTMap<KEY,T,tlt>::find_key (TN* root, const KEY
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::has_value (TN* root, const T& value) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+bool BSTMap<KEY,T,tlt,Alloc>::has_value (TN* root, const T& value) const {
 	if (root == nullptr) // just in case we get nothing in our tree. Or no further trees available
 		return false;
 	else
@@ -332,35 +492,66 @@ bool BSTMap<KEY,T,tlt>::has_value (TN* root, const T& value) const {
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-typename BSTMap<KEY,T,tlt>::TN* BSTMap<KEY,T,tlt>::copy (TN* root) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+typename BSTMap<KEY,T,tlt,Alloc>::TN* BSTMap<KEY,T,tlt,Alloc>::copy (TN* root) {
+	if (root == nullptr)
+		return nullptr;
+	TN* left = copy(root->left);	//allocated with this map's node_alloc, so not const
+	TN* right = nullptr;
+	try {
+		right = copy(root->right);
+		return new_TN(root->value, left, right);
+	} catch (...) {	//nothing copied so far outlives a failed copy
+		delete_BST(left);
+		delete_BST(right);
+		throw;
+	}
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-void BSTMap<KEY,T,tlt>::copy_to_queue (TN* root, ArrayQueue<Entry>& q) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+void BSTMap<KEY,T,tlt,Alloc>::copy_to_queue (TN* root, ArrayQueue<Entry>& q) const {
+	if (root == nullptr)
+		return;
+	copy_to_queue(root->left, q);	//in order: smaller keys (by lt) first
+	q.enqueue(root->value);
+	copy_to_queue(root->right, q);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::equals (TN* root, const BSTMap<KEY,T,tlt>& other) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+bool BSTMap<KEY,T,tlt,Alloc>::equals (TN* root, const BSTMap<KEY,T,tlt,Alloc>& other) const {
+	if (root == nullptr)
+		return true;
+	TN* match = other.find_key(other.map, root->value.first);	//other's lt may shape its tree differently
+	if (match == nullptr || !(match->value.second == root->value.second))
+		return false;
+	return equals(root->left, other) && equals(root->right, other);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-std::string BSTMap<KEY,T,tlt>::string_rotated(TN* root, std::string indent) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+std::string BSTMap<KEY,T,tlt,Alloc>::string_rotated(TN* root, std::string indent) const {
+	//right subtree above, left below: each level indented 2 more dots
+	if (root == nullptr)
+		return "";
+	std::ostringstream answer;
+	answer << string_rotated(root->right, indent+"..")
+	       << indent << root->value.first << "->" << root->value.second << "\n"
+	       << string_rotated(root->left, indent+"..");
+	return answer.str();
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T BSTMap<KEY,T,tlt>::insert (TN*& root, const KEY& key, const T& value) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+T BSTMap<KEY,T,tlt,Alloc>::insert (TN*& root, const KEY& key, const T& value) {
 	//soooooo insert an entry of key and value. This will go down a list? It won't change tree values?
 	//what is value? it is an entry ( String key, something value)
 	//what methods are available to  entry?  first and second:: will return those values
 	//
 	if (root == nullptr)
 	{
-		root = new TN(Entry ( key, value)); //create me a new TN which has an entry value
+		root = new_TN(Entry ( key, value)); //create me a new TN which has an entry value
 		mod_count++;	//remember to add
 		used++;
 		return root->value.second; //return new value of the entry
@@ -376,36 +567,45 @@ T BSTMap<KEY,T,tlt>::insert (TN*& root, const KEY& key, const T& value) {
 
 	// Use recursion? And use lt function to determine priority?
 	if (  lt( key, root->value.first))	//so if key "g" is less than key "k", go to the left tree. Whatever lt that is
-		insert ( root->left, key , value);
+		return insert ( root->left, key , value);	//pass the subtree's answer back up
 	else
-		insert(root->right, key, value);
+		return insert(root->right, key, value);
 
 	//need to make operator [] work first
 
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T& BSTMap<KEY,T,tlt>::find_addempty (TN*& root, const KEY& key) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+T& BSTMap<KEY,T,tlt,Alloc>::find_addempty (TN*& root, const KEY& key) {
+	if (root == nullptr) {	//key is absent: it goes here, as in insert
+		root = new_TN(Entry(key, T()));
+		++used;
+		++mod_count;
+		return root->value.second;
+	}
+	if (key == root->value.first)
+		return root->value.second;
+	return find_addempty(lt(key, root->value.first) ? root->left : root->right, key);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-pair<KEY,T> BSTMap<KEY,T,tlt>::remove_closest(TN*& root) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+pair<KEY,T> BSTMap<KEY,T,tlt,Alloc>::remove_closest(TN*& root) {
   if (root->right != nullptr)
     return remove_closest(root->right);
   else{
     Entry to_return = root->value;
     TN* to_delete = root;
     root = root->left;
-    delete to_delete;
+    delete_TN(to_delete);
     return to_return;
   }
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-T BSTMap<KEY,T,tlt>::remove (TN*& root, const KEY& key) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+T BSTMap<KEY,T,tlt,Alloc>::remove (TN*& root, const KEY& key) {
   if (root == nullptr) {
     std::ostringstream answer;
     answer << "BSTMap::erase: key(" << key << ") not in Map";
@@ -416,11 +616,11 @@ T BSTMap<KEY,T,tlt>::remove (TN*& root, const KEY& key) {
       if (root->left == nullptr) {
         TN* to_delete = root;
         root = root->right;
-        delete to_delete;
+        delete_TN(to_delete);
       }else if (root->right == nullptr) {
         TN* to_delete = root;
         root = root->left;
-        delete to_delete;
+        delete_TN(to_delete);
       }else
         root->value = remove_closest(root->left);
       return to_return;
@@ -429,8 +629,52 @@ T BSTMap<KEY,T,tlt>::remove (TN*& root, const KEY& key) {
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-void BSTMap<KEY,T,tlt>::delete_BST (TN*& root) {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+void BSTMap<KEY,T,tlt,Alloc>::delete_BST (TN*& root) {
+	if (root == nullptr)	//nothing left in this subtree
+		return;
+	delete_BST(root->left);	//children first, then this node
+	delete_BST(root->right);
+	delete_TN(root);
+	root = nullptr;			//root is a reference: the parent's pointer is cleared too
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+void BSTMap<KEY,T,tlt,Alloc>::build_values () {
+	if (value_hash == nullptr || leaked)
+		return;
+	IndexAlloc index_alloc(node_alloc);
+	ValueIndexType* index = IndexTraits::allocate(index_alloc, 1);
+	try {
+		IndexTraits::construct(index_alloc, index, value_hash, value_load_threshold, Alloc(node_alloc));
+	} catch (...) {
+		IndexTraits::deallocate(index_alloc, index, 1);
+		throw;
+	}
+	value_index = index;
+	index_tree(map, value_index);
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+void BSTMap<KEY,T,tlt,Alloc>::drop_values () {
+	if (value_index == nullptr)
+		return;
+	IndexAlloc index_alloc(node_alloc);
+	IndexTraits::destroy(index_alloc, value_index);
+	IndexTraits::deallocate(index_alloc, value_index, 1);
+	value_index = nullptr;
+}
+
+
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+void BSTMap<KEY,T,tlt,Alloc>::index_tree (TN* root, ValueIndexType* index) const {
+	if (root == nullptr)
+		return;
+	index->add(root->value.second);
+	index_tree(root->left,  index);
+	index_tree(root->right, index);
 }
 
 
@@ -442,57 +686,130 @@ void BSTMap<KEY,T,tlt>::delete_BST (TN*& root) {
 //
 //Iterator class definitions
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-BSTMap<KEY,T,tlt>::Iterator::Iterator(BSTMap<KEY,T,tlt>* iterate_over, bool from_begin)
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+BSTMap<KEY,T,tlt,Alloc>::Iterator::Iterator(BSTMap<KEY,T,tlt,Alloc>* iterate_over, bool from_begin)
+: it(), ref_map(iterate_over), expected_mod_count(ref_map->mod_count)
 {
+	if (from_begin)	//end's queue stays empty
+		ref_map->copy_to_queue(ref_map->map, it);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-BSTMap<KEY,T,tlt>::Iterator::~Iterator()
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+BSTMap<KEY,T,tlt,Alloc>::Iterator::~Iterator()
 {}
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto BSTMap<KEY,T,tlt>::Iterator::erase() -> Entry {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+auto BSTMap<KEY,T,tlt,Alloc>::Iterator::erase() -> Entry {
+	if (expected_mod_count != ref_map->mod_count)
+		throw ConcurrentModificationError("BSTMap::Iterator::erase");
+	if (!can_erase)
+		throw CannotEraseError("BSTMap::Iterator::erase Iterator cursor already erased");
+	if (it.empty())
+		throw CannotEraseError("BSTMap::Iterator::erase Iterator cursor beyond data structure");
+
+	//The front of it is the current entry: dequeued, the front is the "next" one
+	can_erase = false;
+	Entry to_return = it.dequeue();
+	ref_map->erase(to_return.first);	//also removes its value from the value index
+	expected_mod_count = ref_map->mod_count;
+	return to_return;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-std::string BSTMap<KEY,T,tlt>::Iterator::str() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+std::string BSTMap<KEY,T,tlt,Alloc>::Iterator::str() const {
+	std::ostringstream answer;
+	answer << ref_map->str() << "(remaining=" << it.size() << ",expected_mod_count=" << expected_mod_count
+	       << ",can_erase=" << can_erase << ")";
+	return answer.str();
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto  BSTMap<KEY,T,tlt>::Iterator::operator ++ () -> BSTMap<KEY,T,tlt>::Iterator& {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+auto  BSTMap<KEY,T,tlt,Alloc>::Iterator::operator ++ () -> BSTMap<KEY,T,tlt,Alloc>::Iterator& {
+	if (expected_mod_count != ref_map->mod_count)
+		throw ConcurrentModificationError("BSTMap::Iterator::operator ++");
+
+	if (it.empty())
+		return *this;
+	if (can_erase)
+		it.dequeue();
+	else
+		can_erase = true;	//erase already dequeued the current entry
+	return *this;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-auto BSTMap<KEY,T,tlt>::Iterator::operator ++ (int) -> BSTMap<KEY,T,tlt>::Iterator {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+auto BSTMap<KEY,T,tlt,Alloc>::Iterator::operator ++ (int) -> BSTMap<KEY,T,tlt,Alloc>::Iterator {
+	if (expected_mod_count != ref_map->mod_count)
+		throw ConcurrentModificationError("BSTMap::Iterator::operator ++(int)");
+
+	if (it.empty())
+		return *this;
+	Iterator to_return(*this);
+	if (can_erase)
+		it.dequeue();
+	else
+		can_erase = true;
+	return to_return;
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::Iterator::operator == (const BSTMap<KEY,T,tlt>::Iterator& rhs) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+bool BSTMap<KEY,T,tlt,Alloc>::Iterator::operator == (const BSTMap<KEY,T,tlt,Alloc>::Iterator& rhs) const {
+	const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+	if (rhsASI == 0)
+		throw IteratorTypeError("BSTMap::Iterator::operator ==");
+	if (expected_mod_count != ref_map->mod_count)
+		throw ConcurrentModificationError("BSTMap::Iterator::operator ==");
+	if (ref_map != rhsASI->ref_map)
+		throw ComparingDifferentIteratorsError("BSTMap::Iterator::operator ==");
+
+	return it.size() == rhsASI->it.size();	//same map, so the same number left means the same position
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-bool BSTMap<KEY,T,tlt>::Iterator::operator != (const BSTMap<KEY,T,tlt>::Iterator& rhs) const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+bool BSTMap<KEY,T,tlt,Alloc>::Iterator::operator != (const BSTMap<KEY,T,tlt,Alloc>::Iterator& rhs) const {
+	return !(*this == rhs);
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-pair<KEY,T>& BSTMap<KEY,T,tlt>::Iterator::operator *() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+pair<KEY,T>& BSTMap<KEY,T,tlt,Alloc>::Iterator::operator *() const {
+	if (expected_mod_count != ref_map->mod_count)
+		throw ConcurrentModificationError("BSTMap::Iterator::operator *");
+	if (!can_erase || it.empty())
+		throw IteratorPositionIllegal("BSTMap::Iterator::operator * Iterator illegal: exhausted or erased");
+
+	return it.peek();
 }
 
 
-template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b)>
-pair<KEY,T>* BSTMap<KEY,T,tlt>::Iterator::operator ->() const {
+template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b), class Alloc>
+pair<KEY,T>* BSTMap<KEY,T,tlt,Alloc>::Iterator::operator ->() const {
+	if (expected_mod_count != ref_map->mod_count)
+		throw ConcurrentModificationError("BSTMap::Iterator::operator ->");
+	if (!can_erase || it.empty())
+		throw IteratorPositionIllegal("BSTMap::Iterator::operator -> Iterator illegal: exhausted or erased");
+
+	return &it.peek();
 }
 
 
+
+#if __cplusplus >= 201703L
+namespace pmr {
+  //BSTMap whose nodes come from a std::pmr::memory_resource: pass
+  //  std::pmr::polymorphic_allocator<pair<KEY,T>>(&resource) as the last constructor argument
+  template<class KEY,class T, bool (*tlt)(const KEY& a, const KEY& b) = nullptr>
+  using BSTMap = ics::BSTMap<KEY,T,tlt,std::pmr::polymorphic_allocator<pair<KEY,T>>>;
+}
+#endif
+
 }
 
 #endif /* BST_MAP_HPP_ */
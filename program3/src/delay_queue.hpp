@@ -0,0 +1,328 @@
+#ifndef DELAY_QUEUE_HPP_
+#define DELAY_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "ics_exceptions.hpp"
+#include "heap_priority_queue.hpp"
+
+
+namespace ics {
+
+
+//A thread-safe queue of values that each become available at a deadline (e.g., delayed
+//  retries): take() returns the value with the earliest deadline once that deadline has
+//  passed, blocking until then. Values with equal deadlines come out in enqueue order.
+//The values are kept in a HeapPriorityQueue ordered by deadline. Like java.util.concurrent's
+//  DelayQueue, one waiting taker (the "leader") sleeps until the earliest deadline while any
+//  others sleep until signaled, so N takers do not all wake at every deadline; an enqueue
+//  that becomes the new earliest deadline wakes a taker to re-arm its wait.
+//take_all_due() removes every value already due in one lock acquisition (for batching).
+//close() wakes every blocked taker: take() on a closed queue returns values that remain
+//  (still waiting for their deadlines) and throws EmptyError once it is empty.
+//T must be default-constructible and copyable (as for HeapPriorityQueue).
+template<class T, class Clock = std::chrono::steady_clock> class DelayQueue {
+  public:
+    typedef typename Clock::time_point time_point;
+    typedef typename Clock::duration   duration;
+
+    //Destructor/Constructors
+    ~DelayQueue();
+    DelayQueue ();
+    DelayQueue (const DelayQueue<T,Clock>& to_copy)                   = delete;
+    DelayQueue<T,Clock>& operator = (const DelayQueue<T,Clock>& rhs)  = delete;
+
+
+    //Queries (a snapshot: other threads may change the queue at any time)
+    bool       empty         () const;
+    int        size          () const;   //Pending values, due or not
+    time_point next_deadline () const;   //Throws EmptyError if empty
+    bool       closed        () const;
+    int        takers_waiting() const;   //Takers blocked in take/take_for/take_batch (leader or not)
+    std::string str          () const;   //supplies useful debugging information
+
+
+    //Commands
+    int  enqueue_at   (const T& element, time_point deadline);
+    template<class Rep, class Period>
+    int  enqueue      (const T& element, std::chrono::duration<Rep,Period> delay);
+
+    T    take         ();                               //Blocks until the earliest value is due
+    bool try_take     (T& element);                     //false if no value is due now
+    template<class Rep, class Period>
+    bool take_for     (T& element, std::chrono::duration<Rep,Period> timeout);   //false if none came due
+
+    std::vector<T> take_all_due ();                     //Every value due now (maybe none), earliest first
+    std::vector<T> take_batch   ();                     //Blocks until at least one is due, then take_all_due
+
+    void close ();
+
+
+  private:
+    struct Entry {
+      time_point deadline;
+      long long  sequence = 0;   //Enqueue order: breaks ties between equal deadlines
+      T          value;
+    };
+
+    static bool earlier (const Entry& a, const Entry& b);    //The heap's gt: a is due before b
+
+    mutable std::mutex        lock;
+    std::condition_variable   available;
+    HeapPriorityQueue<Entry>  pending;
+    long long                 next_sequence = 0;
+    std::thread::id           leader;                  //The taker waiting for pending.peek()'s deadline (none: id())
+    int                       takers        = 0;       //Takers in wait_for_due (see takers_waiting)
+    bool                      is_closed     = false;
+
+    //Helper methods (call with lock held)
+    bool wait_for_due (std::unique_lock<std::mutex>& held, const time_point* give_up);
+    T    pop          ();
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//DelayQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, class Clock>
+DelayQueue<T,Clock>::~DelayQueue() {
+}
+
+
+template<class T, class Clock>
+DelayQueue<T,Clock>::DelayQueue()
+: pending(earlier)
+{}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, class Clock>
+bool DelayQueue<T,Clock>::empty() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return pending.empty();
+}
+
+
+template<class T, class Clock>
+int DelayQueue<T,Clock>::size() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return pending.size();
+}
+
+
+template<class T, class Clock>
+auto DelayQueue<T,Clock>::next_deadline() const -> time_point {
+  std::lock_guard<std::mutex> guard(lock);
+  if (pending.empty())
+    throw EmptyError("DelayQueue::next_deadline");
+  return pending.peek().deadline;
+}
+
+
+template<class T, class Clock>
+bool DelayQueue<T,Clock>::closed() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return is_closed;
+}
+
+
+//A taker counts itself and sleeps on available under one hold of lock: so every taker counted
+//  here (while lock is held) is asleep
+template<class T, class Clock>
+int DelayQueue<T,Clock>::takers_waiting() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return takers;
+}
+
+
+template<class T, class Clock>
+std::string DelayQueue<T,Clock>::str() const {
+  std::lock_guard<std::mutex> guard(lock);
+  std::ostringstream answer;
+  answer << "DelayQueue(pending=" << pending.size();
+  if (!pending.empty())
+    answer << ",next due in " << std::chrono::duration<double>(pending.peek().deadline - Clock::now()).count() << "s";
+  answer << ",takers=" << takers << ",has_leader=" << (leader != std::thread::id()) << (is_closed ? ",closed" : "") << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, class Clock>
+int DelayQueue<T,Clock>::enqueue_at(const T& element, time_point deadline) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (is_closed)
+    throw EmptyError("DelayQueue::enqueue (closed)");
+  Entry e;
+  e.deadline = deadline;
+  e.sequence = next_sequence++;
+  e.value    = element;
+  pending.enqueue(e);
+
+  //A new earliest deadline: the leader (if any) is sleeping too long, so hand off leadership;
+  //  with no leader, wake a taker to become one (any takers are sleeping until signaled)
+  if (pending.peek().sequence == e.sequence)
+    leader = std::thread::id();
+  if (leader == std::thread::id())
+    available.notify_one();
+  return 1;
+}
+
+
+template<class T, class Clock>
+template<class Rep, class Period>
+int DelayQueue<T,Clock>::enqueue(const T& element, std::chrono::duration<Rep,Period> delay) {
+  return enqueue_at(element, Clock::now() + std::chrono::duration_cast<duration>(delay));
+}
+
+
+template<class T, class Clock>
+T DelayQueue<T,Clock>::take() {
+  std::unique_lock<std::mutex> held(lock);
+  wait_for_due(held, nullptr);
+  return pop();
+}
+
+
+template<class T, class Clock>
+bool DelayQueue<T,Clock>::try_take(T& element) {
+  std::lock_guard<std::mutex> guard(lock);
+  if (pending.empty() || pending.peek().deadline > Clock::now())
+    return false;
+  element = pop();
+  return true;
+}
+
+
+template<class T, class Clock>
+template<class Rep, class Period>
+bool DelayQueue<T,Clock>::take_for(T& element, std::chrono::duration<Rep,Period> timeout) {
+  time_point give_up = Clock::now() + std::chrono::duration_cast<duration>(timeout);
+  std::unique_lock<std::mutex> held(lock);
+  if (!wait_for_due(held, &give_up))
+    return false;
+  element = pop();
+  return true;
+}
+
+
+template<class T, class Clock>
+std::vector<T> DelayQueue<T,Clock>::take_all_due() {
+  std::vector<T> answer;
+  std::lock_guard<std::mutex> guard(lock);
+  time_point now = Clock::now();
+  while (!pending.empty() && pending.peek().deadline <= now)
+    answer.push_back(pop());
+  return answer;
+}
+
+
+template<class T, class Clock>
+std::vector<T> DelayQueue<T,Clock>::take_batch() {
+  std::vector<T> answer;
+  std::unique_lock<std::mutex> held(lock);
+  wait_for_due(held, nullptr);
+  time_point now = Clock::now();
+  do
+    answer.push_back(pop());
+  while (!pending.empty() && pending.peek().deadline <= now);
+  return answer;
+}
+
+
+template<class T, class Clock>
+void DelayQueue<T,Clock>::close() {
+  std::lock_guard<std::mutex> guard(lock);
+  is_closed = true;
+  available.notify_all();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, class Clock>
+bool DelayQueue<T,Clock>::earlier(const Entry& a, const Entry& b) {
+  return a.deadline < b.deadline || (a.deadline == b.deadline && a.sequence < b.sequence);
+}
+
+
+//Wait (releasing held) until pending.peek() is due: true; or until give_up (if not nullptr)
+//  passes first: false. Throws EmptyError if the queue is closed and empty.
+//However it returns (as in the finally of Java's DelayQueue.take), if no taker is left as
+//  leader but values are pending, wake a follower to become the leader: otherwise a leader
+//  giving up in take_for would leave the others asleep with nobody waiting for the deadline.
+template<class T, class Clock>
+bool DelayQueue<T,Clock>::wait_for_due(std::unique_lock<std::mutex>& held, const time_point* give_up) {
+  struct HandOff {
+    DelayQueue<T,Clock>* q;
+    ~HandOff() {
+      --q->takers;
+      if (q->leader == std::thread::id() && !q->pending.empty())
+        q->available.notify_one();
+    }
+  } hand_off{this};
+  ++takers;
+
+  for (;;) {
+    if (pending.empty()) {
+      if (is_closed)
+        throw EmptyError("DelayQueue::take (closed)");
+      if (give_up == nullptr)
+        available.wait(held);
+      else if (available.wait_until(held, *give_up) == std::cv_status::timeout && pending.empty())
+        return false;
+      continue;
+    }
+
+    time_point deadline = pending.peek().deadline;
+    time_point now      = Clock::now();
+    if (deadline <= now)
+      return true;
+    if (give_up != nullptr && *give_up <= now)
+      return false;
+
+    time_point until = (give_up != nullptr && *give_up < deadline ? *give_up : deadline);
+    if (leader != std::thread::id() && !is_closed)
+      give_up == nullptr ? available.wait(held) : (void)available.wait_until(held, *give_up);
+    else {
+      std::thread::id self = std::this_thread::get_id();
+      leader = self;
+      available.wait_until(held, until);
+      if (leader == self)         //An enqueue may have handed leadership to someone else meanwhile
+        leader = std::thread::id();
+    }
+  }
+}
+
+
+//Remove the earliest value; if takers are waiting, let one become the new leader
+template<class T, class Clock>
+T DelayQueue<T,Clock>::pop() {
+  T answer = pending.dequeue().value;
+  if (leader == std::thread::id() && !pending.empty())
+    available.notify_one();
+  return answer;
+}
+
+}
+
+#endif /* DELAY_QUEUE_HPP_ */
@@ -4,14 +4,22 @@
 
 
 //#include "driver_priority_queue.hpp"
-//int main() {
+//int main(int argc, char** argv) {
+//  if (argc > 1) {         //driver script_file: batch mode (see command_trace.hpp)
+//    ics::DriverPriorityQueue d(argv[1]);
+//    return 0;
+//  }
 //  ics::DriverPriorityQueue d;
 //  return 0;
 //}
 
 
 //#include "driver_map.hpp"
-//int main() {
+//int main(int argc, char** argv) {
+//  if (argc > 1) {         //driver script_file: batch mode (see command_trace.hpp)
+//    ics::DriverMap d(argv[1]);
+//    return 0;
+//  }
 //  ics::DriverMap d;
 //  return 0;
 //}
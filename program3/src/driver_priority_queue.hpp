@@ -4,9 +4,12 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <chrono>
 #include "ics46goody.hpp"
 #include "ics_exceptions.hpp"
+#include "command_trace.hpp"    //In the repository root (shared with program4's drivers)
 #include "heap_priority_queue.hpp"
+#include "fixed_hash_map.hpp"   //In the repository root (shared with program4's drivers)
 
 
 namespace ics {
@@ -16,6 +19,17 @@ bool reverse_gt(const std::string& a, const std::string& b) {return a > b;}
 
 typedef ics::HeapPriorityQueue<std::string> PriorityQueueType;
 
+//The commands execute knows, found with one probe of a table the compiler builds (not by
+//  comparing the name to each command in turn)
+enum QueueCommand {QueueGt, QueueEnqueue, QueueEnqueueAll, QueueDequeue, QueueClear, QueueAssign, QueueEmpty, QueueSize,
+                   QueuePeek, QueueStr, QueueRelations, QueueForEach, QueueLoadFile, QueueLoadBraces};
+
+constexpr auto queue_commands = make_fixed_hash_map(
+  fixed_entry("gt",QueueGt),      fixed_entry("e",QueueEnqueue),   fixed_entry("E",QueueEnqueueAll), fixed_entry("d",QueueDequeue),
+  fixed_entry("x",QueueClear),    fixed_entry("=",QueueAssign),    fixed_entry("m",QueueEmpty),      fixed_entry("s",QueueSize),
+  fixed_entry("p",QueuePeek),     fixed_entry("<",QueueStr),       fixed_entry("r",QueueRelations),  fixed_entry("f",QueueForEach),
+  fixed_entry("lf",QueueLoadFile),fixed_entry("l{",QueueLoadBraces));
+
 class DriverPriorityQueue {
   public:
   DriverPriorityQueue() : q(regular_gt){
@@ -26,8 +40,15 @@ class DriverPriorityQueue {
       process_commands("");
     };
 
+  //Batch mode: execute the commands in script_file (a text script or binary trace; see
+  //  command_trace.hpp) without prompts or str() dumps, then print their latencies.
+  //  The comparison is regular unless the script issues "gt;R" (or "gt;r") first.
+  DriverPriorityQueue(const std::string& script_file) : q(regular_gt){process_script(script_file);}
+
   private:
     PriorityQueueType q;
+    bool (*batch_gt)(const std::string& a, const std::string& b) = regular_gt;
+    std::size_t batch_sink = 0;
 
     PriorityQueueType prompt_queue(std::string preface, std::string message = "  Enter element for q2") {
       PriorityQueueType q2(regular_gt);
@@ -57,6 +78,62 @@ class DriverPriorityQueue {
       return ics::prompt_string("\n"+preface+"Enter queue command","",allowable);
     }
 
+    //Execute one menu command, taking what it would prompt for from c.args (q2's elements for
+    //  E/=/r); false if unknown. Results are folded into batch_sink so the timed work cannot be
+    //  optimized away.
+    bool execute(const Command& c) {
+      const QueueCommand* command = queue_commands.find(c.name);
+      if (command == nullptr)
+        return false;
+      switch (*command) {
+        case QueueGt:
+          batch_gt = (command_arg(c,0) == "R" ? reverse_gt : regular_gt);
+          q = PriorityQueueType(batch_gt);
+          break;
+        case QueueEnqueue:     batch_sink += q.enqueue(command_arg(c,0));                        break;
+        case QueueEnqueueAll:  batch_sink += q.enqueue_all(PriorityQueueType(c.args,batch_gt));  break;
+        case QueueDequeue:     batch_sink += q.dequeue().size();                                 break;
+        case QueueClear:       q.clear();                                                        break;
+        case QueueAssign:      q = PriorityQueueType(c.args,batch_gt);                           break;
+        case QueueEmpty:       batch_sink += q.empty();                                          break;
+        case QueueSize:        batch_sink += q.size();                                           break;
+        case QueuePeek:        batch_sink += q.peek().size();                                    break;
+        case QueueStr:         batch_sink += q.str().size();                                     break;
+        case QueueRelations: {
+          PriorityQueueType q2(c.args,batch_gt);
+          batch_sink += (q == q) + (q != q) + (q == q2) + (q != q2);
+          break;
+        }
+        case QueueForEach:               //The iterator menu's for-each over every element
+          for (const std::string& e : q)
+            batch_sink += e.size();
+          break;
+        case QueueLoadFile: {
+          std::ifstream in_queue((c.args.empty() ? "loadpq.txt" : c.args[0]).c_str());
+          if (in_queue.fail())
+            throw ics::FileOpenError(c.args.empty() ? "loadpq.txt" : c.args[0]);
+          std::string e;
+          while (getline(in_queue,e))
+            q.enqueue(e);
+          break;
+        }
+        case QueueLoadBraces:
+          q = PriorityQueueType({"c","b","d","e","a"},batch_gt);
+          break;
+      }
+      return true;
+    }
+
+    void process_script(const std::string& script_file) {
+      CommandScript script = load_commands(script_file);
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      CommandLatency latency = run_commands(script, [this] (const Command& c) {return execute(c);});
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now()-start;
+      std::cout << "Executed " << script.size() << " commands from " << script_file << " in " << elapsed.count() << "s"
+                << " (final size = " << q.size() << ", result checksum = " << batch_sink << ")" << std::endl;
+      std::cout << latency.str();
+    }
+
     void process_iterator_commands(PriorityQueueType& q, std::string preface) {
       std::string allowable[] = {"<","e","*","+","i","c","*a","ea","f","q",""};
       PriorityQueueType::Iterator i = q.begin();
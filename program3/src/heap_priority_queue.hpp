@@ -7,90 +7,130 @@
 #include <initializer_list>
 #include "ics_exceptions.hpp"
 #include <utility>              //For std::swap function
+#include <algorithm>            //For std::max
+#include <cstdint>              //For std::uint64_t (Stable sequence numbers)
+#include <memory>               //For std::allocator/std::allocator_traits
+#include <vector>               //For the cancellation token slot tables
+#if __cplusplus >= 201703L
+#include <memory_resource>      //For std::pmr::polymorphic_allocator
+#endif
 #include "array_stack.hpp"      //See operator <<
 
 
 namespace ics {
 
 
+//Array helpers shared by the array-based heaps (HeapPriorityQueue, MinMaxHeap in
+//  min_max_heap.hpp): allocate/destroy an array of length default-constructed T with alloc,
+//  and grow one (keeping its first used values) to at least new_length, at least doubling.
+//heap_ensure_length returns whether it reallocated (a, length updated; old ones released).
+template<class T, class Alloc> T*   heap_new_array     (Alloc& alloc, int length);
+template<class T, class Alloc> void heap_delete_array  (Alloc& alloc, T* a, int length);
+template<class T, class Alloc> bool heap_ensure_length (Alloc& alloc, T*& a, int& length, int used, int new_length);
+
+
 //Instantiate the templated class supplying tgt(a,b): true, iff a has higher priority than b.
 //If tgt is defaulted to nullptr in the template, then a constructor must supply cgt.
 //If both tgt and cgt are supplied, then they must be the same (by ==) function.
 //If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
 //The (unique) non-nullptr value supplied by tgt/cgt is stored in the instance variable gt.
-template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class HeapPriorityQueue {
+//Alloc (any std::allocator-compatible allocator of T) allocates the pq array; a stateful one
+//  is passed as the last constructor argument and is kept by copies but not by operator =.
+//If Stable is true (see StableHeapPriorityQueue below), values of equal priority (neither is gt
+//  the other) are dequeued in the order they were enqueued: each value gets a 64-bit enqueue
+//  sequence number, kept in an array parallel to pq, and every comparison in percolate_up/down
+//  breaks ties by it (see higher). With Stable false there is no sequence array and no cost.
+//enqueue_token enqueues a value and returns a Token that can later cancel it in O(1): cancel
+//  marks the value dead (a tombstone) rather than searching for it (as Iterator::erase must);
+//  dead values are skipped by peek/dequeue (and size, iteration, ==, <<), and when more than
+//  the compact threshold fraction (default 0.5) of the array is dead, the live values are
+//  compacted and re-heapified in O(N). A Token holds a slot number and the slot's generation
+//  (bumped whenever the slot is reused), so cancelling a value already dequeued/cancelled
+//  just returns false. Until enqueue_token is first called there is no per-value slot array.
+template<class T, bool (*tgt)(const T& a, const T& b) = nullptr, class Alloc = std::allocator<T>, bool Stable = false> class HeapPriorityQueue {
   public:
+    typedef std::uint64_t Token;    //From enqueue_token, for cancel
+
     //Destructor/Constructors
     ~HeapPriorityQueue();
 
-    HeapPriorityQueue          (bool (*cgt)(const T& a, const T& b) = nullptr);
-    explicit HeapPriorityQueue (int initial_length, bool (*cgt)(const T& a, const T& b));
-    HeapPriorityQueue          (const HeapPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b) = nullptr);
-    explicit HeapPriorityQueue (const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = nullptr);
+    HeapPriorityQueue          (bool (*cgt)(const T& a, const T& b) = nullptr, const Alloc& alloc = Alloc());
+    explicit HeapPriorityQueue (int initial_length, bool (*cgt)(const T& a, const T& b), const Alloc& alloc = Alloc());
+    HeapPriorityQueue          (const HeapPriorityQueue<T,tgt,Alloc,Stable>& to_copy, bool (*cgt)(const T& a, const T& b) = nullptr);
+    explicit HeapPriorityQueue (const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = nullptr, const Alloc& alloc = Alloc());
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
-    explicit HeapPriorityQueue (const Iterable& i, bool (*cgt)(const T& a, const T& b) = nullptr);
+    explicit HeapPriorityQueue (const Iterable& i, bool (*cgt)(const T& a, const T& b) = nullptr, const Alloc& alloc = Alloc());
 
 
     //Queries
     bool empty      () const;
     int  size       () const;
     T&   peek       () const;
+    Alloc get_allocator () const;
     std::string str () const; //supplies useful debugging information; contrast to operator <<
 
+    int    tombstones      () const;   //Cancelled values still in the array
+    double tombstone_ratio () const;   //tombstones()/(size()+tombstones()); 0 if neither
+    int    compactions     () const;   //Times the tombstones have been compacted away
+
 
     //Commands
     int  enqueue (const T& element);
     T    dequeue ();
     void clear   ();
 
+    Token enqueue_token (const T& element);      //Enqueue, returning a Token that can cancel it
+    bool  cancel        (Token t);               //O(1): false if t's value is no longer queued
+    void  set_compact_threshold (double fraction);
+
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
     int enqueue_all (const Iterable& i);
 
 
     //Operators
-    HeapPriorityQueue<T,tgt>& operator = (const HeapPriorityQueue<T,tgt>& rhs);
-    bool operator == (const HeapPriorityQueue<T,tgt>& rhs) const;
-    bool operator != (const HeapPriorityQueue<T,tgt>& rhs) const;
+    HeapPriorityQueue<T,tgt,Alloc,Stable>& operator = (const HeapPriorityQueue<T,tgt,Alloc,Stable>& rhs);
+    bool operator == (const HeapPriorityQueue<T,tgt,Alloc,Stable>& rhs) const;
+    bool operator != (const HeapPriorityQueue<T,tgt,Alloc,Stable>& rhs) const;
 
-    template<class T2, bool (*gt2)(const T2& a, const T2& b)>
-    friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T2,gt2>& pq);
+    template<class T2, bool (*gt2)(const T2& a, const T2& b), class Alloc2, bool Stable2>
+    friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T2,gt2,Alloc2,Stable2>& pq);
 
 
 
     class Iterator {
       public:
-        //Private constructor called in begin/end, which are friends of HeapPriorityQueue<T,tgt>
+        //Private constructor called in begin/end, which are friends of HeapPriorityQueue<T,tgt,Alloc,Stable>
         ~Iterator();
         T           erase();
         std::string str  () const;
-        HeapPriorityQueue<T,tgt>::Iterator& operator ++ ();
-        HeapPriorityQueue<T,tgt>::Iterator  operator ++ (int);
-        bool operator == (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const;
-        bool operator != (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const;
+        HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator& operator ++ ();
+        HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator  operator ++ (int);
+        bool operator == (const HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator& rhs) const;
+        bool operator != (const HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator& rhs) const;
         T& operator *  () const;
         T* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
 
-        friend Iterator HeapPriorityQueue<T,tgt>::begin () const;
-        friend Iterator HeapPriorityQueue<T,tgt>::end   () const;
+        friend Iterator HeapPriorityQueue<T,tgt,Alloc,Stable>::begin () const;
+        friend Iterator HeapPriorityQueue<T,tgt,Alloc,Stable>::end   () const;
 
       private:
         //If can_erase is false, the value has been removed from "it" (++ does nothing)
-        HeapPriorityQueue<T,tgt>  it;                 //copy of HPQ (from begin), to use as iterator via dequeue
-        HeapPriorityQueue<T,tgt>* ref_pq;
-        int                      expected_mod_count;
-        bool                     can_erase = true;
+        HeapPriorityQueue<T,tgt,Alloc,Stable>  it;                 //copy of HPQ (from begin), to use as iterator via dequeue
+        HeapPriorityQueue<T,tgt,Alloc,Stable>* ref_pq;
+        int                            expected_mod_count;
+        bool                           can_erase = true;
 
         //Called in friends begin/end
         //These constructors have different initializers (see it(...) in first one)
-        Iterator(HeapPriorityQueue<T,tgt>* iterate_over, bool from_begin);    // Called by begin
-        Iterator(HeapPriorityQueue<T,tgt>* iterate_over);                     // Called by end
+        Iterator(HeapPriorityQueue<T,tgt,Alloc,Stable>* iterate_over, bool from_begin);    // Called by begin
+        Iterator(HeapPriorityQueue<T,tgt,Alloc,Stable>* iterate_over);                     // Called by end
     };
 
 
@@ -99,20 +139,46 @@ template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class HeapPrior
 
 
   private:
+    enum : std::uint32_t {no_slot = 0xFFFFFFFF};   //slot[i] for a value enqueued without a token
+
     bool (*gt) (const T& a, const T& b); // The gt used by enqueue (from template or constructor)
+    Alloc alloc;                         // Allocates/constructs the pq array (see new_array/delete_array)
     T*  pq;                              // Smaller values in lower indexes (biggest is at used-1)
+    std::uint64_t* seq = nullptr;        // Stable only: seq[i] is pq[i]'s enqueue sequence number (same length)
+    std::uint64_t  next_seq = 0;         // Stable only: given to the next value enqueued
+    std::uint32_t* slot = nullptr;       // Once enqueue_token is called: slot[i] is pq[i]'s token slot (or no_slot)
+    std::vector<std::uint32_t> slot_generation;  // Per token slot: bumped when it is released (see Token)
+    std::vector<char>          slot_dead;        // Per token slot: its value was cancelled
+    std::vector<std::uint32_t> free_slots;       // Released token slots, to reuse
+    int    dead              = 0;        //Tombstones in pq[0..used-1] (never pq[0]: see drop_dead_top)
+    double compact_threshold = 0.5;      //Compact when dead > compact_threshold*used
+    int    compaction_count  = 0;
     int length    = 0;                   //Physical length of array: must be >= .size()
     int used      = 0;                   //Amount of array used:  invariant: 0 <= used <= length
     int mod_count = 0;                   //For sensing concurrent modification
 
 
     //Helper methods
+    T*   new_array      (int length);         // Allocate length default-constructed T with alloc
+    void delete_array   (T* a, int length);   // Destroy and deallocate an array from new_array
+    std::uint64_t* new_seq    (int length);           // Stable only (otherwise nullptr): a sequence array
+    void           delete_seq (std::uint64_t* s, int length);
+    template<class U> U*   new_parallel    (int length);         //An array parallel to pq (seq, slot) from alloc
+    template<class U> void delete_parallel (U* a, int length);
+    void place_new      (const T& element, std::uint32_t s);     //Enqueue element with token slot s
+    bool is_dead        (int i) const;
+    void release_slot   (int i);              //pq[i] is leaving: its token slot (if any) can be reused
+    void drop_dead_top  ();                   //Restore: pq[0] is never a tombstone
+    void compact        ();                   //Remove every tombstone, then heapify
     void ensure_length  (int new_length);
     int  left_child     (int i) const;         //Useful abstractions for heaps as arrays
     int  right_child    (int i) const;
     int  parent         (int i) const;
     bool is_root        (int i) const;
     bool in_heap        (int i) const;
+    bool higher         (int i, int j) const;  //pq[i] before pq[j]: gt, or (if Stable) tied and enqueued earlier
+    void swap_entries   (int i, int j);        //Swap pq[i]/pq[j] (and seq[i]/seq[j], if Stable)
+    void move_entry     (int to, int from);    //pq[to] = pq[from] (and seq, if Stable)
     void percolate_up   (int i);
     void percolate_down (int i);
     void heapify        ();                   // Percolate down all value is array (from indexes used-1 to 0): O(N)
@@ -122,35 +188,86 @@ template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class HeapPrior
 
 
 
+////////////////////////////////////////////////////////////////////////////////
+//
+//Shared heap array helpers
+
+template<class T, class Alloc>
+T* heap_new_array(Alloc& alloc, int length) {
+	typedef std::allocator_traits<Alloc> Traits;
+	T* a = Traits::allocate(alloc, length);
+	int i = 0;
+	try {
+		for (; i < length; ++i)
+			Traits::construct(alloc, a+i);
+	} catch (...) {
+		heap_delete_array(alloc, a, i);	//only the first i were constructed
+		throw;
+	}
+	return a;
+}
+
+
+template<class T, class Alloc>
+void heap_delete_array(Alloc& alloc, T* a, int length) {
+	typedef std::allocator_traits<Alloc> Traits;
+	if (a == nullptr)	//the initializer_list/Iterable constructors start with pq = nullptr
+		return;
+	for (int i = 0; i < length; ++i)
+		Traits::destroy(alloc, a+i);
+	Traits::deallocate(alloc, a, length);
+}
+
+
+template<class T, class Alloc>
+bool heap_ensure_length(Alloc& alloc, T*& a, int& length, int used, int new_length) {
+	if (length >= new_length)
+		return false;
+	T* old_a = a;
+	int old_length = length;
+	length = std::max(new_length, 2*length);	//double, so enqueue is amortized O(1) copying
+	a = heap_new_array<T>(alloc, length);
+	for (int i = 0; i < used; ++i)
+		a[i] = old_a[i];
+	heap_delete_array(alloc, old_a, old_length);
+	return true;
+}
+
+
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //HeapPriorityQueue class and related definitions
 
 //Destructor/Constructors
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::~HeapPriorityQueue() {
-	delete [] pq;
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+HeapPriorityQueue<T,tgt,Alloc,Stable>::~HeapPriorityQueue() {
+	delete_array(pq, length);
+	delete_seq(seq, length);
+	delete_parallel(slot, length);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(bool (*cgt)(const T& a, const T& b))
-: gt(tgt != nullptr ? tgt: cgt)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+HeapPriorityQueue<T,tgt,Alloc,Stable>::HeapPriorityQueue(bool (*cgt)(const T& a, const T& b), const Alloc& alloc)
+: gt(tgt != nullptr ? tgt: cgt), alloc(alloc)
 {
 	if (gt == nullptr)	//must supply gt function
 	    throw TemplateFunctionError("HeapPriorityQueue::default constructor: neither specified");
 	if (tgt != nullptr &&  cgt != nullptr && tgt != cgt)	//if both comp function is nullptr or both or not equal to each other.
 	    throw TemplateFunctionError("HeapPriorityQueue::default constructor: both specified and different");
 
-	pq = new T[length];
+	pq = new_array(length);
+	seq = new_seq(length);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(int initial_length,
-		bool (*cgt)(const T& a, const T& b))
-: gt(tgt != nullptr ? tgt: cgt), length(initial_length)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+HeapPriorityQueue<T,tgt,Alloc,Stable>::HeapPriorityQueue(int initial_length,
+		bool (*cgt)(const T& a, const T& b), const Alloc& alloc)
+: gt(tgt != nullptr ? tgt: cgt), alloc(alloc), length(initial_length)
 {
 	if (gt == nullptr)	//must supply gt function
 		throw TemplateFunctionError("HeapPriorityQueue::default constructor: neither specified");
@@ -158,22 +275,38 @@ HeapPriorityQueue<T,tgt>::HeapPriorityQueue(int initial_length,
 		throw TemplateFunctionError("HeapPriorityQueue::default constructor: both specified and different");
 	if (length <0)
 		length = 0;
-	pq = new T[length];
+	pq = new_array(length);
+	seq = new_seq(length);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const HeapPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b))
-: gt(tgt != nullptr ? tgt: cgt), length(to_copy.length), used (to_copy.used)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+HeapPriorityQueue<T,tgt,Alloc,Stable>::HeapPriorityQueue(const HeapPriorityQueue<T,tgt,Alloc,Stable>& to_copy, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != nullptr ? tgt: cgt),
+  alloc(std::allocator_traits<Alloc>::select_on_container_copy_construction(to_copy.alloc)),
+  length(to_copy.length), used (to_copy.used)
 {
-	if (gt == nullptr)	//must supply gt function
-		throw TemplateFunctionError("HeapPriorityQueue::default constructor: neither specified");
+	if (gt == nullptr)	//neither specified: copy to_copy's ordering (as the Iterator's copy of the queue needs)
+		gt = to_copy.gt;
 	if (tgt != nullptr &&  cgt != nullptr && tgt != cgt)	//if both comp function is nullptr or both or not equal to each other.
 		throw TemplateFunctionError("HeapPriorityQueue::default constructor: both specified and different");
 
-	pq = new T[length];
+	pq = new_array(length);
+	seq = new_seq(length);
+	next_seq = to_copy.next_seq;
+	if (Stable)
+		std::copy(to_copy.seq, to_copy.seq+to_copy.used, seq);
+	if (to_copy.slot != nullptr) {		//the copy's tokens cancel in the copy
+		slot = new_parallel<std::uint32_t>(length);
+		std::copy(to_copy.slot, to_copy.slot+to_copy.used, slot);
+		slot_generation = to_copy.slot_generation;
+		slot_dead       = to_copy.slot_dead;
+		free_slots      = to_copy.free_slots;
+		dead            = to_copy.dead;
+	}
+	compact_threshold = to_copy.compact_threshold;
 
-	if (cgt == to_copy.gt)
+	if (gt == to_copy.gt)
 	{
  		for (int i = 0; i <to_copy.used; i++)
 			pq[i] = to_copy.pq[i];
@@ -183,14 +316,15 @@ HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const HeapPriorityQueue<T,tgt>& to_c
 		for (int i = 0; i <to_copy.used; i++)
 			pq[i] = to_copy.pq[i];
 		heapify();
+		drop_dead_top();
 	}
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const std::initializer_list<T>& il,
-		bool (*cgt)(const T& a, const T& b))
-:	gt(tgt != nullptr ? tgt : cgt)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+HeapPriorityQueue<T,tgt,Alloc,Stable>::HeapPriorityQueue(const std::initializer_list<T>& il,
+		bool (*cgt)(const T& a, const T& b), const Alloc& alloc)
+:	gt(tgt != nullptr ? tgt : cgt), alloc(alloc)
   {
 
 	if (gt == nullptr)	//must supply gt function
@@ -205,11 +339,11 @@ HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const std::initializer_list<T>& il,
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
 template<class Iterable>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const Iterable& i,
-		bool (*cgt)(const T& a, const T& b))
-: gt(tgt != nullptr ? tgt : cgt) {
+HeapPriorityQueue<T,tgt,Alloc,Stable>::HeapPriorityQueue(const Iterable& i,
+		bool (*cgt)(const T& a, const T& b), const Alloc& alloc)
+: gt(tgt != nullptr ? tgt : cgt), alloc(alloc) {
 	if (gt == nullptr)
 		throw TemplateFunctionError("HeapPriorityQueue::iterable constructor: neither specified");
 	if (tgt != nullptr &&  cgt != nullptr && tgt != cgt)	//if both comp function is nullptr or both or not equal to each other.
@@ -226,74 +360,145 @@ HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const Iterable& i,
 //
 //Queries
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::empty() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+bool HeapPriorityQueue<T,tgt,Alloc,Stable>::empty() const {
 	return used == 0;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::size() const {
-	return used;
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+int HeapPriorityQueue<T,tgt,Alloc,Stable>::size() const {
+	return used - dead;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& HeapPriorityQueue<T,tgt>::peek () const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+T& HeapPriorityQueue<T,tgt,Alloc,Stable>::peek () const {
 	if (empty())
 		throw EmptyError("HeapPriorityQueue::peek()");
 	return pq[0];
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string HeapPriorityQueue<T,tgt>::str() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+Alloc HeapPriorityQueue<T,tgt,Alloc,Stable>::get_allocator() const {
+	return alloc;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+std::string HeapPriorityQueue<T,tgt,Alloc,Stable>::str() const {
 	std::ostringstream answer;
-	answer << *this << "(length)=" <<length<< ",used="<< used << ",mod_count=" << mod_count<<")";
+	answer << *this << "(length)=" <<length<< ",used="<< used << ",tombstones=" << dead << ",mod_count=" << mod_count<<")";
 	return answer.str();
 }
 
 
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+int HeapPriorityQueue<T,tgt,Alloc,Stable>::tombstones() const {
+	return dead;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+double HeapPriorityQueue<T,tgt,Alloc,Stable>::tombstone_ratio() const {
+	return used == 0 ? 0. : double(dead)/used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+int HeapPriorityQueue<T,tgt,Alloc,Stable>::compactions() const {
+	return compaction_count;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Commands
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::enqueue(const T& element) {
-	this->ensure_length(used +1);	//only makes new array when we have too many values.
-	pq[used++] = element;	//used already incremented
-
-	percolate_up(used-1);	// work from bottom up, add to the end, and work way up to preserve
-	//order of the tree
-	++mod_count;
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+int HeapPriorityQueue<T,tgt,Alloc,Stable>::enqueue(const T& element) {
+	place_new(element, no_slot);
 	return 1;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T HeapPriorityQueue<T,tgt>::dequeue() {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+T HeapPriorityQueue<T,tgt,Alloc,Stable>::dequeue() {
 	if (this->empty())
 		throw EmptyError("HeapPriorityQueue::dequeue");
 
 	T topVal = pq[0];
+	release_slot(0);
 	//Alright. Make top value equal to the last value of the tree (it will be at the bottom of the tree. Convienent.
-	pq [0] = pq[--used];	//already called -- on used to decreases size;
+	move_entry(0, --used);	//already called -- on used to decreases size;
 	percolate_down(0); //Here's the brunt of the work, percolating it down now.
+	drop_dead_top();
 	mod_count++;	//fixed mod_count;
 	return topVal;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::clear() {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::clear() {
+	for (int i = 0; i < used; ++i)	//outstanding tokens become stale
+		release_slot(i);
 	used = 0;
+	dead = 0;
+	++mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+auto HeapPriorityQueue<T,tgt,Alloc,Stable>::enqueue_token(const T& element) -> Token {
+	if (slot == nullptr) {
+		ensure_length(used+1);	//so length > 0 (new_parallel(0) is nullptr)
+		slot = new_parallel<std::uint32_t>(length);
+		for (int i = 0; i < used; ++i)
+			slot[i] = no_slot;
+	}
+	std::uint32_t s;
+	if (!free_slots.empty()) {
+		s = free_slots.back();
+		free_slots.pop_back();
+	} else {
+		s = slot_generation.size();
+		slot_generation.push_back(0);
+		slot_dead.push_back(false);
+	}
+	place_new(element, s);
+	return Token(slot_generation[s]) << 32 | s;
+}
+
+
+//A tombstone at the top is removed at once (so peek stays O(1) and const); others wait for
+//  dequeue to reach them or for compact
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+bool HeapPriorityQueue<T,tgt,Alloc,Stable>::cancel(Token t) {
+	std::uint32_t s = std::uint32_t(t);
+	if (s >= slot_generation.size() || slot_generation[s] != std::uint32_t(t >> 32) || slot_dead[s])
+		return false;
+	slot_dead[s] = true;
+	++dead;
+	drop_dead_top();
+	if (dead > compact_threshold*used)
+		compact();
 	++mod_count;
+	return true;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::set_compact_threshold(double fraction) {
+	compact_threshold = fraction;
+	if (dead > compact_threshold*used)
+		compact();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
 template <class Iterable>
-int HeapPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
+int HeapPriorityQueue<T,tgt,Alloc,Stable>::enqueue_all (const Iterable& i) {
 	int count = 0;
 	for ( const T &v :i)
 		count += enqueue(v);
@@ -305,8 +510,8 @@ int HeapPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
 //
 //Operators
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>& HeapPriorityQueue<T,tgt>::operator = (const HeapPriorityQueue<T,tgt>& rhs) {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+HeapPriorityQueue<T,tgt,Alloc,Stable>& HeapPriorityQueue<T,tgt,Alloc,Stable>::operator = (const HeapPriorityQueue<T,tgt,Alloc,Stable>& rhs) {
 	if (this == &rhs)
 		return *this;
 	this->ensure_length(rhs.used);
@@ -318,22 +523,38 @@ HeapPriorityQueue<T,tgt>& HeapPriorityQueue<T,tgt>::operator = (const HeapPriori
 		pq[i] = rhs.pq[i];
 //		std::cout << "pq[" << i << "] = " << pq[i] << ", rhs.pq[" << i << "] = " << rhs.pq[i] << std::endl;
 	}
+	if (Stable)
+		std::copy(rhs.seq, rhs.seq+used, seq);
+	next_seq = rhs.next_seq;
+	if (rhs.slot == nullptr) {
+		delete_parallel(slot, length);
+		slot = nullptr;
+	} else {
+		if (slot == nullptr)
+			slot = new_parallel<std::uint32_t>(length);
+		std::copy(rhs.slot, rhs.slot+used, slot);
+	}
+	slot_generation   = rhs.slot_generation;
+	slot_dead         = rhs.slot_dead;
+	free_slots        = rhs.free_slots;
+	dead              = rhs.dead;
+	compact_threshold = rhs.compact_threshold;
 	++mod_count;
 	return *this;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::operator == (const HeapPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+bool HeapPriorityQueue<T,tgt,Alloc,Stable>::operator == (const HeapPriorityQueue<T,tgt,Alloc,Stable>& rhs) const {
 	if (this == &rhs)
 		return true;
-	if (used != rhs.size() || gt != rhs.gt)
+	if (size() != rhs.size() || gt != rhs.gt)
 		return false;
 
-	HeapPriorityQueue<T,tgt> toCopy = *this;
-	HeapPriorityQueue<T,tgt>::Iterator rhs_i = rhs.begin();
+	HeapPriorityQueue<T,tgt,Alloc,Stable> toCopy = *this;
+	HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator rhs_i = rhs.begin();
 
-	for (int i = 0 ; i < used; ++i, ++rhs_i)
+	for (int i = 0 ; i < size(); ++i, ++rhs_i)
 		if (toCopy.dequeue() != *rhs_i)
 			return false;
 
@@ -343,27 +564,29 @@ bool HeapPriorityQueue<T,tgt>::operator == (const HeapPriorityQueue<T,tgt>& rhs)
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::operator != (const HeapPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+bool HeapPriorityQueue<T,tgt,Alloc,Stable>::operator != (const HeapPriorityQueue<T,tgt,Alloc,Stable>& rhs) const {
 	return !(*this ==rhs);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>& p) {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt,Alloc,Stable>& p) {
 	outs <<"priority_queue[";
 
 	T sort_list  [p.used];	//frustration. using built in sort function to give me how the function looks like. This is probably wrong
+	int live = 0;
 	for (int i = 0; i <p.used ; i++)
-		sort_list [i] = p.pq[i];
-	std::sort (sort_list , sort_list +p.used);
+		if (!p.is_dead(i))		//tombstones are not shown
+			sort_list [live++] = p.pq[i];
+	std::sort (sort_list , sort_list +live);
 
 
 	if (!p.empty())
 	{
-		for (int i = p.used-1; i >=0; --i)
+		for (int i = live-1; i >=0; --i)
 		{
-			if (i == p.used-1)
+			if (i == live-1)
 				outs<<sort_list[i];	//normally would us p.pq[i] so rever back if not right.
 			else
 				outs<< "," << sort_list [i];
@@ -378,16 +601,16 @@ std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>& p
 //
 //Iterator constructors
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::begin () const -> HeapPriorityQueue<T,tgt>::Iterator {
-	  return Iterator(const_cast<HeapPriorityQueue<T,tgt>*>(this),true);
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+auto HeapPriorityQueue<T,tgt,Alloc,Stable>::begin () const -> HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator {
+	  return Iterator(const_cast<HeapPriorityQueue<T,tgt,Alloc,Stable>*>(this),true);
 
  }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::end () const -> HeapPriorityQueue<T,tgt>::Iterator {
-	  return Iterator(const_cast<HeapPriorityQueue<T,tgt>*>(this),false);
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+auto HeapPriorityQueue<T,tgt,Alloc,Stable>::end () const -> HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator {
+	  return Iterator(const_cast<HeapPriorityQueue<T,tgt,Alloc,Stable>*>(this),false);
 
  }
 
@@ -397,37 +620,146 @@ auto HeapPriorityQueue<T,tgt>::end () const -> HeapPriorityQueue<T,tgt>::Iterato
 //
 //Private helper methods
 
-template<class T, bool (*tgt)(const T& a, const T& b)>	//something wrong with this when calling initializer function.
-void HeapPriorityQueue<T,tgt>::ensure_length(int new_length) {
-	if (length >= new_length)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+T* HeapPriorityQueue<T,tgt,Alloc,Stable>::new_array(int length) {
+	return heap_new_array<T>(alloc, length);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::delete_array(T* a, int length) {
+	heap_delete_array(alloc, a, length);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>	//something wrong with this when calling initializer function.
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::ensure_length(int new_length) {
+	int old_length = length;
+	if (!heap_ensure_length(alloc, pq, length, used, new_length))
 		return;	//we want to make sure that our current length is c
-	T *old_pq = pq;//make copy of old pq
-	length = std::max(new_length, 2*length);// new length will be max of either the
-	//newlength or twice that of old length (in the case
-	pq = new T[length];//create that new array
-	for ( int i = 0; i <used ; ++i)
-		pq[i] = old_pq[i];//copy over the values of old to new
 
-	delete [] old_pq;	//ERROR OCCURS HERE WHEN TRYING TO CREATE MORE LISTS IN INITIALIZER AND ITERATORS
+	std::uint64_t* old_seq = seq;		//the sequence numbers follow their values
+	seq = new_seq(length);
+	if (Stable)
+		std::copy(old_seq, old_seq+used, seq);
+	delete_seq(old_seq, old_length);
+
+	if (slot != nullptr) {
+		std::uint32_t* old_slot = slot;
+		slot = new_parallel<std::uint32_t>(length);
+		std::copy(old_slot, old_slot+used, slot);
+		delete_parallel(old_slot, old_length);
+	}
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+std::uint64_t* HeapPriorityQueue<T,tgt,Alloc,Stable>::new_seq(int length) {
+	return Stable ? new_parallel<std::uint64_t>(length) : nullptr;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::delete_seq(std::uint64_t* s, int length) {
+	delete_parallel(s, length);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+template<class U>
+U* HeapPriorityQueue<T,tgt,Alloc,Stable>::new_parallel(int length) {
+	if (length == 0)
+		return nullptr;
+	typename std::allocator_traits<Alloc>::template rebind_alloc<U> u_alloc(alloc);
+	return std::allocator_traits<decltype(u_alloc)>::allocate(u_alloc, length);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+template<class U>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::delete_parallel(U* a, int length) {
+	if (a == nullptr)
+		return;
+	typename std::allocator_traits<Alloc>::template rebind_alloc<U> u_alloc(alloc);
+	std::allocator_traits<decltype(u_alloc)>::deallocate(u_alloc, a, length);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::place_new(const T& element, std::uint32_t s) {
+	this->ensure_length(used +1);	//only makes new array when we have too many values.
+	pq[used] = element;
+	if (Stable)
+		seq[used] = next_seq++;	//stamp it so ties go to whoever was enqueued first
+	if (slot != nullptr)
+		slot[used] = s;
+	++used;
+
+	percolate_up(used-1);	// work from bottom up, add to the end, and work way up to preserve
+	//order of the tree
+	++mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+bool HeapPriorityQueue<T,tgt,Alloc,Stable>::is_dead(int i) const {
+	return slot != nullptr && slot[i] != no_slot && slot_dead[slot[i]];
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::release_slot(int i) {
+	if (slot == nullptr || slot[i] == no_slot)
+		return;
+	std::uint32_t s = slot[i];
+	++slot_generation[s];		//outstanding Tokens for s are now stale
+	slot_dead[s] = false;
+	free_slots.push_back(s);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::drop_dead_top() {
+	while (used > 0 && is_dead(0)) {
+		release_slot(0);
+		--dead;
+		move_entry(0, --used);
+		percolate_down(0);
+	}
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::compact() {
+	int live = 0;
+	for (int i = 0; i < used; ++i)
+		if (is_dead(i))
+			release_slot(i);
+		else
+			move_entry(live++, i);
+	used = live;
+	dead = 0;
+	heapify();
+	++compaction_count;
 }
 
 //this part was on his heap page, had to ctrl-f left child
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::left_child(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+int HeapPriorityQueue<T,tgt,Alloc,Stable>::left_child(int i) const
 {
 	return 2*i + 1;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::right_child(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+int HeapPriorityQueue<T,tgt,Alloc,Stable>::right_child(int i) const
 {
 	return 2*i + 2;
 }
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::parent(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+int HeapPriorityQueue<T,tgt,Alloc,Stable>::parent(int i) const
 {
 	return (i-1)/2;	//this is the formula to find out who the parent is for a certain child
 		//let's say we have 7 nodes, we round down.
@@ -439,27 +771,59 @@ int HeapPriorityQueue<T,tgt>::parent(int i) const
 		// ..c
 }
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::is_root(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+bool HeapPriorityQueue<T,tgt,Alloc,Stable>::is_root(int i) const
 {
 	return i == 0;
 }
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::in_heap(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+bool HeapPriorityQueue<T,tgt,Alloc,Stable>::in_heap(int i) const
 {
 	return (i <used);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::percolate_up(int i) {
+//The fused comparison: one gt call decides unless it is false and the queue is Stable; then
+//  only if i's sequence number is earlier, a second (reversed) gt call detects a tie, which i wins.
+//Calling tgt directly when it is supplied (gt is then the same function) lets it be inlined.
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+bool HeapPriorityQueue<T,tgt,Alloc,Stable>::higher(int i, int j) const {
+	bool (*const cmp)(const T& a, const T& b) = (tgt != nullptr ? tgt : gt);
+	if (cmp(pq[i], pq[j]))
+		return true;
+	return Stable && seq[i] < seq[j] && !cmp(pq[j], pq[i]);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::swap_entries(int i, int j) {
+	std::swap(pq[i], pq[j]);
+	if (Stable)
+		std::swap(seq[i], seq[j]);
+	if (slot != nullptr)
+		std::swap(slot[i], slot[j]);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::move_entry(int to, int from) {
+	pq[to] = pq[from];
+	if (Stable)
+		seq[to] = seq[from];
+	if (slot != nullptr)
+		slot[to] = slot[from];
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::percolate_up(int i) {
 	//This is for enqueue, if the value is not a root
 //	std::string words;
 //	for (int i =0; i <used ; i++)
 //				words += pq[i];
 
-	for (; !is_root(i) && gt(pq[i], pq[parent(i)]) ; i = parent(i))
+	for (; !is_root(i) && higher(i, parent(i)) ; i = parent(i))
 	{
 		//make sure that it is not a root, and check which is greater
 		// the parent value or the current value,
@@ -467,16 +831,16 @@ void HeapPriorityQueue<T,tgt>::percolate_up(int i) {
 //		std::cout<<"PQ in progress: " << words<<
 //				"\nHere is the Values to be removed : parent = " <<pq[parent(i)]<<" and child = " <<pq[i]<<
 //				"\n\n";
-		std::swap(pq[parent(i)], pq[i]);
+		swap_entries(parent(i), i);
 
 	}
 
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::percolate_down(int i) {
-	for (int left = left_child(i) ; in_heap(left) ; left = left_child(left))
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::percolate_down(int i) {
+	for (int left = left_child(i) ; in_heap(left) ; left = left_child(i))	//i moved down to the swapped child below
 	{
 
 		//let's say i = 0, we have left = 1 and right = 2
@@ -484,15 +848,15 @@ void HeapPriorityQueue<T,tgt>::percolate_down(int i) {
 
 		//Dual check : check first to see if right child is in the heap. If not, use left child as comparison
 		int max_val ;
-		if (!in_heap(right) || gt( pq[left], pq [right]))
+		if (!in_heap(right) || higher(left, right))
 			max_val = left;
 		else
 			max_val = right;
 		//if right child is in the heap, now compare the value between left and right child. Used value depends on comp func
 
-		if (gt(pq[i], pq[max_val]))		//if parent is less/greater than its child, stop out of that loop
+		if (higher(i, max_val))		//if parent is less/greater than its child, stop out of that loop
 			break;
-		std::swap ( pq[i], pq[max_val]);	//if comparison condition fails, then swap the values
+		swap_entries(i, max_val);	//if comparison condition fails, then swap the values
 		i = max_val; //here's your tracker. Set your parent index to that of which you swapped with to
 		//ensure correct order tracking. Jasus
 
@@ -500,8 +864,8 @@ void HeapPriorityQueue<T,tgt>::percolate_down(int i) {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::heapify() {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+void HeapPriorityQueue<T,tgt,Alloc,Stable>::heapify() {
 for (int i = used-1; i >= 0; --i)
   percolate_down(i);
 }
@@ -511,9 +875,9 @@ for (int i = used-1; i >= 0; --i)
 //
 //Iterator class definitions
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::Iterator(HeapPriorityQueue<T,tgt>* iterate_over, bool tgt_nullptr)
-: it() , ref_pq(iterate_over)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator::Iterator(HeapPriorityQueue<T,tgt,Alloc,Stable>* iterate_over, bool tgt_nullptr)
+: it(iterate_over->gt) , ref_pq(iterate_over)	//"it" needs gt: it may have come from the constructor
 {
 	if (tgt_nullptr)
 		it = *ref_pq;
@@ -522,20 +886,20 @@ HeapPriorityQueue<T,tgt>::Iterator::Iterator(HeapPriorityQueue<T,tgt>* iterate_o
 
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::Iterator(HeapPriorityQueue<T,tgt>* iterate_over)
-: it (iterate_over)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator::Iterator(HeapPriorityQueue<T,tgt,Alloc,Stable>* iterate_over)
+: it (iterate_over->gt), ref_pq(iterate_over), expected_mod_count(iterate_over->mod_count)
 {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::~Iterator()
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator::~Iterator()
 {}
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T HeapPriorityQueue<T,tgt>::Iterator::erase() {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+T HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator::erase() {
 	if (expected_mod_count != ref_pq->mod_count)
 		throw ConcurrentModificationError("HeapPriorityQueue::Iterator::erase");
 	if (!can_erase)
@@ -548,36 +912,38 @@ T HeapPriorityQueue<T,tgt>::Iterator::erase() {
 	int index;
 	for (int i = 0 ; i < ref_pq->used; i++)
 	{
-		if (it.peek() == ref_pq->pq[i])	//this is where we are scanning, do i compare with dequeued value, in which this is the same?
+		if (!ref_pq->is_dead(i) && (Stable ? it.seq[0] == ref_pq->seq[i] : it.peek() == ref_pq->pq[i]))	//Stable: the sequence number finds exactly this one among equal values
 		{
 			index = i;
 			break;
 		}
 	}
 
-	ref_pq->pq[index] = ref_pq->pq[ref_pq->used-1];	//THIS IS WHERE IT SCREWS UP
+	ref_pq->release_slot(index);
+	ref_pq->move_entry(index, ref_pq->used-1);	//THIS IS WHERE IT SCREWS UP
 	it.dequeue();
 	ref_pq->used--;
 	ref_pq->percolate_down(index);
 	ref_pq->percolate_up(index);
+	ref_pq->drop_dead_top();
 
 	expected_mod_count = ref_pq->mod_count;
 	return top_val;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string HeapPriorityQueue<T,tgt>::Iterator::str() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+std::string HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator::str() const {
 	std::ostringstream answer;
 	answer << ref_pq->str() << "/current_value=" << it.peek() << "/expected_mod_count=" << expected_mod_count << "/can_erase=" << can_erase;  // ASDFASDF?
 	return answer.str();
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ () -> HeapPriorityQueue<T,tgt>::Iterator& {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+auto HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator::operator ++ () -> HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator& {
 	if (expected_mod_count != ref_pq->mod_count)
-		throw ConcurrentModificationError("HeapPriorityQueue<T,tgt>::Iterator::operator ++");
+		throw ConcurrentModificationError("HeapPriorityQueue<T,tgt,Alloc>::Iterator::operator ++");
 
 	if (it.empty())
 		return *this;
@@ -589,10 +955,10 @@ auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ () -> HeapPriorityQueue<T,t
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> HeapPriorityQueue<T,tgt>::Iterator {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+auto HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator::operator ++ (int) -> HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator {
 	if (expected_mod_count != ref_pq->mod_count)
-		throw ConcurrentModificationError("HeapPriorityQueue<T,tgt>::Iterator::operator ++");
+		throw ConcurrentModificationError("HeapPriorityQueue<T,tgt,Alloc>::Iterator::operator ++");
 	if (it.empty())
 		return *this;
 
@@ -608,8 +974,8 @@ auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> HeapPriorityQueue<
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::Iterator::operator == (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+bool HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator::operator == (const HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator& rhs) const {
 	 const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
 	  if (rhsASI == 0)
 	    throw IteratorTypeError("HeapPriorityQueue::Iterator::operator ==");
@@ -623,8 +989,8 @@ bool HeapPriorityQueue<T,tgt>::Iterator::operator == (const HeapPriorityQueue<T,
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::Iterator::operator != (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+bool HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator::operator != (const HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator& rhs) const {
 	 const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
 	if (rhsASI == 0)
 		throw IteratorTypeError("HeapPriorityQueue::Iterator::operator !=");
@@ -637,8 +1003,8 @@ bool HeapPriorityQueue<T,tgt>::Iterator::operator != (const HeapPriorityQueue<T,
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& HeapPriorityQueue<T,tgt>::Iterator::operator *() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+T& HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator::operator *() const {
 	if (expected_mod_count != ref_pq->mod_count)
 		throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator *");
 	if (!can_erase || it.empty())
@@ -652,8 +1018,8 @@ T& HeapPriorityQueue<T,tgt>::Iterator::operator *() const {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T* HeapPriorityQueue<T,tgt>::Iterator::operator ->() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc, bool Stable>
+T* HeapPriorityQueue<T,tgt,Alloc,Stable>::Iterator::operator ->() const {
 	if (expected_mod_count !=  ref_pq->mod_count)
 			throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator ->");
 	if (!can_erase || it.empty())
@@ -666,6 +1032,24 @@ T* HeapPriorityQueue<T,tgt>::Iterator::operator ->() const {
 	return &(it.peek());
 }
 
+
+//A HeapPriorityQueue that dequeues values of equal priority in FIFO order
+template<class T, bool (*tgt)(const T& a, const T& b) = nullptr, class Alloc = std::allocator<T>>
+using StableHeapPriorityQueue = HeapPriorityQueue<T,tgt,Alloc,true>;
+
+
+#if __cplusplus >= 201703L
+namespace pmr {
+  //HeapPriorityQueue whose array comes from a std::pmr::memory_resource: pass
+  //  std::pmr::polymorphic_allocator<T>(&resource) as the last constructor argument
+  template<class T, bool (*tgt)(const T& a, const T& b) = nullptr>
+  using HeapPriorityQueue = ics::HeapPriorityQueue<T,tgt,std::pmr::polymorphic_allocator<T>>;
+
+  template<class T, bool (*tgt)(const T& a, const T& b) = nullptr>
+  using StableHeapPriorityQueue = ics::HeapPriorityQueue<T,tgt,std::pmr::polymorphic_allocator<T>,true>;
+}
+#endif
+
 }
 
 #endif /* HEAP_PRIORITY_QUEUE_HPP_ */
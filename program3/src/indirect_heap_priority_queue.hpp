@@ -0,0 +1,353 @@
+#ifndef INDIRECT_HEAP_PRIORITY_QUEUE_HPP_
+#define INDIRECT_HEAP_PRIORITY_QUEUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <cstdint>              //For std::uint32_t
+#include <type_traits>          //For std::is_void
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//The heap's entries: an index into the element array, and (unless Key is void) that element's
+//  cached key, so most comparisons read only the entry, not the element
+template<class Key> struct IndirectHeapEntry {
+  Key           key;
+  std::uint32_t index;
+};
+
+template<> struct IndirectHeapEntry<void> {
+  std::uint32_t index;
+};
+
+
+//A priority queue of indexes into an externally owned array of elements (e.g., a std::vector
+//  of large values, like wordgenerator's CorpusEntry pairs): percolate_up/down move 4-byte
+//  indexes (or small key/index entries) instead of whole T objects, which never move or copy.
+//gt (tgt/cgt, as for HeapPriorityQueue) compares elements: the index of the highest priority
+//  element is dequeued first.
+//If Key is not void, enqueue caches key_of(element) beside its index; a higher key dequeues
+//  first, and gt only breaks ties between equal keys. So key_of must agree with gt: if
+//  key_of(a) > key_of(b) then gt(a,b) (e.g., a count that gt compares first).
+//Each index can be queued at most once; a position array (one int per element) finds its entry
+//  so that contains/erase are O(1)/O(Log N) and update re-positions an element after it changes.
+//The elements must not change (except via update) or move while their indexes are queued; if the
+//  array is reallocated (e.g., a vector grows), call set_elements before the next operation.
+template<class T, bool (*tgt)(const T& a, const T& b) = nullptr, class Key = void> class IndirectHeapPriorityQueue {
+  public:
+    typedef IndirectHeapEntry<Key> Entry;
+
+    //Destructor/Constructors
+    ~IndirectHeapPriorityQueue();
+    IndirectHeapPriorityQueue (const T* elements, int capacity,
+                               bool (*cgt)(const T& a, const T& b) = nullptr, Key (*key_of)(const T& e) = nullptr);
+    IndirectHeapPriorityQueue (const IndirectHeapPriorityQueue<T,tgt,Key>& to_copy)                             = delete;
+    IndirectHeapPriorityQueue<T,tgt,Key>& operator = (const IndirectHeapPriorityQueue<T,tgt,Key>& rhs)          = delete;
+
+
+    //Queries
+    bool     empty      () const;
+    int      size       () const;
+    int      capacity   () const;            //Indexes are 0 to capacity-1
+    bool     contains   (int index) const;
+    int      peek       () const;            //Index of the highest priority element; EmptyError if empty
+    const T& peek_value () const;            //elements[peek()]
+    std::string str     () const; //supplies useful debugging information
+
+
+    //Commands
+    int  enqueue      (int index);           //IcsError if out of range or already queued
+    int  dequeue      ();                    //Index of the highest priority element; EmptyError if empty
+    void update       (int index);           //elements[index] changed: re-cache its key and re-position it
+    void erase        (int index);           //KeyError if not queued
+    void clear        ();
+    void set_elements (const T* elements, int capacity);   //The array moved/grew (capacity may not shrink)
+
+
+  private:
+    bool (*gt)     (const T& a, const T& b);  // The gt (from template or constructor)
+    Key  (*key_of) (const T& e);              // Non-void Key only: computes cached keys
+    const T* elements;                        // Externally owned: elements[entry.index]
+    int      length;                          // Capacity: length of elements, heap, and position
+    Entry*   heap;                            // heap[0..used-1]: a max-heap of entries (by higher)
+    int*     position;                        // position[i]: where index i is in heap, or -1 if not queued
+    int      used = 0;
+
+    //Helper methods
+    bool higher         (const Entry& a, const Entry& b) const;
+    bool higher         (const Entry& a, const Entry& b, std::true_type  unkeyed) const;
+    bool higher         (const Entry& a, const Entry& b, std::false_type unkeyed) const;
+    void set_key        (Entry& e, std::true_type  unkeyed);
+    void set_key        (Entry& e, std::false_type unkeyed);
+    void place          (int i, const Entry& e);    //heap[i] = e, and record e's position
+    void check_index    (int index, const char* where) const;
+    void percolate_up   (int i);
+    void percolate_down (int i);
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//IndirectHeapPriorityQueue class and related definitions
+
+//Destructor/Constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+IndirectHeapPriorityQueue<T,tgt,Key>::~IndirectHeapPriorityQueue() {
+  delete[] heap;
+  delete[] position;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+IndirectHeapPriorityQueue<T,tgt,Key>::IndirectHeapPriorityQueue(const T* elements, int capacity,
+    bool (*cgt)(const T& a, const T& b), Key (*key_of)(const T& e))
+: gt(tgt != nullptr ? tgt : cgt), key_of(key_of), elements(elements), length(capacity < 0 ? 0 : capacity) {
+  if (gt == nullptr)
+    throw TemplateFunctionError("IndirectHeapPriorityQueue::constructor: neither specified");
+  if (tgt != nullptr && cgt != nullptr && tgt != cgt)
+    throw TemplateFunctionError("IndirectHeapPriorityQueue::constructor: both specified and different");
+  if (!std::is_void<Key>::value && key_of == nullptr)
+    throw TemplateFunctionError("IndirectHeapPriorityQueue::constructor: Key but no key_of specified");
+
+  heap     = new Entry[length];
+  position = new int[length];
+  for (int i = 0; i < length; ++i)
+    position[i] = -1;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+bool IndirectHeapPriorityQueue<T,tgt,Key>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+int IndirectHeapPriorityQueue<T,tgt,Key>::size() const {
+  return used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+int IndirectHeapPriorityQueue<T,tgt,Key>::capacity() const {
+  return length;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+bool IndirectHeapPriorityQueue<T,tgt,Key>::contains(int index) const {
+  return 0 <= index && index < length && position[index] != -1;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+int IndirectHeapPriorityQueue<T,tgt,Key>::peek() const {
+  if (empty())
+    throw EmptyError("IndirectHeapPriorityQueue::peek");
+  return heap[0].index;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+const T& IndirectHeapPriorityQueue<T,tgt,Key>::peek_value() const {
+  return elements[peek()];
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+std::string IndirectHeapPriorityQueue<T,tgt,Key>::str() const {
+  std::ostringstream answer;
+  answer << "indirect_priority_queue[";
+  for (int i = 0; i < used; ++i)
+    answer << (i == 0 ? "" : ",") << heap[i].index << "->" << elements[heap[i].index];
+  answer << "](capacity=" << length << ",used=" << used << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+int IndirectHeapPriorityQueue<T,tgt,Key>::enqueue(int index) {
+  check_index(index, "IndirectHeapPriorityQueue::enqueue");
+  if (position[index] != -1) {
+    std::ostringstream answer;
+    answer << "IndirectHeapPriorityQueue::enqueue index " << index << " already queued";
+    throw IcsError(answer.str());
+  }
+  Entry e;
+  e.index = index;
+  set_key(e, std::is_void<Key>());
+  place(used++, e);
+  percolate_up(used-1);
+  return 1;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+int IndirectHeapPriorityQueue<T,tgt,Key>::dequeue() {
+  if (empty())
+    throw EmptyError("IndirectHeapPriorityQueue::dequeue");
+  int answer = heap[0].index;
+  erase(answer);
+  return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+void IndirectHeapPriorityQueue<T,tgt,Key>::update(int index) {
+  if (!contains(index)) {
+    std::ostringstream answer;
+    answer << "IndirectHeapPriorityQueue::update index " << index << " not queued";
+    throw KeyError(answer.str());
+  }
+  int i = position[index];
+  set_key(heap[i], std::is_void<Key>());
+  percolate_up(i);
+  percolate_down(position[index]);
+}
+
+
+//Fill the hole with the last entry, which may belong above or below it
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+void IndirectHeapPriorityQueue<T,tgt,Key>::erase(int index) {
+  if (!contains(index)) {
+    std::ostringstream answer;
+    answer << "IndirectHeapPriorityQueue::erase index " << index << " not queued";
+    throw KeyError(answer.str());
+  }
+  int i = position[index];
+  position[index] = -1;
+  if (i == --used)
+    return;
+  int moved = heap[used].index;
+  place(i, heap[used]);
+  percolate_up(i);
+  percolate_down(position[moved]);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+void IndirectHeapPriorityQueue<T,tgt,Key>::clear() {
+  for (int i = 0; i < used; ++i)
+    position[heap[i].index] = -1;
+  used = 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+void IndirectHeapPriorityQueue<T,tgt,Key>::set_elements(const T* elements, int capacity) {
+  if (capacity < length)
+    throw IcsError("IndirectHeapPriorityQueue::set_elements capacity cannot shrink");
+  this->elements = elements;
+  if (capacity == length)
+    return;
+
+  Entry* new_heap     = new Entry[capacity];
+  int*   new_position = new int[capacity];
+  for (int i = 0; i < used; ++i)
+    new_heap[i] = heap[i];
+  for (int i = 0; i < capacity; ++i)
+    new_position[i] = (i < length ? position[i] : -1);
+  delete[] heap;
+  delete[] position;
+  heap     = new_heap;
+  position = new_position;
+  length   = capacity;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+bool IndirectHeapPriorityQueue<T,tgt,Key>::higher(const Entry& a, const Entry& b) const {
+  return higher(a, b, std::is_void<Key>());
+}
+
+
+//Calling tgt directly when it is supplied (gt is then the same function) lets it be inlined
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+bool IndirectHeapPriorityQueue<T,tgt,Key>::higher(const Entry& a, const Entry& b, std::true_type) const {
+  return (tgt != nullptr ? tgt : gt)(elements[a.index], elements[b.index]);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+bool IndirectHeapPriorityQueue<T,tgt,Key>::higher(const Entry& a, const Entry& b, std::false_type) const {
+  if (a.key > b.key)
+    return true;
+  if (b.key > a.key)
+    return false;
+  return (tgt != nullptr ? tgt : gt)(elements[a.index], elements[b.index]);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+void IndirectHeapPriorityQueue<T,tgt,Key>::set_key(Entry&, std::true_type) {
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+void IndirectHeapPriorityQueue<T,tgt,Key>::set_key(Entry& e, std::false_type) {
+  e.key = key_of(elements[e.index]);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+void IndirectHeapPriorityQueue<T,tgt,Key>::place(int i, const Entry& e) {
+  heap[i] = e;
+  position[e.index] = i;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+void IndirectHeapPriorityQueue<T,tgt,Key>::check_index(int index, const char* where) const {
+  if (index < 0 || index >= length) {
+    std::ostringstream answer;
+    answer << where << " index " << index << " not in [0," << length << ")";
+    throw IcsError(answer.str());
+  }
+}
+
+
+//Move the hole, not the entry: shift each lower parent down, then place the entry once
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+void IndirectHeapPriorityQueue<T,tgt,Key>::percolate_up(int i) {
+  Entry e = heap[i];
+  for (int p = (i-1)/2; i > 0 && higher(e, heap[p]); i = p, p = (i-1)/2)
+    place(i, heap[p]);
+  place(i, e);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Key>
+void IndirectHeapPriorityQueue<T,tgt,Key>::percolate_down(int i) {
+  Entry e = heap[i];
+  for (int child = 2*i+1; child < used; i = child, child = 2*i+1) {
+    if (child+1 < used && higher(heap[child+1], heap[child]))
+      ++child;
+    if (!higher(heap[child], e))
+      break;
+    place(i, heap[child]);
+  }
+  place(i, e);
+}
+
+}
+
+#endif /* INDIRECT_HEAP_PRIORITY_QUEUE_HPP_ */
@@ -0,0 +1,287 @@
+#ifndef LOSER_TREE_MERGE_HPP_
+#define LOSER_TREE_MERGE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//Merges k sorted sources (sorted runs of an external sort, per-thread results, ...) into one
+//  sorted stream: tgt/cgt (as for HeapPriorityQueue) is true iff a comes out before b, and
+//  each source must already be in that order. Values equal by gt come out in source order
+//  (the order the sources were added), so the merge is stable.
+//A source is a range [begin,end) of InputIterator (any iterator supporting *, prefix ++, and
+//  ==; e.g., a vector's const_iterator or a std::istream_iterator reading a run file). Each
+//  source's current value is copied once into a contiguous array of k heads, so the matches
+//  read only that array (not k scattered runs, which costs more than the comparisons saved).
+//It is a tournament tree of losers: each internal node remembers the source that lost the
+//  match there, and the overall winner sits on top. After the winner's source advances, only
+//  the matches on its leaf-to-root path are replayed: ceil(Log2 k) gt calls per value (a heap
+//  of the k current values needs about 2 Log2 k), and the merge allocates nothing per value
+//  (copying a T into its head may). Those matches are unpredictable, so replay and beats
+//  select with masks instead of branching.
+//The tree is (re)built in O(k) on the first peek/dequeue after sources are added; a source
+//  may be added at any time (it merges with whatever remains of the others).
+template<class T, bool (*tgt)(const T& a, const T& b) = nullptr,
+         class InputIterator = typename std::vector<T>::const_iterator> class LoserTreeMerge {
+  public:
+    //Destructor/Constructors
+    ~LoserTreeMerge();
+    LoserTreeMerge (bool (*cgt)(const T& a, const T& b) = nullptr);
+
+
+    //Queries
+    bool        empty   () const;
+    int         sources () const;      //Sources added (including exhausted ones)
+    const T&    peek    () const;      //The next value; throws EmptyError if empty
+    std::string str     () const; //supplies useful debugging information
+
+
+    //Commands
+    void add     (InputIterator begin, InputIterator end);
+    //Iterable class must have begin/end returning (something convertible to) InputIterator
+    template <class Iterable>
+    void add_all (const Iterable& i);  //add(i.begin(),i.end()): i must outlive the merge
+    T    dequeue ();                   //Remove and return the next value; throws EmptyError if empty
+    void skip    ();                   //Remove the next value without copying it
+
+
+    //Iterates over (and consumes) the merged stream: ++ on an Iterator dequeues (like reading
+    //  an input stream), so a LoserTreeMerge can be traversed only once
+    class Iterator {
+      public:
+        const T& operator *  () const {return merge->peek();}
+        const T* operator -> () const {return &merge->peek();}
+        Iterator& operator ++ ()      {merge->skip(); return *this;}
+        bool operator == (const Iterator& rhs) const {return at_end() == rhs.at_end();}
+        bool operator != (const Iterator& rhs) const {return !(*this == rhs);}
+
+      private:
+        LoserTreeMerge<T,tgt,InputIterator>* merge;
+        bool                                 is_end;
+
+        bool at_end () const {return is_end || merge->empty();}
+        Iterator(LoserTreeMerge<T,tgt,InputIterator>* merge, bool is_end) : merge(merge), is_end(is_end) {}
+        friend class LoserTreeMerge<T,tgt,InputIterator>;
+    };
+
+    Iterator begin ();
+    Iterator end   ();
+
+
+  private:
+    struct Source {
+      InputIterator current;
+      InputIterator end;
+    };
+
+    bool (*gt) (const T& a, const T& b);   // The gt (from template or constructor)
+    std::vector<Source> source;
+    std::vector<T>      head;              // head[s]: *source[s].current (meaningless if done[s])
+    std::vector<char>   done;              // done[s]: source s is exhausted
+    mutable std::vector<int> tree;         // tree[0]: the winner (a source index); tree[1..k-1]: losers
+    mutable bool             built = false;
+
+    //Helper methods
+    void advance   (int s);                //Move source s to its next value (into head[s])
+    bool beats     (int a, int b) const;   //Source a's value comes out before source b's
+    void build     () const;               //Play every match: O(k)
+    void replay    (int s);                //Source s advanced: replay the matches on its path
+};
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//LoserTreeMerge class and related definitions
+
+//Destructor/Constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+LoserTreeMerge<T,tgt,InputIterator>::~LoserTreeMerge() {
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+LoserTreeMerge<T,tgt,InputIterator>::LoserTreeMerge(bool (*cgt)(const T& a, const T& b))
+: gt(tgt != nullptr ? tgt : cgt) {
+  if (gt == nullptr)
+    throw TemplateFunctionError("LoserTreeMerge::default constructor: neither specified");
+  if (tgt != nullptr && cgt != nullptr && tgt != cgt)
+    throw TemplateFunctionError("LoserTreeMerge::default constructor: both specified and different");
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+bool LoserTreeMerge<T,tgt,InputIterator>::empty() const {
+  if (source.empty())
+    return true;
+  if (!built)
+    build();
+  return done[tree[0]];
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+int LoserTreeMerge<T,tgt,InputIterator>::sources() const {
+  return source.size();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+const T& LoserTreeMerge<T,tgt,InputIterator>::peek() const {
+  if (empty())
+    throw EmptyError("LoserTreeMerge::peek");
+  return head[tree[0]];
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+std::string LoserTreeMerge<T,tgt,InputIterator>::str() const {
+  std::ostringstream answer;
+  answer << "LoserTreeMerge[";
+  for (int s = 0; s < int(source.size()); ++s) {
+    answer << (s == 0 ? "" : ",") << s << ":";
+    if (done[s])
+      answer << "exhausted";
+    else
+      answer << head[s];
+  }
+  answer << "](sources=" << source.size() << ",winner=" << (built ? tree[0] : -1) << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+void LoserTreeMerge<T,tgt,InputIterator>::add(InputIterator begin, InputIterator end) {
+  source.push_back(Source{begin, end});
+  head.push_back(begin == end ? T() : *begin);
+  done.push_back(begin == end);
+  built = false;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+template<class Iterable>
+void LoserTreeMerge<T,tgt,InputIterator>::add_all(const Iterable& i) {
+  add(i.begin(), i.end());
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+T LoserTreeMerge<T,tgt,InputIterator>::dequeue() {
+  if (empty())
+    throw EmptyError("LoserTreeMerge::dequeue");
+  int s = tree[0];
+  T answer = head[s];
+  advance(s);
+  replay(s);
+  return answer;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+void LoserTreeMerge<T,tgt,InputIterator>::skip() {
+  if (empty())
+    throw EmptyError("LoserTreeMerge::skip");
+  int s = tree[0];
+  advance(s);
+  replay(s);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+auto LoserTreeMerge<T,tgt,InputIterator>::begin () -> LoserTreeMerge<T,tgt,InputIterator>::Iterator {
+  return Iterator(this, false);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+auto LoserTreeMerge<T,tgt,InputIterator>::end () -> LoserTreeMerge<T,tgt,InputIterator>::Iterator {
+  return Iterator(this, true);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+void LoserTreeMerge<T,tgt,InputIterator>::advance(int s) {
+  if (++source[s].current == source[s].end)
+    done[s] = true;
+  else
+    head[s] = *source[s].current;
+}
+
+
+//An exhausted source loses to everything. Otherwise one gt call decides: the lower-numbered
+//  source wins unless the other's value comes out strictly before it (so ties go to it).
+//Calling tgt directly when it is supplied (gt is then the same function) lets it be inlined.
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+bool LoserTreeMerge<T,tgt,InputIterator>::beats(int a, int b) const {
+  if (done[a] | done[b])      //One (rarely taken) branch for both
+    return !done[a];
+  bool (*const cmp)(const T& a, const T& b) = (tgt != nullptr ? tgt : gt);
+  bool a_first = a < b;                    //Which way to compare: select indexes with a mask, not a branch
+  int  x       = a ^ ((a ^ b) & -int(a_first));
+  return cmp(head[x], head[x ^ a ^ b]) != a_first;
+}
+
+
+//Leaves are (implicitly) nodes k..2k-1 (source s at node k+s); node n's children are 2n and
+//  2n+1. Play the matches bottom up, remembering each node's winner to send up the tree.
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+void LoserTreeMerge<T,tgt,InputIterator>::build() const {
+  int k = source.size();
+  tree.assign(k, 0);
+  std::vector<int> winner(2*k);
+  for (int s = 0; s < k; ++s)
+    winner[k+s] = s;
+  for (int n = k-1; n >= 1; --n) {
+    int l = winner[2*n], r = winner[2*n+1];
+    bool l_wins = beats(l, r);
+    winner[n] = l_wins ? l : r;
+    tree[n]   = l_wins ? r : l;
+  }
+  tree[0] = (k == 1 ? 0 : winner[1]);
+  built = true;
+}
+
+
+//Source s is the old winner: it plays the loser stored at each node on its path to the
+//  root; whoever loses stays there, the winner moves up
+template<class T, bool (*tgt)(const T& a, const T& b), class InputIterator>
+void LoserTreeMerge<T,tgt,InputIterator>::replay(int s) {
+  int k = source.size();
+  for (int n = (k+s)/2; n >= 1; n /= 2) {
+    int loser = tree[n];
+    int swap  = (s ^ loser) & -int(beats(loser, s));   //Unpredictable, so swap with a mask, not a branch
+    tree[n] = loser ^ swap;
+    s      ^= swap;
+  }
+  tree[0] = s;
+}
+
+}
+
+#endif /* LOSER_TREE_MERGE_HPP_ */
@@ -0,0 +1,622 @@
+#ifndef MIN_MAX_HEAP_HPP_
+#define MIN_MAX_HEAP_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <utility>              //For std::swap function
+#include <memory>               //For std::allocator
+#if __cplusplus >= 201703L
+#include <memory_resource>      //For std::pmr::polymorphic_allocator
+#endif
+#include "ics_exceptions.hpp"
+#include "heap_priority_queue.hpp"   //For heap_new_array/heap_delete_array/heap_ensure_length
+
+
+namespace ics {
+
+
+//A double-ended priority queue: peek/dequeue the highest priority value (as HeapPriorityQueue)
+//  or peek_lowest/dequeue_lowest the lowest, e.g., to evict the least important value when a
+//  bounded queue is full. peek/peek_lowest are O(1); enqueue/dequeue/dequeue_lowest O(Log N).
+//It is a min-max heap (Atkinson et al., 1986) in one array: values on even levels (0 is the
+//  root) have higher priority than all their descendants, values on odd levels lower; so the
+//  highest is the root and the lowest is one of its (at most two) children.
+//tgt/cgt and Alloc are as for HeapPriorityQueue (which supplies the array growth logic).
+//Values of equal priority are dequeued (from either end) in no particular order.
+template<class T, bool (*tgt)(const T& a, const T& b) = nullptr, class Alloc = std::allocator<T>> class MinMaxHeap {
+  public:
+    //Destructor/Constructors
+    ~MinMaxHeap();
+
+    MinMaxHeap          (bool (*cgt)(const T& a, const T& b) = nullptr, const Alloc& alloc = Alloc());
+    explicit MinMaxHeap (int initial_length, bool (*cgt)(const T& a, const T& b), const Alloc& alloc = Alloc());
+    MinMaxHeap          (const MinMaxHeap<T,tgt,Alloc>& to_copy, bool (*cgt)(const T& a, const T& b) = nullptr);
+    explicit MinMaxHeap (const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = nullptr, const Alloc& alloc = Alloc());
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit MinMaxHeap (const Iterable& i, bool (*cgt)(const T& a, const T& b) = nullptr, const Alloc& alloc = Alloc());
+
+
+    //Queries
+    bool  empty         () const;
+    int   size          () const;
+    T&    peek          () const;   //Highest priority; throws EmptyError if empty
+    T&    peek_lowest   () const;   //Lowest priority;  throws EmptyError if empty
+    Alloc get_allocator () const;
+    std::string str     () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    int  enqueue        (const T& element);
+    T    dequeue        ();         //Highest priority; throws EmptyError if empty
+    T    dequeue_lowest ();         //Lowest priority;  throws EmptyError if empty
+    void clear          ();
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int enqueue_all (const Iterable& i);
+
+
+    //Operators
+    MinMaxHeap<T,tgt,Alloc>& operator = (const MinMaxHeap<T,tgt,Alloc>& rhs);
+    bool operator == (const MinMaxHeap<T,tgt,Alloc>& rhs) const;
+    bool operator != (const MinMaxHeap<T,tgt,Alloc>& rhs) const;
+
+    template<class T2, bool (*gt2)(const T2& a, const T2& b), class Alloc2>
+    friend std::ostream& operator << (std::ostream& outs, const MinMaxHeap<T2,gt2,Alloc2>& h);
+
+
+
+    //Iterates from the highest to the lowest priority (as HeapPriorityQueue's Iterator does)
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of MinMaxHeap<T,tgt,Alloc>
+        ~Iterator();
+        T           erase();
+        std::string str  () const;
+        MinMaxHeap<T,tgt,Alloc>::Iterator& operator ++ ();
+        MinMaxHeap<T,tgt,Alloc>::Iterator  operator ++ (int);
+        bool operator == (const MinMaxHeap<T,tgt,Alloc>::Iterator& rhs) const;
+        bool operator != (const MinMaxHeap<T,tgt,Alloc>::Iterator& rhs) const;
+        T& operator *  () const;
+        T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const MinMaxHeap<T,tgt,Alloc>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+
+        friend Iterator MinMaxHeap<T,tgt,Alloc>::begin () const;
+        friend Iterator MinMaxHeap<T,tgt,Alloc>::end   () const;
+
+      private:
+        //If can_erase is false, the value has been removed from "it" (++ does nothing)
+        MinMaxHeap<T,tgt,Alloc>  it;                 //copy of the heap (from begin), to use as iterator via dequeue
+        MinMaxHeap<T,tgt,Alloc>* ref_heap;
+        int                      expected_mod_count;
+        bool                     can_erase = true;
+
+        //Called in friends begin/end
+        Iterator(MinMaxHeap<T,tgt,Alloc>* iterate_over, bool from_begin);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    bool (*gt) (const T& a, const T& b); // The gt used by enqueue (from template or constructor)
+    Alloc alloc;                         // Allocates/constructs the heap array
+    T*  heap      = nullptr;             // Even levels: max-ordered (by gt); odd levels: min-ordered
+    int length    = 0;                   //Physical length of array: must be >= .size()
+    int used      = 0;                   //Amount of array used:  invariant: 0 <= used <= length
+    int mod_count = 0;                   //For sensing concurrent modification
+
+    //Helper methods
+    bool higher         (int i, int j) const;   //gt(heap[i],heap[j]), calling tgt directly when supplied
+    bool on_max_level   (int i) const;
+    int  parent         (int i) const;
+    int  grandparent    (int i) const;           //-1 if none
+    int  lowest_index   () const;                //Index of the lowest priority value (used > 0)
+    int  extreme_below  (int i, bool max) const; //Highest (max) or lowest value among i's children/grandchildren
+    int  bubble_up      (int i);                 //Returns where heap[i] ended up
+    void trickle_down   (int i);
+    T    remove_at      (int i);
+    void heapify        ();
+};
+
+
+#if __cplusplus >= 201703L
+namespace pmr {
+  template<class T, bool (*tgt)(const T& a, const T& b) = nullptr>
+  using MinMaxHeap = ics::MinMaxHeap<T,tgt,std::pmr::polymorphic_allocator<T>>;
+}
+#endif
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//MinMaxHeap class and related definitions
+
+//Destructor/Constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+MinMaxHeap<T,tgt,Alloc>::~MinMaxHeap() {
+  heap_delete_array(alloc, heap, length);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+MinMaxHeap<T,tgt,Alloc>::MinMaxHeap(bool (*cgt)(const T& a, const T& b), const Alloc& alloc)
+: gt(tgt != nullptr ? tgt : cgt), alloc(alloc) {
+  if (gt == nullptr)
+    throw TemplateFunctionError("MinMaxHeap::default constructor: neither specified");
+  if (tgt != nullptr && cgt != nullptr && tgt != cgt)
+    throw TemplateFunctionError("MinMaxHeap::default constructor: both specified and different");
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+MinMaxHeap<T,tgt,Alloc>::MinMaxHeap(int initial_length, bool (*cgt)(const T& a, const T& b), const Alloc& alloc)
+: gt(tgt != nullptr ? tgt : cgt), alloc(alloc), length(initial_length < 0 ? 0 : initial_length) {
+  if (gt == nullptr)
+    throw TemplateFunctionError("MinMaxHeap::length constructor: neither specified");
+  if (tgt != nullptr && cgt != nullptr && tgt != cgt)
+    throw TemplateFunctionError("MinMaxHeap::length constructor: both specified and different");
+  heap = heap_new_array<T>(this->alloc, length);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+MinMaxHeap<T,tgt,Alloc>::MinMaxHeap(const MinMaxHeap<T,tgt,Alloc>& to_copy, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != nullptr ? tgt : cgt),
+  alloc(std::allocator_traits<Alloc>::select_on_container_copy_construction(to_copy.alloc)),
+  length(to_copy.used), used(to_copy.used) {
+  if (gt == nullptr)    //neither specified: copy to_copy's ordering (as the Iterator's copy of the heap needs)
+    gt = to_copy.gt;
+  if (tgt != nullptr && cgt != nullptr && tgt != cgt)
+    throw TemplateFunctionError("MinMaxHeap::copy constructor: both specified and different");
+
+  heap = heap_new_array<T>(alloc, length);
+  for (int i = 0; i < used; ++i)
+    heap[i] = to_copy.heap[i];
+  if (gt != to_copy.gt)
+    heapify();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+MinMaxHeap<T,tgt,Alloc>::MinMaxHeap(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b), const Alloc& alloc)
+: MinMaxHeap(int(il.size()), cgt, alloc) {
+  for (const T& v : il)
+    heap[used++] = v;
+  heapify();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+template<class Iterable>
+MinMaxHeap<T,tgt,Alloc>::MinMaxHeap(const Iterable& i, bool (*cgt)(const T& a, const T& b), const Alloc& alloc)
+: MinMaxHeap(cgt, alloc) {
+  for (const T& v : i) {
+    heap_ensure_length(this->alloc, heap, length, used, used+1);
+    heap[used++] = v;
+  }
+  heapify();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool MinMaxHeap<T,tgt,Alloc>::empty() const {
+  return used == 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+int MinMaxHeap<T,tgt,Alloc>::size() const {
+  return used;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T& MinMaxHeap<T,tgt,Alloc>::peek () const {
+  if (empty())
+    throw EmptyError("MinMaxHeap::peek");
+  return heap[0];
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T& MinMaxHeap<T,tgt,Alloc>::peek_lowest () const {
+  if (empty())
+    throw EmptyError("MinMaxHeap::peek_lowest");
+  return heap[lowest_index()];
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+Alloc MinMaxHeap<T,tgt,Alloc>::get_allocator() const {
+  return alloc;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+std::string MinMaxHeap<T,tgt,Alloc>::str() const {
+  std::ostringstream answer;
+  answer << "min_max_heap[";
+  for (int i = 0; i < used; ++i)
+    answer << (i == 0 ? "" : ",") << i << ":" << heap[i];
+  answer << "](length=" << length << ",used=" << used << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+int MinMaxHeap<T,tgt,Alloc>::enqueue(const T& element) {
+  heap_ensure_length(alloc, heap, length, used, used+1);
+  heap[used++] = element;
+  bubble_up(used-1);
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T MinMaxHeap<T,tgt,Alloc>::dequeue() {
+  if (empty())
+    throw EmptyError("MinMaxHeap::dequeue");
+  ++mod_count;
+  return remove_at(0);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T MinMaxHeap<T,tgt,Alloc>::dequeue_lowest() {
+  if (empty())
+    throw EmptyError("MinMaxHeap::dequeue_lowest");
+  ++mod_count;
+  return remove_at(lowest_index());
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+void MinMaxHeap<T,tgt,Alloc>::clear() {
+  used = 0;
+  ++mod_count;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+template<class Iterable>
+int MinMaxHeap<T,tgt,Alloc>::enqueue_all (const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    count += enqueue(v);
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+MinMaxHeap<T,tgt,Alloc>& MinMaxHeap<T,tgt,Alloc>::operator = (const MinMaxHeap<T,tgt,Alloc>& rhs) {
+  if (this == &rhs)
+    return *this;
+  heap_ensure_length(alloc, heap, length, 0, rhs.used);
+  gt   = rhs.gt;
+  used = rhs.used;
+  for (int i = 0; i < used; ++i)
+    heap[i] = rhs.heap[i];
+  ++mod_count;
+  return *this;
+}
+
+
+//Equal if both dequeue the same values in the same order (from highest to lowest)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool MinMaxHeap<T,tgt,Alloc>::operator == (const MinMaxHeap<T,tgt,Alloc>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (used != rhs.used || gt != rhs.gt)
+    return false;
+
+  MinMaxHeap<T,tgt,Alloc> l(*this), r(rhs);
+  while (!l.empty())
+    if (l.dequeue() != r.dequeue())
+      return false;
+  return true;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool MinMaxHeap<T,tgt,Alloc>::operator != (const MinMaxHeap<T,tgt,Alloc>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+//Lowest first, so highest is next to the :highest label (as for HeapPriorityQueue)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+std::ostream& operator << (std::ostream& outs, const MinMaxHeap<T,tgt,Alloc>& h) {
+  outs << "min_max_heap[";
+  MinMaxHeap<T,tgt,Alloc> copy(h);
+  for (bool first = true; !copy.empty(); first = false)
+    outs << (first ? "" : ",") << copy.dequeue_lowest();
+  outs << "]:highest";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+auto MinMaxHeap<T,tgt,Alloc>::begin () const -> MinMaxHeap<T,tgt,Alloc>::Iterator {
+  return Iterator(const_cast<MinMaxHeap<T,tgt,Alloc>*>(this), true);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+auto MinMaxHeap<T,tgt,Alloc>::end () const -> MinMaxHeap<T,tgt,Alloc>::Iterator {
+  return Iterator(const_cast<MinMaxHeap<T,tgt,Alloc>*>(this), false);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool MinMaxHeap<T,tgt,Alloc>::higher(int i, int j) const {
+  return (tgt != nullptr ? tgt : gt)(heap[i], heap[j]);
+}
+
+
+//Level of i is floor(Log2(i+1)): count how many times i+1 can be halved
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool MinMaxHeap<T,tgt,Alloc>::on_max_level(int i) const {
+  int level = 0;
+  for (++i; i > 1; i >>= 1)
+    ++level;
+  return level % 2 == 0;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+int MinMaxHeap<T,tgt,Alloc>::parent(int i) const {
+  return (i-1)/2;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+int MinMaxHeap<T,tgt,Alloc>::grandparent(int i) const {
+  return i < 3 ? -1 : parent(parent(i));
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+int MinMaxHeap<T,tgt,Alloc>::lowest_index() const {
+  if (used <= 2)
+    return used-1;
+  return higher(1, 2) ? 2 : 1;
+}
+
+
+//Among i's children and grandchildren (up to 6 values), the index of the highest (if max) or
+//  lowest (if !max) priority; -1 if i has no children
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+int MinMaxHeap<T,tgt,Alloc>::extreme_below(int i, bool max) const {
+  int first_child = 2*i+1;
+  if (first_child >= used)
+    return -1;
+  int answer = first_child;
+  int candidates[5] = {first_child+1, 4*i+3, 4*i+4, 4*i+5, 4*i+6};
+  for (int c : candidates)
+    if (c < used && (max ? higher(c, answer) : higher(answer, c)))
+      answer = c;
+  return answer;
+}
+
+
+//A value placed at i moves up along every other level: first, if it belongs on the other kind
+//  of level than i's (e.g., lower than its min-level parent), swap it with its parent; then
+//  swap it with its grandparent while it is more extreme (in the direction of its levels).
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+int MinMaxHeap<T,tgt,Alloc>::bubble_up(int i) {
+  if (i == 0)
+    return i;
+  bool max = on_max_level(i);
+  int  p   = parent(i);
+  if (max ? higher(p, i) : higher(i, p)) {
+    std::swap(heap[i], heap[p]);
+    i   = p;
+    max = !max;
+  }
+  for (int g = grandparent(i); g >= 0 && (max ? higher(i, g) : higher(g, i)); g = grandparent(i)) {
+    std::swap(heap[i], heap[g]);
+    i = g;
+  }
+  return i;
+}
+
+
+//A value at i moves down along every other level to the most extreme of its grandchildren;
+//  when it lands on a grandchild it may belong on the (opposite) level between: then swap
+//  with that parent too.
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+void MinMaxHeap<T,tgt,Alloc>::trickle_down(int i) {
+  bool max = on_max_level(i);
+  for (int m = extreme_below(i, max); m >= 0; m = extreme_below(i, max)) {
+    if (!(max ? higher(m, i) : higher(i, m)))
+      return;
+    std::swap(heap[i], heap[m]);
+    if (m <= 2*i+2)            //A child: its subtree holds nothing more extreme
+      return;
+    int p = parent(m);
+    if (max ? higher(p, m) : higher(m, p))
+      std::swap(heap[m], heap[p]);
+    i = m;
+  }
+}
+
+
+//Remove heap[i], filling the hole with the last value and restoring the heap property (the last
+//  value may belong above i or below it)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T MinMaxHeap<T,tgt,Alloc>::remove_at(int i) {
+  T answer = heap[i];
+  heap[i] = heap[--used];
+  if (i < used && bubble_up(i) == i)
+    trickle_down(i);
+  return answer;
+}
+
+
+//Trickle down every value with a child, from the last to the root: O(N)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+void MinMaxHeap<T,tgt,Alloc>::heapify() {
+  for (int i = used/2-1; i >= 0; --i)
+    trickle_down(i);
+}
+
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+MinMaxHeap<T,tgt,Alloc>::Iterator::Iterator(MinMaxHeap<T,tgt,Alloc>* iterate_over, bool from_begin)
+: it(iterate_over->gt), ref_heap(iterate_over), expected_mod_count(iterate_over->mod_count) {
+  if (from_begin)
+    it = *ref_heap;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+MinMaxHeap<T,tgt,Alloc>::Iterator::~Iterator()
+{}
+
+
+//Removes the value from ref_heap by finding an equal one (as HeapPriorityQueue does)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T MinMaxHeap<T,tgt,Alloc>::Iterator::erase() {
+  if (expected_mod_count != ref_heap->mod_count)
+    throw ConcurrentModificationError("MinMaxHeap::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("MinMaxHeap::Iterator::erase Iterator cursor already erased");
+  if (it.empty())
+    throw CannotEraseError("MinMaxHeap::Iterator::erase Iterator cursor beyond data structure");
+
+  can_erase = false;
+  T to_return = it.dequeue();
+  for (int i = 0; i < ref_heap->used; ++i)
+    if (ref_heap->heap[i] == to_return) {
+      ref_heap->remove_at(i);
+      break;
+    }
+  expected_mod_count = ++ref_heap->mod_count;
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+std::string MinMaxHeap<T,tgt,Alloc>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << it.str() << "/expected_mod_count=" << expected_mod_count << "/can_erase=" << can_erase;
+  return answer.str();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+auto MinMaxHeap<T,tgt,Alloc>::Iterator::operator ++ () -> MinMaxHeap<T,tgt,Alloc>::Iterator& {
+  if (expected_mod_count != ref_heap->mod_count)
+    throw ConcurrentModificationError("MinMaxHeap::Iterator::operator ++");
+
+  if (it.empty())
+    return *this;
+
+  if (can_erase)
+    it.dequeue();
+  else
+    can_erase = true;
+  return *this;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+auto MinMaxHeap<T,tgt,Alloc>::Iterator::operator ++ (int) -> MinMaxHeap<T,tgt,Alloc>::Iterator {
+  if (expected_mod_count != ref_heap->mod_count)
+    throw ConcurrentModificationError("MinMaxHeap::Iterator::operator ++(int)");
+
+  if (it.empty())
+    return *this;
+
+  Iterator to_return(*this);
+  if (can_erase)
+    it.dequeue();
+  else
+    can_erase = true;
+  return to_return;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool MinMaxHeap<T,tgt,Alloc>::Iterator::operator == (const MinMaxHeap<T,tgt,Alloc>::Iterator& rhs) const {
+  if (expected_mod_count != ref_heap->mod_count)
+    throw ConcurrentModificationError("MinMaxHeap::Iterator::operator ==");
+  if (ref_heap != rhs.ref_heap)
+    throw ComparingDifferentIteratorsError("MinMaxHeap::Iterator::operator ==");
+
+  return it.size() == rhs.it.size();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool MinMaxHeap<T,tgt,Alloc>::Iterator::operator != (const MinMaxHeap<T,tgt,Alloc>::Iterator& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T& MinMaxHeap<T,tgt,Alloc>::Iterator::operator *() const {
+  if (expected_mod_count != ref_heap->mod_count)
+    throw ConcurrentModificationError("MinMaxHeap::Iterator::operator *");
+  if (!can_erase || it.empty())
+    throw IteratorPositionIllegal("MinMaxHeap::Iterator::operator * Iterator illegal: exhausted or erased");
+
+  return it.peek();
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T* MinMaxHeap<T,tgt,Alloc>::Iterator::operator ->() const {
+  if (expected_mod_count != ref_heap->mod_count)
+    throw ConcurrentModificationError("MinMaxHeap::Iterator::operator ->");
+  if (!can_erase || it.empty())
+    throw IteratorPositionIllegal("MinMaxHeap::Iterator::operator -> Iterator illegal: exhausted or erased");
+
+  return &it.peek();
+}
+
+}
+
+#endif /* MIN_MAX_HEAP_HPP_ */
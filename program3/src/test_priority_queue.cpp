@@ -1,11 +1,19 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>                 // std::random_shuffle
+#include <chrono>
+#include <thread>
+#include <future>
+#include <vector>
 #include "ics46goody.hpp"
 #include "gtest/gtest.h"
 #include "array_stack.hpp"           // must leave in for constructor
 #include "array_priority_queue.hpp"  // must leave in for large_scale
 #include "heap_priority_queue.hpp"
+#include "delay_queue.hpp"
+#include "min_max_heap.hpp"
+#include "indirect_heap_priority_queue.hpp"
+#include "loser_tree_merge.hpp"
 
 bool gt_string  (const std::string& a, const std::string& b) {return a < b;}
 bool gt_string2 (const std::string& a, const std::string& b) {return a > b;}
@@ -659,6 +667,276 @@ TEST_F(PriorityQueueTest, large_scale_speed) {
 }
 
 
+TEST_F(PriorityQueueTest, cancel_tokens) {
+  PriorityQueueTypeStr q;
+  PriorityQueueTypeStr::Token tb = q.enqueue_token("b");
+  PriorityQueueTypeStr::Token ta = q.enqueue_token("a");
+  load(q,"dc");
+  ASSERT_EQ(4,q.size());
+
+  ASSERT_TRUE(q.cancel(ta));               //the top: removed at once
+  ASSERT_FALSE(q.cancel(ta));              //already cancelled
+  ASSERT_EQ("b",q.peek());
+  ASSERT_EQ(3,q.size());
+  ASSERT_TRUE(unload(q,"b"));
+  ASSERT_FALSE(q.cancel(tb));              //already dequeued
+  ASSERT_TRUE(unload(q,"cd"));
+  ASSERT_TRUE(q.empty());
+
+  //A token whose slot was reused for another value cancels nothing
+  PriorityQueueTypeStr::Token tx = q.enqueue_token("x");
+  ASSERT_EQ("x",q.dequeue());
+  PriorityQueueTypeStr::Token ty = q.enqueue_token("y");
+  ASSERT_FALSE(q.cancel(tx));
+  ASSERT_EQ(1,q.size());
+  ASSERT_TRUE(q.cancel(ty));
+  ASSERT_TRUE(q.empty());
+
+  //Tombstones below the top are skipped, then compacted away past the threshold
+  std::vector<PriorityQueueTypeStr::Token> tokens;
+  for (char c='a'; c<='j'; ++c)
+    tokens.push_back(q.enqueue_token(std::string(1,c)));
+  ASSERT_TRUE(q.cancel(tokens[3]));
+  ASSERT_TRUE(q.cancel(tokens[5]));
+  ASSERT_EQ(2,q.tombstones());
+  ASSERT_EQ(8,q.size());
+  int compactions = q.compactions();
+  for (int i : {1,2,7,8,9})
+    ASSERT_TRUE(q.cancel(tokens[i]));
+  ASSERT_LT(compactions,q.compactions());
+  ASSERT_EQ(3,q.size());
+  ASSERT_TRUE(unload(q,"aeg"));
+  ASSERT_TRUE(q.empty());
+
+  //clear makes every outstanding token stale
+  PriorityQueueTypeStr::Token tz = q.enqueue_token("z");
+  q.clear();
+  ASSERT_FALSE(q.cancel(tz));
+}
+
+
+bool gt_tens (const int& a, const int& b) {return a/10 < b/10;}   //equal priority: same tens digit
+
+TEST_F(PriorityQueueTest, stable) {
+  ics::StableHeapPriorityQueue<int,gt_tens> q;
+  std::vector<int> in = {21,5,22,1,9,23,24,3,25,7,26,2};
+  for (int v : in)
+    q.enqueue(v);
+  //Equal priorities come out in enqueue order
+  for (int v : {5,1,9,3,7,2,21,22,23,24,25,26})
+    ASSERT_EQ(v,q.dequeue());
+
+  //Also when mixed with cancellation and compaction
+  std::vector<ics::StableHeapPriorityQueue<int,gt_tens>::Token> tokens;
+  for (int v : in)
+    tokens.push_back(q.enqueue_token(v));
+  ASSERT_TRUE(q.cancel(tokens[2]));                //22
+  ASSERT_TRUE(q.cancel(tokens[7]));                //3
+  q.set_compact_threshold(0.0);                    //compacts now
+  for (int v : {5,1,9,7,2,21,23,24,25,26})
+    ASSERT_EQ(v,q.dequeue());
+  ASSERT_TRUE(q.empty());
+}
+
+
+class MinMaxHeapTest : public ::testing::Test {
+protected:
+    virtual void SetUp()    {}
+    virtual void TearDown() {}
+};
+
+
+TEST_F(MinMaxHeapTest, both_ends) {
+  ics::MinMaxHeap<std::string,gt_string> h;
+  ASSERT_TRUE(h.empty());
+  ASSERT_THROW(h.peek(),ics::EmptyError);
+  ASSERT_THROW(h.dequeue_lowest(),ics::EmptyError);
+  load(h,"fbjadhcgie");
+  ASSERT_EQ(10,h.size());
+  ASSERT_EQ("a",h.peek());
+  ASSERT_EQ("j",h.peek_lowest());
+  ASSERT_EQ("j",h.dequeue_lowest());
+  ASSERT_EQ("a",h.dequeue());
+  ASSERT_EQ("i",h.dequeue_lowest());
+  ASSERT_EQ("b",h.dequeue());
+
+  //The Iterator goes from highest to lowest, without changing h
+  std::string order;
+  for (const std::string& v : h)
+    order += v;
+  ASSERT_EQ("cdefgh",order);
+  ics::MinMaxHeap<std::string,gt_string> copy(h);
+  ASSERT_EQ(copy,h);
+  ASSERT_TRUE(unload(h,"cdefgh"));
+  ASSERT_NE(copy,h);
+}
+
+
+TEST_F(MinMaxHeapTest, against_sorted) {
+  ics::MinMaxHeap<int,gt_int> h;
+  std::vector<int> values;
+  for (int i=0; i<1000; ++i)
+    values.push_back((i*7919) % 1009);
+  for (int v : values)
+    h.enqueue(v);
+  std::sort(values.begin(),values.end());
+  unsigned low = 0, high = values.size();
+  for (int i=0; !h.empty(); ++i)   //alternate ends: both stay correct
+    if (i % 3 == 0)
+      ASSERT_EQ(values[--high],h.dequeue_lowest());
+    else
+      ASSERT_EQ(values[low++],h.dequeue());
+  ASSERT_EQ(low,high);
+}
+
+
+class IndirectHeapTest : public ::testing::Test {
+protected:
+    virtual void SetUp()    {}
+    virtual void TearDown() {}
+};
+
+
+struct Counted {
+  std::string word;
+  int         count;
+};
+bool gt_counted (const Counted& a, const Counted& b) {return a.count > b.count || (a.count == b.count && a.word < b.word);}
+int  count_of   (const Counted& c) {return c.count;}
+
+
+TEST_F(IndirectHeapTest, unkeyed) {
+  std::vector<Counted> words = {{"a",3},{"b",9},{"c",1},{"d",9},{"e",5}};
+  ics::IndirectHeapPriorityQueue<Counted,gt_counted> q(words.data(), words.size());
+  for (int i=0; i<5; ++i)
+    q.enqueue(i);
+  ASSERT_THROW(q.enqueue(2),ics::IcsError);
+  ASSERT_THROW(q.enqueue(5),ics::IcsError);
+  ASSERT_EQ(1,q.peek());
+  ASSERT_EQ("b",q.peek_value().word);
+
+  words[2].count = 10;      //c overtakes everything
+  q.update(2);
+  q.erase(3);               //d leaves
+  ASSERT_FALSE(q.contains(3));
+  ASSERT_THROW(q.erase(3),ics::KeyError);
+  for (int i : {2,1,4,0})
+    ASSERT_EQ(i,q.dequeue());
+  ASSERT_TRUE(q.empty());
+  ASSERT_THROW(q.dequeue(),ics::EmptyError);
+}
+
+
+TEST_F(IndirectHeapTest, keyed) {
+  std::vector<Counted> words = {{"x",2},{"y",4},{"z",4}};
+  ics::IndirectHeapPriorityQueue<Counted,gt_counted,int> q(words.data(), words.size(), nullptr, count_of);
+  for (int i=0; i<3; ++i)
+    q.enqueue(i);
+  ASSERT_EQ(1,q.dequeue());   //y and z: equal keys, gt breaks the tie
+  words.push_back({"w",3});   //may reallocate
+  q.set_elements(words.data(), words.size());
+  q.enqueue(3);
+  words[0].count = 5;
+  q.update(0);                //the cached key changes too
+  for (int i : {0,2,3})
+    ASSERT_EQ(i,q.dequeue());
+}
+
+
+class LoserTreeTest : public ::testing::Test {
+protected:
+    virtual void SetUp()    {}
+    virtual void TearDown() {}
+};
+
+
+TEST_F(LoserTreeTest, merge) {
+  std::vector<std::vector<int>> runs = {{1,4,7,10},{},{2,5,8},{3,6,9,11,12},{0}};
+  ics::LoserTreeMerge<int,gt_int> m;
+  ASSERT_TRUE(m.empty());
+  ASSERT_THROW(m.peek(),ics::EmptyError);
+  for (const std::vector<int>& r : runs)
+    m.add_all(r);
+  ASSERT_EQ(5,m.sources());
+  ASSERT_EQ(0,m.peek());
+  ASSERT_EQ(0,m.dequeue());
+  ASSERT_EQ(1,m.dequeue());
+
+  std::vector<int> late = {2,13};    //added mid-merge: merges with what remains
+  m.add_all(late);
+  std::vector<int> merged;
+  for (int v : m)
+    merged.push_back(v);
+  ASSERT_EQ(std::vector<int>({2,2,3,4,5,6,7,8,9,10,11,12,13}),merged);
+  ASSERT_TRUE(m.empty());
+}
+
+
+struct Tagged {
+  int key;
+  int source;
+};
+bool gt_tagged (const Tagged& a, const Tagged& b) {return a.key < b.key;}
+
+TEST_F(LoserTreeTest, stable) {// equal values come out in the order their sources were added
+  std::vector<std::vector<Tagged>> runs(7);
+  for (int s=0; s<7; ++s)
+    for (int k=0; k<20; k+=1+s%3)
+      runs[s].push_back({k,s});
+  ics::LoserTreeMerge<Tagged,gt_tagged> m;
+  for (const std::vector<Tagged>& r : runs)
+    m.add_all(r);
+  Tagged previous = m.dequeue();
+  while (!m.empty()) {
+    Tagged next = m.dequeue();
+    ASSERT_TRUE(previous.key < next.key || (previous.key == next.key && previous.source < next.source));
+    previous = next;
+  }
+}
+
+
+class DelayQueueTest : public ::testing::Test {
+protected:
+    virtual void SetUp()    {}
+    virtual void TearDown() {}
+};
+
+
+//Whether n takers are blocked in q within 2 seconds
+template<class T>
+::testing::AssertionResult takers_blocked(const ics::DelayQueue<T>& q, int n) {
+  std::chrono::steady_clock::time_point give_up = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (q.takers_waiting() != n)
+    if (std::chrono::steady_clock::now() > give_up)
+      return ::testing::AssertionFailure() << q.str();
+    else
+      std::this_thread::yield();
+  return ::testing::AssertionSuccess();
+}
+
+
+TEST_F(DelayQueueTest, take_for_hands_off) {// a leader timing out must wake a follower
+  ics::DelayQueue<std::string> q;
+  q.enqueue("a", std::chrono::milliseconds(1000));
+
+  std::future<bool> leader = std::async(std::launch::async, [&q] () {
+    std::string value;
+    return q.take_for(value, std::chrono::milliseconds(500));
+  });
+  EXPECT_TRUE(takers_blocked(q,1));                              //The first taker leads (EXPECT: close below)
+  std::future<std::string> follower = std::async(std::launch::async, [&q] () {return q.take();});
+  EXPECT_TRUE(takers_blocked(q,2));                              //Both asleep: the leader has not timed out
+
+  ASSERT_FALSE(leader.get());
+  bool taken = follower.wait_for(std::chrono::seconds(2)) == std::future_status::ready;
+  if (!taken)
+    q.close();                                                   //Wakes the stuck taker, so get() returns
+  ASSERT_TRUE(taken);
+  ASSERT_EQ("a",follower.get());
+  ASSERT_EQ(0,q.takers_waiting());
+}
+
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
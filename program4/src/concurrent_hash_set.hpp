@@ -0,0 +1,443 @@
+#ifndef CONCURRENT_HASH_SET_HPP_
+#define CONCURRENT_HASH_SET_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <atomic>             //For the slots and counters shared by the threads
+#include <cstdint>            //For std::uintptr_t
+#include <algorithm>          //For std::min
+#include <memory>             //For std::allocator/std::allocator_traits
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//A set that many threads may insert into (and query) at once without locking: for deduplicating
+//  (insert returns whether the element was new), not for general use (there is no erase, and
+//  no iterator: clear, str, and destruction need the other threads to have stopped).
+//thash/chash are as in HashSet.
+//The set is one array of slots, each nullptr or a pointer to a node holding an element; insert
+//  probes linearly from the element's home slot and claims the first empty one with a
+//  compare-and-swap (so of two threads inserting the same element, one claims the slot and the
+//  other then sees the element in it).
+//When more than load_threshold of the slots are used, a table twice as large is made, and every
+//  thread that inserts helps move the nodes into it, 1024 slots at a time: a moved (or empty)
+//  slot is sealed by setting its pointer's low bit, so no insert can claim it; an insert that
+//  reaches a sealed slot helps finish the move, then inserts into the new table. Moving a slot
+//  twice does nothing the second time, so once every chunk is claimed a thread does not wait for
+//  the others' (one may be descheduled): it moves any slot still unsealed itself. Inserts never
+//  block each other. contains never waits: an element it does not find before a sealed empty
+//  slot, it looks for in the new table.
+//Old tables are freed with the set, not before (another thread may still be reading one): at
+//  most as much memory as the newest table.
+//Alloc is any std::allocator-compatible allocator of T; it is rebound to allocate the nodes,
+//  tables, and slot arrays.
+template<class T, int (*thash)(const T& a) = nullptr, class Alloc = std::allocator<T>> class ConcurrentHashSet {
+  public:
+    //Destructor/Constructors
+    ~ConcurrentHashSet ();
+
+    ConcurrentHashSet          (double the_load_threshold = 0.5, int (*chash)(const T& a) = nullptr, const Alloc& alloc = Alloc());
+    explicit ConcurrentHashSet (int expected_size, double the_load_threshold = 0.5, int (*chash)(const T& a) = nullptr, const Alloc& alloc = Alloc());
+    ConcurrentHashSet          (const ConcurrentHashSet<T,thash,Alloc>& to_copy) = delete;
+    ConcurrentHashSet<T,thash,Alloc>& operator = (const ConcurrentHashSet<T,thash,Alloc>& rhs) = delete;
+
+
+    //Queries (safe while other threads insert)
+    bool empty      () const;
+    int  size       () const;
+    bool contains   (const T& element) const;
+    int  capacity   () const;   //Slots in the newest table
+    std::string str () const; //supplies useful debugging information (only when no thread inserts)
+
+
+    //Commands
+    int  insert (const T& element);   //1 if element was new (this call added it); 0 if already in the set
+    void clear  ();                   //Only when no other thread uses the set
+
+    //Iterable class must support "for" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int insert_all(const Iterable& i);
+
+
+  private:
+    class Node {
+      public:
+        Node (const T& v, int h) : value(v), hash(h) {}
+
+        T   value;
+        int hash;               //Stored: compared before value, and reused when moved
+    };
+
+    class Table {
+      public:
+        Table (int c) : capacity(c) {
+          while (1 << (32-shift) < capacity)
+            --shift;
+        }
+
+        int                 capacity;               //A power of 2
+        int                 shift = 32;             //32 - log2(capacity): keeps the top bits of the mixed hash
+        std::atomic<Node*>* slots = nullptr;
+        std::atomic<int>    used{0};                //Slots claimed (by inserts or moves)
+        std::atomic<Table*> next{nullptr};          //The table being moved into (then the newer table)
+        std::atomic<int>    claimed{0};             //Chunks of slots claimed by the threads moving them
+        std::atomic<int>    moved{0};               //Chunks of slots moved
+    };
+
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node>               NodeAlloc;
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Table>              TableAlloc;
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<std::atomic<Node*>> SlotAlloc;
+  typedef std::allocator_traits<NodeAlloc>  NodeTraits;
+  typedef std::allocator_traits<TableAlloc> TableTraits;
+  typedef std::allocator_traits<SlotAlloc>  SlotTraits;
+
+  static const int chunk = 1024;      //Slots a thread moves at a time
+
+  int (*hash)(const T& element);      //Hashing function used by this set
+  mutable NodeAlloc  node_alloc;
+  mutable TableAlloc table_alloc;
+  mutable SlotAlloc  slot_alloc;
+  double load_threshold;              //used/capacity must not exceed load_threshold
+  int    initial_capacity;
+  Table* oldest;                      //Each table's next is the newer one (for freeing them all)
+  std::atomic<Table*> table;          //The newest table whose nodes were all moved into it
+  std::atomic<int>    used{0};        //Elements in the set
+
+
+  //Helper methods
+  static bool  sealed (Node* n);     //Whether a slot holding n was sealed (n's low bit set)
+  static Node* seal   (Node* n);
+  static Node* unseal (Node* n);
+  int    home       (int h, const Table* t) const;
+  Table* grow       (Table* t);      //Make (or find) t->next, help move t into it, return it
+  void   move_slot  (Table* from, int s, Table* to);
+  Node*  new_node   (const T& element, int h);
+  void   delete_node(Node* n);
+  Table* new_table  (int capacity);
+  void   delete_table(Table* t);
+  void   delete_tables();            //All tables (from oldest) and the nodes in the newest
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//ConcurrentHashSet class and related definitions
+
+template<class T, int (*thash)(const T& a), class Alloc>
+const int ConcurrentHashSet<T,thash,Alloc>::chunk;
+
+
+//Destructor/Constructors
+
+template<class T, int (*thash)(const T& a), class Alloc>
+ConcurrentHashSet<T,thash,Alloc>::~ConcurrentHashSet() {
+  delete_tables();
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+ConcurrentHashSet<T,thash,Alloc>::ConcurrentHashSet(double the_load_threshold, int (*chash)(const T& element), const Alloc& alloc)
+: ConcurrentHashSet(0, the_load_threshold, chash, alloc) {
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+ConcurrentHashSet<T,thash,Alloc>::ConcurrentHashSet(int expected_size, double the_load_threshold, int (*chash)(const T& element), const Alloc& alloc)
+: hash(thash != nullptr ? thash : chash), node_alloc(alloc), table_alloc(alloc), slot_alloc(alloc),
+  load_threshold(the_load_threshold), initial_capacity(16)
+{
+  if (hash == nullptr)
+    throw TemplateFunctionError("ConcurrentHashSet::length constructor: neither specified");
+  if (thash != nullptr && chash != nullptr && thash != chash)
+    throw TemplateFunctionError("ConcurrentHashSet::length constructor: both specified and different");
+  if (load_threshold <= 0.0 || load_threshold >= 1.0)
+    throw IcsError("ConcurrentHashSet::length constructor: load_threshold must be in (0,1)");
+
+  while (initial_capacity*load_threshold < expected_size)
+    initial_capacity *= 2;
+  oldest = new_table(initial_capacity);
+  table.store(oldest);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, int (*thash)(const T& a), class Alloc>
+bool ConcurrentHashSet<T,thash,Alloc>::empty() const {
+  return used.load() == 0;
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+int ConcurrentHashSet<T,thash,Alloc>::size() const {
+  return used.load();
+}
+
+
+//An element inserted into a newer table was inserted after every slot of this one was sealed:
+//  so not finding element before an unsealed empty slot means it is not in the set
+template<class T, int (*thash)(const T& a), class Alloc>
+bool ConcurrentHashSet<T,thash,Alloc>::contains (const T& element) const {
+  int h = hash(element);
+  for (Table* t = table.load(std::memory_order_acquire); t != nullptr; t = t->next.load(std::memory_order_acquire)) {
+    int s = home(h,t);
+    for (int probes = 0; probes < t->capacity; ++probes, s = (s+1) & (t->capacity-1)) {
+      Node* n = t->slots[s].load(std::memory_order_acquire);
+      Node* u = unseal(n);
+      if (u == nullptr) {
+        if (n == nullptr)
+          return false;
+        break;                          //Sealed empty: any later insert went to the next table
+      }
+      if (u->hash == h && u->value == element)
+        return true;
+    }
+  }
+  return false;
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+int ConcurrentHashSet<T,thash,Alloc>::capacity() const {
+  return table.load()->capacity;
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+std::string ConcurrentHashSet<T,thash,Alloc>::str() const {
+  std::ostringstream answer;
+  Table* t = table.load();
+  answer << "ConcurrentHashSet[";
+  for (int s = 0; s < t->capacity; ++s) {
+    Node* n = unseal(t->slots[s].load());
+    if (n != nullptr)
+      answer << std::endl << "  slot[" << s << "] = " << n->value;
+  }
+  int tables = 0;
+  for (Table* o = oldest; o != nullptr; o = o->next.load())
+    ++tables;
+  answer << "](load_threshold=" << load_threshold << ",capacity=" << t->capacity << ",used=" << used.load()
+         << ",tables=" << tables << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+//The node is made at most once (when the first empty slot is found), and kept through retries
+template<class T, int (*thash)(const T& a), class Alloc>
+int ConcurrentHashSet<T,thash,Alloc>::insert(const T& element) {
+  int   h    = hash(element);
+  Node* node = nullptr;
+  for (Table* t = table.load(std::memory_order_acquire); ; t = grow(t)) {
+    if (t->used.load(std::memory_order_relaxed) + 1 > t->capacity*load_threshold)
+      continue;                         //Grow first
+    int s = home(h,t);
+    for (int probes = 0; probes < t->capacity; ++probes, s = (s+1) & (t->capacity-1)) {
+      Node* n = t->slots[s].load(std::memory_order_acquire);
+      if (n == nullptr) {
+        if (node == nullptr)
+          node = new_node(element,h);
+        if (t->slots[s].compare_exchange_strong(n, node, std::memory_order_acq_rel, std::memory_order_acquire)) {
+          t->used.fetch_add(1, std::memory_order_relaxed);
+          used.fetch_add(1, std::memory_order_relaxed);
+          return 1;
+        }
+        //n is now what another thread put there: check it as if loaded
+      }
+      Node* u = unseal(n);
+      if (u != nullptr && u->hash == h && u->value == element) {
+        if (node != nullptr)
+          delete_node(node);
+        return 0;
+      }
+      if (sealed(n))
+        break;                          //Being moved: help, then insert into the next table
+    }
+  }
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+void ConcurrentHashSet<T,thash,Alloc>::clear() {
+  delete_tables();
+  oldest = new_table(initial_capacity);
+  table.store(oldest);
+  used.store(0);
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+template<class Iterable>
+int ConcurrentHashSet<T,thash,Alloc>::insert_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    count += insert(v);
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, int (*thash)(const T& a), class Alloc>
+bool ConcurrentHashSet<T,thash,Alloc>::sealed (Node* n) {
+  return reinterpret_cast<std::uintptr_t>(n) & 1;
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+auto ConcurrentHashSet<T,thash,Alloc>::seal (Node* n) -> Node* {
+  return reinterpret_cast<Node*>(reinterpret_cast<std::uintptr_t>(n) | 1);
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+auto ConcurrentHashSet<T,thash,Alloc>::unseal (Node* n) -> Node* {
+  return reinterpret_cast<Node*>(reinterpret_cast<std::uintptr_t>(n) & ~std::uintptr_t(1));
+}
+
+
+//Fibonacci hashing: spreads even poor hash values (e.g., i for int i) over the slots
+template<class T, int (*thash)(const T& a), class Alloc>
+int ConcurrentHashSet<T,thash,Alloc>::home (int h, const Table* t) const {
+  return int((unsigned(h) * 2654435769u) >> t->shift);
+}
+
+
+//Threads claim chunks of t's slots until none are left, then finish any chunk other threads
+//  claimed but have not yet moved: only when every slot of t is sealed may anything be inserted
+//  into the next table (an element still in t could otherwise be inserted again there)
+template<class T, int (*thash)(const T& a), class Alloc>
+auto ConcurrentHashSet<T,thash,Alloc>::grow (Table* t) -> Table* {
+  Table* next = t->next.load(std::memory_order_acquire);
+  if (next == nullptr) {
+    Table* bigger = new_table(2*t->capacity);
+    if (t->next.compare_exchange_strong(next, bigger, std::memory_order_acq_rel, std::memory_order_acquire))
+      next = bigger;
+    else
+      delete_table(bigger);             //Another thread's is used (now in next)
+  }
+
+  int chunks = (t->capacity + chunk-1) / chunk;
+  for (int c; (c = t->claimed.fetch_add(1, std::memory_order_relaxed)) < chunks; ) {
+    int stop = std::min(t->capacity, (c+1)*chunk);
+    for (int s = c*chunk; s < stop; ++s)
+      move_slot(t, s, next);
+    t->moved.fetch_add(1, std::memory_order_release);
+  }
+  for (int c = 0; c < chunks && t->moved.load(std::memory_order_acquire) < chunks; ++c) {
+    int stop = std::min(t->capacity, (c+1)*chunk);
+    for (int s = c*chunk; s < stop; ++s)
+      move_slot(t, s, next);            //Just a load, for a slot already sealed
+  }
+
+  Table* expected = t;
+  table.compare_exchange_strong(expected, next, std::memory_order_acq_rel);
+  return next;
+}
+
+
+//Several threads may move slot s at once (and one may resume long after another finished it).
+//  Returns only once s is sealed. While from is moved, to's slots only change from empty to a
+//  node: so every mover of n probes the same run and stops at n or at the first empty slot, and
+//  n is put in to just once.
+template<class T, int (*thash)(const T& a), class Alloc>
+void ConcurrentHashSet<T,thash,Alloc>::move_slot (Table* from, int s, Table* to) {
+  Node* n = from->slots[s].load(std::memory_order_acquire);
+  //A failed compare-and-swap leaves in n the node an insert just claimed the slot for (or its seal)
+  while (n == nullptr)
+    if (from->slots[s].compare_exchange_strong(n, seal(nullptr), std::memory_order_acq_rel, std::memory_order_acquire))
+      return;
+  if (sealed(n))
+    return;                             //Moved already
+
+  for (int t = home(n->hash, to); ; t = (t+1) & (to->capacity-1)) {
+    Node* m = to->slots[t].load(std::memory_order_acquire);
+    if (m == nullptr && to->slots[t].compare_exchange_strong(m, n, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      to->used.fetch_add(1, std::memory_order_relaxed);
+      break;
+    }
+    if (unseal(m) == n)
+      break;                            //Another thread put it there (to may be moving on by now)
+  }
+  from->slots[s].compare_exchange_strong(n, seal(n), std::memory_order_acq_rel, std::memory_order_relaxed);  //Fails only if another mover sealed it
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+auto ConcurrentHashSet<T,thash,Alloc>::new_node (const T& element, int h) -> Node* {
+  Node* n = NodeTraits::allocate(node_alloc, 1);
+  try {
+    NodeTraits::construct(node_alloc, n, element, h);
+  } catch (...) {
+    NodeTraits::deallocate(node_alloc, n, 1);
+    throw;
+  }
+  return n;
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+void ConcurrentHashSet<T,thash,Alloc>::delete_node (Node* n) {
+  NodeTraits::destroy(node_alloc, n);
+  NodeTraits::deallocate(node_alloc, n, 1);
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+auto ConcurrentHashSet<T,thash,Alloc>::new_table (int capacity) -> Table* {
+  Table* t = TableTraits::allocate(table_alloc, 1);
+  TableTraits::construct(table_alloc, t, capacity);
+  try {
+    t->slots = SlotTraits::allocate(slot_alloc, capacity);
+  } catch (...) {
+    TableTraits::destroy(table_alloc, t);
+    TableTraits::deallocate(table_alloc, t, 1);
+    throw;
+  }
+  for (int s = 0; s < capacity; ++s)
+    SlotTraits::construct(slot_alloc, t->slots+s, nullptr);
+  return t;
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+void ConcurrentHashSet<T,thash,Alloc>::delete_table (Table* t) {
+  for (int s = 0; s < t->capacity; ++s)
+    SlotTraits::destroy(slot_alloc, t->slots+s);
+  SlotTraits::deallocate(slot_alloc, t->slots, t->capacity);
+  TableTraits::destroy(table_alloc, t);
+  TableTraits::deallocate(table_alloc, t, 1);
+}
+
+
+//Every node is in the newest table (no thread is moving one when this is called)
+template<class T, int (*thash)(const T& a), class Alloc>
+void ConcurrentHashSet<T,thash,Alloc>::delete_tables () {
+  Table* newest = table.load();
+  for (int s = 0; s < newest->capacity; ++s) {
+    Node* n = unseal(newest->slots[s].load());
+    if (n != nullptr)
+      delete_node(n);
+  }
+  for (Table* t = oldest; t != nullptr; ) {
+    Table* to_delete = t;
+    t = t->next.load();
+    delete_table(to_delete);
+  }
+}
+
+}
+
+#endif /* CONCURRENT_HASH_SET_HPP_ */
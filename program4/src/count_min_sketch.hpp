@@ -0,0 +1,412 @@
+#ifndef COUNT_MIN_SKETCH_HPP_
+#define COUNT_MIN_SKETCH_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>          //For std::min/std::sort
+#include <cstdint>
+#include "ics_exceptions.hpp"
+#include "pair.hpp"
+#include "hash_map.hpp"
+#include "heap_priority_queue.hpp"
+
+
+namespace ics {
+
+
+//Approximate counts of values in a stream, in fixed memory (depth rows of width counters),
+//  however many distinct values there are.
+//Adding a value adds to one counter in each row (chosen by a different hash of the value in
+//  each); its estimate is the smallest of those counters. Values sharing a counter only add to
+//  it, so an estimate is never below the true count, and is above it by at most 2.72*total/width
+//  except with probability 1/2.72^depth (so width 2048 and depth 4: within 0.13% of all values
+//  added, 98% of the time).
+//thash/chash are as in HashSet: the hash is mixed into 64 bits, and each row's column is its
+//  own multiply-shift hash of those (so two values share a counter in every row about as rarely
+//  as if each row had an independent hash function). Sketches of the same dimensions and hash
+//  can be merged (e.g., one per thread): the merged sketch is the one that would have counted
+//  both streams.
+template<class T, int (*thash)(const T& a) = nullptr> class CountMinSketch {
+  public:
+    //Destructor/Constructors
+    ~CountMinSketch ();
+    explicit CountMinSketch (int the_width = 2048, int the_depth = 4, int (*chash)(const T& a) = nullptr);
+
+
+    //Queries
+    long estimate   (const T& value) const;   //At least the count of value added
+    long total      () const;                 //Sum of all counts added
+    int  width      () const;
+    int  depth      () const;
+    int  bytes      () const;                 //Memory used (this object and its counters)
+    std::string str () const; //supplies useful debugging information
+
+
+    //Commands
+    long add   (const T& value, long count = 1);   //count >= 0; returns value's new estimate
+    void merge (const CountMinSketch<T,thash>& other);
+    void clear ();
+
+
+  private:
+    int (*hash)(const T& value);
+    int  columns;
+    int  rows;
+    long sum = 0;
+    std::vector<long> counters;        //Row r's counters are [r*columns, (r+1)*columns)
+    std::vector<std::uint64_t> multipliers;   //Row r's (odd) multiplier: the same in every sketch
+
+    //Helper methods
+    static std::uint64_t mix (std::uint64_t h);
+    std::uint64_t hashed (const T& value) const;
+    std::size_t   counter(std::uint64_t h, int r) const;   //Index of h's counter in row r
+};
+
+
+
+
+//The k values with the highest estimated counts in a stream (e.g., the most frequent n-grams),
+//  in fixed memory: a CountMinSketch of every value, plus the k current candidates.
+//The candidates are kept in a HeapPriorityQueue ordered by count (the least frequent at its top)
+//  and a HashMap from each to its latest estimate. A value that is not a candidate replaces the
+//  top one when its estimate becomes higher. Heap entries are not updated when a candidate's
+//  estimate rises (the heap cannot change an entry in place): only when one reaches the top is
+//  it re-enqueued with the HashMap's estimate, until the top is up to date.
+//HeavyHitters of the same k, dimensions, and hash can be merged (e.g., each thread counting
+//  part of a stream, merged at the end): the sketches are merged, and the k candidates of both
+//  with the highest merged estimates are kept.
+template<class T, int (*thash)(const T& a) = nullptr> class HeavyHitters {
+  public:
+    typedef ics::pair<T,long> Entry;   //A value and its estimated count
+
+    //Destructor/Constructors
+    ~HeavyHitters ();
+    explicit HeavyHitters (int the_k, int width = 2048, int depth = 4, int (*chash)(const T& a) = nullptr);
+
+
+    //Queries
+    std::vector<Entry> top () const;           //The candidates, highest estimate first
+    long estimate   (const T& value) const;    //As in CountMinSketch (for any value)
+    long total      () const;
+    int  size       () const;                  //Candidates (k once k distinct values are added)
+    int  k          () const;
+    std::string str () const; //supplies useful debugging information
+
+
+    //Commands
+    long add   (const T& value, long count = 1);   //count >= 0; returns value's new estimate
+    void merge (const HeavyHitters<T,thash>& other);
+    void clear ();
+
+
+  private:
+    int                              most;          //k
+    CountMinSketch<T,thash>          sketch;
+    HeapPriorityQueue<Entry>         candidates;    //Least estimate (when last enqueued) at the top
+    HashMap<T,long,thash>            latest;        //Each candidate's latest estimate
+
+    //Helper methods
+    static bool fewer (const Entry& a, const Entry& b);   //The heap's gt: a's count is lower
+    void offer (const T& value, long estimate);            //Make value a candidate, if high enough
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//CountMinSketch class and related definitions
+
+//Destructor/Constructors
+
+template<class T, int (*thash)(const T& a)>
+CountMinSketch<T,thash>::~CountMinSketch() {
+}
+
+
+template<class T, int (*thash)(const T& a)>
+CountMinSketch<T,thash>::CountMinSketch(int the_width, int the_depth, int (*chash)(const T& a))
+: hash(thash != nullptr ? thash : chash), columns(the_width), rows(the_depth) {
+  if (hash == nullptr)
+    throw TemplateFunctionError("CountMinSketch::constructor: neither specified");
+  if (thash != nullptr && chash != nullptr && thash != chash)
+    throw TemplateFunctionError("CountMinSketch::constructor: both specified and different");
+  if (columns < 1 || rows < 1)
+    throw IcsError("CountMinSketch::constructor: width and depth must be >= 1");
+  counters.assign(std::size_t(columns)*rows, 0);
+  for (int r = 0; r < rows; ++r)
+    multipliers.push_back(mix(r+1) | 1);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, int (*thash)(const T& a)>
+long CountMinSketch<T,thash>::estimate(const T& value) const {
+  std::uint64_t h = hashed(value);
+  long answer = counters[counter(h,0)];
+  for (int r = 1; r < rows; ++r)
+    answer = std::min(answer, counters[counter(h,r)]);
+  return answer;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+long CountMinSketch<T,thash>::total() const {
+  return sum;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+int CountMinSketch<T,thash>::width() const {
+  return columns;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+int CountMinSketch<T,thash>::depth() const {
+  return rows;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+int CountMinSketch<T,thash>::bytes() const {
+  return sizeof(CountMinSketch<T,thash>) + counters.capacity()*sizeof(long) + multipliers.capacity()*sizeof(std::uint64_t);
+}
+
+
+template<class T, int (*thash)(const T& a)>
+std::string CountMinSketch<T,thash>::str() const {
+  std::ostringstream answer;
+  answer << "CountMinSketch[";
+  for (int r = 0; r < rows; ++r) {
+    long most = 0;
+    int  used = 0;
+    for (int c = 0; c < columns; ++c) {
+      most = std::max(most, counters[std::size_t(r)*columns + c]);
+      used += counters[std::size_t(r)*columns + c] != 0;
+    }
+    answer << std::endl << "  row " << r << ": " << used << " counters used, max " << most;
+  }
+  answer << "](width=" << columns << ",depth=" << rows << ",total=" << sum << ",bytes=" << bytes() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+//A negative count could lower a counter shared with other values (so their estimates could
+//  fall below their counts), and HeavyHitters relies on estimates never decreasing
+template<class T, int (*thash)(const T& a)>
+long CountMinSketch<T,thash>::add(const T& value, long count) {
+  if (count < 0)
+    throw IcsError("CountMinSketch::add: count must be >= 0");
+  std::uint64_t h = hashed(value);
+  long answer = counters[counter(h,0)] += count;
+  for (int r = 1; r < rows; ++r)
+    answer = std::min(answer, counters[counter(h,r)] += count);
+  sum += count;
+  return answer;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+void CountMinSketch<T,thash>::merge(const CountMinSketch<T,thash>& other) {
+  if (other.columns != columns || other.rows != rows || other.hash != hash)
+    throw IcsError("CountMinSketch::merge: different width, depth, or hash");
+  for (std::size_t i = 0; i < counters.size(); ++i)
+    counters[i] += other.counters[i];
+  sum += other.sum;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+void CountMinSketch<T,thash>::clear() {
+  counters.assign(counters.size(), 0);
+  sum = 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+//splitmix64's finalizer: spreads even poor hash values (e.g., i for int i) over all 64 bits
+template<class T, int (*thash)(const T& a)>
+std::uint64_t CountMinSketch<T,thash>::mix(std::uint64_t h) {
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+  return h ^ (h >> 31);
+}
+
+
+template<class T, int (*thash)(const T& a)>
+std::uint64_t CountMinSketch<T,thash>::hashed(const T& value) const {
+  return mix(unsigned(hash(value)));
+}
+
+
+//The top 32 bits of h*multiplier, scaled to [0,columns) (no %)
+template<class T, int (*thash)(const T& a)>
+std::size_t CountMinSketch<T,thash>::counter(std::uint64_t h, int r) const {
+  return std::size_t(r)*columns + std::size_t(((h*multipliers[r]) >> 32) * std::uint64_t(columns) >> 32);
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//HeavyHitters class and related definitions
+
+//Destructor/Constructors
+
+template<class T, int (*thash)(const T& a)>
+HeavyHitters<T,thash>::~HeavyHitters() {
+}
+
+
+template<class T, int (*thash)(const T& a)>
+HeavyHitters<T,thash>::HeavyHitters(int the_k, int width, int depth, int (*chash)(const T& a))
+: most(the_k), sketch(width, depth, chash), candidates(the_k, fewer), latest(ExpectedSize(the_k), 1.0, chash) {
+  if (most < 1)
+    throw IcsError("HeavyHitters::constructor: k must be >= 1");
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, int (*thash)(const T& a)>
+auto HeavyHitters<T,thash>::top() const -> std::vector<Entry> {
+  std::vector<Entry> answer;
+  answer.reserve(candidates.size());
+  for (const Entry& e : candidates)
+    answer.push_back(Entry(e.first, latest[e.first]));
+  std::sort(answer.begin(), answer.end(), [] (const Entry& a, const Entry& b) {return a.second > b.second;});
+  return answer;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+long HeavyHitters<T,thash>::estimate(const T& value) const {
+  return sketch.estimate(value);
+}
+
+
+template<class T, int (*thash)(const T& a)>
+long HeavyHitters<T,thash>::total() const {
+  return sketch.total();
+}
+
+
+template<class T, int (*thash)(const T& a)>
+int HeavyHitters<T,thash>::size() const {
+  return candidates.size();
+}
+
+
+template<class T, int (*thash)(const T& a)>
+int HeavyHitters<T,thash>::k() const {
+  return most;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+std::string HeavyHitters<T,thash>::str() const {
+  std::ostringstream answer;
+  answer << "HeavyHitters[";
+  for (const Entry& e : top())
+    answer << std::endl << "  " << e.first << ": " << e.second;
+  answer << "](k=" << most << ",candidates=" << candidates.size() << ",total=" << sketch.total() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, int (*thash)(const T& a)>
+long HeavyHitters<T,thash>::add(const T& value, long count) {
+  long answer = sketch.add(value, count);
+  offer(value, answer);
+  return answer;
+}
+
+
+//Each candidate is offered again with its merged estimate (a value that is a candidate in only
+//  one of them may now have a higher estimate than the other's candidates)
+template<class T, int (*thash)(const T& a)>
+void HeavyHitters<T,thash>::merge(const HeavyHitters<T,thash>& other) {
+  if (other.most != most)
+    throw IcsError("HeavyHitters::merge: different k");
+  sketch.merge(other.sketch);
+
+  std::vector<T> values;
+  values.reserve(candidates.size() + other.candidates.size());
+  for (const Entry& e : candidates)
+    values.push_back(e.first);
+  for (const Entry& e : other.candidates)
+    values.push_back(e.first);
+
+  candidates.clear();
+  latest.clear();
+  for (const T& v : values)
+    offer(v, sketch.estimate(v));
+}
+
+
+template<class T, int (*thash)(const T& a)>
+void HeavyHitters<T,thash>::clear() {
+  sketch.clear();
+  candidates.clear();
+  latest.clear();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, int (*thash)(const T& a)>
+bool HeavyHitters<T,thash>::fewer(const Entry& a, const Entry& b) {
+  return a.second < b.second;
+}
+
+
+template<class T, int (*thash)(const T& a)>
+void HeavyHitters<T,thash>::offer(const T& value, long estimate) {
+  if (latest.has_key(value)) {
+    latest[value] = estimate;
+    return;
+  }
+  if (candidates.size() < most) {
+    latest.put(value, estimate);
+    candidates.enqueue(Entry(value, estimate));
+    return;
+  }
+
+  //Bring the top up to date: then it is the candidate with the lowest estimate
+  for (long now; (now = latest[candidates.peek().first]) != candidates.peek().second; ) {
+    Entry e = candidates.dequeue();
+    e.second = now;
+    candidates.enqueue(e);
+  }
+  if (estimate <= candidates.peek().second)
+    return;
+  latest.erase(candidates.dequeue().first);
+  latest.put(value, estimate);
+  candidates.enqueue(Entry(value, estimate));
+}
+
+}
+
+#endif /* COUNT_MIN_SKETCH_HPP_ */
@@ -0,0 +1,358 @@
+#ifndef COW_TABLE_HPP_
+#define COW_TABLE_HPP_
+
+#include <memory>             //For std::allocator_traits
+#include <atomic>             //For base and Shared::refs
+
+
+namespace ics {
+
+
+//The copy-on-write array of bins behind HashMap and HashSet (a private base of each); V is what
+//  every LN stores (HashMap's pair<KEY,T>, HashSet's T), and Alloc is the container's allocator
+//  of V, rebound here for the LNs, the bins, the Shared tables, and the borrowed flags.
+//Each bin stores a list ending in a trailer node. Copying (share) freezes the source's table
+//  into a Shared, which both then reference; a table's first write after that copies the array
+//  of bin pointers (own_bin), then each bin just before writing it: the bins never written
+//  stay shared. The container hashes; this class only owns, shares, copies, and frees lists.
+//snapshot is the one const member that writes (base): copying one container from several
+//  threads at once is safe (the first snapshot wins; see snapshot), but other writes are not.
+template<class V, class Alloc> class CowTable {
+  protected:
+    class LN {
+      public:
+        LN ()                      {}
+        LN (const LN& ln)          : value(ln.value), next(ln.next){}
+        LN (V v,  LN* n = nullptr) : value(v), next(n){}
+
+        V   value;
+        LN* next   = nullptr;
+    };
+
+    //A table frozen when its container was copied: every container sharing it holds a
+    //  reference, and it is deleted (with the lists it owns) when the last one releases it. Like
+    //  a container, it may borrow some bins' lists from the table it was copied from (parent).
+    class Shared {
+      public:
+        Shared (LN** table, int bins, char* borrowed, int borrowed_bins, Shared* parent)
+        : table(table), bins(bins), borrowed(borrowed), borrowed_bins(borrowed_bins), parent(parent), refs(1) {}
+
+        LN**             table;
+        int              bins;
+        char*            borrowed;        //As in CowTable (nullptr: every list is its own)
+        int              borrowed_bins;
+        Shared*          parent;
+        std::atomic<int> refs;
+    };
+
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<LN>     NodeAlloc;
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<LN*>    BinAlloc;
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Shared> SharedAlloc;
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<char>   FlagAlloc;
+    typedef std::allocator_traits<NodeAlloc>                                     NodeTraits;
+    typedef std::allocator_traits<BinAlloc>                                      BinTraits;
+    typedef std::allocator_traits<SharedAlloc>                                   SharedTraits;
+    typedef std::allocator_traits<FlagAlloc>                                     FlagTraits;
+
+    //Destructor/Constructors (the container fills in table and bins)
+    ~CowTable ();
+    explicit CowTable (const Alloc& alloc);
+    CowTable          (const CowTable<V,Alloc>& to_copy);   //Copies just the allocators (as a container copy would)
+    CowTable<V,Alloc>& operator = (const CowTable<V,Alloc>& rhs) = delete;
+
+
+    NodeAlloc node_alloc;      //Allocates/constructs every LN (see new_LN/delete_LN)
+    BinAlloc  bin_alloc;       //Allocates the array of bins (see new_bins/delete_bins)
+    LN**      table = nullptr; //Pointer to array of pointers: each bin stores a list with a trailer node
+    int       bins  = 1;       //# bins in array (start it at 1 so hash_compress doesn't % 0)
+
+    //Copy-on-write state: base == nullptr means every bin's list belongs to this table. Otherwise
+    //  either table == base->table (just copied: nothing is this table's own) or table is this
+    //  table's own array, in which bin b's list is still base's iff borrowed[b]
+    mutable std::atomic<Shared*> base;
+    char*   borrowed      = nullptr;
+    int     borrowed_bins = 0;
+
+
+    //Helper methods
+    LN*   new_LN            ();                          //Allocate a trailer LN with node_alloc
+    LN*   new_LN            (const V& v, LN* n);         //Allocate an LN storing v with node_alloc
+    void  delete_LN         (LN* ln);                    //Destroy and deallocate an LN with node_alloc
+    LN**  new_bins          (int bins);                  //Allocate an (uninitialized) array of bins with bin_alloc
+    void  delete_bins       (LN** ht, int bins);         //Deallocate an array from new_bins (not its LNs)
+    LN*   copy_list         (LN* l)             const;   //Copy the values in a bin (in the same order)
+    LN**  copy_hash_table   (LN** ht, int bins) const;   //Copy the bins/values in ht (no rehashing)
+    void  delete_hash_table (LN**& ht, int bins);        //Deallocate all LN in ht (and the ht itself; ht == nullptr)
+    void  delete_list       (LN* l);                     //Deallocate every LN in a bin (including the trailer)
+
+    bool    sharing         () const;                    //Is any bin still shared (so must be owned before writing)?
+    int     shared_bins     () const;                    //How many bins are still shared (for str)
+    Shared* snapshot        () const;                    //Freeze this table (if not already) for sharing
+    void    share           (const CowTable<V,Alloc>& t);//Become a copy of t's table (the caller copies its size)
+    void    own_bin         (int bin);                   //Before writing bin: copy it (and the bins array) if shared
+    void    own_all         ();                          //Own every bin (before relinking them all)
+    void    drop_table      ();                          //Release this table: table == nullptr, base == nullptr
+    void    release         (Shared* s);                 //Drop a reference to s (deleting s and maybe its parents)
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//CowTable class and related definitions
+
+//Destructor/Constructors
+
+template<class V, class Alloc>
+CowTable<V,Alloc>::~CowTable() {
+  drop_table();
+}
+
+
+template<class V, class Alloc>
+CowTable<V,Alloc>::CowTable(const Alloc& alloc)
+: node_alloc(alloc), bin_alloc(alloc), base(nullptr)
+{}
+
+
+template<class V, class Alloc>
+CowTable<V,Alloc>::CowTable(const CowTable<V,Alloc>& to_copy)
+: node_alloc(NodeTraits::select_on_container_copy_construction(to_copy.node_alloc)),
+  bin_alloc (BinTraits::select_on_container_copy_construction(to_copy.bin_alloc)),
+  base(nullptr)
+{}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Helper methods
+
+template<class V, class Alloc>
+auto CowTable<V,Alloc>::new_LN () -> LN* {
+  LN* ln = NodeTraits::allocate(node_alloc, 1);
+  try {
+    NodeTraits::construct(node_alloc, ln);
+  } catch (...) {
+    NodeTraits::deallocate(node_alloc, ln, 1);
+    throw;
+  }
+  return ln;
+}
+
+
+template<class V, class Alloc>
+auto CowTable<V,Alloc>::new_LN (const V& v, LN* n) -> LN* {
+  LN* ln = NodeTraits::allocate(node_alloc, 1);
+  try {
+    NodeTraits::construct(node_alloc, ln, v, n);
+  } catch (...) {
+    NodeTraits::deallocate(node_alloc, ln, 1);
+    throw;
+  }
+  return ln;
+}
+
+
+template<class V, class Alloc>
+void CowTable<V,Alloc>::delete_LN (LN* ln) {
+  NodeTraits::destroy(node_alloc, ln);
+  NodeTraits::deallocate(node_alloc, ln, 1);
+}
+
+
+template<class V, class Alloc>
+auto CowTable<V,Alloc>::new_bins (int bins) -> LN** {
+  return BinTraits::allocate(bin_alloc, bins);  //LN* is trivial: the caller fills in every bin
+}
+
+
+template<class V, class Alloc>
+void CowTable<V,Alloc>::delete_bins (LN** ht, int bins) {
+  BinTraits::deallocate(bin_alloc, ht, bins);
+}
+
+
+template<class V, class Alloc>
+auto CowTable<V,Alloc>::copy_list (LN* l) const -> LN* {
+  CowTable<V,Alloc>* self = const_cast<CowTable<V,Alloc>*>(this);   //The allocators are not const
+  LN*  answer = self->new_LN();       //Built iteratively (a recursive copy of a long bin can overflow the stack),
+  LN** rear   = &answer;              //  in the same order (the Iterators' erase relies on that)
+  for (LN* p = l; p->next != nullptr; p = p->next) {
+    *rear = self->new_LN(p->value, *rear);
+    rear = &(*rear)->next;
+  }
+  return answer;
+}
+
+
+template<class V, class Alloc>
+auto CowTable<V,Alloc>::copy_hash_table (LN** ht, int bins) const -> LN** {
+  CowTable<V,Alloc>* self = const_cast<CowTable<V,Alloc>*>(this);   //The allocators are not const
+  LN** answer = self->new_bins(bins);
+  for (int b=0; b<bins; ++b)
+    answer[b] = copy_list(ht[b]);
+  return answer;
+}
+
+
+template<class V, class Alloc>
+void CowTable<V,Alloc>::delete_hash_table (LN**& ht, int bins) {
+  if (ht == nullptr)
+    return;
+  for (int b=0; b<bins; ++b)
+    delete_list(ht[b]);
+  delete_bins(ht, bins);
+  ht = nullptr;
+}
+
+
+template<class V, class Alloc>
+void CowTable<V,Alloc>::delete_list (LN* l) {
+  while (l != nullptr) {
+    LN* to_delete = l;
+    l = l->next;
+    delete_LN(to_delete);
+  }
+}
+
+
+template<class V, class Alloc>
+bool CowTable<V,Alloc>::sharing () const {
+  return base.load(std::memory_order_relaxed) != nullptr;
+}
+
+
+template<class V, class Alloc>
+int CowTable<V,Alloc>::shared_bins () const {
+  Shared* s = base.load(std::memory_order_acquire);
+  return s == nullptr ? 0 : (table == s->table ? bins : borrowed_bins);
+}
+
+
+//Freeze this table into a Shared (taking over its array, borrowed flags, and base), unless it
+//  already is one: the copy then just shares it too (and copies what it writes).
+//Copying only reads its source, so two threads may snapshot one table at once: each builds a
+//  Shared, and a compare-and-swap on base keeps the first (the other is deleted unused, never
+//  having touched a reference count). borrowed/borrowed_bins are left alone: once table ==
+//  base->table they are the Shared's, and nothing reads them through this table again.
+template<class V, class Alloc>
+auto CowTable<V,Alloc>::snapshot () const -> Shared* {
+  Shared* old = base.load(std::memory_order_acquire);
+  if (old != nullptr && table == old->table)
+    return old;
+  SharedAlloc shared_alloc(node_alloc);
+  Shared* s = SharedTraits::allocate(shared_alloc, 1);
+  SharedTraits::construct(shared_alloc, s, table, bins, borrowed, borrowed_bins, old);
+  if (base.compare_exchange_strong(old, s, std::memory_order_acq_rel, std::memory_order_acquire))
+    return s;
+  SharedTraits::destroy(shared_alloc, s);
+  SharedTraits::deallocate(shared_alloc, s, 1);
+  return old;                         //The winner's Shared (the failed compare_exchange loaded it)
+}
+
+
+template<class V, class Alloc>
+void CowTable<V,Alloc>::share (const CowTable<V,Alloc>& t) {
+  Shared* s = t.snapshot();
+  s->refs.fetch_add(1, std::memory_order_relaxed);
+  base.store(s, std::memory_order_relaxed);
+  table = s->table;
+  bins  = s->bins;
+}
+
+
+//If every other table sharing base has let go of it, this table takes it back over (no
+//  copying). Otherwise copy the bins array (borrowing every list), then copy just this bin's list.
+template<class V, class Alloc>
+void CowTable<V,Alloc>::own_bin (int bin) {
+  Shared* s = base.load(std::memory_order_relaxed);
+  if (s == nullptr)
+    return;
+  FlagAlloc flag_alloc(node_alloc);
+  if (table == s->table) {
+    if (s->refs.load(std::memory_order_acquire) == 1) {
+      borrowed      = s->borrowed;
+      borrowed_bins = s->borrowed_bins;
+      base.store(s->parent, std::memory_order_relaxed);
+      SharedAlloc shared_alloc(node_alloc);
+      SharedTraits::destroy(shared_alloc, s);
+      SharedTraits::deallocate(shared_alloc, s, 1);
+      s = base.load(std::memory_order_relaxed);
+      if (s == nullptr)
+        return;
+    }else {
+      table = new_bins(bins);
+      for (int b=0; b<bins; ++b)
+        table[b] = s->table[b];
+      borrowed      = FlagTraits::allocate(flag_alloc, bins);
+      borrowed_bins = bins;
+      for (int b=0; b<bins; ++b)
+        borrowed[b] = 1;
+    }
+  }
+  if (!borrowed[bin])
+    return;
+
+  table[bin] = copy_list(table[bin]);
+  borrowed[bin] = 0;
+  if (--borrowed_bins == 0) {         //Nothing is borrowed any more: let go of base
+    FlagTraits::deallocate(flag_alloc, borrowed, bins);
+    borrowed = nullptr;
+    base.store(nullptr, std::memory_order_relaxed);
+    release(s);
+  }
+}
+
+
+template<class V, class Alloc>
+void CowTable<V,Alloc>::own_all () {
+  for (int b=0; b<bins && sharing(); ++b)
+    own_bin(b);
+}
+
+
+template<class V, class Alloc>
+void CowTable<V,Alloc>::drop_table () {
+  Shared* s = base.load(std::memory_order_relaxed);
+  if (s == nullptr) {
+    delete_hash_table(table, bins);
+    return;
+  }
+  if (table != s->table) {            //This table's own array: delete the lists it doesn't borrow
+    for (int b=0; b<bins; ++b)
+      if (!borrowed[b])
+        delete_list(table[b]);
+    delete_bins(table, bins);
+    FlagAlloc flag_alloc(node_alloc);
+    FlagTraits::deallocate(flag_alloc, borrowed, bins);
+  }
+  release(s);
+  table         = nullptr;
+  base.store(nullptr, std::memory_order_relaxed);
+  borrowed      = nullptr;
+  borrowed_bins = 0;
+}
+
+
+template<class V, class Alloc>
+void CowTable<V,Alloc>::release (Shared* s) {
+  SharedAlloc shared_alloc(node_alloc);
+  FlagAlloc   flag_alloc(node_alloc);
+  while (s != nullptr && s->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    for (int b=0; b<s->bins; ++b)
+      if (s->borrowed == nullptr || !s->borrowed[b])
+        delete_list(s->table[b]);
+    delete_bins(s->table, s->bins);
+    if (s->borrowed != nullptr)
+      FlagTraits::deallocate(flag_alloc, s->borrowed, s->bins);
+    Shared* parent = s->parent;
+    SharedTraits::destroy(shared_alloc, s);
+    SharedTraits::deallocate(shared_alloc, s, 1);
+    s = parent;
+  }
+}
+
+}
+
+#endif /* COW_TABLE_HPP_ */
@@ -4,14 +4,22 @@
 
 
 //#include "driver_map.hpp"
-//int main() {
+//int main(int argc, char** argv) {
+//  if (argc > 1) {         //driver script_file: batch mode (see command_trace.hpp)
+//    ics::DriverMap d(argv[1]);
+//    return 0;
+//  }
 //  ics::DriverMap d;
 //  return 0;
 //}
 
 
 //#include "driver_set.hpp"
-//int main() {
+//int main(int argc, char** argv) {
+//  if (argc > 1) {         //driver script_file: batch mode (see command_trace.hpp)
+//    ics::DriverSet d(argv[1]);
+//    return 0;
+//  }
 //  ics::DriverSet d;
 //  return 0;
 //}
@@ -5,9 +5,13 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <chrono>
 #include "ics46goody.hpp"
 #include "ics_exceptions.hpp"
+#include "command_trace.hpp"    //In the repository root (shared with program3's drivers)
+#include "bulk_load.hpp"        //In the repository root (shared with program3's drivers)
 #include "hash_map.hpp"
+#include "fixed_hash_map.hpp"   //In the repository root (shared with program3's drivers)
 
 
 namespace ics {
@@ -17,12 +21,28 @@ int hash_string(const std::string& s) {std::hash<std::string> str_hash; return s
 typedef ics::pair<std::string,std::string>                MapEntry;
 typedef ics::HashMap<std::string,std::string,hash_string> MapType;
 
+//The commands execute knows, found with one probe of a table the compiler builds (not by
+//  comparing the name to each command in turn)
+enum MapCommand {MapPutIndex, MapPut, MapPutAll, MapErase, MapClear, MapAssign, MapGet, MapEmpty, MapSize,
+                 MapHasKey, MapHasValue, MapStr, MapRelations, MapForEach, MapLoadFile, MapLoadBraces};
+
+constexpr auto map_commands = make_fixed_hash_map(
+  fixed_entry("[",MapPutIndex), fixed_entry("p",MapPut),       fixed_entry("P",MapPutAll),    fixed_entry("e",MapErase),
+  fixed_entry("x",MapClear),    fixed_entry("=",MapAssign),    fixed_entry("g",MapGet),       fixed_entry("m",MapEmpty),
+  fixed_entry("s",MapSize),     fixed_entry("k",MapHasKey),    fixed_entry("v",MapHasValue),  fixed_entry("<",MapStr),
+  fixed_entry("r",MapRelations),fixed_entry("f",MapForEach),   fixed_entry("lf",MapLoadFile), fixed_entry("l{",MapLoadBraces));
+
 class DriverMap {
   public:
     DriverMap(){process_commands("");}
 
+    //Batch mode: execute the commands in script_file (a text script or binary trace; see
+    //  command_trace.hpp) without prompts or str() dumps, then print their latencies
+    DriverMap(const std::string& script_file){process_script(script_file);}
+
   private:
     MapType m;
+    std::size_t batch_sink = 0;
 
     MapType prompt_map(std::string preface, std::string message = "  Enter element for m2") {
       MapType m2;
@@ -51,6 +71,64 @@ class DriverMap {
       return ics::prompt_string("\n"+preface+"Enter set command","",allowable);
     }
 
+    //The arguments of a batch command are alternating keys and values
+    MapType args_map(const Command& c) {
+      MapType m2;
+      for (unsigned i=0; i+1<c.args.size(); i+=2)
+        m2.put(c.args[i],c.args[i+1]);
+      return m2;
+    }
+
+    //Execute one menu command, taking what it would prompt for from c.args; false if unknown.
+    //  Results are folded into batch_sink so the timed work cannot be optimized away.
+    bool execute(const Command& c) {
+      const MapCommand* command = map_commands.find(c.name);
+      if (command == nullptr)
+        return false;
+      switch (*command) {
+        case MapPutIndex:  m[command_arg(c,0)] = command_arg(c,1);             break;
+        case MapPut:       m.put(command_arg(c,0),command_arg(c,1));           break;
+        case MapPutAll:    batch_sink += m.put_all(args_map(c));               break;
+        case MapErase:     m.erase(command_arg(c,0));                          break;
+        case MapClear:     m.clear();                                          break;
+        case MapAssign:    m = args_map(c);                                    break;
+        case MapGet:       batch_sink += m[command_arg(c,0)].size();           break;
+        case MapEmpty:     batch_sink += m.empty();                            break;
+        case MapSize:      batch_sink += m.size();                             break;
+        case MapHasKey:    batch_sink += m.has_key(command_arg(c,0));          break;
+        case MapHasValue:  batch_sink += m.has_value(command_arg(c,0));        break;
+        case MapStr:       batch_sink += m.str().size();                       break;
+        case MapRelations: {
+          MapType m2(args_map(c));
+          batch_sink += (m == m) + (m != m) + (m == m2) + (m != m2);
+          break;
+        }
+        case MapForEach:                 //The iterator menu's for-each over every entry
+          for (const MapEntry& me : m)
+            batch_sink += me.first.size();
+          break;
+        case MapLoadFile: {
+          BulkLoadTimes times = bulk_load_map(m, c.args.empty() ? "loadmap.txt" : c.args[0]);
+          std::cout << "lf: " << times.str() << std::endl;
+          break;
+        }
+        case MapLoadBraces:
+          m = MapType({MapEntry("a","1"), MapEntry("b","2"), MapEntry("c","3"), MapEntry("d","4"), MapEntry("e","5")});
+          break;
+      }
+      return true;
+    }
+
+    void process_script(const std::string& script_file) {
+      CommandScript script = load_commands(script_file);
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      CommandLatency latency = run_commands(script, [this] (const Command& c) {return execute(c);});
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now()-start;
+      std::cout << "Executed " << script.size() << " commands from " << script_file << " in " << elapsed.count() << "s"
+                << " (final size = " << m.size() << ", result checksum = " << batch_sink << ")" << std::endl;
+      std::cout << latency.str();
+    }
+
   void process_iterator_commands(MapType& m, std::string preface) {
     std::string allowable[] = {"<","e","*","+","i","c","*a","ea","f","q",""};
     MapType::Iterator i = m.begin();
@@ -66,7 +144,7 @@ class DriverMap {
           std::cout << preface+"  erase = " << erased.first << "->" << erased.second << std::endl;
         }
         else if (i_command == "*") {
-          MapEntry& erased = *i;
+          const MapEntry& erased = *i;
           std::cout << preface+"  * = " << erased.first << "->" << erased.second << std::endl;
         }
         else if (i_command == "+")
@@ -172,16 +250,9 @@ class DriverMap {
       }
 
       else if (command == "lf") {
-        std::ifstream in_set;
-        ics::safe_open(in_set,preface+"  Enter file name to read", "loadmap.txt");
-        std::string line;
-        while (getline(in_set,line)) {
-          std::vector<std::string> line_2 = ics::split(line,";");
-          std::string k = line_2[0];
-          std::string v = line_2[1];
-          m.put(k,v);
-        }
-        in_set.close();
+        std::string file_name = ics::prompt_string(preface+"  Enter file name to read", "loadmap.txt");
+        BulkLoadTimes times = bulk_load_map(m, file_name);
+        std::cout << preface+"  " << times.str() << std::endl;
       }
 
       else if (command == "l{") {
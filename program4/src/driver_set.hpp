@@ -4,9 +4,13 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <chrono>
 #include "ics46goody.hpp"
 #include "ics_exceptions.hpp"
+#include "command_trace.hpp"    //In the repository root (shared with program3's drivers)
+#include "bulk_load.hpp"        //In the repository root (shared with program3's drivers)
 #include "hash_set.hpp"
+#include "fixed_hash_map.hpp"   //In the repository root (shared with program3's drivers)
 
 
 namespace ics {
@@ -15,12 +19,28 @@ int hash_string(const std::string& s) {std::hash<std::string> str_hash; return s
 
 typedef ics::HashSet<std::string,hash_string> SetType;
 
+//The commands execute knows, found with one probe of a table the compiler builds (not by
+//  comparing the name to each command in turn)
+enum SetCommand {SetInsert, SetInsertAll, SetErase, SetEraseAll, SetClear, SetRetainAll, SetAssign, SetEmpty, SetSize,
+                 SetContains, SetContainsAll, SetStr, SetRelations, SetForEach, SetLoadFile, SetLoadBraces};
+
+constexpr auto set_commands = make_fixed_hash_map(
+  fixed_entry("i",SetInsert),   fixed_entry("I",SetInsertAll), fixed_entry("e",SetErase),    fixed_entry("E",SetEraseAll),
+  fixed_entry("x",SetClear),    fixed_entry("R",SetRetainAll), fixed_entry("=",SetAssign),   fixed_entry("m",SetEmpty),
+  fixed_entry("s",SetSize),     fixed_entry("c",SetContains),  fixed_entry("C",SetContainsAll), fixed_entry("<",SetStr),
+  fixed_entry("r",SetRelations),fixed_entry("f",SetForEach),   fixed_entry("lf",SetLoadFile), fixed_entry("l{",SetLoadBraces));
+
 class DriverSet {
   public:
     DriverSet(){process_commands("");}
 
+    //Batch mode: execute the commands in script_file (a text script or binary trace; see
+    //  command_trace.hpp) without prompts or str() dumps, then print their latencies
+    DriverSet(const std::string& script_file){process_script(script_file);}
+
   private:
     SetType s;
+    std::size_t batch_sink = 0;
 
     SetType prompt_set(std::string preface, std::string message = "  Enter element for s2") {
       SetType s2;
@@ -48,6 +68,57 @@ class DriverSet {
       return ics::prompt_string("\n"+preface+"Enter set command","",allowable);
     }
 
+    //Execute one menu command, taking what it would prompt for from c.args (s2's elements for
+    //  I/E/R/=/C/r); false if unknown. Results are folded into batch_sink so the timed work
+    //  cannot be optimized away.
+    bool execute(const Command& c) {
+      const SetCommand* command = set_commands.find(c.name);
+      if (command == nullptr)
+        return false;
+      switch (*command) {
+        case SetInsert:      batch_sink += s.insert(command_arg(c,0));           break;
+        case SetInsertAll:   batch_sink += s.insert_all(SetType(c.args));        break;
+        case SetErase:       batch_sink += s.erase(command_arg(c,0));            break;
+        case SetEraseAll:    batch_sink += s.erase_all(SetType(c.args));         break;
+        case SetClear:       s.clear();                                          break;
+        case SetRetainAll:   batch_sink += s.retain_all(SetType(c.args));        break;
+        case SetAssign:      s = SetType(c.args);                                break;
+        case SetEmpty:       batch_sink += s.empty();                            break;
+        case SetSize:        batch_sink += s.size();                             break;
+        case SetContains:    batch_sink += s.contains(command_arg(c,0));         break;
+        case SetContainsAll: batch_sink += s.contains_all(SetType(c.args));      break;
+        case SetStr:         batch_sink += s.str().size();                       break;
+        case SetRelations: {
+          SetType s2(c.args);
+          batch_sink += (s == s2) + (s != s2) + (s <= s2) + (s < s2) + (s > s2) + (s >= s2);
+          break;
+        }
+        case SetForEach:                 //The iterator menu's for-each over every element
+          for (const std::string& e : s)
+            batch_sink += e.size();
+          break;
+        case SetLoadFile: {
+          BulkLoadTimes times = bulk_load_set(s, c.args.empty() ? "loadset.txt" : c.args[0]);
+          std::cout << "lf: " << times.str() << std::endl;
+          break;
+        }
+        case SetLoadBraces:
+          s = SetType({"c","b","d","b","e","a","c"});
+          break;
+      }
+      return true;
+    }
+
+    void process_script(const std::string& script_file) {
+      CommandScript script = load_commands(script_file);
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      CommandLatency latency = run_commands(script, [this] (const Command& c) {return execute(c);});
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now()-start;
+      std::cout << "Executed " << script.size() << " commands from " << script_file << " in " << elapsed.count() << "s"
+                << " (final size = " << s.size() << ", result checksum = " << batch_sink << ")" << std::endl;
+      std::cout << latency.str();
+    }
+
   void process_iterator_commands(SetType& s, std::string preface) {
     std::string allowable[] = {"<","e","*","+","i","c","*a","ea","f","q",""};
     SetType::Iterator i = s.begin();
@@ -170,12 +241,9 @@ class DriverSet {
       }
 
       else if (command == "lf") {
-        std::ifstream in_set;
-        ics::safe_open(in_set,preface+"  Enter file name to read", "loadset.txt");
-        std::string e;
-        while (getline(in_set,e))
-          s.insert(e);
-        in_set.close();
+        std::string file_name = ics::prompt_string(preface+"  Enter file name to read", "loadset.txt");
+        BulkLoadTimes times = bulk_load_set(s, file_name);
+        std::cout << preface+"  " << times.str() << std::endl;
       }
 
       else if (command == "l{")
@@ -0,0 +1,860 @@
+#ifndef FLAT_HASH_MAP_HPP_
+#define FLAT_HASH_MAP_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <memory>             //For std::allocator/std::allocator_traits
+#include <limits>
+#include <type_traits>
+#include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>        //For comparing 4 int/2 long long keys at once
+#endif
+#include "ics_exceptions.hpp"
+#include "pair.hpp"
+#include "hash_map.hpp"
+
+
+namespace ics {
+
+
+//A HashMap for integral KEY types (int, long long, unsigned, char, ...), with the same public
+//  interface: use AutoHashMap (below) to get this for integral keys and a HashMap otherwise.
+//No LN nodes and no bins: keys and values are stored in two flat arrays (so probing only
+//  reads keys, packed 16 to a cache line for int), found by linear probing from the slot
+//  chosen by the key itself (Fibonacci hashing: no hash function call, no abs()%bins).
+//  Probes never wrap around: the arrays have `overflow` extra slots past the last home slot
+//  (32 at first), and if a probe would run past them that area doubles. (Only the load grows
+//  the home slots: keys whose probes collide that badly share the top bits of their mixed
+//  value, so they would collide at any capacity.) An empty slot holds the sentinel key
+//  empty_key (the smallest signed/largest unsigned value); that key itself, if put, is kept
+//  apart. Erasing shifts later keys of the probe back (no tombstones).
+//With SSE2 (every x86-64 compiler), 4 int (2 long long) keys are compared at once.
+//thash/chash are accepted (so AutoHashMap and code written for HashMap can pass them on) but
+//  not used: a key hashes itself (so the constructors leave chash unnamed).
+//T must have a default constructor (every slot holds a T). load_threshold is at most 7/8.
+//Iterators give const access to the entries, as HashMap's do: write values with put or
+//  operator []. Keys and values are in separate arrays, so the Entry is a copy the Iterator
+//  holds, valid until it is incremented (for (const Entry& kv : m) works as for HashMap).
+//HashMap itself is not replaced for integral keys (it is a class, not an alias): only code
+//  written with AutoHashMap gets a FlatHashMap.
+template<class KEY,class T, int (*thash)(const KEY& a) = nullptr, class Alloc = std::allocator<pair<KEY,T>>> class FlatHashMap {
+  static_assert(std::is_integral<KEY>::value, "FlatHashMap: KEY must be an integral type (use HashMap)");
+
+  public:
+    typedef ics::pair<KEY,T> Entry;
+
+    static constexpr KEY empty_key = std::is_signed<KEY>::value ? std::numeric_limits<KEY>::min() : std::numeric_limits<KEY>::max();
+
+    //Destructor/Constructors
+    ~FlatHashMap ();
+
+    FlatHashMap          (double the_load_threshold = 0.5, int (*chash)(const KEY& a) = nullptr, const Alloc& alloc = Alloc());
+    explicit FlatHashMap (int initial_bins, double the_load_threshold = 0.5, int (*chash)(const KEY& k) = nullptr, const Alloc& alloc = Alloc());
+    FlatHashMap          (const FlatHashMap<KEY,T,thash,Alloc>& to_copy, double the_load_threshold = 0.5, int (*chash)(const KEY& a) = nullptr);
+    explicit FlatHashMap (const std::initializer_list<Entry>& il, double the_load_threshold = 0.5, int (*chash)(const KEY& a) = nullptr, const Alloc& alloc = Alloc());
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit FlatHashMap (const Iterable& i, double the_load_threshold = 0.5, int (*chash)(const KEY& a) = nullptr, const Alloc& alloc = Alloc());
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    bool has_key    (const KEY& key) const;
+    bool has_value  (const T& value) const;
+    Alloc get_allocator () const;
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Commands
+    T    put   (const KEY& key, const T& value);
+    T    erase (const KEY& key);
+    void clear ();
+    void reserve (int n);  //Grow now, so holding n entries never rehashes (used by bulk loads)
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    int put_all(const Iterable& i);
+
+
+    //Operators
+
+    T&       operator [] (const KEY&);
+    const T& operator [] (const KEY&) const;
+    FlatHashMap<KEY,T,thash,Alloc>& operator = (const FlatHashMap<KEY,T,thash,Alloc>& rhs);
+    bool operator == (const FlatHashMap<KEY,T,thash,Alloc>& rhs) const;
+    bool operator != (const FlatHashMap<KEY,T,thash,Alloc>& rhs) const;
+
+    template<class KEY2,class T2, int (*hash2)(const KEY2& a), class Alloc2>
+    friend std::ostream& operator << (std::ostream& outs, const FlatHashMap<KEY2,T2,hash2,Alloc2>& m);
+
+
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of FlatHashMap<KEY,T,thash,Alloc>
+        ~Iterator();
+        Entry       erase();
+        std::string str  () const;
+        FlatHashMap<KEY,T,thash,Alloc>::Iterator& operator ++ ();
+        FlatHashMap<KEY,T,thash,Alloc>::Iterator  operator ++ (int);
+        bool operator == (const FlatHashMap<KEY,T,thash,Alloc>::Iterator& rhs) const;
+        bool operator != (const FlatHashMap<KEY,T,thash,Alloc>::Iterator& rhs) const;
+        const Entry& operator *  () const;
+        const Entry* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const FlatHashMap<KEY,T,thash,Alloc>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator FlatHashMap<KEY,T,thash,Alloc>::begin () const;
+        friend Iterator FlatHashMap<KEY,T,thash,Alloc>::end   () const;
+
+      private:
+        //current is a slot; -1 is the empty_key entry; slots (the map's) is the end
+        //If can_erase is false, current indexes the "next" value (must ++ to reach it)
+        int                             current;
+        FlatHashMap<KEY,T,thash,Alloc>* ref_map;
+        int                             expected_mod_count;
+        bool                            can_erase = true;
+        mutable Entry                   entry;  //The copy of current's key and value * returns
+
+        //Helper methods
+        void advance_cursor();          //Go on to the first entry after current
+        void advance_from(int slot);    //Go on to the first entry at or after slot
+
+        //Called in friends begin/end
+        Iterator(FlatHashMap<KEY,T,thash,Alloc>* iterate_over, bool from_begin);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<KEY> KeyAlloc;
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<T>   ValueAlloc;
+  typedef std::allocator_traits<KeyAlloc>                                   KeyTraits;
+  typedef std::allocator_traits<ValueAlloc>                                 ValueTraits;
+
+  static constexpr int group        = 4;        //keys has this many (empty_key) slots past slots, for whole-group loads
+  static constexpr int min_overflow = 32;       //overflow starts here
+  static constexpr int max_capacity = 1 << 30;  //Home slots never double past this (nor overflow), so no int overflows
+
+  KeyAlloc   key_alloc;
+  ValueAlloc value_alloc;
+  double load_threshold;
+  KEY*   keys      = nullptr;   //slots+group keys; empty_key marks an empty slot
+  T*     values    = nullptr;   //slots values; values[s] is keys[s]'s value
+  int    capacity  = 0;         //Home slots (a power of 2)
+  int    overflow  = min_overflow; //Slots past the last home slot that probes may use
+  int    slots     = 0;         //capacity+overflow
+  int    shift     = 64;        //64 - log2(capacity): keeps the top bits of the mixed key
+  int    used      = 0;         //Cache for number of key->value pairs (including empty_key's)
+  int    mod_count = 0;         //For sensing concurrent modification
+  bool   has_empty_key = false; //Whether empty_key is a key: its value is empty_key_value
+  T      empty_key_value;
+
+
+  //Helper methods
+  int   home         (KEY key) const;              //The slot where key's probe starts
+  int   find_slot    (KEY key) const;              //key's slot (key != empty_key), or -1 if not a key
+  int   insert_slot  (KEY key);                    //An empty slot for key (growing as needed); key not a key
+  void  erase_slot   (int s);                      //Empty slot s, shifting later keys of its probe back
+  void  allocate     (int new_capacity);           //Allocate empty keys/values arrays (with overflow extra slots)
+  void  deallocate   ();                           //Deallocate keys/values: keys == nullptr
+  void  rehash       (int new_capacity, int new_overflow);  //Move every entry into new arrays
+  void  copy_from    (const FlatHashMap<KEY,T,thash,Alloc>& m);  //Become a copy of m (after deallocate)
+  static double limit(double the_load_threshold);  //the_load_threshold, at most 7/8
+  static int    capacity_for(int n, double the_load_threshold);  //Home slots needed to hold n keys
+};
+
+
+//A HashMap for integral keys is a FlatHashMap; for other keys, a HashMap (with the same
+//  template arguments): e.g., AutoHashMap<int,std::string> and AutoHashMap<std::string,int,hash_str>
+template<class KEY,class T, int (*thash)(const KEY& a) = nullptr, class Alloc = std::allocator<pair<KEY,T>>>
+using AutoHashMap = typename std::conditional<std::is_integral<KEY>::value,
+                                              FlatHashMap<KEY,T,thash,Alloc>,
+                                              HashMap<KEY,T,thash,Alloc>>::type;
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//FlatHashMap class and related definitions
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+constexpr KEY FlatHashMap<KEY,T,thash,Alloc>::empty_key;
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+constexpr int FlatHashMap<KEY,T,thash,Alloc>::group;
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+constexpr int FlatHashMap<KEY,T,thash,Alloc>::min_overflow;
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+constexpr int FlatHashMap<KEY,T,thash,Alloc>::max_capacity;
+
+
+//Destructor/Constructors
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+FlatHashMap<KEY,T,thash,Alloc>::~FlatHashMap() {
+  deallocate();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+FlatHashMap<KEY,T,thash,Alloc>::FlatHashMap(double the_load_threshold, int (*)(const KEY&), const Alloc& alloc)
+: key_alloc(alloc), value_alloc(alloc), load_threshold(limit(the_load_threshold)), empty_key_value() {
+  allocate(16);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+FlatHashMap<KEY,T,thash,Alloc>::FlatHashMap(int initial_bins, double the_load_threshold, int (*)(const KEY&), const Alloc& alloc)
+: key_alloc(alloc), value_alloc(alloc), load_threshold(limit(the_load_threshold)), empty_key_value() {
+  allocate(capacity_for(initial_bins, load_threshold));
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+FlatHashMap<KEY,T,thash,Alloc>::FlatHashMap(const FlatHashMap<KEY,T,thash,Alloc>& to_copy, double the_load_threshold, int (*)(const KEY&))
+: key_alloc  (KeyTraits::select_on_container_copy_construction(to_copy.key_alloc)),
+  value_alloc(ValueTraits::select_on_container_copy_construction(to_copy.value_alloc)),
+  load_threshold(limit(the_load_threshold)), empty_key_value() {
+  copy_from(to_copy);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+FlatHashMap<KEY,T,thash,Alloc>::FlatHashMap(const std::initializer_list<Entry>& il, double the_load_threshold, int (*)(const KEY&), const Alloc& alloc)
+: key_alloc(alloc), value_alloc(alloc), load_threshold(limit(the_load_threshold)), empty_key_value() {
+  allocate(capacity_for(il.size(), load_threshold));
+  put_all(il);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+template<class Iterable>
+FlatHashMap<KEY,T,thash,Alloc>::FlatHashMap(const Iterable& i, double the_load_threshold, int (*)(const KEY&), const Alloc& alloc)
+: key_alloc(alloc), value_alloc(alloc), load_threshold(limit(the_load_threshold)), empty_key_value() {
+  allocate(16);
+  put_all(i);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool FlatHashMap<KEY,T,thash,Alloc>::empty() const {
+  return used == 0;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+int FlatHashMap<KEY,T,thash,Alloc>::size() const {
+  return used;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool FlatHashMap<KEY,T,thash,Alloc>::has_key (const KEY& key) const {
+  return key == empty_key ? has_empty_key : find_slot(key) != -1;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool FlatHashMap<KEY,T,thash,Alloc>::has_value (const T& value) const {
+  if (has_empty_key && empty_key_value == value)
+    return true;
+  for (int s = 0; s < slots; ++s)
+    if (keys[s] != empty_key && values[s] == value)
+      return true;
+  return false;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+Alloc FlatHashMap<KEY,T,thash,Alloc>::get_allocator() const {
+  return Alloc(key_alloc);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+std::string FlatHashMap<KEY,T,thash,Alloc>::str() const {
+  std::ostringstream answer;
+  answer << "FlatHashMap[";
+  if (has_empty_key)
+    answer << std::endl << "  empty_key: " << empty_key << "->" << empty_key_value;
+  for (int s = 0; s < slots; ++s)
+    if (keys[s] != empty_key)
+      answer << std::endl << "  slot[" << s << "]: " << keys[s] << "->" << values[s] << " (home " << home(keys[s]) << ")";
+  answer << "](load_threshold=" << load_threshold << ",capacity=" << capacity << ",slots=" << slots
+         << ",used=" << used << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+T FlatHashMap<KEY,T,thash,Alloc>::put(const KEY& key, const T& value) {
+  ++mod_count;
+  if (key == empty_key) {
+    T old_value = has_empty_key ? empty_key_value : value;
+    if (!has_empty_key)
+      ++used;
+    has_empty_key   = true;
+    empty_key_value = value;
+    return old_value;
+  }
+
+  int s = find_slot(key);
+  if (s != -1) {
+    T old_value = values[s];
+    values[s] = value;
+    return old_value;
+  }
+  s = insert_slot(key);
+  values[s] = value;
+  return value;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+T FlatHashMap<KEY,T,thash,Alloc>::erase(const KEY& key) {
+  int s = key == empty_key ? (has_empty_key ? -2 : -1) : find_slot(key);
+  if (s == -1) {
+    std::ostringstream answer;
+    answer << "FlatHashMap::erase: key(" << key << ") not in Map";
+    throw KeyError(answer.str());
+  }
+
+  T to_return;
+  if (s == -2) {
+    to_return       = empty_key_value;
+    has_empty_key   = false;
+    empty_key_value = T();
+  } else {
+    to_return = values[s];
+    erase_slot(s);
+  }
+  --used;
+  ++mod_count;
+  return to_return;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void FlatHashMap<KEY,T,thash,Alloc>::clear() {
+  for (int s = 0; s < slots; ++s)
+    if (keys[s] != empty_key) {
+      keys[s]   = empty_key;
+      values[s] = T();
+    }
+  has_empty_key   = false;
+  empty_key_value = T();
+  used = 0;
+  ++mod_count;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void FlatHashMap<KEY,T,thash,Alloc>::reserve(int n) {
+  int new_capacity = capacity_for(n, load_threshold);
+  if (new_capacity > capacity)
+    rehash(new_capacity, overflow);   //one rehash now instead of log2(n/capacity) of them while putting
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+template<class Iterable>
+int FlatHashMap<KEY,T,thash,Alloc>::put_all(const Iterable& i) {
+  int count = 0;
+  for (const Entry& kv : i) {
+    ++count;
+    put(kv.first, kv.second);
+  }
+  return count;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+T& FlatHashMap<KEY,T,thash,Alloc>::operator [] (const KEY& key) {
+  if (key == empty_key) {
+    if (!has_empty_key)
+      put(key, T());
+    return empty_key_value;
+  }
+  int s = find_slot(key);
+  if (s == -1) {  //like std::map: a missing key is put with T() first (values[s] already is T())
+    s = insert_slot(key);
+    ++mod_count;
+  }
+  return values[s];
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+const T& FlatHashMap<KEY,T,thash,Alloc>::operator [] (const KEY& key) const {
+  if (key == empty_key && has_empty_key)
+    return empty_key_value;
+  int s = key == empty_key ? -1 : find_slot(key);
+  if (s != -1)
+    return values[s];
+
+  std::ostringstream answer;
+  answer << "FlatHashMap::operator []: key(" << key << ") not in Map";
+  throw KeyError(answer.str());
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+FlatHashMap<KEY,T,thash,Alloc>& FlatHashMap<KEY,T,thash,Alloc>::operator = (const FlatHashMap<KEY,T,thash,Alloc>& rhs) {
+  if (this == &rhs)
+    return *this;
+  deallocate();
+  load_threshold = rhs.load_threshold;
+  copy_from(rhs);
+  ++mod_count;
+  return *this;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool FlatHashMap<KEY,T,thash,Alloc>::operator == (const FlatHashMap<KEY,T,thash,Alloc>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (used != rhs.used || has_empty_key != rhs.has_empty_key)
+    return false;
+  if (has_empty_key && !(empty_key_value == rhs.empty_key_value))
+    return false;
+  for (int s = 0; s < slots; ++s)
+    if (keys[s] != empty_key) {
+      int r = rhs.find_slot(keys[s]);
+      if (r == -1 || !(values[s] == rhs.values[r]))
+        return false;
+    }
+  return true;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool FlatHashMap<KEY,T,thash,Alloc>::operator != (const FlatHashMap<KEY,T,thash,Alloc>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+std::ostream& operator << (std::ostream& outs, const FlatHashMap<KEY,T,thash,Alloc>& m) {
+  outs << "map[";
+  bool first = true;
+  for (const pair<KEY,T>& kv : m) {
+    outs << (first ? "" : ",") << kv.first << "->" << kv.second;
+    first = false;
+  }
+  outs << "]";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+auto FlatHashMap<KEY,T,thash,Alloc>::begin () const -> FlatHashMap<KEY,T,thash,Alloc>::Iterator {
+  return Iterator(const_cast<FlatHashMap<KEY,T,thash,Alloc>*>(this),true);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+auto FlatHashMap<KEY,T,thash,Alloc>::end () const -> FlatHashMap<KEY,T,thash,Alloc>::Iterator {
+  return Iterator(const_cast<FlatHashMap<KEY,T,thash,Alloc>*>(this),false);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+//Fibonacci hashing: the top bits of key*2^64/phi (so consecutive keys spread out)
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+int FlatHashMap<KEY,T,thash,Alloc>::home (KEY key) const {
+  return int((std::uint64_t(key) * 0x9E3779B97F4A7C15ull) >> shift);
+}
+
+
+//key is in the probe run starting at home(key): before the first empty slot. The keys array
+//  ends with `group` empty slots, so a probe always finds one, and whole groups can be loaded.
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+int FlatHashMap<KEY,T,thash,Alloc>::find_slot (KEY key) const {
+  int s = home(key);
+#ifdef __SSE2__
+  if (sizeof(KEY) == 4 || sizeof(KEY) == 8) {
+    const __m128i k     = sizeof(KEY) == 4 ? _mm_set1_epi32(int(key))       : _mm_set1_epi64x((long long)key);
+    const __m128i empty = sizeof(KEY) == 4 ? _mm_set1_epi32(int(empty_key)) : _mm_set1_epi64x((long long)empty_key);
+    const int     per   = 16/sizeof(KEY);   //keys per 16-byte load
+    for (;; s += per) {
+      __m128i group_keys = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys+s));
+      __m128i is_key     = _mm_cmpeq_epi32(group_keys, k);
+      __m128i is_empty   = _mm_cmpeq_epi32(group_keys, empty);
+      if (sizeof(KEY) == 8) {   //a 64-bit key matches if both its 32-bit halves do
+        is_key   = _mm_and_si128(is_key,   _mm_shuffle_epi32(is_key,   _MM_SHUFFLE(2,3,0,1)));
+        is_empty = _mm_and_si128(is_empty, _mm_shuffle_epi32(is_empty, _MM_SHUFFLE(2,3,0,1)));
+      }
+      int key_bits   = _mm_movemask_epi8(is_key);     //sizeof(KEY) bits per matching key
+      int empty_bits = _mm_movemask_epi8(is_empty);
+      if (key_bits != 0 && (empty_bits & ((key_bits & -key_bits) - 1)) == 0)
+        return s + __builtin_ctz(key_bits)/sizeof(KEY);
+      if (empty_bits != 0)
+        return -1;
+    }
+  }
+#endif
+  for (; keys[s] != empty_key; ++s)
+    if (keys[s] == key)
+      return s;
+  return -1;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+int FlatHashMap<KEY,T,thash,Alloc>::insert_slot (KEY key) {
+  if (used+1 > capacity*load_threshold && capacity < max_capacity)
+    rehash(2*capacity, overflow);
+  for (;;) {
+    int s = home(key);
+    while (s < slots && keys[s] != empty_key)
+      ++s;
+    if (s < slots) {
+      keys[s] = key;
+      ++used;
+      return s;
+    }
+    //A probe run reached the end of the overflow slots: more home slots would not split it (see
+    //  the class comment), so give it more overflow slots. All of them hold keys, so overflow
+    //  stays at most 2*used.
+    if (overflow >= max_capacity)
+      throw IcsError("FlatHashMap::insert_slot: too many keys in one probe run");
+    rehash(capacity, 2*overflow);
+  }
+}
+
+
+//No wrap around: a later key in the run moves back to s unless its home is after s
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void FlatHashMap<KEY,T,thash,Alloc>::erase_slot (int s) {
+  for (int next = s+1; next < slots && keys[next] != empty_key; ++next)
+    if (home(keys[next]) <= s) {
+      keys[s]   = keys[next];
+      values[s] = values[next];
+      s = next;
+    }
+  keys[s]   = empty_key;
+  values[s] = T();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void FlatHashMap<KEY,T,thash,Alloc>::allocate (int new_capacity) {
+  int new_slots = new_capacity + overflow;
+  KEY* new_keys = KeyTraits::allocate(key_alloc, new_slots+group);
+  for (int s = 0; s < new_slots+group; ++s)
+    new_keys[s] = empty_key;
+  T* new_values = ValueTraits::allocate(value_alloc, new_slots);
+  int constructed = 0;
+  try {
+    for (; constructed < new_slots; ++constructed)
+      ValueTraits::construct(value_alloc, new_values+constructed);
+  } catch (...) {
+    while (constructed > 0)
+      ValueTraits::destroy(value_alloc, new_values + --constructed);
+    ValueTraits::deallocate(value_alloc, new_values, new_slots);
+    KeyTraits::deallocate(key_alloc, new_keys, new_slots+group);
+    throw;
+  }
+
+  keys     = new_keys;
+  values   = new_values;
+  capacity = new_capacity;
+  slots    = new_slots;
+  shift    = 64;
+  for (int c = capacity; c > 1; c /= 2)
+    --shift;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void FlatHashMap<KEY,T,thash,Alloc>::deallocate () {
+  if (keys == nullptr)
+    return;
+  for (int s = 0; s < slots; ++s)
+    ValueTraits::destroy(value_alloc, values+s);
+  ValueTraits::deallocate(value_alloc, values, slots);
+  KeyTraits::deallocate(key_alloc, keys, slots+group);
+  keys   = nullptr;
+  values = nullptr;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void FlatHashMap<KEY,T,thash,Alloc>::rehash (int new_capacity, int new_overflow) {
+  KEY* old_keys     = keys;
+  T*   old_values   = values;
+  int  old_capacity = capacity;
+  int  old_overflow = overflow;
+  int  old_slots    = slots;
+  int  old_shift    = shift;
+  keys = nullptr;
+  overflow = new_overflow;
+  try {
+    allocate(new_capacity);   //changes nothing else if it throws
+  } catch (...) {
+    keys     = old_keys;
+    overflow = old_overflow;
+    throw;
+  }
+  for (int o = 0; o < old_slots; ++o)
+    if (old_keys[o] != empty_key) {
+      int s = home(old_keys[o]);
+      while (keys[s] != empty_key)
+        ++s;
+      if (s >= slots) {      //Can't place it (its run reaches the end): start over with twice the overflow
+        for (int n = 0; n < slots; ++n)
+          ValueTraits::destroy(value_alloc, values+n);
+        ValueTraits::deallocate(value_alloc, values, slots);
+        KeyTraits::deallocate(key_alloc, keys, slots+group);
+        keys     = old_keys;
+        values   = old_values;
+        capacity = old_capacity;
+        overflow = old_overflow;
+        slots    = old_slots;
+        shift    = old_shift;
+        if (new_overflow >= max_capacity)
+          throw IcsError("FlatHashMap::rehash: too many keys in one probe run");
+        rehash(new_capacity, 2*new_overflow);
+        return;
+      }
+      keys[s]   = old_keys[o];
+      values[s] = old_values[o];
+    }
+
+  for (int o = 0; o < old_slots; ++o)
+    ValueTraits::destroy(value_alloc, old_values+o);
+  ValueTraits::deallocate(value_alloc, old_values, old_slots);
+  KeyTraits::deallocate(key_alloc, old_keys, old_slots+group);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void FlatHashMap<KEY,T,thash,Alloc>::copy_from (const FlatHashMap<KEY,T,thash,Alloc>& m) {
+  overflow = m.overflow;
+  allocate(m.capacity);
+  for (int s = 0; s < slots; ++s)
+    if (m.keys[s] != empty_key) {
+      keys[s]   = m.keys[s];
+      values[s] = m.values[s];
+    }
+  has_empty_key   = m.has_empty_key;
+  empty_key_value = m.empty_key_value;
+  used            = m.used;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+double FlatHashMap<KEY,T,thash,Alloc>::limit (double the_load_threshold) {
+  return the_load_threshold > 0.875 ? 0.875 : the_load_threshold;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+int FlatHashMap<KEY,T,thash,Alloc>::capacity_for (int n, double the_load_threshold) {
+  int answer = 16;
+  while (n > answer*the_load_threshold && answer < max_capacity)
+    answer *= 2;
+  return answer;
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void FlatHashMap<KEY,T,thash,Alloc>::Iterator::advance_from(int slot) {
+  for (current = slot; current < ref_map->slots; ++current)
+    if (ref_map->keys[current] != empty_key)
+      return;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void FlatHashMap<KEY,T,thash,Alloc>::Iterator::advance_cursor() {
+  if (current < ref_map->slots)
+    advance_from(current+1);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+FlatHashMap<KEY,T,thash,Alloc>::Iterator::Iterator(FlatHashMap<KEY,T,thash,Alloc>* iterate_over, bool begin)
+: current(iterate_over->slots), ref_map(iterate_over), expected_mod_count(iterate_over->mod_count)
+{
+  if (begin) {
+    if (ref_map->has_empty_key)
+      current = -1;
+    else
+      advance_from(0);
+  }
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+FlatHashMap<KEY,T,thash,Alloc>::Iterator::~Iterator()
+{}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+auto FlatHashMap<KEY,T,thash,Alloc>::Iterator::erase() -> Entry {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("FlatHashMap::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("FlatHashMap::Iterator::erase Iterator cursor already erased");
+  if (current == ref_map->slots)
+    throw CannotEraseError("FlatHashMap::Iterator::erase Iterator cursor beyond data structure");
+
+  //Erasing shifts only later keys back into current: so it then indexes the "next" value,
+  //  unless it became empty (then the next value is in a later slot)
+  Entry to_return = **this;
+  can_erase = false;
+  if (current == -1) {
+    ref_map->has_empty_key   = false;
+    ref_map->empty_key_value = T();
+    advance_from(0);
+  } else {
+    ref_map->erase_slot(current);
+    if (ref_map->keys[current] == empty_key)
+      advance_cursor();
+  }
+  --ref_map->used;
+  ++ref_map->mod_count;
+  expected_mod_count = ref_map->mod_count;
+  return to_return;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+std::string FlatHashMap<KEY,T,thash,Alloc>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_map->str() << "(current=" << current << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+  return answer.str();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+auto  FlatHashMap<KEY,T,thash,Alloc>::Iterator::operator ++ () -> FlatHashMap<KEY,T,thash,Alloc>::Iterator& {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("FlatHashMap::Iterator::operator ++");
+
+  if (current == ref_map->slots)
+    return *this;
+  if (can_erase)
+    advance_cursor();
+  else
+    can_erase = true;
+  return *this;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+auto  FlatHashMap<KEY,T,thash,Alloc>::Iterator::operator ++ (int) -> FlatHashMap<KEY,T,thash,Alloc>::Iterator {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("FlatHashMap::Iterator::operator ++(int)");
+
+  if (current == ref_map->slots)
+    return *this;
+  Iterator to_return(*this);
+  if (can_erase)
+    advance_cursor();
+  else
+    can_erase = true;
+  return to_return;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool FlatHashMap<KEY,T,thash,Alloc>::Iterator::operator == (const FlatHashMap<KEY,T,thash,Alloc>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("FlatHashMap::Iterator::operator ==");
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("FlatHashMap::Iterator::operator ==");
+  if (ref_map != rhsASI->ref_map)
+    throw ComparingDifferentIteratorsError("FlatHashMap::Iterator::operator ==");
+
+  return current == rhsASI->current;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool FlatHashMap<KEY,T,thash,Alloc>::Iterator::operator != (const FlatHashMap<KEY,T,thash,Alloc>::Iterator& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+auto FlatHashMap<KEY,T,thash,Alloc>::Iterator::operator *() const -> const Entry& {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("FlatHashMap::Iterator::operator *");
+  if (!can_erase || current == ref_map->slots)
+    throw IteratorPositionIllegal("FlatHashMap::Iterator::operator * Iterator illegal: exhausted or erased");
+
+  if (current == -1) {
+    entry.first  = empty_key;
+    entry.second = ref_map->empty_key_value;
+  } else {
+    entry.first  = ref_map->keys[current];
+    entry.second = ref_map->values[current];
+  }
+  return entry;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+auto FlatHashMap<KEY,T,thash,Alloc>::Iterator::operator ->() const -> const Entry* {
+  if (expected_mod_count != ref_map->mod_count)
+    throw ConcurrentModificationError("FlatHashMap::Iterator::operator ->");
+  if (!can_erase || current == ref_map->slots)
+    throw IteratorPositionIllegal("FlatHashMap::Iterator::operator -> Iterator illegal: exhausted or erased");
+
+  return &**this;
+}
+
+
+#if __cplusplus >= 201703L
+namespace pmr {
+  //FlatHashMap whose arrays come from a std::pmr::memory_resource: pass
+  //  std::pmr::polymorphic_allocator<pair<KEY,T>>(&resource) as the last constructor argument
+  template<class KEY,class T, int (*thash)(const KEY& a) = nullptr>
+  using FlatHashMap = ics::FlatHashMap<KEY,T,thash,std::pmr::polymorphic_allocator<pair<KEY,T>>>;
+}
+#endif
+
+}
+
+#endif /* FLAT_HASH_MAP_HPP_ */
@@ -0,0 +1,406 @@
+#ifndef FROZEN_HASH_MAP_HPP_
+#define FROZEN_HASH_MAP_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include "ics_exceptions.hpp"
+#include "pair.hpp"
+
+
+namespace ics {
+
+
+//An immutable key->value map for tables that are built once (e.g., at startup) and then only
+//  read: see HashMap::freeze, or construct one from any Iterable of Entry (a later duplicate
+//  key replaces an earlier one, as put would).
+//thash/chash are as for HashMap (the same function must be used to freeze a HashMap).
+//The index is a minimal perfect hash function (hash-and-displace, as in CHD/PTHash) over the
+//  keys' hash values: every key maps to its own slot in one flat array of exactly size()
+//  entries, so a lookup computes one slot and compares one key (no bins, no nodes, no chains).
+//  Keys are split into buckets of about 5; each bucket stores a 16-bit "pilot" chosen (while
+//  building) so that its keys land on free slots: about 3.2 bits/key, plus 32 bits for each
+//  remapped slot (see remap below: about 1% of the keys, so about 3.5 bits/key in all).
+//Keys whose hash values are equal (the MPHF can't tell them apart) are stored after the
+//  slots, found through a small overflow index sorted by hash value; it is only searched
+//  when a lookup misses in its slot.
+template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class FrozenHashMap {
+  public:
+    typedef ics::pair<KEY,T> Entry;
+    typedef typename std::vector<Entry>::const_iterator Iterator;
+
+    //Destructor/Constructors
+    ~FrozenHashMap ();
+    FrozenHashMap  (int (*chash)(const KEY& a) = nullptr);   //An empty map
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit FrozenHashMap (const Iterable& i, int (*chash)(const KEY& a) = nullptr);
+
+
+    //Queries
+    bool        empty      () const;
+    int         size       () const;
+    bool        has_key    (const KEY& key) const;
+    const T*    find       (const KEY& key) const;   //Pointer to key's value, or nullptr if not a key
+    int         overflows  () const;                 //Keys in the overflow array (hash value shared with another key)
+    int         index_bytes() const;                 //Memory used by the index (pilots and remap), not the entries
+    double      index_bits_per_key() const;
+    std::string str        () const; //supplies useful debugging information; contrast to operator <<
+
+
+    //Operators
+    const T& operator [] (const KEY& key) const;     //Throws KeyError if not a key
+
+    template<class KEY2,class T2, int (*hash2)(const KEY2& a)>
+    friend std::ostream& operator << (std::ostream& outs, const FrozenHashMap<KEY2,T2,hash2>& m);
+
+
+    //Iterates over every entry, in slot order (unrelated to the order they were supplied)
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    static const int keys_per_bucket = 5;           //Larger: fewer bits/key but a longer build
+    static const int max_pilot       = 65535;       //Pilots are stored in 16 bits
+    static const int max_seeds       = 64;          //Reseed if some bucket finds no pilot (rare)
+
+    int (*hash)(const KEY& k);                     //Hashing function used (from template or constructor)
+    std::uint64_t              seed = 0;
+    int                        slotted = 0;        //entries[0,slotted) are the MPHF's slots; the rest overflow
+    int                        slots   = 0;        //Positions computed are in [0,slots): slots >= slotted
+    std::vector<std::uint16_t> pilot;              //pilot[b]: the displacement chosen for bucket b
+    std::vector<int>           remap;              //A position p >= slotted means slot remap[p-slotted]
+    std::vector<Entry>         entries;            //entries[slot]: the (one) key with that slot
+    std::vector<pair<std::uint32_t,int>> overflow; //(hash value, index in entries), sorted by hash value
+
+
+    //Helper methods
+    static std::uint64_t mix     (std::uint64_t x);                   //A 64-bit bijective finalizer
+    std::uint32_t        hash_of (const KEY& key) const;
+    int                  bucket  (std::uint64_t x) const;
+    int                  position(std::uint64_t x, int p) const;    //In [0,slots)
+    int                  slot    (std::uint32_t h) const;           //key's slot, from its hash_of
+    bool                 try_build(const std::vector<std::uint32_t>& h);  //false: some bucket found no pilot
+    const T*             find_overflow(const KEY& key, std::uint32_t h) const;
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//FrozenHashMap class and related definitions
+
+//Destructor/Constructors
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+FrozenHashMap<KEY,T,thash>::~FrozenHashMap() {
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+FrozenHashMap<KEY,T,thash>::FrozenHashMap(int (*chash)(const KEY& k))
+: hash(thash != nullptr ? thash : chash) {
+  if (hash == nullptr)
+    throw TemplateFunctionError("FrozenHashMap::default constructor: neither specified");
+  if (thash != nullptr && chash != nullptr && thash != chash)
+    throw TemplateFunctionError("FrozenHashMap::default constructor: both specified and different");
+}
+
+
+//Sort the entries by hash value: the first key with each hash value gets a slot (the MPHF
+//  is built over those distinct hash values); any other key with the same hash value replaces
+//  an equal key or overflows
+template<class KEY,class T, int (*thash)(const KEY& a)>
+template<class Iterable>
+FrozenHashMap<KEY,T,thash>::FrozenHashMap(const Iterable& i, int (*chash)(const KEY& k))
+: hash(thash != nullptr ? thash : chash) {
+  if (hash == nullptr)
+    throw TemplateFunctionError("FrozenHashMap::Iterable constructor: neither specified");
+  if (thash != nullptr && chash != nullptr && thash != chash)
+    throw TemplateFunctionError("FrozenHashMap::Iterable constructor: both specified and different");
+
+  std::vector<pair<std::uint32_t,Entry>> all;
+  for (const Entry& kv : i)
+    all.push_back(pair<std::uint32_t,Entry>(hash_of(kv.first), kv));
+  std::stable_sort(all.begin(), all.end(),    //stable: a later duplicate key stays later
+                   [] (const pair<std::uint32_t,Entry>& a, const pair<std::uint32_t,Entry>& b) {return a.first < b.first;});
+
+  std::vector<std::uint32_t> h;               //h[j]: entries[j]'s hash value (until placed)
+  std::vector<pair<std::uint32_t,Entry>> extra;
+  for (int j = 0; j < int(all.size()); ) {
+    int group_end = j;
+    while (group_end < int(all.size()) && all[group_end].first == all[j].first)
+      ++group_end;
+    std::vector<Entry> group;               //The distinct keys with this hash value (last value wins)
+    for (int k = j; k < group_end; ++k) {
+      int g = 0;
+      while (g < int(group.size()) && !(group[g].first == all[k].second.first))
+        ++g;
+      if (g == int(group.size()))
+        group.push_back(all[k].second);
+      else
+        group[g].second = all[k].second.second;
+    }
+    h.push_back(all[j].first);
+    entries.push_back(group[0]);
+    for (int g = 1; g < int(group.size()); ++g)
+      extra.push_back(pair<std::uint32_t,Entry>(all[j].first, group[g]));
+    j = group_end;
+  }
+  slotted = entries.size();
+
+  for (seed = 0; !try_build(h); )
+    if (++seed == max_seeds)
+      throw IcsError("FrozenHashMap::Iterable constructor: no perfect hash function found");
+
+  //try_build computed no slots for entries: place each where its key now maps
+  std::vector<Entry> placed(slotted);
+  for (int j = 0; j < slotted; ++j)
+    placed[slot(h[j])] = entries[j];
+  entries.swap(placed);
+  for (const pair<std::uint32_t,Entry>& e : extra) {   //Already sorted by hash value
+    overflow.push_back(pair<std::uint32_t,int>(e.first, entries.size()));
+    entries.push_back(e.second);
+  }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+bool FrozenHashMap<KEY,T,thash>::empty() const {
+  return entries.empty();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+int FrozenHashMap<KEY,T,thash>::size() const {
+  return entries.size();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+bool FrozenHashMap<KEY,T,thash>::has_key(const KEY& key) const {
+  return find(key) != nullptr;
+}
+
+
+//One slot computation and one key comparison; the overflow array is searched only on a miss
+template<class KEY,class T, int (*thash)(const KEY& a)>
+const T* FrozenHashMap<KEY,T,thash>::find(const KEY& key) const {
+  if (entries.empty())
+    return nullptr;
+  std::uint32_t h = hash_of(key);
+  const Entry& e  = entries[slot(h)];
+  if (e.first == key)
+    return &e.second;
+  return overflow.empty() ? nullptr : find_overflow(key, h);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+int FrozenHashMap<KEY,T,thash>::overflows() const {
+  return overflow.size();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+int FrozenHashMap<KEY,T,thash>::index_bytes() const {
+  return pilot.size()*sizeof(std::uint16_t) + remap.size()*sizeof(int);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+double FrozenHashMap<KEY,T,thash>::index_bits_per_key() const {
+  return slotted == 0 ? 0 : 8.0*index_bytes()/slotted;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+std::string FrozenHashMap<KEY,T,thash>::str() const {
+  std::ostringstream answer;
+  answer << "FrozenHashMap[";
+  for (int s = 0; s < int(entries.size()); ++s)
+    answer << (s == 0 ? "" : ",") << (s < slotted ? "" : "overflow ") << s << ":" << entries[s].first << "->" << entries[s].second;
+  answer << "](size=" << size() << ",overflows=" << overflow.size() << ",buckets=" << pilot.size() << ",slots=" << slots << ",remapped=" << remap.size()
+         << ",seed=" << seed << ",index bits/key=" << index_bits_per_key() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+const T& FrozenHashMap<KEY,T,thash>::operator [] (const KEY& key) const {
+  const T* value = find(key);
+  if (value != nullptr)
+    return *value;
+
+  std::ostringstream answer;
+  answer << "FrozenHashMap::operator []: key(" << key << ") not in Map";
+  throw KeyError(answer.str());
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+std::ostream& operator << (std::ostream& outs, const FrozenHashMap<KEY,T,thash>& m) {
+  outs << "map[";
+  bool first = true;
+  for (const pair<KEY,T>& kv : m) {
+    outs << (first ? "" : ",") << kv.first << "->" << kv.second;
+    first = false;
+  }
+  outs << "]";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+auto FrozenHashMap<KEY,T,thash>::begin () const -> FrozenHashMap<KEY,T,thash>::Iterator {
+  return entries.begin();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+auto FrozenHashMap<KEY,T,thash>::end () const -> FrozenHashMap<KEY,T,thash>::Iterator {
+  return entries.end();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+std::uint64_t FrozenHashMap<KEY,T,thash>::mix(std::uint64_t x) {
+  x ^= x >> 31; x *= 0x7fb5d329728ea185ULL;
+  x ^= x >> 27; x *= 0x81dadef4bc2dd44dULL;
+  x ^= x >> 33;
+  return x;
+}
+
+
+//Calling thash directly when it is supplied (hash is then the same function) lets it be inlined
+template<class KEY,class T, int (*thash)(const KEY& a)>
+std::uint32_t FrozenHashMap<KEY,T,thash>::hash_of(const KEY& key) const {
+  return std::uint32_t((thash != nullptr ? thash : hash)(key));
+}
+
+
+//The high 32 bits of x choose the bucket, the low 32 bits (displaced by the pilot) the position:
+//  both ranged by multiplying and shifting (no %)
+template<class KEY,class T, int (*thash)(const KEY& a)>
+int FrozenHashMap<KEY,T,thash>::bucket(std::uint64_t x) const {
+  return int(((x >> 32) * pilot.size()) >> 32);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+int FrozenHashMap<KEY,T,thash>::position(std::uint64_t x, int p) const {
+  return int((std::uint32_t(x ^ mix(p + 1)) * std::uint64_t(slots)) >> 32);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+int FrozenHashMap<KEY,T,thash>::slot(std::uint32_t h) const {
+  std::uint64_t x = mix(h ^ (seed << 32));
+  int p = position(x, pilot[bucket(x)]);
+  return p < slotted ? p : remap[p - slotted];
+}
+
+
+//Place the biggest buckets first (while most slots are free). A bucket's pilot is the first
+//  that sends all its keys to free slots, distinct from each other. Positions are computed in
+//  slots = about 1.01*n (so even the last buckets find free ones quickly); the few keys landing
+//  at n or beyond are then remapped to the slots below n left free, so the array is minimal.
+//  Rarely (more often for small n) some bucket finds no pilot: the caller reseeds and retries.
+template<class KEY,class T, int (*thash)(const KEY& a)>
+bool FrozenHashMap<KEY,T,thash>::try_build(const std::vector<std::uint32_t>& h) {
+  int n = h.size();
+  pilot.assign(n == 0 ? 0 : (n + keys_per_bucket - 1)/keys_per_bucket, 0);
+  remap.clear();
+  slots = n + n/100 + 64;                   //A few spare slots even for small n (else the last buckets may find no pilot)
+  if (n == 0)
+    return true;
+
+  std::vector<std::uint64_t> x(n);
+  std::vector<int> bucket_start(pilot.size()+1, 0), member(n);
+  for (int j = 0; j < n; ++j) {
+    x[j] = mix(h[j] ^ (seed << 32));
+    ++bucket_start[bucket(x[j])+1];
+  }
+  int biggest = 0;
+  for (int b = 0; b < int(pilot.size()); ++b) {
+    biggest = std::max(biggest, bucket_start[b+1]);
+    bucket_start[b+1] += bucket_start[b];
+  }
+  std::vector<int> fill(bucket_start.begin(), bucket_start.end()-1);
+  for (int j = 0; j < n; ++j)
+    member[fill[bucket(x[j])]++] = j;
+
+  std::vector<int> order;                   //Buckets by decreasing size (counting sort)
+  for (int s = biggest; s > 0; --s)
+    for (int b = 0; b < int(pilot.size()); ++b)
+      if (bucket_start[b+1] - bucket_start[b] == s)
+        order.push_back(b);
+
+  std::vector<char> taken(slots, 0);
+  std::vector<int>  pos(biggest);
+  for (int b : order) {
+    int  first = bucket_start[b], count = bucket_start[b+1] - first;
+    bool placed = false;
+    for (int p = 0; p <= max_pilot && !placed; ++p) {
+      placed = true;
+      for (int k = 0; k < count && placed; ++k) {
+        pos[k] = position(x[member[first+k]], p);
+        placed = !taken[pos[k]] && std::find(pos.begin(), pos.begin()+k, pos[k]) == pos.begin()+k;
+      }
+      if (placed) {
+        pilot[b] = p;
+        for (int k = 0; k < count; ++k)
+          taken[pos[k]] = 1;
+      }
+    }
+    if (!placed)
+      return false;
+  }
+
+  remap.assign(slots - n, 0);
+  int free_slot = 0;
+  for (int p = n; p < slots; ++p)
+    if (taken[p]) {
+      while (taken[free_slot])
+        ++free_slot;
+      remap[p - n] = free_slot++;
+    }
+  return true;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a)>
+const T* FrozenHashMap<KEY,T,thash>::find_overflow(const KEY& key, std::uint32_t h) const {
+  auto o = std::lower_bound(overflow.begin(), overflow.end(), h,
+                            [] (const pair<std::uint32_t,int>& a, std::uint32_t b) {return a.first < b;});
+  for (; o != overflow.end() && o->first == h; ++o)
+    if (entries[o->second].first == key)
+      return &entries[o->second].second;
+  return nullptr;
+}
+
+}
+
+#endif /* FROZEN_HASH_MAP_HPP_ */
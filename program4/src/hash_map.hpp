@@ -9,33 +9,67 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <vector>
+#include <limits>             //For the largest number of bins
+#include <memory>             //For std::allocator/std::allocator_traits
+#include <cstdlib>            //For abs
+#if __cplusplus >= 201703L
+#include <memory_resource>    //For std::pmr::polymorphic_allocator
+#endif
 #include "ics_exceptions.hpp"
 #include "pair.hpp"
+#include "value_index.hpp"    //In the repository root (shared with program3's BSTMap)
+#include "expected_size.hpp"  //In the repository root (shared with hyper_log_log.hpp)
+#include "cow_table.hpp"
 
 
 namespace ics {
 
 
+template<class KEY,class T, int (*thash)(const KEY& a)> class FrozenHashMap;   //Include frozen_hash_map.hpp to call freeze
+
+
 //Instantiate the templated class supplying thash(a): produces a hash value for a.
 //If thash is defaulted to nullptr in the template, then a constructor must supply chash.
 //If both thash and chash are supplied, then they must be the same (by ==) function.
 //If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
 //The (unique) non-nullptr value supplied by thash/chash is stored in the instance variable hash.
-template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap {
+//Alloc is any std::allocator-compatible allocator of Entry; it is rebound to allocate the LN nodes
+//  and the array of bins (a stateful one is passed as the last constructor argument).
+//Constructed with an ExpectedSize (e.g., a HyperLogLog's expected_size from a pre-scan of the
+//  keys), it starts with the bins for that many, instead of rehashing as it grows.
+//Copies are copy-on-write (see CowTable, as for HashSet): copying (with the same hash and an
+//  equal allocator) is O(1), the copies sharing one immutable table; a map copies the array of
+//  bin pointers on its first write after that, and each bin just before writing it (put, erase,
+//  and the non-const operator [], whose T& may be written). Bins never written stay shared.
+//  Iterators give only const access to the entries, so they never write a shared bin. A T& from
+//  operator [] may be written at any later time, so once one is handed out the map is "leaked"
+//  (as a copy-on-write std::string is): later copies of it are deep, until clear or operator =
+//  replaces its nodes.
+//  Different copies may be used by different threads at once, and several threads may copy one
+//  map at once; otherwise one HashMap still needs its own locking.
+//has_value scans every entry, unless index_values was called: then the map also keeps a
+//  ValueIndex (value -> number of keys with it), making has_value O(1) at the cost of
+//  value_index_bytes more memory. Copies keep indexing values (building their own index as they
+//  are made, so has_value only reads). Iterators cannot write values, but a T& from operator []
+//  may be written at any later time, unseen: so a leaked map drops its index (has_value scans
+//  again) and rebuilds it when clear or operator = replaces its nodes.
+template<class KEY,class T, int (*thash)(const KEY& a) = nullptr, class Alloc = std::allocator<pair<KEY,T>>> class HashMap : private CowTable<pair<KEY,T>,Alloc> {
   public:
     typedef ics::pair<KEY,T>   Entry;
 
     //Destructor/Constructors
     ~HashMap ();
 
-    HashMap          (double the_load_threshold = 1.0, int (*chash)(const KEY& a) = nullptr);
-    explicit HashMap (int initial_bins, double the_load_threshold = 1.0, int (*chash)(const KEY& k) = nullptr);
-    HashMap          (const HashMap<KEY,T,thash>& to_copy, double the_load_threshold = 1.0, int (*chash)(const KEY& a) = nullptr);
-    explicit HashMap (const std::initializer_list<Entry>& il, double the_load_threshold = 1.0, int (*chash)(const KEY& a) = nullptr);
+    HashMap          (double the_load_threshold = 1.0, int (*chash)(const KEY& a) = nullptr, const Alloc& alloc = Alloc());
+    explicit HashMap (int initial_bins, double the_load_threshold = 1.0, int (*chash)(const KEY& k) = nullptr, const Alloc& alloc = Alloc());
+    explicit HashMap (const ExpectedSize& expected, double the_load_threshold = 1.0, int (*chash)(const KEY& k) = nullptr, const Alloc& alloc = Alloc());
+    HashMap          (const HashMap<KEY,T,thash,Alloc>& to_copy, double the_load_threshold = 1.0, int (*chash)(const KEY& a) = nullptr);
+    explicit HashMap (const std::initializer_list<Entry>& il, double the_load_threshold = 1.0, int (*chash)(const KEY& a) = nullptr, const Alloc& alloc = Alloc());
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
-    explicit HashMap (const Iterable& i, double the_load_threshold = 1.0, int (*chash)(const KEY& a) = nullptr);
+    explicit HashMap (const Iterable& i, double the_load_threshold = 1.0, int (*chash)(const KEY& a) = nullptr, const Alloc& alloc = Alloc());
 
 
     //Queries
@@ -43,13 +77,18 @@ template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap
     int  size       () const;
     bool has_key    (const KEY& key) const;
     bool has_value  (const T& value) const;
+    Alloc get_allocator () const;
     std::string str () const; //supplies useful debugging information; contrast to operator <<
+    FrozenHashMap<KEY,T,thash> freeze () const;  //Immutable copy for read-only use: one probe per lookup
 
 
     //Commands
     T    put   (const KEY& key, const T& value);
     T    erase (const KEY& key);
     void clear ();
+    void reserve (int n);  //Grow the bins now, so holding n entries never rehashes (used by bulk loads)
+    void index_values (int (*vhash)(const T& v), double load_threshold = 0.5); //has_value by a ValueIndex (vhash == nullptr: stop)
+    int  value_index_bytes () const;  //Memory the value index uses (0 if none, or the map is leaked)
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
@@ -60,17 +99,18 @@ template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap
 
     T&       operator [] (const KEY&);
     const T& operator [] (const KEY&) const;
-    HashMap<KEY,T,thash>& operator = (const HashMap<KEY,T,thash>& rhs);
-    bool operator == (const HashMap<KEY,T,thash>& rhs) const;
-    bool operator != (const HashMap<KEY,T,thash>& rhs) const;
+    HashMap<KEY,T,thash,Alloc>& operator = (const HashMap<KEY,T,thash,Alloc>& rhs);
+    bool operator == (const HashMap<KEY,T,thash,Alloc>& rhs) const;
+    bool operator != (const HashMap<KEY,T,thash,Alloc>& rhs) const;
 
-    template<class KEY2,class T2, int (*hash2)(const KEY2& a)>
-    friend std::ostream& operator << (std::ostream& outs, const HashMap<KEY2,T2,hash2>& m);
+    template<class KEY2,class T2, int (*hash2)(const KEY2& a), class Alloc2>
+    friend std::ostream& operator << (std::ostream& outs, const HashMap<KEY2,T2,hash2,Alloc2>& m);
 
 
 
   private:
-    class LN;
+    typedef CowTable<Entry,Alloc> Table;
+    typedef typename Table::LN    LN;
 
   public:
     class Iterator {
@@ -81,23 +121,23 @@ template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap
         ~Iterator();
         Entry       erase();
         std::string str  () const;
-        HashMap<KEY,T,thash>::Iterator& operator ++ ();
-        HashMap<KEY,T,thash>::Iterator  operator ++ (int);
-        bool operator == (const HashMap<KEY,T,thash>::Iterator& rhs) const;
-        bool operator != (const HashMap<KEY,T,thash>::Iterator& rhs) const;
-        Entry& operator *  () const;
-        Entry* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash>::Iterator& i) {
+        HashMap<KEY,T,thash,Alloc>::Iterator& operator ++ ();
+        HashMap<KEY,T,thash,Alloc>::Iterator  operator ++ (int);
+        bool operator == (const HashMap<KEY,T,thash,Alloc>::Iterator& rhs) const;
+        bool operator != (const HashMap<KEY,T,thash,Alloc>::Iterator& rhs) const;
+        const Entry& operator *  () const;
+        const Entry* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash,Alloc>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
-        friend Iterator HashMap<KEY,T,thash>::begin () const;
-        friend Iterator HashMap<KEY,T,thash>::end   () const;
+        friend Iterator HashMap<KEY,T,thash,Alloc>::begin () const;
+        friend Iterator HashMap<KEY,T,thash,Alloc>::end   () const;
 
       private:
         //If can_erase is false, current indexes the "next" value (must ++ to reach it)
         Cursor               current; //Bin Index & Cursor; stop: LN* == nullptr
-        HashMap<KEY,T,thash>* ref_map;
+        HashMap<KEY,T,thash,Alloc>* ref_map;
         int                  expected_mod_count;
         bool                 can_erase = true;
 
@@ -105,7 +145,7 @@ template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap
         void advance_cursors();
 
         //Called in friends begin/end
-        Iterator(HashMap<KEY,T,thash>* iterate_over, bool from_begin);
+        Iterator(HashMap<KEY,T,thash,Alloc>* iterate_over, bool from_begin);
     };
 
 
@@ -114,32 +154,50 @@ template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap
 
 
   private:
-    class LN {
-    public:
-      LN ()                         : next(nullptr){}
-      LN (const LN& ln)             : value(ln.value), next(ln.next){}
-      LN (Entry v, LN* n = nullptr) : value(v), next(n){}
-
-      Entry value;
-      LN*   next;
-  };
+  //The bins and their copy-on-write state: table[b] is bin b's list (with a trailer node)
+  using Table::node_alloc;
+  using Table::table;
+  using Table::bins;
+  using Table::new_LN;
+  using Table::delete_LN;
+  using Table::new_bins;
+  using Table::delete_bins;
+  using Table::copy_hash_table;
+  using Table::sharing;
+  using Table::shared_bins;
+  using Table::share;
+  using Table::own_bin;
+  using Table::own_all;
+  using Table::drop_table;
 
   int (*hash)(const KEY& k);  //Hashing function used (from template or constructor)
-  LN** map      = nullptr;    //Pointer to array of pointers: each bin stores a list with a trailer node
-  double load_threshold;      //used/bins <= load_threshold
-  int bins      = 1;          //# bins in array (start it at 1 so hash_compress doesn't % 0)
+  double load_threshold;      //used/bins <= load_threshold (> 0), unless bins would pass max_bins
+  static const int max_bins = std::numeric_limits<int>::max();   //Doubling never goes past this
   int used      = 0;          //Cache for number of key->value pairs in the hash table
   int mod_count = 0;          //For sensing concurrent modification
+  bool leaked   = false;      //operator [] handed out a T& into this table: copies must be deep
+
+  //Reverse index for has_value (see index_values): built whenever value_hash != nullptr and !leaked
+  typedef ValueIndex<T,Alloc>                                                 ValueIndexType;
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<ValueIndexType> IndexAlloc;
+  typedef std::allocator_traits<IndexAlloc>                                   IndexTraits;
+
+  int (*value_hash)(const T& v) = nullptr;
+  double value_load_threshold   = 0.5;
+  ValueIndexType* value_index = nullptr;
 
 
   //Helper methods
   int   hash_compress        (const KEY& key)          const;  //hash function ranged to [0,bins-1]
   LN*   find_key             (int bin, const KEY& key) const;  //Returns reference to key's node or nullptr
-  LN*   copy_list            (LN*   l)                 const;  //Copy the keys/values in a bin (order irrelevant)
-  LN**  copy_hash_table      (LN** ht, int bins)       const;  //Copy the bins/keys/values in ht tree (order in bins irrelevant)
 
   void  ensure_load_threshold(int new_used);                   //Reallocate if load_factor > load_threshold
-  void  delete_hash_table    (LN**& ht, int bins);             //Deallocate all LN in ht (and the ht itself; ht == nullptr)
+  void  rehash               (int new_bins);                   //Relink every LN into a table with new_bins bins
+
+  bool  can_share            (const HashMap<KEY,T,thash,Alloc>& m) const; //Same hash and interchangeable allocators
+
+  void  build_values         ();                               //Index every value (if value_hash != nullptr and not leaked)
+  void  drop_values          ();                               //Delete the value index
 };
 
 
@@ -151,60 +209,108 @@ template<class KEY,class T, int (*thash)(const KEY& a) = nullptr> class HashMap
 
 //Destructor/Constructors
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::~HashMap() {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+HashMap<KEY,T,thash,Alloc>::~HashMap() {
+	drop_values();	//CowTable's destructor releases the table
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::HashMap(double the_load_threshold, int (*chash)(const KEY& k))
-: hash ( thash != nullptr ? thash : chash),	load_threshold(the_load_threshold)
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+HashMap<KEY,T,thash,Alloc>::HashMap(double the_load_threshold, int (*chash)(const KEY& k), const Alloc& alloc)
+: Table(alloc), hash ( thash != nullptr ? thash : chash), load_threshold(the_load_threshold)
 {
 	if (hash == nullptr)
 		throw TemplateFunctionError("HashMap::default constructor nothing specified");
 	if (thash != nullptr && chash != nullptr &&  thash != chash)
 		throw TemplateFunctionError("HashMap::default constructor both specified and different");
+	if (!(load_threshold > 0))	//also rejects NaN: reserve/ensure_load_threshold divide by it
+		throw IcsError("HashMap::default constructor: load_threshold must be > 0");
 
-	map = new LN*[bins]; //initialize your bin first
+	table = new_bins(bins); //initialize your bin first
 	for (int i =0 ; i< bins; i++)
-		map[i] = new LN();
+		table[i] = new_LN();
 	//used/bins <= load_threshold
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::HashMap(int initial_bins, double the_load_threshold, int (*chash)(const KEY& k))
-: hash ( thash != nullptr ? thash : chash), load_threshold(the_load_threshold)
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+HashMap<KEY,T,thash,Alloc>::HashMap(int initial_bins, double the_load_threshold, int (*chash)(const KEY& k), const Alloc& alloc)
+: Table(alloc), hash ( thash != nullptr ? thash : chash), load_threshold(the_load_threshold)
 {
 	if (hash == nullptr)
 		throw TemplateFunctionError("HashMap::default constructor nothing specified");
 	if (thash != nullptr && chash != nullptr &&  thash != chash)
 		throw TemplateFunctionError("HashMap::default constructor both specified and different");
+	if (!(load_threshold > 0))
+		throw IcsError("HashMap::length constructor: load_threshold must be > 0");
 
-	map = new LN*[initial_bins]; //so, create your bins, in which a dbl ptr map points to an
+	bins = (initial_bins < 1 ? 1 : initial_bins);	//hash_compress % bins, so never 0
+	table = new_bins(bins); //so, create your bins, in which a dbl ptr map points to an
 	//array of Linked nodes!!!
 
-	for (int i = 0 ; i < initial_bins; i++) // for these many bins
-		map[i] = new LN(); 	//create a new linked node into each of them
+	for (int i = 0 ; i < bins; i++) // for these many bins
+		table[i] = new_LN(); 	//create a new linked node into each of them
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::HashMap(const HashMap<KEY,T,thash>& to_copy, double the_load_threshold, int (*chash)(const KEY& a))
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+HashMap<KEY,T,thash,Alloc>::HashMap(const ExpectedSize& expected, double the_load_threshold, int (*chash)(const KEY& k), const Alloc& alloc)
+: HashMap(1, the_load_threshold, chash, alloc)
 {
+	reserve(expected.size);	//the bins for expected.size keys, so putting them never rehashes
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::HashMap(const std::initializer_list<Entry>& il, double the_load_threshold, int (*chash)(const KEY& k))
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+HashMap<KEY,T,thash,Alloc>::HashMap(const HashMap<KEY,T,thash,Alloc>& to_copy, double the_load_threshold, int (*chash)(const KEY& a))
+: Table(to_copy), hash ( thash != nullptr ? thash : chash), load_threshold(the_load_threshold)
 {
+	bins = to_copy.bins;
+	if (hash == nullptr)
+		hash = to_copy.hash;
+	if (thash != nullptr && chash != nullptr &&  thash != chash)
+		throw TemplateFunctionError("HashMap::copy constructor both specified and different");
+	if (!(load_threshold > 0))
+		throw IcsError("HashMap::copy constructor: load_threshold must be > 0");
+
+	value_hash           = to_copy.value_hash;
+	value_load_threshold = to_copy.value_load_threshold;
+	if (can_share(to_copy)) {	//Same hash and allocator: share the table until either writes
+		share(to_copy);
+		used = to_copy.used;
+	}
+	else if (hash == to_copy.hash) {	//Same hash: same bin for every key, so copy bin by bin
+		table = copy_hash_table(to_copy.table, bins);
+		used  = to_copy.used;
+	}
+	else {	//Different hash: every key must be rehashed
+		table = new_bins(bins);
+		for (int i = 0; i < bins; i++)
+			table[i] = new_LN();
+		for (int binNum = 0; binNum < to_copy.bins; ++binNum)
+			for (LN* node = to_copy.table[binNum]; node->next != nullptr; node = node->next)
+				put(node->value.first, node->value.second);
+	}
+	build_values();	//now, not in has_value: a const map is only read
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+HashMap<KEY,T,thash,Alloc>::HashMap(const std::initializer_list<Entry>& il, double the_load_threshold, int (*chash)(const KEY& k), const Alloc& alloc)
+: HashMap(the_load_threshold, chash, alloc)
+{
+	reserve(il.size());	//the number of entries is known: no put rehashes
+	for (const Entry& kv : il)
+		put(kv.first, kv.second);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
 template <class Iterable>
-HashMap<KEY,T,thash>::HashMap(const Iterable& i, double the_load_threshold, int (*chash)(const KEY& k))
+HashMap<KEY,T,thash,Alloc>::HashMap(const Iterable& i, double the_load_threshold, int (*chash)(const KEY& k), const Alloc& alloc)
+: HashMap(the_load_threshold, chash, alloc)
 {
+	put_all(i);
 }
 
 
@@ -212,40 +318,75 @@ HashMap<KEY,T,thash>::HashMap(const Iterable& i, double the_load_threshold, int
 //
 //Queries
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::empty() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool HashMap<KEY,T,thash,Alloc>::empty() const {
 	return used == 0;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-int HashMap<KEY,T,thash>::size() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+int HashMap<KEY,T,thash,Alloc>::size() const {
 	return used;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::has_key (const KEY& key) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool HashMap<KEY,T,thash,Alloc>::has_key (const KEY& key) const {
 	return find_key(hash_compress(key), key) != nullptr;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::has_value (const T& value) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool HashMap<KEY,T,thash,Alloc>::has_value (const T& value) const {
 	/*
 	 * bool find_value (const T& value) const; This method traverses all the LNs in all the bins in a hash table attempting to
 	 *  to find any LN storing value: if successful it returns true; if unsuccessful it returns false
+	 *  (unless values are indexed: then one probe of the index answers)
 	 */
+	if (value_index != nullptr)
+		return value_index->contains(value);
 	for (int binNum = 0; binNum <bins; ++binNum)
-		for (LN* node = map[binNum] ; node != nullptr; node = node->next)
+		for (LN* node = table[binNum] ; node->next != nullptr; node = node->next)	//skip the trailer node
 			if (node->value.second == value)
 				return true;
 	return false;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-std::string HashMap<KEY,T,thash>::str() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+Alloc HashMap<KEY,T,thash,Alloc>::get_allocator() const {
+	return Alloc(node_alloc);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+std::string HashMap<KEY,T,thash,Alloc>::str() const {
+	//every bin's list, trailer included, then the bookkeeping (and how many bins are still shared)
+	std::ostringstream answer;
+	answer << "HashMap[";
+	for (int binNum = 0; binNum < bins; ++binNum) {
+		answer << std::endl << "  bin[" << binNum << "]: ";
+		for (LN* node = table[binNum]; node->next != nullptr; node = node->next)
+			answer << node->value.first << "->" << node->value.second << " -> ";
+		answer << "TRAILER";
+	}
+	answer << "](load_threshold=" << load_threshold << ",bins=" << bins << ",used=" << used << ",mod_count=" << mod_count;
+	if (sharing())
+		answer << ",shared bins=" << shared_bins();
+	answer << ")";
+	return answer.str();
+}
+
+
+//Collect the entries straight from the bins (one pass, no rehashing) and build the MPHF
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+FrozenHashMap<KEY,T,thash> HashMap<KEY,T,thash,Alloc>::freeze() const {
+	std::vector<Entry> all;
+	all.reserve(used);
+	for (int binNum = 0; binNum < bins; ++binNum)
+		for (LN* node = table[binNum]; node->next != nullptr; node = node->next)	//skip the trailer node
+			all.push_back(node->value);
+	return FrozenHashMap<KEY,T,thash>(all, hash);
 }
 
 
@@ -253,15 +394,25 @@ std::string HashMap<KEY,T,thash>::str() const {
 //
 //Commands
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-T HashMap<KEY,T,thash>::put(const KEY& key, const T& value) {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+T HashMap<KEY,T,thash,Alloc>::put(const KEY& key, const T& value) {
+	ValueIndexType* index = value_index;
 	int bin_hash_idx= hash_compress(key);
 	T ret_val;
 	LN* exisiting_hash = find_key(bin_hash_idx, key);
+	if (exisiting_hash != nullptr && sharing())	//write this map's own copy of the bin
+	{
+		own_bin(bin_hash_idx);
+		exisiting_hash = find_key(bin_hash_idx, key);
+	}
 	if (exisiting_hash != nullptr)	//if this map does exist
 	{
 		ret_val = exisiting_hash->value.second; // to return our value
 		exisiting_hash->value.second = value; // replaces the map of that key this value.
+		if (index != nullptr) {
+			index->remove(ret_val);
+			index->add(value);
+		}
 	}
 	else
 	{//creation of new node
@@ -269,10 +420,16 @@ T HashMap<KEY,T,thash>::put(const KEY& key, const T& value) {
 		//put in value and index
 		//dont forget to return said value
 		ret_val = value;
+		int prev_bins = bins;
 		ensure_load_threshold(used+1);	//check if our used/bin ratio exceeds threshold if one extra bin is created
-		map[bin_hash_idx] = new LN (ics::make_pair(key,value), map[bin_hash_idx]);//this should create the pair entry VALUE first
+		if (bins != prev_bins)
+			bin_hash_idx = hash_compress(key);	//bins doubled above: the old index is stale
+		own_bin(bin_hash_idx);
+		table[bin_hash_idx] = new_LN (ics::make_pair(key,value), table[bin_hash_idx]);//this should create the pair entry VALUE first
 		//then it will point towhat was previously the empty LN node
 		++used;
+		if (index != nullptr)
+			index->add(value);
 	}
 	++mod_count;
 	return ret_val;
@@ -280,19 +437,93 @@ T HashMap<KEY,T,thash>::put(const KEY& key, const T& value) {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-T HashMap<KEY,T,thash>::erase(const KEY& key) {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+T HashMap<KEY,T,thash,Alloc>::erase(const KEY& key) {
+	ValueIndexType* index = value_index;
+	int bin = hash_compress(key);
+	LN* to_erase = find_key(bin, key);
+	if (to_erase == nullptr) {
+		std::ostringstream answer;
+		answer << "HashMap::erase: key(" << key << ") not in Map";
+		throw KeyError(answer.str());
+	}
+	if (sharing()) {	//erase from this map's own copy of the bin
+		own_bin(bin);
+		to_erase = find_key(bin, key);
+	}
+
+	//Copy the next LN (possibly the trailer) into this one and delete that next LN
+	T to_return = to_erase->value.second;
+	if (index != nullptr)
+		index->remove(to_return);
+	LN* to_delete = to_erase->next;
+	to_erase->value = to_delete->value;
+	to_erase->next  = to_delete->next;
+	delete_LN(to_delete);
+	--used;
+	++mod_count;
+	return to_return;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-void HashMap<KEY,T,thash>::clear() {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void HashMap<KEY,T,thash,Alloc>::clear() {
+	if (sharing()) {	//nothing to copy: just let go of the shared table
+		drop_table();
+		table = new_bins(bins);
+		for (int i = 0; i < bins; i++)
+			table[i] = new_LN();
+	}
+	for (int binNum = 0; binNum < bins; ++binNum)	//keep the bins (and their trailers)
+		while (table[binNum]->next != nullptr) {
+			LN* to_delete = table[binNum];
+			table[binNum] = table[binNum]->next;
+			delete_LN(to_delete);
+		}
+	used   = 0;
+	leaked = false;	//every node a T& could refer to is gone
+	if (value_index != nullptr)
+		value_index->clear();
+	else
+		build_values();	//(re)start indexing, if the map was leaked
+	++mod_count;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
 template<class Iterable>
-int HashMap<KEY,T,thash>::put_all(const Iterable& i) {
+int HashMap<KEY,T,thash,Alloc>::put_all(const Iterable& i) {
+	int count = 0;
+	for (const Entry& kv : i) {	//call reserve first when the number of entries is known: then no put rehashes
+		++count;
+		put(kv.first, kv.second);
+	}
+	return count;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void HashMap<KEY,T,thash,Alloc>::index_values(int (*vhash)(const T& v), double load_threshold) {
+	drop_values();
+	value_hash           = vhash;
+	value_load_threshold = load_threshold;
+	build_values();	//a bad load_threshold throws here
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+int HashMap<KEY,T,thash,Alloc>::value_index_bytes() const {
+	return value_index == nullptr ? 0 : value_index->bytes();
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void HashMap<KEY,T,thash,Alloc>::reserve(int n) {
+	int new_bins = bins;
+	while (double(n)/new_bins > load_threshold && new_bins <= max_bins/2)	//same test as ensure_load_threshold, doubling the same way
+		new_bins *= 2;
+	if (new_bins != bins)
+		rehash(new_bins);	//one rehash now instead of log2(n/bins) of them while putting
 }
 
 
@@ -300,44 +531,90 @@ int HashMap<KEY,T,thash>::put_all(const Iterable& i) {
 //
 //Operators
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-T& HashMap<KEY,T,thash>::operator [] (const KEY& key) {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+T& HashMap<KEY,T,thash,Alloc>::operator [] (const KEY& key) {
+	leaked = true;	//the T& may be written after a copy, so never share this table again,
+	drop_values();	//  nor trust an index of its values (written unseen)
+	LN* curr_node = find_key(hash_compress(key), key);
+	if (curr_node != nullptr && sharing()) {	//the T& returned may be written: own its bin
+		own_bin(hash_compress(key));
+		curr_node = find_key(hash_compress(key), key);
+	}
+	if (curr_node == nullptr) {	//like std::map: a missing key is put with T() first
+		put(key, T());
+		curr_node = find_key(hash_compress(key), key);	//put may have rehashed: find it again
+	}
+	return curr_node->value.second;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>	//NEED TO DO THIS FIRST TO GET PUT WORKING
-const T& HashMap<KEY,T,thash>::operator [] (const KEY& key) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>	//NEED TO DO THIS FIRST TO GET PUT WORKING
+const T& HashMap<KEY,T,thash,Alloc>::operator [] (const KEY& key) const {
 	LN* curr_node = find_key(hash_compress(key), key);
 	if (curr_node != nullptr)
 		return curr_node->value.second;
 
-
+	std::ostringstream answer;
+	answer << "HashMap::operator []: key(" << key << ") not in Map";
+	throw KeyError(answer.str());
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>& HashMap<KEY,T,thash>::operator = (const HashMap<KEY,T,thash>& rhs) {
-//	Don't just put each key->value pair in the map.
-
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+HashMap<KEY,T,thash,Alloc>& HashMap<KEY,T,thash,Alloc>::operator = (const HashMap<KEY,T,thash,Alloc>& rhs) {
+	if (this == &rhs)
+		return *this;
 
+	drop_values();	//this map keeps its own choice of indexing: rebuilt below
+	drop_table();
+	hash           = rhs.hash;
+	load_threshold = rhs.load_threshold;
+	bins           = rhs.bins;
+	if (can_share(rhs))	//O(1): share rhs's table until either writes
+		share(rhs);
+	else
+		table = copy_hash_table(rhs.table, bins);
+	used           = rhs.used;
+	leaked         = false;
+	build_values();
+	++mod_count;
+	return *this;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::operator == (const HashMap<KEY,T,thash>& rhs) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool HashMap<KEY,T,thash,Alloc>::operator == (const HashMap<KEY,T,thash,Alloc>& rhs) const {
 //	Don't just put each key->value pair in the map.
-
-
+	if (this == &rhs)
+		return true;
+	if (used != rhs.used)
+		return false;
+	for (int binNum = 0; binNum < bins; ++binNum)	//same size, so every key in rhs matching is enough
+		for (LN* node = table[binNum]; node->next != nullptr; node = node->next) {
+			LN* other = rhs.find_key(rhs.hash_compress(node->value.first), node->value.first);
+			if (other == nullptr || !(other->value.second == node->value.second))
+				return false;
+		}
+	return true;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::operator != (const HashMap<KEY,T,thash>& rhs) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool HashMap<KEY,T,thash,Alloc>::operator != (const HashMap<KEY,T,thash,Alloc>& rhs) const {
+	return !(*this == rhs);
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash>& m) {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash,Alloc>& m) {
+	outs << "map[";
+	bool first = true;
+	for (const pair<KEY,T>& kv : m) {
+		outs << (first ? "" : ",") << kv.first << "->" << kv.second;
+		first = false;
+	}
+	outs << "]";
+	return outs;
 }
 
 
@@ -345,13 +622,15 @@ std::ostream& operator << (std::ostream& outs, const HashMap<KEY,T,thash>& m) {
 //
 //Iterator constructors
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto HashMap<KEY,T,thash>::begin () const -> HashMap<KEY,T,thash>::Iterator {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+auto HashMap<KEY,T,thash,Alloc>::begin () const -> HashMap<KEY,T,thash,Alloc>::Iterator {
+	return Iterator(const_cast<HashMap<KEY,T,thash,Alloc>*>(this),true);
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto HashMap<KEY,T,thash>::end () const -> HashMap<KEY,T,thash>::Iterator {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+auto HashMap<KEY,T,thash,Alloc>::end () const -> HashMap<KEY,T,thash,Alloc>::Iterator {
+	return Iterator(const_cast<HashMap<KEY,T,thash,Alloc>*>(this),false);
 }
 
 
@@ -359,8 +638,8 @@ auto HashMap<KEY,T,thash>::end () const -> HashMap<KEY,T,thash>::Iterator {
 //
 //Private helper methods
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-int HashMap<KEY,T,thash>::hash_compress (const KEY& key) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+int HashMap<KEY,T,thash,Alloc>::hash_compress (const KEY& key) const {
 /*
  * int hash_compress (const KEY& key) const; This method uses the hash function supplied by the constructor and the number of bins
  * in the current hash table, to compute the bin index of any given key. Remember to compute the absolute value of the hash function
@@ -372,14 +651,14 @@ int HashMap<KEY,T,thash>::hash_compress (const KEY& key) const {
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-typename HashMap<KEY,T,thash>::LN* HashMap<KEY,T,thash>::find_key (int bin, const KEY& key) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+typename HashMap<KEY,T,thash,Alloc>::LN* HashMap<KEY,T,thash,Alloc>::find_key (int bin, const KEY& key) const {
 	/*
 	 * LN* find_key (int bin, const KEY& key) const; This method attempts to find the LN storing key in the bin index of a hash table:
 	 *  if successful it returns a pointer to that LN (possibly to examine or update its associated value);
 	 *   if unsuccessful it returns nullptr. The caller of this function will determine what to do with the pointer returned.
 	 */
-	for (LN* node = map[bin]; node != nullptr; node = node->next)
+	for (LN* node = table[bin]; node->next != nullptr; node = node->next)	//skip the trailer node: its KEY() is not in the map
 		if (node->value.first == key)
 			return node;
 	return nullptr; //same as last project
@@ -388,28 +667,8 @@ typename HashMap<KEY,T,thash>::LN* HashMap<KEY,T,thash>::find_key (int bin, cons
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-typename HashMap<KEY,T,thash>::LN* HashMap<KEY,T,thash>::copy_list (LN* l) const {
-	/*
-	 * LN* copy_list(LN* l) const; This method copies a linked list (which is a bin; actually,
-	 * the values in the list can occur in any order), including the trailer node.
-	 *  It is called by copy_hash_table
-	 */
-}
-
-
-template<class KEY,class T, int (*thash)(const KEY& a)>
-typename HashMap<KEY,T,thash>::LN** HashMap<KEY,T,thash>::copy_hash_table (LN** ht, int bins) const {
-	/*
-	 * LN** copy_hash_table(LN** ht, int bins) const; This method copies an entire hash table,
-	 * by allocating space for the bins and then copying the list nodes in each bin.
-	 * It does not need to rehash/call hash_compress.
-	 */
-}
-
-
-template<class KEY,class T, int (*thash)(const KEY& a)>
-void HashMap<KEY,T,thash>::ensure_load_threshold(int new_used) {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void HashMap<KEY,T,thash,Alloc>::ensure_load_threshold(int new_used) {
 	/*
 	 * void ensure_load_factor(int new_used); This method ensures that a hash table with new_used values does
 	 * not exceed the load factor (based on this value and the number of bins currently in the hash table).
@@ -418,44 +677,85 @@ void HashMap<KEY,T,thash>::ensure_load_threshold(int new_used) {
 	 *  the new one (which requires rehashing each, since compression using a new number of bins can produce a different bin
 	 *  index from hash_compress).
 	 */
-	double ratio = new_used/bins; //this is our current ratio;
-	if (ratio <= load_threshold) //if the ratio <= threshold, don't make any changes
+	double ratio = double(new_used)/bins; //this is our current ratio; (int/int truncated it)
+	if (ratio <= load_threshold || bins > max_bins/2) //if the ratio <= threshold (or bins can't double), don't make any changes
 		return;
-	LN** prev_map = map;	//so take all the old values
-	T	 prev_bin = bins;
+	rehash(2 * bins);
+}
 
-	bins = 2 * prev_bin;	//Create the new values
-	map = new LN*[bins];	//DON'T FORGET THAT *. DONT DO THAT.
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void HashMap<KEY,T,thash,Alloc>::rehash(int new_bin_count) {
+	/*
+	 * void rehash(int new_bin_count); Moves every LN (but not the trailers) into a new table with new_bin_count bins,
+	 *  rehashing each key; used by ensure_load_threshold (doubling) and reserve (any size).
+	 */
+	own_all();	//relinking changes every list: they must all be this map's own
+	LN** prev_map = table;	//so take all the old values
+	int	 prev_bin = bins;
+
+	bins = new_bin_count;	//Create the new values
+	table = new_bins(bins);	//DON'T FORGET THAT *. DONT DO THAT.
 
 	for (int i = 0 ; i < bins; i++)
-		map[i] = new LN();	//assign new value again. We won't have any memory leaks because we will delete old value later
+		table[i] = new_LN();	//assign new value again. We won't have any memory leaks because we will delete old value later
 
 	// time to copy over values
 	for (int prevNum = 0 ; prevNum< prev_bin; ++prevNum)
 	{
 		LN* prev_LN = prev_map[prevNum];//This is a node at bin index.
-		for (LN* prev_node = prev_LN; prev_node != nullptr; prev_node = prev_node->next)
+		while (prev_LN->next != nullptr)	//relink every node but the trailer into the new bins
 		{
-			//need to use that for the new map index
-			//need to create copy of LN value to transfer over
-			//Need to make that copy.next point to a new LN()
-			int hash_bin = hash_compress(prev_node->value.first);	//get our hash key
-			LN* copying = prev_node;
-			copying->next = map[hash_bin];
-			map[hash_bin] = copying;	//PROBLEM, STUCK IN AN INFINTE LOOP HERE AFTER  I TRY TO INSERT A NEW VALUE INTO IT.
+			//Advance BEFORE relinking: copying->next is overwritten below, which used to send
+			//this loop into the new bin (and around forever)
+			LN* copying = prev_LN;
+			prev_LN = prev_LN->next;
+			int hash_bin = hash_compress(copying->value.first);	//get our hash key
+			copying->next = table[hash_bin];
+			table[hash_bin] = copying;
 		}
-		delete prev_LN;	//delete that pointer, which in this loop will delete all pointers within array
+		delete_LN(prev_LN);	//only the old trailer node is left in this bin
 	}
-	delete [] prev_map; //now delete the entire array. Can do because you cleared the previous one
+	delete_bins(prev_map, prev_bin); //now delete the entire array. Can do because you cleared the previous one
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-void HashMap<KEY,T,thash>::delete_hash_table (LN**& ht, int bins) {
-	/*
-	 * void delete_hash_table(LN**& ht, int bins); This method deletes every LN used in the hash table (including trailer nodes),
-	 *  and then deletes the hash table array itself.
-	 */
+//Sharing frees nodes with the other map's allocator, so they must be interchangeable (e.g.,
+//  not a pmr copy, which gets the default resource: that copy is deep). A leaked m may still
+//  be written through a T&, which a copy sharing its nodes would see.
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool HashMap<KEY,T,thash,Alloc>::can_share (const HashMap<KEY,T,thash,Alloc>& m) const {
+	return hash == m.hash && node_alloc == m.node_alloc && !m.leaked;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void HashMap<KEY,T,thash,Alloc>::build_values () {
+	if (value_hash == nullptr || leaked)
+		return;
+	IndexAlloc index_alloc(node_alloc);
+	ValueIndexType* index = IndexTraits::allocate(index_alloc, 1);
+	try {
+		IndexTraits::construct(index_alloc, index, value_hash, value_load_threshold, Alloc(node_alloc));
+	} catch (...) {
+		IndexTraits::deallocate(index_alloc, index, 1);
+		throw;
+	}
+	value_index = index;
+	for (int binNum = 0; binNum < bins; ++binNum)
+		for (LN* node = table[binNum]; node->next != nullptr; node = node->next)
+			value_index->add(node->value.second);
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void HashMap<KEY,T,thash,Alloc>::drop_values () {
+	if (value_index == nullptr)
+		return;
+	IndexAlloc index_alloc(node_alloc);
+	IndexTraits::destroy(index_alloc, value_index);
+	IndexTraits::deallocate(index_alloc, value_index, 1);
+	value_index = nullptr;
 }
 
 
@@ -467,64 +767,165 @@ void HashMap<KEY,T,thash>::delete_hash_table (LN**& ht, int bins) {
 //
 //Iterator class definitions
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-void HashMap<KEY,T,thash>::Iterator::advance_cursors(){
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+void HashMap<KEY,T,thash,Alloc>::Iterator::advance_cursors(){
+	//move off the current entry (if any); if that reaches a trailer, go on to the first entry in a later bin
+	if (current.second != nullptr && current.second->next != nullptr)
+		current.second = current.second->next;
+	if (current.second != nullptr && current.second->next != nullptr)
+		return;
+
+	for (++current.first; current.first < ref_map->bins; ++current.first)
+		if (ref_map->table[current.first]->next != nullptr) {
+			current.second = ref_map->table[current.first];
+			return;
+		}
+	current = Cursor(-1,nullptr);
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::Iterator::Iterator(HashMap<KEY,T,thash>* iterate_over, bool from_begin)
-: ref_map(iterate_over), expected_mod_count(ref_map->mod_count) {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+HashMap<KEY,T,thash,Alloc>::Iterator::Iterator(HashMap<KEY,T,thash,Alloc>* iterate_over, bool from_begin)
+: current(-1,nullptr), ref_map(iterate_over), expected_mod_count(ref_map->mod_count) {
+	if (from_begin)
+		advance_cursors();
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-HashMap<KEY,T,thash>::Iterator::~Iterator()
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+HashMap<KEY,T,thash,Alloc>::Iterator::~Iterator()
 {}
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto HashMap<KEY,T,thash>::Iterator::erase() -> Entry {
-}
-
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+auto HashMap<KEY,T,thash,Alloc>::Iterator::erase() -> Entry {
+	if (expected_mod_count != ref_map->mod_count)
+		throw ConcurrentModificationError("HashMap::Iterator::erase");
+	if (!can_erase)
+		throw CannotEraseError("HashMap::Iterator::erase Iterator cursor already erased");
+	if (current.second == nullptr)
+		throw CannotEraseError("HashMap::Iterator::erase Iterator cursor beyond data structure");
+
+	ValueIndexType* index = ref_map->value_index;
+	if (ref_map->sharing()) {	//move the cursor to the same position in the map's own copy of its bin
+		int position = 0;
+		for (LN* node = ref_map->table[current.first]; node != current.second; node = node->next)
+			++position;
+		ref_map->own_bin(current.first);
+		for (current.second = ref_map->table[current.first]; position > 0; --position)
+			current.second = current.second->next;
+	}
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-std::string HashMap<KEY,T,thash>::Iterator::str() const {
+	//As in HashMap::erase: copy the next LN into this one, so current now indexes the "next" entry
+	can_erase = false;
+	Entry to_return = current.second->value;
+	if (index != nullptr)
+		index->remove(to_return.second);
+	LN* to_delete = current.second->next;
+	current.second->value = to_delete->value;
+	current.second->next  = to_delete->next;
+	ref_map->delete_LN(to_delete);
+	--ref_map->used;
+	++ref_map->mod_count;
+	expected_mod_count = ref_map->mod_count;
+
+	if (current.second->next == nullptr)	//copied the trailer: the "next" entry is in a later bin
+		advance_cursors();
+	return to_return;
+}
+
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+std::string HashMap<KEY,T,thash,Alloc>::Iterator::str() const {
+	std::ostringstream answer;
+	answer << ref_map->str() << "(current=" << current.first << "/" << current.second
+	       << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+	return answer.str();
+}
+
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+auto  HashMap<KEY,T,thash,Alloc>::Iterator::operator ++ () -> HashMap<KEY,T,thash,Alloc>::Iterator& {
+	if (expected_mod_count != ref_map->mod_count)
+		throw ConcurrentModificationError("HashMap::Iterator::operator ++");
+
+	if (current.second == nullptr)
+		return *this;
+	if (can_erase)
+		advance_cursors();
+	else
+		can_erase = true;	//erase already moved current to the "next" entry
+	return *this;
 }
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto  HashMap<KEY,T,thash>::Iterator::operator ++ () -> HashMap<KEY,T,thash>::Iterator& {
-}
 
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+auto  HashMap<KEY,T,thash,Alloc>::Iterator::operator ++ (int) -> HashMap<KEY,T,thash,Alloc>::Iterator {
+	if (expected_mod_count != ref_map->mod_count)
+		throw ConcurrentModificationError("HashMap::Iterator::operator ++(int)");
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-auto  HashMap<KEY,T,thash>::Iterator::operator ++ (int) -> HashMap<KEY,T,thash>::Iterator {
+	if (current.second == nullptr)
+		return *this;
+	Iterator to_return(*this);
+	if (can_erase)
+		advance_cursors();
+	else
+		can_erase = true;
+	return to_return;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::Iterator::operator == (const HashMap<KEY,T,thash>::Iterator& rhs) const {
-//Don't just put each key->value pair in the map.
-
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool HashMap<KEY,T,thash,Alloc>::Iterator::operator == (const HashMap<KEY,T,thash,Alloc>::Iterator& rhs) const {
+	const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+	if (rhsASI == 0)
+		throw IteratorTypeError("HashMap::Iterator::operator ==");
+	if (expected_mod_count != ref_map->mod_count)
+		throw ConcurrentModificationError("HashMap::Iterator::operator ==");
+	if (ref_map != rhsASI->ref_map)
+		throw ComparingDifferentIteratorsError("HashMap::Iterator::operator ==");
 
+	return current.second == rhsASI->current.second;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-bool HashMap<KEY,T,thash>::Iterator::operator != (const HashMap<KEY,T,thash>::Iterator& rhs) const {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+bool HashMap<KEY,T,thash,Alloc>::Iterator::operator != (const HashMap<KEY,T,thash,Alloc>::Iterator& rhs) const {
+	return !(*this == rhs);
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-pair<KEY,T>& HashMap<KEY,T,thash>::Iterator::operator *() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+const pair<KEY,T>& HashMap<KEY,T,thash,Alloc>::Iterator::operator *() const {
+	if (expected_mod_count != ref_map->mod_count)
+		throw ConcurrentModificationError("HashMap::Iterator::operator *");
+	if (!can_erase || current.second == nullptr)
+		throw IteratorPositionIllegal("HashMap::Iterator::operator * Iterator illegal: exhausted or erased");
+
+	return current.second->value;
 }
 
 
-template<class KEY,class T, int (*thash)(const KEY& a)>
-pair<KEY,T>* HashMap<KEY,T,thash>::Iterator::operator ->() const {
+template<class KEY,class T, int (*thash)(const KEY& a), class Alloc>
+const pair<KEY,T>* HashMap<KEY,T,thash,Alloc>::Iterator::operator ->() const {
+	if (expected_mod_count != ref_map->mod_count)
+		throw ConcurrentModificationError("HashMap::Iterator::operator ->");
+	if (!can_erase || current.second == nullptr)
+		throw IteratorPositionIllegal("HashMap::Iterator::operator -> Iterator illegal: exhausted or erased");
+
+	return &current.second->value;
 }
 
 
+
+#if __cplusplus >= 201703L
+namespace pmr {
+  //HashMap whose nodes/bins come from a std::pmr::memory_resource: pass
+  //  std::pmr::polymorphic_allocator<pair<KEY,T>>(&resource) as the last constructor argument
+  template<class KEY,class T, int (*thash)(const KEY& a) = nullptr>
+  using HashMap = ics::HashMap<KEY,T,thash,std::pmr::polymorphic_allocator<pair<KEY,T>>>;
+}
+#endif
+
 }
 
 #endif /* HASH_MAP_HPP_ */
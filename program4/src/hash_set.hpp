@@ -5,8 +5,16 @@
 #include <iostream>
 #include <sstream>
 #include <initializer_list>
+#include <cstdlib>            //For abs
+#include <limits>             //For the largest number of bins
+#include <memory>             //For std::allocator
+#if __cplusplus >= 201703L
+#include <memory_resource>    //For std::pmr::polymorphic_allocator
+#endif
 #include "ics_exceptions.hpp"
 #include "pair.hpp"
+#include "expected_size.hpp"  //In the repository root (shared with hyper_log_log.hpp)
+#include "cow_table.hpp"
 
 
 namespace ics {
@@ -17,25 +25,39 @@ namespace ics {
 //If both thash and chash are supplied, then they must be the same (by ==) function.
 //If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
 //The (unique) non-nullptr value supplied by thash/chash is stored in the instance variable hash.
-template<class T, int (*thash)(const T& a) = nullptr> class HashSet {
+//Alloc is any std::allocator-compatible allocator of T; it is rebound to allocate the LN nodes
+//  and the array of bins (a stateful one is passed as the last constructor argument).
+//Constructed with an ExpectedSize (e.g., a HyperLogLog's expected_size from a pre-scan of the
+//  elements), it starts with the bins for that many, instead of rehashing as it grows.
+//Copies are copy-on-write (see CowTable): copying (with the same hash and an equal allocator) is
+//  O(1), the copies sharing one immutable table. A set's first write after that copies the array
+//  of bin pointers, then each bin it writes is copied before it is changed; the bins never
+//  written stay shared. Different copies may be used (and destroyed) by different threads at
+//  once, and one set may be copied by several threads at once (the sharing is reference counted
+//  atomically), but otherwise one HashSet still needs its own locking.
+//  Iterators give only const access to the elements (changing one would also misplace it in
+//  its bin), so they never write a shared bin.
+template<class T, int (*thash)(const T& a) = nullptr, class Alloc = std::allocator<T>> class HashSet : private CowTable<T,Alloc> {
   public:
     //Destructor/Constructors
     ~HashSet ();
 
-    HashSet          (double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr);
-    explicit HashSet (int initial_bins, double the_load_threshold = 1.0, int (*chash)(const T& k) = nullptr);
-    HashSet          (const HashSet<T,thash>& to_copy, double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr);
-    explicit HashSet (const std::initializer_list<T>& il, double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr);
+    HashSet          (double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr, const Alloc& alloc = Alloc());
+    explicit HashSet (int initial_bins, double the_load_threshold = 1.0, int (*chash)(const T& k) = nullptr, const Alloc& alloc = Alloc());
+    explicit HashSet (const ExpectedSize& expected, double the_load_threshold = 1.0, int (*chash)(const T& k) = nullptr, const Alloc& alloc = Alloc());
+    HashSet          (const HashSet<T,thash,Alloc>& to_copy, double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr);
+    explicit HashSet (const std::initializer_list<T>& il, double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr, const Alloc& alloc = Alloc());
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
-    explicit HashSet (const Iterable& i, double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr);
+    explicit HashSet (const Iterable& i, double the_load_threshold = 1.0, int (*chash)(const T& a) = nullptr, const Alloc& alloc = Alloc());
 
 
     //Queries
     bool empty      () const;
     int  size       () const;
     bool contains   (const T& element) const;
+    Alloc get_allocator () const;
     std::string str () const; //supplies useful debugging information; contrast to operator <<
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
@@ -47,6 +69,7 @@ template<class T, int (*thash)(const T& a) = nullptr> class HashSet {
     int  insert (const T& element);
     int  erase  (const T& element);
     void clear  ();
+    void reserve(int n);  //Grow the bins now, so holding n elements never rehashes (used by bulk loads)
 
     //Iterable class must support "for" loop: .begin()/.end() and prefix ++ on returned result
 
@@ -61,48 +84,49 @@ template<class T, int (*thash)(const T& a) = nullptr> class HashSet {
 
 
     //Operators
-    HashSet<T,thash>& operator = (const HashSet<T,thash>& rhs);
-    bool operator == (const HashSet<T,thash>& rhs) const;
-    bool operator != (const HashSet<T,thash>& rhs) const;
-    bool operator <= (const HashSet<T,thash>& rhs) const;
-    bool operator <  (const HashSet<T,thash>& rhs) const;
-    bool operator >= (const HashSet<T,thash>& rhs) const;
-    bool operator >  (const HashSet<T,thash>& rhs) const;
+    HashSet<T,thash,Alloc>& operator = (const HashSet<T,thash,Alloc>& rhs);
+    bool operator == (const HashSet<T,thash,Alloc>& rhs) const;
+    bool operator != (const HashSet<T,thash,Alloc>& rhs) const;
+    bool operator <= (const HashSet<T,thash,Alloc>& rhs) const;
+    bool operator <  (const HashSet<T,thash,Alloc>& rhs) const;
+    bool operator >= (const HashSet<T,thash,Alloc>& rhs) const;
+    bool operator >  (const HashSet<T,thash,Alloc>& rhs) const;
 
-    template<class T2, int (hash2) (const T2& a)>
-    friend std::ostream& operator << (std::ostream& outs, const HashSet<T2,hash2>& s);
+    template<class T2, int (hash2) (const T2& a), class Alloc2>
+    friend std::ostream& operator << (std::ostream& outs, const HashSet<T2,hash2,Alloc2>& s);
 
 
 
   private:
-    class LN;
+    typedef CowTable<T,Alloc>  Table;
+    typedef typename Table::LN LN;
 
   public:
     class Iterator {
       public:
         typedef pair<int,LN*> Cursor;
 
-        //Private constructor called in begin/end, which are friends of HashSet<T,thash>
+        //Private constructor called in begin/end, which are friends of HashSet<T,thash,Alloc>
         ~Iterator();
         T           erase();
         std::string str  () const;
-        HashSet<T,thash>::Iterator& operator ++ ();
-        HashSet<T,thash>::Iterator  operator ++ (int);
-        bool operator == (const HashSet<T,thash>::Iterator& rhs) const;
-        bool operator != (const HashSet<T,thash>::Iterator& rhs) const;
-        T& operator *  () const;
-        T* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const HashSet<T,thash>::Iterator& i) {
+        HashSet<T,thash,Alloc>::Iterator& operator ++ ();
+        HashSet<T,thash,Alloc>::Iterator  operator ++ (int);
+        bool operator == (const HashSet<T,thash,Alloc>::Iterator& rhs) const;
+        bool operator != (const HashSet<T,thash,Alloc>::Iterator& rhs) const;
+        const T& operator *  () const;
+        const T* operator -> () const;
+        friend std::ostream& operator << (std::ostream& outs, const HashSet<T,thash,Alloc>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
-        friend Iterator HashSet<T,thash>::begin () const;
-        friend Iterator HashSet<T,thash>::end   () const;
+        friend Iterator HashSet<T,thash,Alloc>::begin () const;
+        friend Iterator HashSet<T,thash,Alloc>::end   () const;
 
       private:
         //If can_erase is false, current indexes the "next" value (must ++ to reach it)
         Cursor              current; //Bin Index with Cursor; stop: LN* == nullptr
-        HashSet<T,thash>*    ref_set;
+        HashSet<T,thash,Alloc>*    ref_set;
         int                 expected_mod_count;
         bool                can_erase = true;
 
@@ -110,7 +134,7 @@ template<class T, int (*thash)(const T& a) = nullptr> class HashSet {
         void advance_cursors();
 
         //Called in friends begin/end
-        Iterator(HashSet<T,thash>* iterate_over, bool from_begin);
+        Iterator(HashSet<T,thash,Alloc>* iterate_over, bool from_begin);
     };
 
 
@@ -118,23 +142,27 @@ template<class T, int (*thash)(const T& a) = nullptr> class HashSet {
     Iterator end   () const;
 
 
-  private:
-    class LN {
-      public:
-        LN ()                      {}
-        LN (const LN& ln)          : value(ln.value), next(ln.next){}
-        LN (T v,  LN* n = nullptr) : value(v), next(n){}
-
-        T   value;
-        LN* next   = nullptr;
-    };
-
 public:
   int (*hash)(const T& k);   //Hashing function used (from template or constructor)
 private:
-  LN** set      = nullptr;   //Pointer to array of pointers: each bin stores a list with a trailer node
-  double load_threshold;     //used/bins <= load_threshold
-  int bins      = 1;         //# bins in array (should start at 1 so hash_compress doesn't % 0)
+  //The bins and their copy-on-write state: table[b] is bin b's list (with a trailer node)
+  using Table::node_alloc;
+  using Table::table;
+  using Table::bins;
+  using Table::new_LN;
+  using Table::delete_LN;
+  using Table::new_bins;
+  using Table::delete_bins;
+  using Table::copy_hash_table;
+  using Table::sharing;
+  using Table::shared_bins;
+  using Table::share;
+  using Table::own_bin;
+  using Table::own_all;
+  using Table::drop_table;
+
+  double load_threshold;     //used/bins <= load_threshold (> 0), unless bins would pass max_bins
+  static const int max_bins = std::numeric_limits<int>::max();   //Doubling never goes past this
   int used      = 0;         //Cache for number of key->value pairs in the hash table
   int mod_count = 0;         //For sensing concurrent modification
 
@@ -142,11 +170,11 @@ private:
   //Helper methods
   int   hash_compress        (const T& key)              const;  //hash function ranged to [0,bins-1]
   LN*   find_element         (int bin, const T& element) const;  //Returns reference to element's node or nullptr
-  LN*   copy_list            (LN*   l)                   const;  //Copy the elements in a bin (order irrelevant)
-  LN**  copy_hash_table      (LN** ht, int bins)         const;  //Copy the bins/keys/values in ht tree (order in bins irrelevant)
 
   void  ensure_load_threshold(int new_used);                     //Reallocate if load_threshold > load_threshold
-  void  delete_hash_table    (LN**& ht, int bins);               //Deallocate all LN in ht (and the ht itself; ht == nullptr)
+  void  rehash               (int new_bins);                     //Relink every LN into a table with new_bins bins
+
+  bool  can_share            (const HashSet<T,thash,Alloc>& s) const; //Same hash and interchangeable allocators
 };
 
 
@@ -159,38 +187,98 @@ private:
 //
 //Destructor/Constructors
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::~HashSet() {
+template<class T, int (*thash)(const T& a), class Alloc>
+HashSet<T,thash,Alloc>::~HashSet() {
+  //CowTable's destructor releases the table
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::HashSet(double the_load_threshold, int (*chash)(const T& element))
+template<class T, int (*thash)(const T& a), class Alloc>
+HashSet<T,thash,Alloc>::HashSet(double the_load_threshold, int (*chash)(const T& element), const Alloc& alloc)
+: Table(alloc), hash(thash != nullptr ? thash : chash), load_threshold(the_load_threshold)
+{
+  if (hash == nullptr)
+    throw TemplateFunctionError("HashSet::default constructor: neither specified");
+  if (thash != nullptr && chash != nullptr && thash != chash)
+    throw TemplateFunctionError("HashSet::default constructor: both specified and different");
+  if (!(load_threshold > 0))          //Also rejects NaN; reserve/ensure_load_threshold divide by it
+    throw IcsError("HashSet::default constructor: load_threshold must be > 0");
+
+  table = new_bins(bins);
+  for (int b=0; b<bins; ++b)
+    table[b] = new_LN();
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::HashSet(int initial_bins, double the_load_threshold, int (*chash)(const T& element))
+template<class T, int (*thash)(const T& a), class Alloc>
+HashSet<T,thash,Alloc>::HashSet(int initial_bins, double the_load_threshold, int (*chash)(const T& element), const Alloc& alloc)
+: Table(alloc), hash(thash != nullptr ? thash : chash), load_threshold(the_load_threshold)
 {
+  if (hash == nullptr)
+    throw TemplateFunctionError("HashSet::length constructor: neither specified");
+  if (thash != nullptr && chash != nullptr && thash != chash)
+    throw TemplateFunctionError("HashSet::length constructor: both specified and different");
+  if (!(load_threshold > 0))
+    throw IcsError("HashSet::length constructor: load_threshold must be > 0");
+
+  bins = (initial_bins < 1 ? 1 : initial_bins);
+  table = new_bins(bins);
+  for (int b=0; b<bins; ++b)
+    table[b] = new_LN();
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::HashSet(const HashSet<T,thash>& to_copy, double the_load_threshold, int (*chash)(const T& element))
+template<class T, int (*thash)(const T& a), class Alloc>
+HashSet<T,thash,Alloc>::HashSet(const ExpectedSize& expected, double the_load_threshold, int (*chash)(const T& element), const Alloc& alloc)
+: HashSet(1, the_load_threshold, chash, alloc)
 {
+  reserve(expected.size);   //The bins for expected.size elements, so inserting them never rehashes
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::HashSet(const std::initializer_list<T>& il, double the_load_threshold, int (*chash)(const T& element))
+template<class T, int (*thash)(const T& a), class Alloc>
+HashSet<T,thash,Alloc>::HashSet(const HashSet<T,thash,Alloc>& to_copy, double the_load_threshold, int (*chash)(const T& element))
+: Table(to_copy), hash(thash != nullptr ? thash : chash), load_threshold(the_load_threshold)
+{
+  bins = to_copy.bins;
+  if (hash == nullptr)
+    hash = to_copy.hash;
+  if (thash != nullptr && chash != nullptr && thash != chash)
+    throw TemplateFunctionError("HashSet::copy constructor: both specified and different");
+  if (!(load_threshold > 0))
+    throw IcsError("HashSet::copy constructor: load_threshold must be > 0");
+
+  if (can_share(to_copy)) {           //Same hash and allocator: share the table until either writes
+    share(to_copy);
+    used = to_copy.used;
+  }else if (hash == to_copy.hash) {   //Same hash: same bin for every element, so copy bin by bin
+    table = copy_hash_table(to_copy.table, bins);
+    used  = to_copy.used;
+  }else {                             //Different hash: every element must be rehashed
+    table = new_bins(bins);
+    for (int b=0; b<bins; ++b)
+      table[b] = new_LN();
+    insert_all(to_copy);
+  }
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+HashSet<T,thash,Alloc>::HashSet(const std::initializer_list<T>& il, double the_load_threshold, int (*chash)(const T& element), const Alloc& alloc)
+: HashSet(the_load_threshold, chash, alloc)
 {
+  reserve(il.size());
+  for (const T& element : il)
+    insert(element);
 }
 
 
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class Alloc>
 template<class Iterable>
-HashSet<T,thash>::HashSet(const Iterable& i, double the_load_threshold, int (*chash)(const T& a))
+HashSet<T,thash,Alloc>::HashSet(const Iterable& i, double the_load_threshold, int (*chash)(const T& a), const Alloc& alloc)
+: HashSet(the_load_threshold, chash, alloc)
 {
+  insert_all(i);
 }
 
 
@@ -198,29 +286,55 @@ HashSet<T,thash>::HashSet(const Iterable& i, double the_load_threshold, int (*ch
 //
 //Queries
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::empty() const {
+template<class T, int (*thash)(const T& a), class Alloc>
+bool HashSet<T,thash,Alloc>::empty() const {
+  return used == 0;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-int HashSet<T,thash>::size() const {
+template<class T, int (*thash)(const T& a), class Alloc>
+int HashSet<T,thash,Alloc>::size() const {
+  return used;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::contains (const T& element) const {
+template<class T, int (*thash)(const T& a), class Alloc>
+bool HashSet<T,thash,Alloc>::contains (const T& element) const {
+  return find_element(hash_compress(element), element) != nullptr;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-std::string HashSet<T,thash>::str() const {
+template<class T, int (*thash)(const T& a), class Alloc>
+Alloc HashSet<T,thash,Alloc>::get_allocator() const {
+  return Alloc(node_alloc);
 }
 
 
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class Alloc>
+std::string HashSet<T,thash,Alloc>::str() const {
+  std::ostringstream answer;
+  answer << "HashSet[";
+  for (int b=0; b<bins; ++b) {
+    answer << std::endl << "  bin[" << b << "]: ";
+    for (LN* p = table[b]; p->next != nullptr; p = p->next)
+      answer << p->value << " -> ";
+    answer << "TRAILER";
+  }
+  answer << "](load_threshold=" << load_threshold << ",bins=" << bins << ",used=" << used << ",mod_count=" << mod_count;
+  if (sharing())
+    answer << ",shared bins=" << shared_bins();
+  answer << ")";
+  return answer.str();
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
 template <class Iterable>
-bool HashSet<T,thash>::contains_all(const Iterable& i) const {
+bool HashSet<T,thash,Alloc>::contains_all(const Iterable& i) const {
+  for (const T& v : i)
+    if (!contains(v))
+      return false;
+  return true;
 }
 
 
@@ -228,36 +342,106 @@ bool HashSet<T,thash>::contains_all(const Iterable& i) const {
 //
 //Commands
 
-template<class T, int (*thash)(const T& a)>
-int HashSet<T,thash>::insert(const T& element) {
-}
-
-
-template<class T, int (*thash)(const T& a)>
-int HashSet<T,thash>::erase(const T& element) {
-}
-
-
-template<class T, int (*thash)(const T& a)>
-void HashSet<T,thash>::clear() {
-}
-
-
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class Alloc>
+int HashSet<T,thash,Alloc>::insert(const T& element) {
+  int b = hash_compress(element);
+  if (find_element(b, element) != nullptr)
+    return 0;
+
+  int old_bins = bins;
+  ensure_load_threshold(used+1);
+  if (bins != old_bins)               //Rehashed: the element's bin may have changed
+    b = hash_compress(element);
+  own_bin(b);
+  table[b] = new_LN(element, table[b]);
+  ++used;
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+int HashSet<T,thash,Alloc>::erase(const T& element) {
+  int b = hash_compress(element);
+  LN* to_erase = find_element(b, element);
+  if (to_erase == nullptr)
+    return 0;
+  if (sharing()) {                    //Erase from this set's own copy of the bin
+    own_bin(b);
+    to_erase = find_element(b, element);
+  }
+
+  //Copy the next LN (possibly the trailer) into this one and delete that next LN
+  LN* to_delete   = to_erase->next;
+  to_erase->value = to_delete->value;
+  to_erase->next  = to_delete->next;
+  delete_LN(to_delete);
+  --used;
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+void HashSet<T,thash,Alloc>::clear() {
+  if (sharing()) {                    //Nothing to copy: just let go of the shared table
+    drop_table();
+    table = new_bins(bins);
+    for (int b=0; b<bins; ++b)
+      table[b] = new_LN();
+  }
+  for (int b=0; b<bins; ++b)          //Keep the bins (and their trailers): a cleared set is usually refilled
+    while (table[b]->next != nullptr) {
+      LN* to_delete = table[b];
+      table[b] = table[b]->next;
+      delete_LN(to_delete);
+    }
+  used = 0;
+  ++mod_count;
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+void HashSet<T,thash,Alloc>::reserve(int n) {
+  int new_bins = bins;
+  while (double(n)/new_bins > load_threshold && new_bins <= max_bins/2)   //Same test/doubling as ensure_load_threshold
+    new_bins *= 2;
+  if (new_bins != bins)
+    rehash(new_bins);
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
 template<class Iterable>
-int HashSet<T,thash>::insert_all(const Iterable& i) {
+int HashSet<T,thash,Alloc>::insert_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    count += insert(v);
+  return count;
 }
 
 
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class Alloc>
 template<class Iterable>
-int HashSet<T,thash>::erase_all(const Iterable& i) {
+int HashSet<T,thash,Alloc>::erase_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    count += erase(v);
+  return count;
 }
 
 
-template<class T, int (*thash)(const T& a)>
+template<class T, int (*thash)(const T& a), class Alloc>
 template<class Iterable>
-int HashSet<T,thash>::retain_all(const Iterable& i) {
+int HashSet<T,thash,Alloc>::retain_all(const Iterable& i) {
+  HashSet<T,thash,Alloc> keep(i, load_threshold, hash);
+  int count = 0;
+  for (Iterator it = begin(); it != end(); ++it)
+    if (!keep.contains(*it)) {
+      it.erase();
+      ++count;
+    }
+  return count;
 }
 
 
@@ -265,42 +449,76 @@ int HashSet<T,thash>::retain_all(const Iterable& i) {
 //
 //Operators
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>& HashSet<T,thash>::operator = (const HashSet<T,thash>& rhs) {
+template<class T, int (*thash)(const T& a), class Alloc>
+HashSet<T,thash,Alloc>& HashSet<T,thash,Alloc>::operator = (const HashSet<T,thash,Alloc>& rhs) {
+  if (this == &rhs)
+    return *this;
+
+  drop_table();
+  hash           = rhs.hash;
+  load_threshold = rhs.load_threshold;
+  bins           = rhs.bins;
+  if (can_share(rhs))
+    share(rhs);
+  else
+    table = copy_hash_table(rhs.table, bins);
+  used           = rhs.used;
+  ++mod_count;
+  return *this;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator == (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class Alloc>
+bool HashSet<T,thash,Alloc>::operator == (const HashSet<T,thash,Alloc>& rhs) const {
+  if (this == &rhs)
+    return true;
+  return used == rhs.used && rhs.contains_all(*this);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator != (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class Alloc>
+bool HashSet<T,thash,Alloc>::operator != (const HashSet<T,thash,Alloc>& rhs) const {
+  return !(*this == rhs);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator <= (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class Alloc>
+bool HashSet<T,thash,Alloc>::operator <= (const HashSet<T,thash,Alloc>& rhs) const {
+  if (this == &rhs)
+    return true;
+  return used <= rhs.used && rhs.contains_all(*this);
 }
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator < (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class Alloc>
+bool HashSet<T,thash,Alloc>::operator < (const HashSet<T,thash,Alloc>& rhs) const {
+  if (this == &rhs)
+    return false;
+  return used < rhs.used && rhs.contains_all(*this);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator >= (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class Alloc>
+bool HashSet<T,thash,Alloc>::operator >= (const HashSet<T,thash,Alloc>& rhs) const {
+  return rhs <= *this;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::operator > (const HashSet<T,thash>& rhs) const {
+template<class T, int (*thash)(const T& a), class Alloc>
+bool HashSet<T,thash,Alloc>::operator > (const HashSet<T,thash,Alloc>& rhs) const {
+  return rhs < *this;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-std::ostream& operator << (std::ostream& outs, const HashSet<T,thash>& s) {
+template<class T, int (*thash)(const T& a), class Alloc>
+std::ostream& operator << (std::ostream& outs, const HashSet<T,thash,Alloc>& s) {
+  outs << "set[";
+  bool first = true;
+  for (const T& v : s) {
+    outs << (first ? "" : ",") << v;
+    first = false;
+  }
+  outs << "]";
+  return outs;
 }
 
 
@@ -308,13 +526,15 @@ std::ostream& operator << (std::ostream& outs, const HashSet<T,thash>& s) {
 //
 //Iterator constructors
 
-template<class T, int (*thash)(const T& a)>
-auto HashSet<T,thash>::begin () const -> HashSet<T,thash>::Iterator {
+template<class T, int (*thash)(const T& a), class Alloc>
+auto HashSet<T,thash,Alloc>::begin () const -> HashSet<T,thash,Alloc>::Iterator {
+  return Iterator(const_cast<HashSet<T,thash,Alloc>*>(this),true);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-auto HashSet<T,thash>::end () const -> HashSet<T,thash>::Iterator {
+template<class T, int (*thash)(const T& a), class Alloc>
+auto HashSet<T,thash,Alloc>::end () const -> HashSet<T,thash,Alloc>::Iterator {
+  return Iterator(const_cast<HashSet<T,thash,Alloc>*>(this),false);
 }
 
 
@@ -322,95 +542,220 @@ auto HashSet<T,thash>::end () const -> HashSet<T,thash>::Iterator {
 //
 //Private helper methods
 
-template<class T, int (*thash)(const T& a)>
-int HashSet<T,thash>::hash_compress (const T& element) const {
+template<class T, int (*thash)(const T& a), class Alloc>
+int HashSet<T,thash,Alloc>::hash_compress (const T& element) const {
+  return abs(hash(element)) % bins;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-typename HashSet<T,thash>::LN* HashSet<T,thash>::find_element (int bin, const T& element) const {
+template<class T, int (*thash)(const T& a), class Alloc>
+typename HashSet<T,thash,Alloc>::LN* HashSet<T,thash,Alloc>::find_element (int bin, const T& element) const {
+  for (LN* p = table[bin]; p->next != nullptr; p = p->next)   //Stop at the trailer: its T() is not in the set
+    if (p->value == element)
+      return p;
+  return nullptr;
 }
 
-template<class T, int (*thash)(const T& a)>
-typename HashSet<T,thash>::LN* HashSet<T,thash>::copy_list (LN* l) const {
+template<class T, int (*thash)(const T& a), class Alloc>
+void HashSet<T,thash,Alloc>::ensure_load_threshold(int new_used) {
+  if (double(new_used)/bins > load_threshold && bins <= max_bins/2)   //At max_bins, chains just grow
+    rehash(2*bins);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-typename HashSet<T,thash>::LN** HashSet<T,thash>::copy_hash_table (LN** ht, int bins) const {
-}
+template<class T, int (*thash)(const T& a), class Alloc>
+void HashSet<T,thash,Alloc>::rehash(int new_bin_count) {
+  own_all();                          //Relinking changes every list: they must all be this set's own
+  LN** old_table = table;
+  int  old_bins  = bins;
 
+  bins = new_bin_count;
+  table = new_bins(bins);
+  for (int b=0; b<bins; ++b)
+    table[b] = new_LN();
 
-template<class T, int (*thash)(const T& a)>
-void HashSet<T,thash>::ensure_load_threshold(int new_used) {
+  //Relink (don't copy) every LN but the trailers; then delete the old trailers/bins
+  for (int b=0; b<old_bins; ++b) {
+    LN* p = old_table[b];
+    while (p->next != nullptr) {
+      LN* to_move = p;
+      p = p->next;
+      int new_b = hash_compress(to_move->value);
+      to_move->next = table[new_b];
+      table[new_b] = to_move;
+    }
+    delete_LN(p);
+  }
+  delete_bins(old_table, old_bins);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-void HashSet<T,thash>::delete_hash_table (LN**& ht, int bins) {
+//Sharing frees nodes with the other set's allocator, so they must be interchangeable (e.g.,
+//  not a pmr copy, which gets the default resource: that copy is deep, as before)
+template<class T, int (*thash)(const T& a), class Alloc>
+bool HashSet<T,thash,Alloc>::can_share (const HashSet<T,thash,Alloc>& s) const {
+  return hash == s.hash && node_alloc == s.node_alloc;
 }
 
 
-
-
-
-
 ////////////////////////////////////////////////////////////////////////////////
 //
 //Iterator class definitions
 
-template<class T, int (*thash)(const T& a)>
-void HashSet<T,thash>::Iterator::advance_cursors() {
+template<class T, int (*thash)(const T& a), class Alloc>
+void HashSet<T,thash,Alloc>::Iterator::advance_cursors() {
+  //Move off the current value (if any); if that reaches a trailer, go on to the first value in a later bin
+  if (current.second != nullptr && current.second->next != nullptr)
+    current.second = current.second->next;
+  if (current.second != nullptr && current.second->next != nullptr)
+    return;
+
+  for (++current.first; current.first < ref_set->bins; ++current.first)
+    if (ref_set->table[current.first]->next != nullptr) {
+      current.second = ref_set->table[current.first];
+      return;
+    }
+  current = Cursor(-1,nullptr);
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::Iterator::Iterator(HashSet<T,thash>* iterate_over, bool begin)
+template<class T, int (*thash)(const T& a), class Alloc>
+HashSet<T,thash,Alloc>::Iterator::Iterator(HashSet<T,thash,Alloc>* iterate_over, bool begin)
+: current(-1,nullptr), ref_set(iterate_over), expected_mod_count(iterate_over->mod_count)
 {
+  if (begin)
+    advance_cursors();
 }
 
 
-template<class T, int (*thash)(const T& a)>
-HashSet<T,thash>::Iterator::~Iterator()
+template<class T, int (*thash)(const T& a), class Alloc>
+HashSet<T,thash,Alloc>::Iterator::~Iterator()
 {}
 
 
-template<class T, int (*thash)(const T& a)>
-T HashSet<T,thash>::Iterator::erase() {
+template<class T, int (*thash)(const T& a), class Alloc>
+T HashSet<T,thash,Alloc>::Iterator::erase() {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("HashSet::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("HashSet::Iterator::erase Iterator cursor already erased");
+  if (current.second == nullptr)
+    throw CannotEraseError("HashSet::Iterator::erase Iterator cursor beyond data structure");
+
+  if (ref_set->sharing()) {           //Move the cursor to the same position in the set's own copy of its bin
+    int position = 0;
+    for (LN* p = ref_set->table[current.first]; p != current.second; p = p->next)
+      ++position;
+    ref_set->own_bin(current.first);
+    for (current.second = ref_set->table[current.first]; position > 0; --position)
+      current.second = current.second->next;
+  }
+
+  //As in HashSet::erase: copy the next LN into this one, so current now indexes the "next" value
+  can_erase = false;
+  T to_return = current.second->value;
+  LN* to_delete = current.second->next;
+  current.second->value = to_delete->value;
+  current.second->next  = to_delete->next;
+  ref_set->delete_LN(to_delete);
+  --ref_set->used;
+  ++ref_set->mod_count;
+  expected_mod_count = ref_set->mod_count;
+
+  if (current.second->next == nullptr)  //Copied the trailer: the "next" value is in a later bin
+    advance_cursors();
+  return to_return;
+}
+
+
+template<class T, int (*thash)(const T& a), class Alloc>
+std::string HashSet<T,thash,Alloc>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_set->str() << "(current=" << current.first << "/" << current.second
+         << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+  return answer.str();
 }
 
 
-template<class T, int (*thash)(const T& a)>
-std::string HashSet<T,thash>::Iterator::str() const {
+template<class T, int (*thash)(const T& a), class Alloc>
+auto  HashSet<T,thash,Alloc>::Iterator::operator ++ () -> HashSet<T,thash,Alloc>::Iterator& {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("HashSet::Iterator::operator ++");
+
+  if (current.second == nullptr)
+    return *this;
+  if (can_erase)
+    advance_cursors();
+  else
+    can_erase = true;
+  return *this;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-auto  HashSet<T,thash>::Iterator::operator ++ () -> HashSet<T,thash>::Iterator& {
+template<class T, int (*thash)(const T& a), class Alloc>
+auto  HashSet<T,thash,Alloc>::Iterator::operator ++ (int) -> HashSet<T,thash,Alloc>::Iterator {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("HashSet::Iterator::operator ++(int)");
+
+  if (current.second == nullptr)
+    return *this;
+  Iterator to_return(*this);
+  if (can_erase)
+    advance_cursors();
+  else
+    can_erase = true;
+  return to_return;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-auto  HashSet<T,thash>::Iterator::operator ++ (int) -> HashSet<T,thash>::Iterator {
+template<class T, int (*thash)(const T& a), class Alloc>
+bool HashSet<T,thash,Alloc>::Iterator::operator == (const HashSet<T,thash,Alloc>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("HashSet::Iterator::operator ==");
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("HashSet::Iterator::operator ==");
+  if (ref_set != rhsASI->ref_set)
+    throw ComparingDifferentIteratorsError("HashSet::Iterator::operator ==");
+
+  return current.second == rhsASI->current.second;
 }
 
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::Iterator::operator == (const HashSet<T,thash>::Iterator& rhs) const {
+template<class T, int (*thash)(const T& a), class Alloc>
+bool HashSet<T,thash,Alloc>::Iterator::operator != (const HashSet<T,thash,Alloc>::Iterator& rhs) const {
+  return !(*this == rhs);
 }
 
+template<class T, int (*thash)(const T& a), class Alloc>
+const T& HashSet<T,thash,Alloc>::Iterator::operator *() const {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("HashSet::Iterator::operator *");
+  if (!can_erase || current.second == nullptr)
+    throw IteratorPositionIllegal("HashSet::Iterator::operator * Iterator illegal: exhausted or erased");
 
-template<class T, int (*thash)(const T& a)>
-bool HashSet<T,thash>::Iterator::operator != (const HashSet<T,thash>::Iterator& rhs) const {
+  return current.second->value;
 }
 
-template<class T, int (*thash)(const T& a)>
-T& HashSet<T,thash>::Iterator::operator *() const {
+template<class T, int (*thash)(const T& a), class Alloc>
+const T* HashSet<T,thash,Alloc>::Iterator::operator ->() const {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("HashSet::Iterator::operator ->");
+  if (!can_erase || current.second == nullptr)
+    throw IteratorPositionIllegal("HashSet::Iterator::operator -> Iterator illegal: exhausted or erased");
+
+  return &current.second->value;
 }
 
-template<class T, int (*thash)(const T& a)>
-T* HashSet<T,thash>::Iterator::operator ->() const {
+
+#if __cplusplus >= 201703L
+namespace pmr {
+  //HashSet whose nodes/bins come from a std::pmr::memory_resource: pass
+  //  std::pmr::polymorphic_allocator<T>(&resource) as the last constructor argument
+  template<class T, int (*thash)(const T& a) = nullptr>
+  using HashSet = ics::HashSet<T,thash,std::pmr::polymorphic_allocator<T>>;
 }
+#endif
 
 }
 
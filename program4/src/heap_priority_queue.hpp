@@ -7,6 +7,11 @@
 #include <initializer_list>
 #include "ics_exceptions.hpp"
 #include <utility>              //For std::swap function
+#include <algorithm>            //For std::max
+#include <memory>               //For std::allocator/std::allocator_traits
+#if __cplusplus >= 201703L
+#include <memory_resource>      //For std::pmr::polymorphic_allocator
+#endif
 #include "array_stack.hpp"      //See operator <<
 
 
@@ -18,25 +23,28 @@ namespace ics {
 //If both tgt and cgt are supplied, then they must be the same (by ==) function.
 //If neither is supplied, or both are supplied but different, TemplateFunctionError is raised.
 //The (unique) non-nullptr value supplied by tgt/cgt is stored in the instance variable gt.
-template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class HeapPriorityQueue {
+//Alloc (any std::allocator-compatible allocator of T) allocates the pq array; a stateful one
+//  is passed as the last constructor argument and is kept by copies but not by operator =.
+template<class T, bool (*tgt)(const T& a, const T& b) = nullptr, class Alloc = std::allocator<T>> class HeapPriorityQueue {
   public:
     //Destructor/Constructors
     ~HeapPriorityQueue();
 
-    HeapPriorityQueue(bool (*cgt)(const T& a, const T& b) = nullptr);
-    explicit HeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b));
-    HeapPriorityQueue(const HeapPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b) = nullptr);
-    explicit HeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = nullptr);
+    HeapPriorityQueue(bool (*cgt)(const T& a, const T& b) = nullptr, const Alloc& alloc = Alloc());
+    explicit HeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b), const Alloc& alloc = Alloc());
+    HeapPriorityQueue(const HeapPriorityQueue<T,tgt,Alloc>& to_copy, bool (*cgt)(const T& a, const T& b) = nullptr);
+    explicit HeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b) = nullptr, const Alloc& alloc = Alloc());
 
     //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
     template <class Iterable>
-    explicit HeapPriorityQueue (const Iterable& i, bool (*cgt)(const T& a, const T& b) = nullptr);
+    explicit HeapPriorityQueue (const Iterable& i, bool (*cgt)(const T& a, const T& b) = nullptr, const Alloc& alloc = Alloc());
 
 
     //Queries
     bool empty      () const;
     int  size       () const;
     T&   peek       () const;
+    Alloc get_allocator () const;
     std::string str () const; //supplies useful debugging information; contrast to operator <<
 
 
@@ -51,46 +59,46 @@ template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class HeapPrior
 
 
     //Operators
-    HeapPriorityQueue<T,tgt>& operator = (const HeapPriorityQueue<T,tgt>& rhs);
-    bool operator == (const HeapPriorityQueue<T,tgt>& rhs) const;
-    bool operator != (const HeapPriorityQueue<T,tgt>& rhs) const;
+    HeapPriorityQueue<T,tgt,Alloc>& operator = (const HeapPriorityQueue<T,tgt,Alloc>& rhs);
+    bool operator == (const HeapPriorityQueue<T,tgt,Alloc>& rhs) const;
+    bool operator != (const HeapPriorityQueue<T,tgt,Alloc>& rhs) const;
 
-    template<class T2, bool (*gt2)(const T2& a, const T2& b)>
-    friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T2,gt2>& pq);
+    template<class T2, bool (*gt2)(const T2& a, const T2& b), class Alloc2>
+    friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T2,gt2,Alloc2>& pq);
 
 
 
     class Iterator {
       public:
-        //Private constructor called in begin/end, which are friends of HeapPriorityQueue<T,tgt>
+        //Private constructor called in begin/end, which are friends of HeapPriorityQueue<T,tgt,Alloc>
         ~Iterator();
         T           erase();
         std::string str  () const;
-        HeapPriorityQueue<T,tgt>::Iterator& operator ++ ();
-        HeapPriorityQueue<T,tgt>::Iterator  operator ++ (int);
-        bool operator == (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const;
-        bool operator != (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const;
+        HeapPriorityQueue<T,tgt,Alloc>::Iterator& operator ++ ();
+        HeapPriorityQueue<T,tgt,Alloc>::Iterator  operator ++ (int);
+        bool operator == (const HeapPriorityQueue<T,tgt,Alloc>::Iterator& rhs) const;
+        bool operator != (const HeapPriorityQueue<T,tgt,Alloc>::Iterator& rhs) const;
         T& operator *  () const;
         T* operator -> () const;
-        friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>::Iterator& i) {
+        friend std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt,Alloc>::Iterator& i) {
           outs << i.str(); //Use the same meaning as the debugging .str() method
           return outs;
         }
 
-        friend Iterator HeapPriorityQueue<T,tgt>::begin () const;
-        friend Iterator HeapPriorityQueue<T,tgt>::end   () const;
+        friend Iterator HeapPriorityQueue<T,tgt,Alloc>::begin () const;
+        friend Iterator HeapPriorityQueue<T,tgt,Alloc>::end   () const;
 
       private:
         //If can_erase is false, the value has been removed from "it" (++ does nothing)
-        HeapPriorityQueue<T,tgt>  it;                 //copy of HPQ (from begin), to use as iterator via dequeue
-        HeapPriorityQueue<T,tgt>* ref_pq;
-        int                       expected_mod_count;
-        bool                      can_erase = true;
+        HeapPriorityQueue<T,tgt,Alloc>  it;                 //copy of HPQ (from begin), to use as iterator via dequeue
+        HeapPriorityQueue<T,tgt,Alloc>* ref_pq;
+        int                             expected_mod_count;
+        bool                            can_erase = true;
 
         //Called in friends begin/end
         //These constructors have different initializers (see it(...) in first one)
-        Iterator(HeapPriorityQueue<T,tgt>* iterate_over, bool from_begin);    // Called by begin
-        Iterator(HeapPriorityQueue<T,tgt>* iterate_over);                     // Called by end
+        Iterator(HeapPriorityQueue<T,tgt,Alloc>* iterate_over, bool from_begin);    // Called by begin
+        Iterator(HeapPriorityQueue<T,tgt,Alloc>* iterate_over);                     // Called by end
     };
 
 
@@ -100,6 +108,7 @@ template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class HeapPrior
 
   private:
     bool (*gt) (const T& a, const T& b); // The gt used by enqueue (from template or constructor)
+    Alloc alloc;                         // Allocates/constructs the pq array (see new_array/delete_array)
     T*  pq;                              // Smaller values in lower indexes (biggest is at used-1)
     int length    = 0;                   //Physical length of array: must be >= .size()
     int used      = 0;                   //Amount of array used:  invariant: 0 <= used <= length
@@ -107,6 +116,8 @@ template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class HeapPrior
 
 
     //Helper methods
+    T*   new_array      (int length);         // Allocate length default-constructed T with alloc
+    void delete_array   (T* a, int length);   // Destroy and deallocate an array from new_array
     void ensure_length  (int new_length);
     int  left_child     (int i) const;         //Useful abstractions for heaps as arrays
     int  right_child    (int i) const;
@@ -128,27 +139,27 @@ template<class T, bool (*tgt)(const T& a, const T& b) = nullptr> class HeapPrior
 
 //Destructor/Constructors
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::~HeapPriorityQueue() {
-  delete[] pq;
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+HeapPriorityQueue<T,tgt,Alloc>::~HeapPriorityQueue() {
+  delete_array(pq,length);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(bool (*cgt)(const T& a, const T& b))
-: gt(tgt != nullptr ? tgt : cgt) {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+HeapPriorityQueue<T,tgt,Alloc>::HeapPriorityQueue(bool (*cgt)(const T& a, const T& b), const Alloc& alloc)
+: gt(tgt != nullptr ? tgt : cgt), alloc(alloc) {
   if (gt == nullptr)
     throw TemplateFunctionError("HeapPriorityQueue::default constructor: neither specified");
   if (tgt != nullptr && cgt != nullptr && tgt != cgt)
     throw TemplateFunctionError("HeapPriorityQueue::default constructor: both specified and different");
 
-  pq = new T[length];
+  pq = new_array(length);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b))
-: gt(tgt != nullptr ? tgt : cgt), length(initial_length) {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+HeapPriorityQueue<T,tgt,Alloc>::HeapPriorityQueue(int initial_length, bool (*cgt)(const T& a, const T& b), const Alloc& alloc)
+: gt(tgt != nullptr ? tgt : cgt), alloc(alloc), length(initial_length) {
   if (gt == nullptr)
     throw TemplateFunctionError("HeapPriorityQueue::length constructor: neither specified");
   if (tgt != nullptr && cgt != nullptr && tgt != cgt)
@@ -156,19 +167,21 @@ HeapPriorityQueue<T,tgt>::HeapPriorityQueue(int initial_length, bool (*cgt)(cons
 
   if (length < 0)
     length = 0;
-  pq = new T[length];
+  pq = new_array(length);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const HeapPriorityQueue<T,tgt>& to_copy, bool (*cgt)(const T& a, const T& b))
-: gt(tgt != nullptr ? tgt : cgt), length(to_copy.length), used(to_copy.used) {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+HeapPriorityQueue<T,tgt,Alloc>::HeapPriorityQueue(const HeapPriorityQueue<T,tgt,Alloc>& to_copy, bool (*cgt)(const T& a, const T& b))
+: gt(tgt != nullptr ? tgt : cgt),
+  alloc(std::allocator_traits<Alloc>::select_on_container_copy_construction(to_copy.alloc)),
+  length(to_copy.length), used(to_copy.used) {
   if (gt == nullptr)
     gt = to_copy.gt;//throw TemplateFunctionError("HeapPriorityQueue::copy constructor: neither specified");
   if (tgt != nullptr && cgt != nullptr && tgt != cgt)
     throw TemplateFunctionError("HeapPriorityQueue::copy constructor: both specified and different");
 
-  pq = new T[length];
+  pq = new_array(length);
   for (int i=0; i<to_copy.used; ++i)
     pq[i] = to_copy.pq[i];
 
@@ -177,15 +190,15 @@ HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const HeapPriorityQueue<T,tgt>& to_c
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b))
-: gt(tgt != nullptr ? tgt : cgt), length(il.size()) {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+HeapPriorityQueue<T,tgt,Alloc>::HeapPriorityQueue(const std::initializer_list<T>& il, bool (*cgt)(const T& a, const T& b), const Alloc& alloc)
+: gt(tgt != nullptr ? tgt : cgt), alloc(alloc), length(il.size()) {
   if (gt == nullptr)
     throw TemplateFunctionError("HeapPriorityQueue::initializer_list constructor: neither specified");
   if (tgt != nullptr && cgt != nullptr && tgt != cgt)
     throw TemplateFunctionError("HeapPriorityQueue::initializer_list constructor: both specified and different");
 
-  pq = new T[length];
+  pq = new_array(length);
   int i = 0;
   for (const T& pq_elem : il) {
     pq[i++] = pq_elem;
@@ -195,16 +208,16 @@ HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const std::initializer_list<T>& il,
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
 template<class Iterable>
-HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b))
-: gt(tgt != nullptr ? tgt : cgt), length(i.size()) {
+HeapPriorityQueue<T,tgt,Alloc>::HeapPriorityQueue(const Iterable& i, bool (*cgt)(const T& a, const T& b), const Alloc& alloc)
+: gt(tgt != nullptr ? tgt : cgt), alloc(alloc), length(i.size()) {
   if (gt == nullptr)
     throw TemplateFunctionError("HeapPriorityQueue::Iterable constructor: neither specified");
   if (tgt != nullptr && cgt != nullptr && tgt != cgt)
     throw TemplateFunctionError("HeapPriorityQueue::Iterable constructor: both specified and different");
 
-  pq = new T[length];
+  pq = new_array(length);
   int j = 0;
   for (const T& pq_elem : i) {
     pq[j++] = pq_elem;
@@ -218,20 +231,20 @@ HeapPriorityQueue<T,tgt>::HeapPriorityQueue(const Iterable& i, bool (*cgt)(const
 //
 //Queries
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::empty() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool HeapPriorityQueue<T,tgt,Alloc>::empty() const {
   return used == 0;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::size() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+int HeapPriorityQueue<T,tgt,Alloc>::size() const {
   return used;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& HeapPriorityQueue<T,tgt>::peek () const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T& HeapPriorityQueue<T,tgt,Alloc>::peek () const {
   if (empty())
     throw EmptyError("HeapPriorityQueue::peek");
 
@@ -239,8 +252,14 @@ T& HeapPriorityQueue<T,tgt>::peek () const {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string HeapPriorityQueue<T,tgt>::str() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+Alloc HeapPriorityQueue<T,tgt,Alloc>::get_allocator() const {
+  return alloc;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+std::string HeapPriorityQueue<T,tgt,Alloc>::str() const {
   std::ostringstream answer;
   answer << "HeapPriorityQueue[";
 
@@ -259,8 +278,8 @@ std::string HeapPriorityQueue<T,tgt>::str() const {
 //
 //Commands
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::enqueue(const T& element) {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+int HeapPriorityQueue<T,tgt,Alloc>::enqueue(const T& element) {
   this->ensure_length(used+1);
   pq[used++] = element;
 
@@ -270,8 +289,8 @@ int HeapPriorityQueue<T,tgt>::enqueue(const T& element) {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T HeapPriorityQueue<T,tgt>::dequeue() {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T HeapPriorityQueue<T,tgt,Alloc>::dequeue() {
   if (this->empty())
     throw EmptyError("HeapPriorityQueue::dequeue");
 
@@ -285,16 +304,16 @@ T HeapPriorityQueue<T,tgt>::dequeue() {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::clear() {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+void HeapPriorityQueue<T,tgt,Alloc>::clear() {
   used = 0;
   ++mod_count;
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
 template <class Iterable>
-int HeapPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
+int HeapPriorityQueue<T,tgt,Alloc>::enqueue_all (const Iterable& i) {
   int count = 0;
   for (const T& v : i)
      count += enqueue(v);
@@ -307,8 +326,8 @@ int HeapPriorityQueue<T,tgt>::enqueue_all (const Iterable& i) {
 //
 //Operators
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>& HeapPriorityQueue<T,tgt>::operator = (const HeapPriorityQueue<T,tgt>& rhs) {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+HeapPriorityQueue<T,tgt,Alloc>& HeapPriorityQueue<T,tgt,Alloc>::operator = (const HeapPriorityQueue<T,tgt,Alloc>& rhs) {
   if (this == &rhs)
     return *this;
 
@@ -323,15 +342,15 @@ HeapPriorityQueue<T,tgt>& HeapPriorityQueue<T,tgt>::operator = (const HeapPriori
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::operator == (const HeapPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool HeapPriorityQueue<T,tgt,Alloc>::operator == (const HeapPriorityQueue<T,tgt,Alloc>& rhs) const {
   if (this == &rhs)
     return true;
   if (gt != rhs.gt) //For PriorityQueues to be equal, they need the same gt function, and values
     return false;
   if (used != rhs.size())
     return false;
-  HeapPriorityQueue<T,tgt>::Iterator l = this->begin(), r = rhs.begin();
+  HeapPriorityQueue<T,tgt,Alloc>::Iterator l = this->begin(), r = rhs.begin();
   for (int i=0; i<used; ++i, ++l, ++r)
     if (*l != *r)
       return false;
@@ -340,14 +359,14 @@ bool HeapPriorityQueue<T,tgt>::operator == (const HeapPriorityQueue<T,tgt>& rhs)
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::operator != (const HeapPriorityQueue<T,tgt>& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool HeapPriorityQueue<T,tgt,Alloc>::operator != (const HeapPriorityQueue<T,tgt,Alloc>& rhs) const {
   return !(*this == rhs);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>& p) {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt,Alloc>& p) {
   outs << "priority_queue[";
 
   if (!p.empty()) {
@@ -366,15 +385,15 @@ std::ostream& operator << (std::ostream& outs, const HeapPriorityQueue<T,tgt>& p
 //
 //Iterator constructors
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::begin () const -> HeapPriorityQueue<T,tgt>::Iterator {
-    return Iterator(const_cast<HeapPriorityQueue<T,tgt>*>(this),true);
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+auto HeapPriorityQueue<T,tgt,Alloc>::begin () const -> HeapPriorityQueue<T,tgt,Alloc>::Iterator {
+    return Iterator(const_cast<HeapPriorityQueue<T,tgt,Alloc>*>(this),true);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::end () const -> HeapPriorityQueue<T,tgt>::Iterator {
-  return Iterator(const_cast<HeapPriorityQueue<T,tgt>*>(this));  //Create empty pq (size == 0)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+auto HeapPriorityQueue<T,tgt,Alloc>::end () const -> HeapPriorityQueue<T,tgt,Alloc>::Iterator {
+  return Iterator(const_cast<HeapPriorityQueue<T,tgt,Alloc>*>(this));  //Create empty pq (size == 0)
 }
 
 
@@ -382,50 +401,78 @@ auto HeapPriorityQueue<T,tgt>::end () const -> HeapPriorityQueue<T,tgt>::Iterato
 //
 //Private helper methods
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::ensure_length(int new_length) {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T* HeapPriorityQueue<T,tgt,Alloc>::new_array(int length) {
+  typedef std::allocator_traits<Alloc> Traits;
+  T* a = Traits::allocate(alloc,length);
+  int i = 0;
+  try {
+    for (/*i*/; i<length; ++i)
+      Traits::construct(alloc,a+i);
+  } catch (...) {
+    delete_array(a,i);
+    throw;
+  }
+  return a;
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+void HeapPriorityQueue<T,tgt,Alloc>::delete_array(T* a, int length) {
+  typedef std::allocator_traits<Alloc> Traits;
+  if (a == nullptr)
+    return;
+  for (int i=0; i<length; ++i)
+    Traits::destroy(alloc,a+i);
+  Traits::deallocate(alloc,a,length);
+}
+
+
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+void HeapPriorityQueue<T,tgt,Alloc>::ensure_length(int new_length) {
   if (length >= new_length)
     return;
-  T*  old_pq  = pq;
+  T*  old_pq     = pq;
+  int old_length = length;
   length = std::max(new_length,2*length);
-  pq = new T[length];
+  pq = new_array(length);
   for (int i=0; i<used; ++i)
     pq[i] = old_pq[i];
 
-  delete [] old_pq;
+  delete_array(old_pq,old_length);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::left_child(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+int HeapPriorityQueue<T,tgt,Alloc>::left_child(int i) const
 {return 2*i+1;}
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::right_child(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+int HeapPriorityQueue<T,tgt,Alloc>::right_child(int i) const
 {return 2*i+2;}
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-int HeapPriorityQueue<T,tgt>::parent(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+int HeapPriorityQueue<T,tgt,Alloc>::parent(int i) const
 {return (i-1)/2;}
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::is_root(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool HeapPriorityQueue<T,tgt,Alloc>::is_root(int i) const
 {return i == 0;}
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::in_heap(int i) const
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool HeapPriorityQueue<T,tgt,Alloc>::in_heap(int i) const
 {return i < used;}
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::percolate_up(int i) {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+void HeapPriorityQueue<T,tgt,Alloc>::percolate_up(int i) {
   for (/*parameter*/; !is_root(i) && gt(pq[i],pq[parent(i)]); i = parent(i))
     std::swap(pq[parent(i)],pq[i]);
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::percolate_down(int i) {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+void HeapPriorityQueue<T,tgt,Alloc>::percolate_down(int i) {
   for (int l = left_child(i); in_heap(l); l = left_child(i)) {
     int r = right_child(i);
     int max_child = (!in_heap(r) || gt(pq[l],pq[r]) ? l : r);
@@ -438,8 +485,8 @@ void HeapPriorityQueue<T,tgt>::percolate_down(int i) {
 
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-void HeapPriorityQueue<T,tgt>::heapify() {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+void HeapPriorityQueue<T,tgt,Alloc>::heapify() {
 for (int i = used-1; i >= 0; --i)
   percolate_down(i);
 }
@@ -449,27 +496,27 @@ for (int i = used-1; i >= 0; --i)
 //
 //Iterator class definitions
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::Iterator(HeapPriorityQueue<T,tgt>* iterate_over, bool tgt_nullptr)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+HeapPriorityQueue<T,tgt,Alloc>::Iterator::Iterator(HeapPriorityQueue<T,tgt,Alloc>* iterate_over, bool tgt_nullptr)
 : it(*iterate_over,iterate_over->gt), ref_pq(iterate_over), expected_mod_count(iterate_over->mod_count) {
   // Full priority queue; use copy constructor
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::Iterator(HeapPriorityQueue<T,tgt>* iterate_over)
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+HeapPriorityQueue<T,tgt,Alloc>::Iterator::Iterator(HeapPriorityQueue<T,tgt,Alloc>* iterate_over)
 : it(iterate_over->gt), ref_pq(iterate_over), expected_mod_count(iterate_over->mod_count) {
   // Empty priority queue; use default constructor (from declaration of "it")
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-HeapPriorityQueue<T,tgt>::Iterator::~Iterator()
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+HeapPriorityQueue<T,tgt,Alloc>::Iterator::~Iterator()
 {}
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T HeapPriorityQueue<T,tgt>::Iterator::erase() {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T HeapPriorityQueue<T,tgt,Alloc>::Iterator::erase() {
   if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::erase");
   if (!can_erase)
@@ -494,8 +541,8 @@ T HeapPriorityQueue<T,tgt>::Iterator::erase() {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-std::string HeapPriorityQueue<T,tgt>::Iterator::str() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+std::string HeapPriorityQueue<T,tgt,Alloc>::Iterator::str() const {
   std::ostringstream answer;
   answer << it.str() << "/expected_mod_count=" << expected_mod_count << "/can_erase=" << can_erase;
   return answer.str();
@@ -503,8 +550,8 @@ std::string HeapPriorityQueue<T,tgt>::Iterator::str() const {
 
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ () -> HeapPriorityQueue<T,tgt>::Iterator& {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+auto HeapPriorityQueue<T,tgt,Alloc>::Iterator::operator ++ () -> HeapPriorityQueue<T,tgt,Alloc>::Iterator& {
 if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator ++");
 
@@ -520,8 +567,8 @@ if (expected_mod_count != ref_pq->mod_count)
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> HeapPriorityQueue<T,tgt>::Iterator {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+auto HeapPriorityQueue<T,tgt,Alloc>::Iterator::operator ++ (int) -> HeapPriorityQueue<T,tgt,Alloc>::Iterator {
   if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator ++(int)");
 
@@ -538,8 +585,8 @@ auto HeapPriorityQueue<T,tgt>::Iterator::operator ++ (int) -> HeapPriorityQueue<
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::Iterator::operator == (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool HeapPriorityQueue<T,tgt,Alloc>::Iterator::operator == (const HeapPriorityQueue<T,tgt,Alloc>::Iterator& rhs) const {
   const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
   if (rhsASI == 0)
     throw IteratorTypeError("HeapPriorityQueue::Iterator::operator ==");
@@ -553,8 +600,8 @@ bool HeapPriorityQueue<T,tgt>::Iterator::operator == (const HeapPriorityQueue<T,
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-bool HeapPriorityQueue<T,tgt>::Iterator::operator != (const HeapPriorityQueue<T,tgt>::Iterator& rhs) const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+bool HeapPriorityQueue<T,tgt,Alloc>::Iterator::operator != (const HeapPriorityQueue<T,tgt,Alloc>::Iterator& rhs) const {
   const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
   if (rhsASI == 0)
     throw IteratorTypeError("HeapPriorityQueue::Iterator::operator !=");
@@ -567,8 +614,8 @@ bool HeapPriorityQueue<T,tgt>::Iterator::operator != (const HeapPriorityQueue<T,
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T& HeapPriorityQueue<T,tgt>::Iterator::operator *() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T& HeapPriorityQueue<T,tgt,Alloc>::Iterator::operator *() const {
   if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator *");
   if (!can_erase || it.empty())
@@ -578,8 +625,8 @@ T& HeapPriorityQueue<T,tgt>::Iterator::operator *() const {
 }
 
 
-template<class T, bool (*tgt)(const T& a, const T& b)>
-T* HeapPriorityQueue<T,tgt>::Iterator::operator ->() const {
+template<class T, bool (*tgt)(const T& a, const T& b), class Alloc>
+T* HeapPriorityQueue<T,tgt,Alloc>::Iterator::operator ->() const {
   if (expected_mod_count != ref_pq->mod_count)
     throw ConcurrentModificationError("HeapPriorityQueue::Iterator::operator *");
   if (!can_erase || it.empty())
@@ -588,6 +635,16 @@ T* HeapPriorityQueue<T,tgt>::Iterator::operator ->() const {
   return &it.peek();
 }
 
+
+#if __cplusplus >= 201703L
+namespace pmr {
+  //HeapPriorityQueue whose array comes from a std::pmr::memory_resource: pass
+  //  std::pmr::polymorphic_allocator<T>(&resource) as the last constructor argument
+  template<class T, bool (*tgt)(const T& a, const T& b) = nullptr>
+  using HeapPriorityQueue = ics::HeapPriorityQueue<T,tgt,std::pmr::polymorphic_allocator<T>>;
+}
+#endif
+
 }
 
 #endif /* HEAP_PRIORITY_QUEUE_HPP_ */
@@ -0,0 +1,995 @@
+#ifndef ROARING_SET_HPP_
+#define ROARING_SET_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <initializer_list>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <cstdint>
+#ifdef __SSE2__
+#include <emmintrin.h>        //For 128 bits of bitmap (8 array values) per instruction
+#endif
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//A set of integers (T: int, unsigned, short, ...: at most 32 bits) with the HashSet interface,
+//  stored as a Roaring bitmap: for sets of many, mostly dense, values (e.g., ids) instead of
+//  a HashSet's LN node per value.
+//Values are split by their high 16 bits into chunks of 65536 possible values. Each chunk
+//  present is a Container (kept in a vector sorted by those bits) holding its low 16 bits:
+//  either a sorted array of them (2 bytes per value, while there are at most 4096) or a
+//  bitmap of all 65536 (8KB, whatever the number of values). So a set uses at most about 2
+//  bytes per value, and 1/8 of a byte per value when its chunks are full.
+//insert_all/erase_all/retain_all/relations with another RoaringSet work chunk by chunk, not
+//  value by value: a bitmap with a bitmap is a loop of AND/OR/AND-NOT over 1024 64-bit words
+//  (128 bits per instruction with SSE2), and arrays are intersected 8 values against 8.
+//  With any other Iterable they insert/erase/check one value at a time, as HashSet does.
+//Iterators produce the values in increasing order, as T values (not references).
+template<class T = int> class RoaringSet {
+  static_assert(std::is_integral<T>::value && sizeof(T) <= 4, "RoaringSet: T must be an integral type of at most 32 bits");
+
+  public:
+    //Destructor/Constructors
+    ~RoaringSet ();
+
+    RoaringSet          ();
+    RoaringSet          (const RoaringSet<T>& to_copy);
+    explicit RoaringSet (const std::initializer_list<T>& il);
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    explicit RoaringSet (const Iterable& i);
+
+
+    //Queries
+    bool empty      () const;
+    int  size       () const;
+    bool contains   (const T& element) const;
+    long bytes      () const;   //Memory used (this object, its containers, and their arrays/bitmaps)
+    std::string str () const; //supplies useful debugging information; contrast to operator <<
+
+    //Iterable class must support "for-each" loop: .begin()/.end() and prefix ++ on returned result
+    template <class Iterable>
+    bool contains_all (const Iterable& i) const;
+    bool contains_all (const RoaringSet<T>& s) const;
+
+
+    //Commands
+    int  insert (const T& element);
+    int  erase  (const T& element);
+    void clear  ();
+
+    //Iterable class must support "for" loop: .begin()/.end() and prefix ++ on returned result
+
+    template <class Iterable>
+    int insert_all(const Iterable& i);
+    int insert_all(const RoaringSet<T>& s);
+
+    template <class Iterable>
+    int erase_all(const Iterable& i);
+    int erase_all(const RoaringSet<T>& s);
+
+    template<class Iterable>
+    int retain_all(const Iterable& i);
+    int retain_all(const RoaringSet<T>& s);
+
+
+    //Operators
+    RoaringSet<T>& operator = (const RoaringSet<T>& rhs);
+    bool operator == (const RoaringSet<T>& rhs) const;
+    bool operator != (const RoaringSet<T>& rhs) const;
+    bool operator <= (const RoaringSet<T>& rhs) const;
+    bool operator <  (const RoaringSet<T>& rhs) const;
+    bool operator >= (const RoaringSet<T>& rhs) const;
+    bool operator >  (const RoaringSet<T>& rhs) const;
+
+    template<class T2>
+    friend std::ostream& operator << (std::ostream& outs, const RoaringSet<T2>& s);
+
+
+    class Iterator {
+      public:
+        //Private constructor called in begin/end, which are friends of RoaringSet<T>
+        ~Iterator();
+        T           erase();
+        std::string str  () const;
+        RoaringSet<T>::Iterator& operator ++ ();
+        RoaringSet<T>::Iterator  operator ++ (int);
+        bool operator == (const RoaringSet<T>::Iterator& rhs) const;
+        bool operator != (const RoaringSet<T>::Iterator& rhs) const;
+        T operator *  () const;
+        friend std::ostream& operator << (std::ostream& outs, const RoaringSet<T>::Iterator& i) {
+          outs << i.str(); //Use the same meaning as the debugging .str() method
+          return outs;
+        }
+        friend Iterator RoaringSet<T>::begin () const;
+        friend Iterator RoaringSet<T>::end   () const;
+
+      private:
+        //container == containers.size() at the end; index is a position in an array container
+        //  or a bit number in a bitmap container
+        //If can_erase is false, the cursor indexes the "next" value (must ++ to reach it)
+        int            container;
+        int            index;
+        RoaringSet<T>* ref_set;
+        int            expected_mod_count;
+        bool           can_erase = true;
+
+        //Helper methods
+        void advance();                   //Go on to the next value (or the end)
+        void seek(std::uint64_t code);    //Go to the first value whose code is >= code (or the end)
+
+        //Called in friends begin/end
+        Iterator(RoaringSet<T>* iterate_over, bool from_begin);
+    };
+
+
+    Iterator begin () const;
+    Iterator end   () const;
+
+
+  private:
+    static const int array_max = 4096;     //An array container with more values becomes a bitmap
+    static const int words     = 1024;     //64-bit words in a bitmap container (65536 bits)
+
+    class Container {
+      public:
+        Container (std::uint16_t h = 0) : high(h) {}
+
+        std::uint16_t              high;            //The high 16 bits of every value in it
+        int                        cardinality = 0;
+        std::vector<std::uint16_t> array;           //The low 16 bits in increasing order, or
+        std::vector<std::uint64_t> bitmap;          //  (if not empty) bit low set for each
+
+        bool is_bitmap() const {return !bitmap.empty();}
+        bool contains (std::uint16_t low) const;
+        bool insert   (std::uint16_t low);          //Whether low was not already in it
+        bool erase    (std::uint16_t low);          //Whether low was in it
+        void fit      ();                           //Array iff cardinality <= array_max
+        long bytes    () const;
+        bool operator == (const Container& rhs) const;
+    };
+
+  std::vector<Container> containers;     //Increasing by high; none empty
+  int used      = 0;                     //Cache for number of values in the set
+  int mod_count = 0;                     //For sensing concurrent modification
+
+
+  //Helper methods
+  static std::uint32_t code  (T value);              //value's bits, ordered like the values (signed: sign bit flipped)
+  static T             value (std::uint32_t code);
+  int   find_container (std::uint16_t high) const;   //Index of high's container, or -1
+
+  //Container set algebra (results fitted); the static ones leave their arguments alone
+  static int  popcount       (const std::vector<std::uint64_t>& bitmap);
+  static void to_bitmap      (Container& c);
+  static void to_array       (Container& c);
+  static void unite          (Container& into, const Container& c);   //into |= c
+  static void subtract       (Container& from, const Container& c);   //from -= c
+  static void intersect      (Container& into, const Container& c);   //into &= c
+  static bool subset         (const Container& a, const Container& b); //a <= b
+  static void intersect_arrays(const std::vector<std::uint16_t>& a, const std::vector<std::uint16_t>& b, std::vector<std::uint16_t>& answer);
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//RoaringSet class and related definitions
+
+template<class T>
+const int RoaringSet<T>::array_max;
+
+template<class T>
+const int RoaringSet<T>::words;
+
+
+//Destructor/Constructors
+
+template<class T>
+RoaringSet<T>::~RoaringSet() {
+}
+
+
+template<class T>
+RoaringSet<T>::RoaringSet() {
+}
+
+
+template<class T>
+RoaringSet<T>::RoaringSet(const RoaringSet<T>& to_copy)
+: containers(to_copy.containers), used(to_copy.used) {
+}
+
+
+template<class T>
+RoaringSet<T>::RoaringSet(const std::initializer_list<T>& il) {
+  for (const T& element : il)
+    insert(element);
+}
+
+
+template<class T>
+template<class Iterable>
+RoaringSet<T>::RoaringSet(const Iterable& i) {
+  insert_all(i);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T>
+bool RoaringSet<T>::empty() const {
+  return used == 0;
+}
+
+
+template<class T>
+int RoaringSet<T>::size() const {
+  return used;
+}
+
+
+template<class T>
+bool RoaringSet<T>::contains (const T& element) const {
+  std::uint32_t c = code(element);
+  int i = find_container(c >> 16);
+  return i != -1 && containers[i].contains(c & 0xFFFF);
+}
+
+
+template<class T>
+long RoaringSet<T>::bytes() const {
+  long answer = sizeof(RoaringSet<T>) + containers.capacity()*sizeof(Container);
+  for (const Container& c : containers)
+    answer += c.bytes();
+  return answer;
+}
+
+
+template<class T>
+std::string RoaringSet<T>::str() const {
+  std::ostringstream answer;
+  answer << "RoaringSet[";
+  for (const Container& c : containers)
+    answer << std::endl << "  high " << c.high << ": " << (c.is_bitmap() ? "bitmap" : "array")
+           << " of " << c.cardinality << " (" << c.bytes() << " bytes)";
+  answer << "](used=" << used << ",containers=" << containers.size() << ",bytes=" << bytes()
+         << ",mod_count=" << mod_count << ")";
+  return answer.str();
+}
+
+
+template<class T>
+template <class Iterable>
+bool RoaringSet<T>::contains_all(const Iterable& i) const {
+  for (const T& v : i)
+    if (!contains(v))
+      return false;
+  return true;
+}
+
+
+template<class T>
+bool RoaringSet<T>::contains_all(const RoaringSet<T>& s) const {
+  return s <= *this;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T>
+int RoaringSet<T>::insert(const T& element) {
+  std::uint32_t c = code(element);
+  std::uint16_t high = c >> 16;
+  typename std::vector<Container>::iterator i = std::lower_bound(containers.begin(), containers.end(), high,
+      [] (const Container& container, std::uint16_t h) {return container.high < h;});
+  if (i == containers.end() || i->high != high)
+    i = containers.insert(i, Container(high));
+  if (!i->insert(c & 0xFFFF))
+    return 0;
+  ++used;
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T>
+int RoaringSet<T>::erase(const T& element) {
+  std::uint32_t c = code(element);
+  int i = find_container(c >> 16);
+  if (i == -1 || !containers[i].erase(c & 0xFFFF))
+    return 0;
+  if (containers[i].cardinality == 0)
+    containers.erase(containers.begin()+i);
+  --used;
+  ++mod_count;
+  return 1;
+}
+
+
+template<class T>
+void RoaringSet<T>::clear() {
+  containers.clear();
+  used = 0;
+  ++mod_count;
+}
+
+
+template<class T>
+template<class Iterable>
+int RoaringSet<T>::insert_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    count += insert(v);
+  return count;
+}
+
+
+//Merge the two sorted container vectors: uniting the containers both have
+template<class T>
+int RoaringSet<T>::insert_all(const RoaringSet<T>& s) {
+  if (this == &s)
+    return 0;
+  std::vector<Container> answer;
+  answer.reserve(containers.size() + s.containers.size());
+  int old_used = used;
+  used = 0;
+  std::size_t a = 0, b = 0;
+  while (a < containers.size() || b < s.containers.size()) {
+    if (b == s.containers.size() || (a < containers.size() && containers[a].high < s.containers[b].high))
+      answer.push_back(std::move(containers[a++]));
+    else if (a == containers.size() || s.containers[b].high < containers[a].high)
+      answer.push_back(s.containers[b++]);
+    else {
+      answer.push_back(std::move(containers[a++]));
+      unite(answer.back(), s.containers[b++]);
+    }
+    used += answer.back().cardinality;
+  }
+  containers.swap(answer);
+  ++mod_count;
+  return used - old_used;
+}
+
+
+template<class T>
+template<class Iterable>
+int RoaringSet<T>::erase_all(const Iterable& i) {
+  int count = 0;
+  for (const T& v : i)
+    count += erase(v);
+  return count;
+}
+
+
+template<class T>
+int RoaringSet<T>::erase_all(const RoaringSet<T>& s) {
+  if (this == &s) {
+    int count = used;
+    clear();
+    return count;
+  }
+  int old_used = used;
+  used = 0;
+  std::size_t kept = 0, b = 0;
+  for (std::size_t a = 0; a < containers.size(); ++a) {
+    while (b < s.containers.size() && s.containers[b].high < containers[a].high)
+      ++b;
+    if (b < s.containers.size() && s.containers[b].high == containers[a].high)
+      subtract(containers[a], s.containers[b]);
+    if (containers[a].cardinality > 0) {
+      used += containers[a].cardinality;
+      if (kept != a)
+        containers[kept] = std::move(containers[a]);
+      ++kept;
+    }
+  }
+  containers.resize(kept);
+  ++mod_count;
+  return old_used - used;
+}
+
+
+template<class T>
+template<class Iterable>
+int RoaringSet<T>::retain_all(const Iterable& i) {
+  RoaringSet<T> keep(i);
+  return retain_all(keep);
+}
+
+
+template<class T>
+int RoaringSet<T>::retain_all(const RoaringSet<T>& s) {
+  if (this == &s)
+    return 0;
+  int old_used = used;
+  used = 0;
+  std::size_t kept = 0, b = 0;
+  for (std::size_t a = 0; a < containers.size(); ++a) {
+    while (b < s.containers.size() && s.containers[b].high < containers[a].high)
+      ++b;
+    if (b == s.containers.size() || s.containers[b].high != containers[a].high)
+      continue;
+    intersect(containers[a], s.containers[b]);
+    if (containers[a].cardinality > 0) {
+      used += containers[a].cardinality;
+      if (kept != a)
+        containers[kept] = std::move(containers[a]);
+      ++kept;
+    }
+  }
+  containers.resize(kept);
+  ++mod_count;
+  return old_used - used;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Operators
+
+template<class T>
+RoaringSet<T>& RoaringSet<T>::operator = (const RoaringSet<T>& rhs) {
+  if (this == &rhs)
+    return *this;
+  containers = rhs.containers;
+  used       = rhs.used;
+  ++mod_count;
+  return *this;
+}
+
+
+//Containers are always fitted, so equal sets have equal containers
+template<class T>
+bool RoaringSet<T>::operator == (const RoaringSet<T>& rhs) const {
+  if (this == &rhs)
+    return true;
+  return used == rhs.used && containers == rhs.containers;
+}
+
+
+template<class T>
+bool RoaringSet<T>::operator != (const RoaringSet<T>& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T>
+bool RoaringSet<T>::operator <= (const RoaringSet<T>& rhs) const {
+  if (this == &rhs)
+    return true;
+  if (used > rhs.used)
+    return false;
+  std::size_t b = 0;
+  for (const Container& c : containers) {
+    while (b < rhs.containers.size() && rhs.containers[b].high < c.high)
+      ++b;
+    if (b == rhs.containers.size() || rhs.containers[b].high != c.high || !subset(c, rhs.containers[b]))
+      return false;
+  }
+  return true;
+}
+
+
+template<class T>
+bool RoaringSet<T>::operator < (const RoaringSet<T>& rhs) const {
+  if (this == &rhs)
+    return false;
+  return used < rhs.used && *this <= rhs;
+}
+
+
+template<class T>
+bool RoaringSet<T>::operator >= (const RoaringSet<T>& rhs) const {
+  return rhs <= *this;
+}
+
+
+template<class T>
+bool RoaringSet<T>::operator > (const RoaringSet<T>& rhs) const {
+  return rhs < *this;
+}
+
+
+template<class T>
+std::ostream& operator << (std::ostream& outs, const RoaringSet<T>& s) {
+  outs << "set[";
+  bool first = true;
+  for (T v : s) {
+    outs << (first ? "" : ",") << v;
+    first = false;
+  }
+  outs << "]";
+  return outs;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator constructors
+
+template<class T>
+auto RoaringSet<T>::begin () const -> RoaringSet<T>::Iterator {
+  return Iterator(const_cast<RoaringSet<T>*>(this),true);
+}
+
+
+template<class T>
+auto RoaringSet<T>::end () const -> RoaringSet<T>::Iterator {
+  return Iterator(const_cast<RoaringSet<T>*>(this),false);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Container definitions
+
+template<class T>
+bool RoaringSet<T>::Container::contains (std::uint16_t low) const {
+  if (is_bitmap())
+    return (bitmap[low >> 6] >> (low & 63)) & 1;
+  return std::binary_search(array.begin(), array.end(), low);
+}
+
+
+template<class T>
+bool RoaringSet<T>::Container::insert (std::uint16_t low) {
+  if (is_bitmap()) {
+    std::uint64_t& word = bitmap[low >> 6];
+    std::uint64_t  bit  = std::uint64_t(1) << (low & 63);
+    if (word & bit)
+      return false;
+    word |= bit;
+  } else {
+    std::vector<std::uint16_t>::iterator i = std::lower_bound(array.begin(), array.end(), low);
+    if (i != array.end() && *i == low)
+      return false;
+    array.insert(i, low);
+  }
+  ++cardinality;
+  fit();
+  return true;
+}
+
+
+template<class T>
+bool RoaringSet<T>::Container::erase (std::uint16_t low) {
+  if (is_bitmap()) {
+    std::uint64_t& word = bitmap[low >> 6];
+    std::uint64_t  bit  = std::uint64_t(1) << (low & 63);
+    if (!(word & bit))
+      return false;
+    word &= ~bit;
+  } else {
+    std::vector<std::uint16_t>::iterator i = std::lower_bound(array.begin(), array.end(), low);
+    if (i == array.end() || *i != low)
+      return false;
+    array.erase(i);
+  }
+  --cardinality;
+  fit();
+  return true;
+}
+
+
+template<class T>
+void RoaringSet<T>::Container::fit () {
+  if (is_bitmap() && cardinality <= array_max)
+    to_array(*this);
+  else if (!is_bitmap() && cardinality > array_max)
+    to_bitmap(*this);
+}
+
+
+template<class T>
+long RoaringSet<T>::Container::bytes () const {
+  return array.capacity()*sizeof(std::uint16_t) + bitmap.capacity()*sizeof(std::uint64_t);
+}
+
+
+template<class T>
+bool RoaringSet<T>::Container::operator == (const Container& rhs) const {
+  return high == rhs.high && cardinality == rhs.cardinality && array == rhs.array && bitmap == rhs.bitmap;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T>
+std::uint32_t RoaringSet<T>::code (T value) {
+  return std::is_signed<T>::value ? std::uint32_t(std::int32_t(value)) ^ 0x80000000u : std::uint32_t(value);
+}
+
+
+template<class T>
+T RoaringSet<T>::value (std::uint32_t code) {
+  return std::is_signed<T>::value ? T(std::int32_t(code ^ 0x80000000u)) : T(code);
+}
+
+
+template<class T>
+int RoaringSet<T>::find_container (std::uint16_t high) const {
+  typename std::vector<Container>::const_iterator i = std::lower_bound(containers.begin(), containers.end(), high,
+      [] (const Container& container, std::uint16_t h) {return container.high < h;});
+  return i == containers.end() || i->high != high ? -1 : int(i - containers.begin());
+}
+
+
+template<class T>
+int RoaringSet<T>::popcount (const std::vector<std::uint64_t>& bitmap) {
+  int answer = 0;
+  for (std::uint64_t word : bitmap)
+    answer += __builtin_popcountll(word);
+  return answer;
+}
+
+
+template<class T>
+void RoaringSet<T>::to_bitmap (Container& c) {
+  c.bitmap.assign(words, 0);
+  for (std::uint16_t low : c.array)
+    c.bitmap[low >> 6] |= std::uint64_t(1) << (low & 63);
+  std::vector<std::uint16_t>().swap(c.array);
+}
+
+
+template<class T>
+void RoaringSet<T>::to_array (Container& c) {
+  c.array.clear();
+  c.array.reserve(c.cardinality);
+  for (int w = 0; w < words; ++w)
+    for (std::uint64_t word = c.bitmap[w]; word != 0; word &= word-1)
+      c.array.push_back(std::uint16_t(w*64 + __builtin_ctzll(word)));
+  std::vector<std::uint64_t>().swap(c.bitmap);
+}
+
+
+//OR of two bitmaps, 128 bits at a time with SSE2
+template<class T>
+void RoaringSet<T>::unite (Container& into, const Container& c) {
+  if (!into.is_bitmap() && !c.is_bitmap()) {
+    std::vector<std::uint16_t> answer(into.array.size() + c.array.size());
+    answer.resize(std::set_union(into.array.begin(), into.array.end(), c.array.begin(), c.array.end(), answer.begin()) - answer.begin());
+    into.array.swap(answer);
+    into.cardinality = into.array.size();
+  } else {
+    if (!into.is_bitmap())
+      to_bitmap(into);
+    if (c.is_bitmap()) {
+      std::uint64_t*       a = into.bitmap.data();
+      const std::uint64_t* b = c.bitmap.data();
+#ifdef __SSE2__
+      for (int w = 0; w < words; w += 2)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(a+w), _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a+w)),
+                                                                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(b+w))));
+#else
+      for (int w = 0; w < words; ++w)
+        a[w] |= b[w];
+#endif
+    } else
+      for (std::uint16_t low : c.array)
+        into.bitmap[low >> 6] |= std::uint64_t(1) << (low & 63);
+    into.cardinality = popcount(into.bitmap);
+  }
+  into.fit();
+}
+
+
+//AND-NOT of two bitmaps, 128 bits at a time with SSE2
+template<class T>
+void RoaringSet<T>::subtract (Container& from, const Container& c) {
+  if (from.is_bitmap() && c.is_bitmap()) {
+    std::uint64_t*       a = from.bitmap.data();
+    const std::uint64_t* b = c.bitmap.data();
+#ifdef __SSE2__
+    for (int w = 0; w < words; w += 2)
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(a+w), _mm_andnot_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b+w)),
+                                                                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(a+w))));
+#else
+    for (int w = 0; w < words; ++w)
+      a[w] &= ~b[w];
+#endif
+    from.cardinality = popcount(from.bitmap);
+  } else if (from.is_bitmap()) {
+    for (std::uint16_t low : c.array)
+      from.bitmap[low >> 6] &= ~(std::uint64_t(1) << (low & 63));
+    from.cardinality = popcount(from.bitmap);
+  } else {
+    std::size_t kept = 0;
+    for (std::uint16_t low : from.array)
+      if (!c.contains(low))
+        from.array[kept++] = low;
+    from.array.resize(kept);
+    from.cardinality = kept;
+  }
+  from.fit();
+}
+
+
+//AND of two bitmaps, 128 bits at a time with SSE2; of two arrays, by intersect_arrays
+template<class T>
+void RoaringSet<T>::intersect (Container& into, const Container& c) {
+  if (into.is_bitmap() && c.is_bitmap()) {
+    std::uint64_t*       a = into.bitmap.data();
+    const std::uint64_t* b = c.bitmap.data();
+#ifdef __SSE2__
+    for (int w = 0; w < words; w += 2)
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(a+w), _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a+w)),
+                                                                      _mm_loadu_si128(reinterpret_cast<const __m128i*>(b+w))));
+#else
+    for (int w = 0; w < words; ++w)
+      a[w] &= b[w];
+#endif
+    into.cardinality = popcount(into.bitmap);
+  } else if (into.is_bitmap()) {       //The answer is at most c's array: build it from that
+    std::vector<std::uint16_t> answer;
+    answer.reserve(c.array.size());
+    for (std::uint16_t low : c.array)
+      if (into.contains(low))
+        answer.push_back(low);
+    std::vector<std::uint64_t>().swap(into.bitmap);
+    into.array.swap(answer);
+    into.cardinality = into.array.size();
+  } else if (c.is_bitmap()) {
+    std::size_t kept = 0;
+    for (std::uint16_t low : into.array)
+      if (c.contains(low))
+        into.array[kept++] = low;
+    into.array.resize(kept);
+    into.cardinality = kept;
+  } else {
+    std::vector<std::uint16_t> answer;
+    intersect_arrays(into.array, c.array, answer);
+    into.array.swap(answer);
+    into.cardinality = into.array.size();
+  }
+  into.fit();
+}
+
+
+template<class T>
+bool RoaringSet<T>::subset (const Container& a, const Container& b) {
+  if (a.cardinality > b.cardinality)
+    return false;
+  if (a.is_bitmap()) {                 //b is too (it has more values)
+    for (int w = 0; w < words; ++w)
+      if (a.bitmap[w] & ~b.bitmap[w])
+        return false;
+    return true;
+  }
+  if (b.is_bitmap()) {
+    for (std::uint16_t low : a.array)
+      if (!b.contains(low))
+        return false;
+    return true;
+  }
+  return std::includes(b.array.begin(), b.array.end(), a.array.begin(), a.array.end());
+}
+
+
+//With SSE2: compare a block of 8 values of a with all 8 rotations of a block of 8 of b (every
+//  pair of values compared in 8 instructions), keep a's matching values, and then move past
+//  the block(s) with the smaller last value. The rest (fewer than 8 left in a or b) one by one.
+template<class T>
+void RoaringSet<T>::intersect_arrays (const std::vector<std::uint16_t>& a, const std::vector<std::uint16_t>& b, std::vector<std::uint16_t>& answer) {
+  answer.clear();
+  answer.reserve(std::min(a.size(), b.size()));
+  std::size_t i = 0, j = 0;
+#ifdef __SSE2__
+  while (i+8 <= a.size() && j+8 <= b.size()) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.data()+i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data()+j));
+    #define ICS_ROTATE(v,n) _mm_or_si128(_mm_srli_si128(v,2*n), _mm_slli_si128(v,16-2*n))
+    __m128i match = _mm_or_si128(
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(va, vb),                _mm_cmpeq_epi16(va, ICS_ROTATE(vb,1))),
+                     _mm_or_si128(_mm_cmpeq_epi16(va, ICS_ROTATE(vb,2)),  _mm_cmpeq_epi16(va, ICS_ROTATE(vb,3)))),
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(va, ICS_ROTATE(vb,4)),  _mm_cmpeq_epi16(va, ICS_ROTATE(vb,5))),
+                     _mm_or_si128(_mm_cmpeq_epi16(va, ICS_ROTATE(vb,6)),  _mm_cmpeq_epi16(va, ICS_ROTATE(vb,7)))));
+    #undef ICS_ROTATE
+    for (int bits = _mm_movemask_epi8(match); bits != 0; bits &= bits-1) {
+      int byte = __builtin_ctz(bits);
+      answer.push_back(a[i + byte/2]);
+      bits &= bits-1;                  //each matching 16-bit value sets 2 mask bits
+    }
+    std::uint16_t a_last = a[i+7], b_last = b[j+7];
+    if (a_last <= b_last)
+      i += 8;
+    if (b_last <= a_last)
+      j += 8;
+  }
+#endif
+  while (i < a.size() && j < b.size())
+    if (a[i] < b[j])
+      ++i;
+    else if (b[j] < a[i])
+      ++j;
+    else {
+      answer.push_back(a[i]);
+      ++i;
+      ++j;
+    }
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Iterator class definitions
+
+template<class T>
+void RoaringSet<T>::Iterator::advance() {
+  const std::vector<Container>& cs = ref_set->containers;
+  if (container == int(cs.size()))
+    return;
+  const Container& c = cs[container];
+  if (!c.is_bitmap()) {
+    if (++index < int(c.array.size()))
+      return;
+  } else if (index < 65535) {
+    int w = (index+1) >> 6;
+    std::uint64_t word = c.bitmap[w] & (~std::uint64_t(0) << ((index+1) & 63));
+    while (word == 0 && ++w < words)
+      word = c.bitmap[w];
+    if (w < words) {
+      index = w*64 + __builtin_ctzll(word);
+      return;
+    }
+  }
+  ++container;                          //Every container has a value: the next one's first
+  if (container < int(cs.size()))
+    seek(std::uint64_t(cs[container].high) << 16);
+}
+
+
+template<class T>
+void RoaringSet<T>::Iterator::seek(std::uint64_t code) {
+  const std::vector<Container>& cs = ref_set->containers;
+  for (container = 0; container < int(cs.size()) && (std::uint64_t(cs[container].high) << 16 | 0xFFFF) < code; ++container)
+    ;
+  if (container == int(cs.size()))
+    return;
+  const Container& c = cs[container];
+  std::uint16_t low = (std::uint64_t(c.high) << 16) < code ? std::uint16_t(code & 0xFFFF) : 0;
+  if (!c.is_bitmap()) {
+    index = std::lower_bound(c.array.begin(), c.array.end(), low) - c.array.begin();
+    if (index == int(c.array.size()))   //Nothing >= low here: the next container's first
+      seek(std::uint64_t(c.high+1) << 16);
+  } else {
+    index = low;
+    if (!c.contains(low)) {
+      --index;                          //advance() moves to the first value after index
+      if (index == -1) {                //(low == 0 is not in it: find the first set bit)
+        int w = 0;
+        while (c.bitmap[w] == 0)
+          ++w;
+        index = w*64 + __builtin_ctzll(c.bitmap[w]);
+      } else
+        advance();
+    }
+  }
+}
+
+
+template<class T>
+RoaringSet<T>::Iterator::Iterator(RoaringSet<T>* iterate_over, bool begin)
+: container(iterate_over->containers.size()), index(0), ref_set(iterate_over), expected_mod_count(iterate_over->mod_count)
+{
+  if (begin)
+    seek(0);
+}
+
+
+template<class T>
+RoaringSet<T>::Iterator::~Iterator()
+{}
+
+
+template<class T>
+T RoaringSet<T>::Iterator::erase() {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("RoaringSet::Iterator::erase");
+  if (!can_erase)
+    throw CannotEraseError("RoaringSet::Iterator::erase Iterator cursor already erased");
+  if (container == int(ref_set->containers.size()))
+    throw CannotEraseError("RoaringSet::Iterator::erase Iterator cursor beyond data structure");
+
+  //Erasing may turn the container into an array or remove it: find the "next" value again
+  T to_return = **this;
+  can_erase = false;
+  ref_set->erase(to_return);
+  expected_mod_count = ref_set->mod_count;
+  seek(std::uint64_t(code(to_return)) + 1);
+  return to_return;
+}
+
+
+template<class T>
+std::string RoaringSet<T>::Iterator::str() const {
+  std::ostringstream answer;
+  answer << ref_set->str() << "(current=" << container << "/" << index
+         << ",expected_mod_count=" << expected_mod_count << ",can_erase=" << can_erase << ")";
+  return answer.str();
+}
+
+
+template<class T>
+auto  RoaringSet<T>::Iterator::operator ++ () -> RoaringSet<T>::Iterator& {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("RoaringSet::Iterator::operator ++");
+
+  if (container == int(ref_set->containers.size()))
+    return *this;
+  if (can_erase)
+    advance();
+  else
+    can_erase = true;
+  return *this;
+}
+
+
+template<class T>
+auto  RoaringSet<T>::Iterator::operator ++ (int) -> RoaringSet<T>::Iterator {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("RoaringSet::Iterator::operator ++(int)");
+
+  if (container == int(ref_set->containers.size()))
+    return *this;
+  Iterator to_return(*this);
+  if (can_erase)
+    advance();
+  else
+    can_erase = true;
+  return to_return;
+}
+
+
+template<class T>
+bool RoaringSet<T>::Iterator::operator == (const RoaringSet<T>::Iterator& rhs) const {
+  const Iterator* rhsASI = dynamic_cast<const Iterator*>(&rhs);
+  if (rhsASI == 0)
+    throw IteratorTypeError("RoaringSet::Iterator::operator ==");
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("RoaringSet::Iterator::operator ==");
+  if (ref_set != rhsASI->ref_set)
+    throw ComparingDifferentIteratorsError("RoaringSet::Iterator::operator ==");
+
+  int end = ref_set->containers.size();
+  return container == rhsASI->container && (container == end || index == rhsASI->index);
+}
+
+
+template<class T>
+bool RoaringSet<T>::Iterator::operator != (const RoaringSet<T>::Iterator& rhs) const {
+  return !(*this == rhs);
+}
+
+
+template<class T>
+T RoaringSet<T>::Iterator::operator *() const {
+  if (expected_mod_count != ref_set->mod_count)
+    throw ConcurrentModificationError("RoaringSet::Iterator::operator *");
+  if (!can_erase || container == int(ref_set->containers.size()))
+    throw IteratorPositionIllegal("RoaringSet::Iterator::operator * Iterator illegal: exhausted or erased");
+
+  const Container& c = ref_set->containers[container];
+  return value(std::uint32_t(c.high) << 16 | (c.is_bitmap() ? index : c.array[index]));
+}
+
+}
+
+#endif /* ROARING_SET_HPP_ */
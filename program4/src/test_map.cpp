@@ -1,12 +1,18 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>                 // std::random_shuffle
+#include <functional>
+#include <type_traits>
+#include <vector>
 #include "ics46goody.hpp"
 #include "gtest/gtest.h"
 #include "array_priority_queue.hpp"  // must leave in for use in iterator_simple
 #include "array_queue.hpp"           // must leave in for use in iterator_erase
 #include "array_stack.hpp"           // must leave in for use in constructor
 #include "hash_map.hpp"
+#include "flat_hash_map.hpp"
+#include "frozen_hash_map.hpp"
+#include "fixed_hash_map.hpp"
 
 int hash_string  (const std::string& s) {std::hash<std::string> str_hash; return str_hash(s);}
 int hash_int     (const int& s)         {std::hash<int> str_hash; return str_hash(s);}
@@ -859,6 +865,219 @@ TEST_F(MapTest, large_scale_speed) {
 }
 
 
+MapTypeStr unshared_copy(const MapTypeStr& m) {   //put by put, so it shares no table with m
+  MapTypeStr answer;
+  for (const EntryType& kv : m)
+    answer.put(kv.first,kv.second);
+  return answer;
+}
+
+
+TEST_F(MapTest, copy_on_write) {
+  static_assert(std::is_const<std::remove_reference<decltype(*MapTypeStr().begin())>::type>::value,
+                "an Iterator must not hand out a writable entry of a shared table");
+  MapTypeStr m;
+  for (char c='a'; c<='z'; ++c)
+    m.put(std::string(1,c),c-'a');
+  MapTypeStr other({EntryType("x",1),EntryType("y",2)});
+
+  //Every way of writing m, each with all earlier copies of m still alive
+  std::vector<std::function<void(MapTypeStr&)>> writes = {
+    [] (MapTypeStr& m) {m.put("a",100);},
+    [] (MapTypeStr& m) {for (char c='A'; c<='Z'; ++c) m.put(std::string(1,c),c);},   //rehashes
+    [] (MapTypeStr& m) {m.erase("b");},
+    [] (MapTypeStr& m) {m["c"] = 300;},
+    [] (MapTypeStr& m) {m["new"] = 1;},
+    [] (MapTypeStr& m) {MapTypeStr::Iterator i = m.begin(); i.erase();},
+    [] (MapTypeStr& m) {m.reserve(1000);},
+    [] (MapTypeStr& m) {m.clear();},
+    [&other] (MapTypeStr& m) {m = other; m.put("x",10);},
+  };
+  std::vector<MapTypeStr> copies, expected;
+  for (auto& write : writes) {
+    copies.push_back(m);
+    expected.push_back(unshared_copy(m));
+    write(m);
+    for (unsigned i=0; i<copies.size(); ++i)
+      ASSERT_EQ(expected[i],copies[i]);
+  }
+  ASSERT_EQ(MapTypeStr({EntryType("x",1),EntryType("y",2)}),other);
+
+  //A T& handed out before a copy still writes only its own map
+  MapTypeStr a;
+  a.put("a",1);
+  int& r = a["a"];
+  MapTypeStr b(a);
+  r = 77;
+  ASSERT_EQ(1,b["a"]);
+  ASSERT_EQ(77,a["a"]);
+
+  //and one from a copy writes only the copy
+  MapTypeStr c(b);
+  c["a"] = 2;
+  ASSERT_EQ(1,b["a"]);
+  ASSERT_EQ(2,c["a"]);
+}
+
+
+TEST_F(MapTest, value_index) {
+  MapTypeStr m;
+  m.index_values(hash_int);
+  ASSERT_LT(0,m.value_index_bytes());
+  for (char c='a'; c<='z'; ++c)
+    m.put(std::string(1,c),(c-'a')%5);
+  for (int v=0; v<5; ++v)
+    ASSERT_TRUE(m.has_value(v));
+  ASSERT_FALSE(m.has_value(5));
+
+  m.put("a",5);           //f, k, p, u, and z still map to 0
+  ASSERT_TRUE(m.has_value(5));
+  ASSERT_TRUE(m.has_value(0));
+  for (char c : std::string("fkpuz"))
+    m.erase(std::string(1,c));
+  ASSERT_FALSE(m.has_value(0));
+  for (MapTypeStr::Iterator i = m.begin(); i != m.end(); ++i)
+    if (i->second == 5)
+      i.erase();
+  ASSERT_FALSE(m.has_value(5));
+
+  //Copies index their own values
+  MapTypeStr copy(m);
+  copy.put("z",50);
+  ASSERT_TRUE(copy.has_value(50));
+  ASSERT_FALSE(m.has_value(50));
+
+  //A T& may be written after the map's next call: has_value must still see it
+  int& r = m["b"];
+  ASSERT_TRUE(m.has_value(1));
+  r = 60;
+  m.put("y",61);
+  int& s = m["new"];
+  s = 62;
+  ASSERT_TRUE(m.has_value(60));
+  ASSERT_TRUE(m.has_value(61));
+  ASSERT_TRUE(m.has_value(62));
+  ASSERT_FALSE(m.has_value(0));
+  ASSERT_EQ(0,m.value_index_bytes());     //no index while a T& may be written unseen
+
+  m.clear();                              //no T& is left: indexed again
+  ASSERT_LT(0,m.value_index_bytes());
+  m.put("a",7);
+  ASSERT_TRUE(m.has_value(7));
+  ASSERT_FALSE(m.has_value(60));
+
+  m.index_values(nullptr);
+  ASSERT_EQ(0,m.value_index_bytes());
+  ASSERT_TRUE(m.has_value(7));
+}
+
+
+TEST_F(MapTest, flat_hash_map) {
+  typedef ics::FlatHashMap<int,int> FlatMap;
+  static_assert(std::is_same<ics::AutoHashMap<int,int>,FlatMap>::value,           "integral keys: flat");
+  static_assert(std::is_same<ics::AutoHashMap<std::string,int>,MapTypeNone>::value, "others: HashMap");
+  FlatMap m(0.5, hash_int);                       //a hash is accepted (and not needed)
+  ASSERT_TRUE(m.empty());
+  ASSERT_EQ(10,m.put(1,10));                      //a new key: the value put (as HashMap)
+  ASSERT_EQ(10,m.put(1,11));
+  m[FlatMap::empty_key] = 7;                      //the sentinel key is kept apart
+  m[0] = 0;
+  ASSERT_EQ(3,m.size());
+  ASSERT_TRUE(m.has_key(FlatMap::empty_key));
+  ASSERT_TRUE(m.has_value(7));
+  ASSERT_EQ(11,m.erase(1));
+  ASSERT_THROW(m.erase(1),ics::KeyError);
+  ASSERT_THROW(static_cast<const FlatMap&>(m)[1],ics::KeyError);
+  m.erase(FlatMap::empty_key);
+  m.erase(0);
+
+  //Against a HashMap, through many grows and erases (each shifting its probe back)
+  MapTypeInt reference;
+  for (int i=0; i<5000; ++i) {
+    int k = (i*7919) % 3001 - 1500;
+    if (i % 3 == 2 && reference.has_key(k))
+      ASSERT_EQ(reference.erase(k),m.erase(k));
+    else
+      ASSERT_EQ(reference.put(k,i),m.put(k,i));
+  }
+  ASSERT_EQ(reference.size(),m.size());
+  int visited = 0;
+  for (const FlatMap::Entry& kv : m) {
+    ASSERT_EQ(reference[kv.first],kv.second);
+    ++visited;
+  }
+  ASSERT_EQ(m.size(),visited);
+
+  FlatMap copy(m);
+  ASSERT_EQ(copy,m);
+  for (FlatMap::Iterator i = m.begin(); i != m.end(); ++i)
+    if (i->first % 2 == 0)
+      i.erase();
+  for (const FlatMap::Entry& kv : m)
+    ASSERT_NE(0,kv.first % 2);
+  ASSERT_NE(copy,m);
+  m.clear();
+  ASSERT_TRUE(m.empty());
+  ASSERT_EQ(m.begin(),m.end());
+}
+
+
+int same_hash (const std::string& s) {return s.size();}   //keys of one length collide
+
+TEST_F(MapTest, frozen_hash_map) {
+  MapTypeStr m;
+  for (int i=0; i<2000; ++i)
+    m.put("k" + std::to_string(i),i);
+  ics::FrozenHashMap<std::string,int,hash_string> f = m.freeze();
+  ASSERT_EQ(m.size(),f.size());
+  for (const EntryType& kv : m) {
+    ASSERT_TRUE(f.has_key(kv.first));
+    ASSERT_EQ(kv.second,f[kv.first]);
+  }
+  for (int i=2000; i<2200; ++i)
+    ASSERT_EQ(nullptr,f.find("k" + std::to_string(i)));
+  ASSERT_THROW(f["absent"],ics::KeyError);
+  ASSERT_LT(f.index_bits_per_key(),8.0);
+  int visited = 0;
+  for (const EntryType& kv : f) {
+    ASSERT_EQ(m[kv.first],kv.second);
+    ++visited;
+  }
+  ASSERT_EQ(m.size(),visited);
+
+  //Keys the hash cannot tell apart go to the overflow array; a later duplicate key replaces
+  ics::FrozenHashMap<std::string,int> g(std::vector<EntryType>{{"a",1},{"b",2},{"cc",3},{"a",4}}, same_hash);
+  ASSERT_EQ(3,g.size());
+  ASSERT_LT(0,g.overflows());
+  ASSERT_EQ(4,g["a"]);
+  ASSERT_EQ(2,g["b"]);
+  ASSERT_EQ(3,g["cc"]);
+  ASSERT_FALSE(g.has_key("d"));
+
+  ics::FrozenHashMap<std::string,int,hash_string> empty;
+  ASSERT_TRUE(empty.empty());
+  ASSERT_FALSE(empty.has_key("a"));
+}
+
+
+TEST_F(MapTest, fixed_hash_map) {
+  constexpr auto codes = ics::make_fixed_hash_map(ics::fixed_entry("put",1), ics::fixed_entry("erase",2),
+                                                  ics::fixed_entry("clear",3), ics::fixed_entry("p",4));
+  static_assert(codes.size() == 4,                   "every entry is kept");
+  static_assert(*codes.find("erase") == 2,            "lookups with literals are constexpr");
+  static_assert(codes.find("get") == nullptr,         "absent keys are not found");
+  ASSERT_EQ(1,codes[std::string("put")]);
+  ASSERT_EQ(4,codes[std::string("p")]);
+  ASSERT_FALSE(codes.has_key(std::string("pu")));
+  ASSERT_THROW(codes[std::string("get")],ics::KeyError);
+
+  constexpr auto squares = ics::make_fixed_hash_map(ics::fixed_entry(-3,9), ics::fixed_entry(0,0), ics::fixed_entry(7,49));
+  static_assert(*squares.find(7) == 49, "integral keys");
+  ASSERT_EQ(9,squares[-3]);
+  ASSERT_FALSE(squares.has_key(3));
+}
+
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,341 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+#ifndef QUEUE_TELEMETRY_HPP_
+#define QUEUE_TELEMETRY_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+
+namespace ics {
+
+
+//Queue telemetry: depth, high-watermark depth, enqueue/dequeue counts (so rates), and a
+//  histogram of time-in-queue (each value is timestamped when enqueued).
+//A QueueTelemetry is written by the thread(s) using its queue(s) and may be read at any time by
+//  any other thread (snapshot() never blocks or stops the producers): every counter is a relaxed
+//  atomic, so a snapshot is a consistent-enough sample, not an exact cut. Several queues (e.g.,
+//  one per worker) may share one QueueTelemetry to see a whole pool's load.
+//Time-in-queue buckets are powers of 2 in nanoseconds: bucket b counts waits in [2^b,2^(b+1)).
+class QueueTelemetry {
+  public:
+    static const int buckets = 40;      //Up to 2^40ns (about 18 minutes); longer waits go in the last
+
+    struct Snapshot {
+      double        seconds        = 0;   //Since construction/reset
+      std::int64_t  enqueues       = 0;
+      std::int64_t  dequeues       = 0;
+      std::int64_t  depth          = 0;
+      std::int64_t  high_watermark = 0;
+      std::int64_t  wait_total_ns  = 0;   //Over all dequeues
+      std::int64_t  wait_max_ns    = 0;
+      std::vector<std::int64_t> histogram = std::vector<std::int64_t>(buckets,0);
+
+      double enqueue_rate      () const;  //Per second, over the whole interval
+      double dequeue_rate      () const;
+      double mean_wait_seconds () const;
+      double wait_percentile   (double p) const;   //Upper bound of the bucket holding the p-th fraction (0..1), in seconds
+
+      //Rates/waits over the interval since an earlier snapshot (e.g., the last second)
+      Snapshot since (const Snapshot& earlier) const;
+
+      //Little's law (L = lambda W): the mean number of values in the queue implied by the rates
+      //  and mean wait; with a service time per value, lambda*service is the busy workers needed
+      double mean_depth () const;
+
+      std::string str () const;
+    };
+
+    QueueTelemetry ();
+    QueueTelemetry (const QueueTelemetry& to_copy)              = delete;
+    QueueTelemetry& operator = (const QueueTelemetry& rhs)      = delete;
+
+    Snapshot snapshot () const;
+    void     reset    ();                    //Zeroes all but depth (values still queued stay counted)
+
+    //Called by the queue (TelemetryQueue) under its own synchronization
+    static std::int64_t now_ns ();
+    void on_enqueue (int count = 1);
+    void on_dequeue (std::int64_t enqueued_ns);
+    void on_discard (int count);             //Values removed without being dequeued (clear)
+
+  private:
+    std::atomic<std::int64_t>              start_ns;
+    std::atomic<std::int64_t>              enqueues, dequeues, depth, high_watermark;
+    std::atomic<std::int64_t>              wait_total_ns, wait_max_ns;
+    std::atomic<std::int64_t>              histogram[buckets];
+
+    static void relaxed_max (std::atomic<std::int64_t>& a, std::int64_t value);
+};
+
+
+//Wraps a FIFO queue (e.g., LinkedQueue) and reports every operation to a QueueTelemetry;
+//  with a nullptr telemetry it only forwards (no timestamps are taken), so telemetry can be
+//  turned on per queue without changing the code that uses it.
+//Enqueue timestamps are kept in a ring parallel to the queue (values are dequeued in the
+//  order they were enqueued), so the wrapped queue and its values are unchanged.
+template<class Queue> class TelemetryQueue {
+  public:
+    typedef typename std::decay<decltype(std::declval<Queue&>().peek())>::type T;
+
+    template<class... Args>
+    explicit TelemetryQueue(QueueTelemetry* telemetry, Args&&... args)
+    : telemetry(telemetry), q(std::forward<Args>(args)...) {
+      if (telemetry != nullptr && !q.empty()) {
+        for (int i = q.size(); i > 0; --i)
+          stamp();
+        telemetry->on_enqueue(q.size());
+      }
+    }
+
+    ~TelemetryQueue() {
+      if (telemetry != nullptr)
+        telemetry->on_discard(q.size());
+    }
+
+    bool empty   () const            {return q.empty();}
+    int  size    () const            {return q.size();}
+    T&   peek    () const            {return q.peek();}
+    int  enqueue (const T& element);
+    T    dequeue ();
+    void clear   ();
+
+    template <class Iterable>
+    int enqueue_all (const Iterable& i) {
+      int count = 0;
+      for (const T& v : i)
+        count += enqueue(v);
+      return count;
+    }
+
+    QueueTelemetry* get_telemetry() const {return telemetry;}
+    Queue&          container()           {return q;}     //Changes made directly are not seen
+    const Queue&    container() const     {return q;}
+
+  private:
+    QueueTelemetry*           telemetry;
+    Queue                     q;
+    std::vector<std::int64_t> stamps;          //Ring of enqueue times; capacity is a power of 2
+    std::size_t               stamps_front = 0;
+    std::size_t               stamps_used  = 0;
+
+    void         stamp   ();
+    std::int64_t unstamp ();
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//QueueTelemetry::Snapshot
+
+inline double QueueTelemetry::Snapshot::enqueue_rate() const {
+  return seconds > 0 ? enqueues/seconds : 0;
+}
+
+
+inline double QueueTelemetry::Snapshot::dequeue_rate() const {
+  return seconds > 0 ? dequeues/seconds : 0;
+}
+
+
+inline double QueueTelemetry::Snapshot::mean_wait_seconds() const {
+  return dequeues > 0 ? wait_total_ns/1e9/dequeues : 0;
+}
+
+
+inline double QueueTelemetry::Snapshot::wait_percentile(double p) const {
+  std::int64_t total = 0;
+  for (std::int64_t c : histogram)
+    total += c;
+  if (total == 0)
+    return 0;
+  std::int64_t rank = std::int64_t(p*total + 0.5), seen = 0;
+  for (int b = 0; b < buckets; ++b)
+    if ((seen += histogram[b]) >= rank && seen > 0)
+      return std::min<double>(double(std::int64_t(1) << (b+1)), double(wait_max_ns)) / 1e9;
+  return wait_max_ns/1e9;
+}
+
+
+inline QueueTelemetry::Snapshot QueueTelemetry::Snapshot::since(const Snapshot& earlier) const {
+  Snapshot answer(*this);
+  answer.seconds       -= earlier.seconds;
+  answer.enqueues      -= earlier.enqueues;
+  answer.dequeues      -= earlier.dequeues;
+  answer.wait_total_ns -= earlier.wait_total_ns;
+  for (int b = 0; b < buckets; ++b)
+    answer.histogram[b] -= earlier.histogram[b];
+  return answer;
+}
+
+
+inline double QueueTelemetry::Snapshot::mean_depth() const {
+  return dequeue_rate() * mean_wait_seconds();
+}
+
+
+inline std::string QueueTelemetry::Snapshot::str() const {
+  std::ostringstream answer;
+  answer << "QueueTelemetry(" << seconds << "s: enqueues=" << enqueues << " (" << enqueue_rate() << "/s)"
+         << ", dequeues=" << dequeues << " (" << dequeue_rate() << "/s)"
+         << ", depth=" << depth << ", high_watermark=" << high_watermark
+         << ", wait mean=" << mean_wait_seconds()*1e6 << "us"
+         << " p50<=" << wait_percentile(.50)*1e6 << "us"
+         << " p99<=" << wait_percentile(.99)*1e6 << "us"
+         << " max=" << wait_max_ns/1e3 << "us"
+         << ", Little's L=" << mean_depth() << ")";
+  return answer.str();
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//QueueTelemetry
+
+inline QueueTelemetry::QueueTelemetry()
+: start_ns(now_ns()), enqueues(0), dequeues(0), depth(0), high_watermark(0),
+  wait_total_ns(0), wait_max_ns(0)
+{
+  for (std::atomic<std::int64_t>& c : histogram)
+    c.store(0, std::memory_order_relaxed);
+}
+
+
+inline QueueTelemetry::Snapshot QueueTelemetry::snapshot() const {
+  Snapshot answer;
+  answer.seconds        = (now_ns() - start_ns.load(std::memory_order_relaxed)) / 1e9;
+  answer.enqueues       = enqueues.load(std::memory_order_relaxed);
+  answer.dequeues       = dequeues.load(std::memory_order_relaxed);
+  answer.depth          = depth.load(std::memory_order_relaxed);
+  answer.high_watermark = high_watermark.load(std::memory_order_relaxed);
+  answer.wait_total_ns  = wait_total_ns.load(std::memory_order_relaxed);
+  answer.wait_max_ns    = wait_max_ns.load(std::memory_order_relaxed);
+  for (int b = 0; b < buckets; ++b)
+    answer.histogram[b] = histogram[b].load(std::memory_order_relaxed);
+  return answer;
+}
+
+
+inline void QueueTelemetry::reset() {
+  start_ns.store(now_ns(), std::memory_order_relaxed);
+  enqueues.store(0, std::memory_order_relaxed);
+  dequeues.store(0, std::memory_order_relaxed);
+  high_watermark.store(depth.load(std::memory_order_relaxed), std::memory_order_relaxed);
+  wait_total_ns.store(0, std::memory_order_relaxed);
+  wait_max_ns.store(0, std::memory_order_relaxed);
+  for (std::atomic<std::int64_t>& c : histogram)
+    c.store(0, std::memory_order_relaxed);
+}
+
+
+inline std::int64_t QueueTelemetry::now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+inline void QueueTelemetry::on_enqueue(int count) {
+  enqueues.fetch_add(count, std::memory_order_relaxed);
+  relaxed_max(high_watermark, depth.fetch_add(count, std::memory_order_relaxed) + count);
+}
+
+
+inline void QueueTelemetry::on_dequeue(std::int64_t enqueued_ns) {
+  std::int64_t wait = now_ns() - enqueued_ns;
+  if (wait < 1)
+    wait = 1;
+  int b = 63 - __builtin_clzll(std::uint64_t(wait));     //floor(log2(wait))
+  if (b >= buckets)
+    b = buckets-1;
+  dequeues.fetch_add(1, std::memory_order_relaxed);
+  depth.fetch_sub(1, std::memory_order_relaxed);
+  wait_total_ns.fetch_add(wait, std::memory_order_relaxed);
+  relaxed_max(wait_max_ns, wait);
+  histogram[b].fetch_add(1, std::memory_order_relaxed);
+}
+
+
+inline void QueueTelemetry::on_discard(int count) {
+  depth.fetch_sub(count, std::memory_order_relaxed);
+}
+
+
+inline void QueueTelemetry::relaxed_max(std::atomic<std::int64_t>& a, std::int64_t value) {
+  std::int64_t old = a.load(std::memory_order_relaxed);
+  while (old < value && !a.compare_exchange_weak(old, value, std::memory_order_relaxed))
+    ;
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//TelemetryQueue
+
+template<class Queue>
+int TelemetryQueue<Queue>::enqueue(const T& element) {
+  int answer = q.enqueue(element);
+  if (telemetry != nullptr) {
+    stamp();
+    telemetry->on_enqueue();
+  }
+  return answer;
+}
+
+
+template<class Queue>
+auto TelemetryQueue<Queue>::dequeue() -> T {
+  T answer = q.dequeue();          //Throws EmptyError (before unstamp) if empty
+  if (telemetry != nullptr)
+    telemetry->on_dequeue(unstamp());
+  return answer;
+}
+
+
+template<class Queue>
+void TelemetryQueue<Queue>::clear() {
+  if (telemetry != nullptr)
+    telemetry->on_discard(q.size());
+  q.clear();
+  stamps_front = stamps_used = 0;
+}
+
+
+template<class Queue>
+void TelemetryQueue<Queue>::stamp() {
+  if (stamps_used == stamps.size()) {           //Grow the ring, unrolling it to start at 0
+    std::vector<std::int64_t> bigger(stamps.empty() ? 16 : 2*stamps.size());
+    for (std::size_t i = 0; i < stamps_used; ++i)
+      bigger[i] = stamps[(stamps_front+i) & (stamps.size()-1)];
+    stamps.swap(bigger);
+    stamps_front = 0;
+  }
+  stamps[(stamps_front+stamps_used++) & (stamps.size()-1)] = QueueTelemetry::now_ns();
+}
+
+
+template<class Queue>
+std::int64_t TelemetryQueue<Queue>::unstamp() {
+  std::int64_t answer = stamps[stamps_front];
+  stamps_front = (stamps_front+1) & (stamps.size()-1);
+  --stamps_used;
+  return answer;
+}
+
+}
+
+#endif /* QUEUE_TELEMETRY_HPP_ */
@@ -0,0 +1,97 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Replays a recorded operation trace (trace_recorder.hpp), or a driver command script/trace
+//  (command_trace.hpp), against every ics backend of the same kind, so their costs can be
+//  compared on exactly the same workload. Values are replayed as std::string.
+//
+//Build (the include path must reach this directory, program3/src and program4/src):
+//  g++ -std=gnu++11 -O2 -I. -Iprogram4/src -Iprogram3/src replay_trace.cpp -o replay_trace
+//  replay_trace queue|map|set file [repeat]
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include "ics_exceptions.hpp"
+#include "command_trace.hpp"
+#include "trace_recorder.hpp"
+#include "linked_queue.hpp"
+#include "heap_priority_queue.hpp"
+#include "bst_map.hpp"
+#include "hash_map.hpp"
+#include "hash_set.hpp"
+
+
+bool gt_string  (const std::string& a, const std::string& b) {return a < b;}
+bool lt_string  (const std::string& a, const std::string& b) {return a < b;}
+int  hash_string(const std::string& s) {std::hash<std::string> str_hash; return str_hash(s);}
+
+
+//A recording (starts with ICSR) or anything load_commands reads
+ics::CommandScript load_any(const std::string& file_name) {
+  std::ifstream in(file_name.c_str(), std::ios::binary);
+  char magic[4] = {0,0,0,0};
+  in.read(magic,4);
+  if (in.gcount() == 4 && std::string(magic,4) == "ICSR")
+    return ics::read_recording(file_name).commands;
+  return ics::load_commands(file_name);
+}
+
+
+template<class Replay>
+void report(const std::string& backend, int repeat, Replay replay) {
+  for (int r=1; r<=repeat; ++r) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ics::CommandLatency latency = replay();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now()-start;
+    std::cout << backend << " (run " << r << "): " << elapsed.count() << "s" << std::endl << latency.str() << std::endl;
+  }
+}
+
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cout << "usage: " << argv[0] << " queue|map|set file [repeat]" << std::endl;
+    return 2;
+  }
+  std::string kind = argv[1];
+  int repeat = (argc > 3 ? std::atoi(argv[3]) : 1);
+
+  try {
+    ics::CommandScript script = load_any(argv[2]);
+    std::cout << "Replaying " << script.size() << " commands from " << argv[2] << std::endl << std::endl;
+
+    if (kind == "queue") {
+      report("LinkedQueue", repeat, [&script] () {
+        ics::LinkedQueue<std::string> q;
+        return ics::replay_queue(script,q);
+      });
+      report("HeapPriorityQueue", repeat, [&script] () {
+        ics::HeapPriorityQueue<std::string,gt_string> q;
+        return ics::replay_queue(script,q);
+      });
+    }else if (kind == "map") {
+      report("HashMap", repeat, [&script] () {
+        ics::HashMap<std::string,std::string,hash_string> m;
+        return ics::replay_map(script,m);
+      });
+      report("BSTMap", repeat, [&script] () {
+        ics::BSTMap<std::string,std::string,lt_string> m;
+        return ics::replay_map(script,m);
+      });
+    }else if (kind == "set") {
+      report("HashSet", repeat, [&script] () {
+        ics::HashSet<std::string,hash_string> s;
+        return ics::replay_set(script,s);
+      });
+    }else {
+      std::cout << "unknown kind \"" << kind << "\"" << std::endl;
+      return 2;
+    }
+  } catch (ics::IcsError& e) {
+    std::cout << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,696 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+//Differential stress/fuzz harness: drives an ics container and a std:: reference model
+//  with the same random operation sequence, checking after every operation that they
+//  agree (and that no allocation leaked), and reporting operations/second per round.
+//
+//Build (the include path must reach this directory, program3/src and program4/src):
+//  g++ -std=gnu++11 -O2 -I. -Iprogram4/src -Iprogram3/src stress_test.cpp -o stress_test
+//  stress_test container [ops_per_round [rounds [seed [check|bench [op,op,...]]]]]
+//    container: queue | priority_queue | bst_map | hash_map | flat_hash_map | hash_set | roaring_set | all
+//    bench:     run only the ics container (no reference model, no checks) for raw ops/sec
+//    op list:   restrict the mix to the named operations (see the *_ops tables below)
+//
+//Build with -DICS_LIBFUZZER -fsanitize=fuzzer,address to get a libFuzzer target instead:
+//  the first input byte chooses the container, the rest drive the operation sequence.
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <deque>
+#include <queue>
+#include <map>
+#include <set>
+#include <random>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include "ics_exceptions.hpp"
+#include "linked_queue.hpp"
+#include "heap_priority_queue.hpp"
+#include "bst_map.hpp"
+#include "hash_map.hpp"
+#include "flat_hash_map.hpp"
+#include "hash_set.hpp"
+#include "roaring_set.hpp"
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Allocation accounting: every container is instantiated with CountingAllocator,
+//  so a missing delete shows up as live allocations that outlive the container.
+
+long live_allocations = 0;
+
+template<class T> class CountingAllocator {
+  public:
+    typedef T value_type;
+
+    CountingAllocator() {}
+    template<class U> CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+      live_allocations += n;
+      return static_cast<T*>(::operator new(n*sizeof(T)));
+    }
+    void deallocate(T* p, std::size_t n) {
+      live_allocations -= n;
+      ::operator delete(p);
+    }
+
+    template<class U> bool operator == (const CountingAllocator<U>&) const {return true;}
+    template<class U> bool operator != (const CountingAllocator<U>&) const {return false;}
+};
+
+
+bool gt_int (const int& a, const int& b) {return a < b;}
+bool lt_int (const int& a, const int& b) {return a < b;}
+int  hash_int(const int& a)              {std::hash<int> int_hash; return int_hash(a);}
+
+typedef ics::LinkedQueue<int,CountingAllocator<int>>                                       QueueType;
+typedef ics::HeapPriorityQueue<int,gt_int,CountingAllocator<int>>                          PriorityQueueType;
+typedef ics::BSTMap<int,int,lt_int,CountingAllocator<ics::pair<int,int>>>                  BSTMapType;
+typedef ics::HashMap<int,int,hash_int,CountingAllocator<ics::pair<int,int>>>               HashMapType;
+typedef ics::FlatHashMap<int,int,hash_int,CountingAllocator<ics::pair<int,int>>>           FlatHashMapType;
+typedef ics::HashSet<int,hash_int,CountingAllocator<int>>                                  HashSetType;
+typedef ics::RoaringSet<int>                                                               RoaringSetType;
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//OpSource: where operation choices come from; either a seeded generator (random
+//  mode) or the bytes of a libFuzzer input (exhausted when the bytes run out)
+
+class OpSource {
+  public:
+    explicit OpSource(unsigned seed)                  : rng(seed) {}
+    OpSource(const std::uint8_t* bytes, std::size_t n) : data(bytes), size(n) {}
+
+    bool exhausted() const {return data != nullptr && pos >= size;}
+
+    //Return a value in [0,bound)
+    int next(int bound) {
+      if (data == nullptr)
+        return std::uniform_int_distribution<int>(0,bound-1)(rng);
+      if (pos >= size)
+        return 0;
+      return data[pos++] % bound;
+    }
+
+  private:
+    std::mt19937         rng;
+    const std::uint8_t*  data = nullptr;
+    std::size_t          size = 0;
+    std::size_t          pos  = 0;
+};
+
+
+class StressFailure {
+  public:
+    explicit StressFailure(const std::string& m) : message(m) {}
+    std::string message;
+};
+
+
+//Remembers the last few operations, so a failure can be reproduced by hand
+class OpLog {
+  public:
+    void add(const std::string& op) {
+      if (ops.size() == 32)
+        ops.pop_front();
+      ops.push_back(op);
+    }
+    std::string str() const {
+      std::ostringstream answer;
+      for (const std::string& op : ops)
+        answer << "    " << op << std::endl;
+      return answer.str();
+    }
+  private:
+    std::deque<std::string> ops;
+};
+
+
+//Options shared by every container run
+struct Options {
+  int                   ops_per_round = 100000;
+  int                   rounds        = 1;
+  unsigned              seed          = 0;
+  bool                  check         = true;
+  std::set<std::string> only;                 //empty means every operation
+};
+
+
+int choose_op(OpSource& src, const std::vector<std::string>& names, const Options& o) {
+  if (o.only.empty())
+    return src.next(names.size());
+  for (;;) {                                   //Options::only is validated in main
+    int op = src.next(names.size());
+    if (o.only.count(names[op]))
+      return op;
+  }
+}
+
+
+#define STRESS_EXPECT(cond,what)                                                \
+  do {                                                                          \
+    if (!(cond)) {                                                              \
+      std::ostringstream where;                                                 \
+      where << what << " (op #" << op_number << ")" << std::endl << log.str();  \
+      throw StressFailure(where.str());                                         \
+    }                                                                           \
+  } while (false)
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//LinkedQueue vs std::deque
+
+const std::vector<std::string> queue_ops = {"enqueue","dequeue","peek","clear","iterate","erase","copy","assign"};
+
+long stress_queue(OpSource& src, const Options& o) {
+  QueueType       q;
+  std::deque<int> model;
+  OpLog           log;
+  long            op_number = 0;
+
+  for (; op_number < o.ops_per_round && !src.exhausted(); ++op_number) {
+    int op = choose_op(src,queue_ops,o);
+    int v  = src.next(1000);
+    std::ostringstream entry;
+    entry << queue_ops[op] << "(" << v << ")";
+    log.add(entry.str());
+
+    switch (op) {
+      case 0:
+        q.enqueue(v);
+        if (o.check) model.push_back(v);
+        break;
+      case 1:
+        if (q.empty()) {
+          if (!o.check) break;
+          bool threw = false;
+          try {q.dequeue();} catch (ics::EmptyError&) {threw = true;}
+          STRESS_EXPECT(threw, "dequeue of empty queue did not throw EmptyError");
+        }else {
+          int got = q.dequeue();
+          if (o.check) {
+            STRESS_EXPECT(got == model.front(), "dequeue returned " << got << ", expected " << model.front());
+            model.pop_front();
+          }
+        }
+        break;
+      case 2:
+        if (!q.empty() && o.check)
+          STRESS_EXPECT(q.peek() == model.front(), "peek returned " << q.peek() << ", expected " << model.front());
+        break;
+      case 3:
+        q.clear();
+        model.clear();
+        break;
+      case 4: {
+        std::deque<int>::iterator m = model.begin();
+        for (int x : q) {
+          if (o.check) {
+            STRESS_EXPECT(m != model.end() && x == *m, "iteration produced " << x << " at the wrong position");
+            ++m;
+          }
+        }
+        if (o.check)
+          STRESS_EXPECT(m == model.end(), "iteration stopped early");
+        break;
+      }
+      case 5: {
+        if (q.empty())
+          break;
+        int skip = v % q.size();
+        QueueType::Iterator i = q.begin();
+        for (int s=0; s<skip; ++s)
+          ++i;
+        int got = i.erase();
+        if (o.check) {
+          STRESS_EXPECT(got == model[skip], "Iterator::erase returned " << got << ", expected " << model[skip]);
+          model.erase(model.begin()+skip);
+        }
+        break;
+      }
+      case 6: {
+        QueueType copy(q);
+        if (o.check)
+          STRESS_EXPECT(copy == q && !(copy != q), "copy constructor result != original");
+        break;
+      }
+      case 7: {
+        QueueType other;
+        other.enqueue(v);
+        other = q;
+        if (o.check)
+          STRESS_EXPECT(other == q, "operator = result != original");
+        break;
+      }
+    }
+
+    if (o.check) {
+      STRESS_EXPECT(q.size() == int(model.size()), "size() == " << q.size() << ", expected " << model.size());
+      STRESS_EXPECT(q.empty() == model.empty(), "empty() disagrees with size " << model.size());
+      STRESS_EXPECT(live_allocations == q.size(), live_allocations << " live nodes for size " << q.size());
+    }
+  }
+  return op_number;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//HeapPriorityQueue vs std::priority_queue (gt_int: smaller values have higher priority)
+
+const std::vector<std::string> priority_queue_ops = {"enqueue","dequeue","peek","clear","iterate","copy","assign"};
+
+long stress_priority_queue(OpSource& src, const Options& o) {
+  typedef std::priority_queue<int,std::vector<int>,std::greater<int>> Model;
+  PriorityQueueType pq;
+  Model             model;
+  OpLog             log;
+  long              op_number = 0;
+
+  for (; op_number < o.ops_per_round && !src.exhausted(); ++op_number) {
+    int op = choose_op(src,priority_queue_ops,o);
+    int v  = src.next(1000);
+    std::ostringstream entry;
+    entry << priority_queue_ops[op] << "(" << v << ")";
+    log.add(entry.str());
+
+    switch (op) {
+      case 0:
+        pq.enqueue(v);
+        if (o.check) model.push(v);
+        break;
+      case 1:
+        if (pq.empty()) {
+          if (!o.check) break;
+          bool threw = false;
+          try {pq.dequeue();} catch (ics::EmptyError&) {threw = true;}
+          STRESS_EXPECT(threw, "dequeue of empty priority queue did not throw EmptyError");
+        }else {
+          int got = pq.dequeue();
+          if (o.check) {
+            STRESS_EXPECT(got == model.top(), "dequeue returned " << got << ", expected " << model.top());
+            model.pop();
+          }
+        }
+        break;
+      case 2:
+        if (!pq.empty() && o.check)
+          STRESS_EXPECT(pq.peek() == model.top(), "peek returned " << pq.peek() << ", expected " << model.top());
+        break;
+      case 3:
+        pq.clear();
+        model = Model();
+        break;
+      case 4: {
+        if (pq.size() > 64)                 //Iterator copies the heap: keep this O(N log N) step rare
+          break;
+        Model m(model);
+        for (int x : pq) {
+          if (o.check) {
+            STRESS_EXPECT(!m.empty() && x == m.top(), "iteration produced " << x << " out of priority order");
+            m.pop();
+          }
+        }
+        break;
+      }
+      case 5: {
+        PriorityQueueType copy(pq);
+        if (o.check)
+          STRESS_EXPECT(copy.size() == pq.size() && copy == pq, "copy constructor result != original");
+        break;
+      }
+      case 6: {
+        PriorityQueueType other;
+        other.enqueue(v);
+        other = pq;
+        if (o.check)
+          STRESS_EXPECT(other == pq, "operator = result != original");
+        break;
+      }
+    }
+
+    if (o.check)
+      STRESS_EXPECT(pq.size() == int(model.size()), "size() == " << pq.size() << ", expected " << model.size());
+  }
+  return op_number;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//BSTMap/HashMap/FlatHashMap vs std::map (same public interface, so one driver serves all)
+
+const std::vector<std::string> map_ops = {"put","erase","has_key","has_value","index","const_index","clear","iterate","copy","assign"};
+
+template<class MapType>
+long stress_map(OpSource& src, const Options& o) {
+  MapType           m;
+  std::map<int,int> model;
+  OpLog             log;
+  long              op_number = 0;
+
+  for (; op_number < o.ops_per_round && !src.exhausted(); ++op_number) {
+    int op = choose_op(src,map_ops,o);
+    int k  = src.next(64);                  //a small key space gives both hits and misses
+    int v  = src.next(1000);
+    std::ostringstream entry;
+    entry << map_ops[op] << "(" << k << "," << v << ")";
+    log.add(entry.str());
+
+    switch (op) {
+      case 0: {
+        int got = m.put(k,v);
+        if (o.check) {
+          int expected = model.count(k) ? model[k] : v;
+          STRESS_EXPECT(got == expected, "put returned " << got << ", expected " << expected);
+          model[k] = v;
+        }
+        break;
+      }
+      case 1:
+        if (o.check && !model.count(k)) {
+          bool threw = false;
+          try {m.erase(k);} catch (ics::KeyError&) {threw = true;}
+          STRESS_EXPECT(threw, "erase of missing key did not throw KeyError");
+        }else if (o.check) {
+          int got = m.erase(k);
+          STRESS_EXPECT(got == model[k], "erase returned " << got << ", expected " << model[k]);
+          model.erase(k);
+        }else if (m.has_key(k))
+          m.erase(k);
+        break;
+      case 2:
+        if (o.check)
+          STRESS_EXPECT(m.has_key(k) == (model.count(k) == 1), "has_key(" << k << ") disagrees");
+        else
+          m.has_key(k);
+        break;
+      case 3:
+        if (o.check) {
+          bool expected = false;
+          for (const std::pair<const int,int>& kv : model)
+            expected = expected || kv.second == v;
+          STRESS_EXPECT(m.has_value(v) == expected, "has_value(" << v << ") disagrees");
+        }else
+          m.has_value(v);
+        break;
+      case 4: {
+        int got = (m[k] += 1);
+        if (o.check) {
+          model[k] += 1;
+          STRESS_EXPECT(got == model[k], "operator [] returned " << got << ", expected " << model[k]);
+        }
+        break;
+      }
+      case 5: {
+        const MapType& cm = m;
+        if (o.check && !model.count(k)) {
+          bool threw = false;
+          try {cm[k];} catch (ics::KeyError&) {threw = true;}
+          STRESS_EXPECT(threw, "const operator [] of missing key did not throw KeyError");
+        }else if (o.check)
+          STRESS_EXPECT(cm[k] == model[k], "const operator [] returned " << cm[k] << ", expected " << model[k]);
+        break;
+      }
+      case 6:
+        m.clear();
+        model.clear();
+        break;
+      case 7: {
+        std::map<int,int> seen;
+        for (const ics::pair<int,int>& kv : m)
+          seen[kv.first] = kv.second;
+        if (o.check)
+          STRESS_EXPECT(seen == model, "iteration did not produce exactly the map's entries");
+        break;
+      }
+      case 8: {
+        MapType copy(m);
+        if (o.check)
+          STRESS_EXPECT(copy == m && !(copy != m), "copy constructor result != original");
+        break;
+      }
+      case 9: {
+        MapType other;
+        other.put(k,v);
+        other = m;
+        if (o.check)
+          STRESS_EXPECT(other == m, "operator = result != original");
+        break;
+      }
+    }
+
+    if (o.check)
+      STRESS_EXPECT(m.size() == int(model.size()), "size() == " << m.size() << ", expected " << model.size());
+  }
+  return op_number;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//HashSet/RoaringSet vs std::set (same public interface, so one driver serves both)
+
+const std::vector<std::string> set_ops = {"insert","erase","contains","clear","iterate","insert_all","retain_all","relations","copy"};
+
+//Half the values are small (so operations often hit each other); the rest are anywhere in 4 of
+//  RoaringSet's 65536-value chunks, negative ones included
+int set_value(OpSource& src) {
+  if (src.next(2) == 0)
+    return src.next(64);
+  return (src.next(4)-2)*65536 + src.next(256)*256 + src.next(256);
+}
+
+const int long_run = 5000;   //insert_all this many consecutive values: more than a RoaringSet array container holds
+
+template<class SetType>
+long stress_set(OpSource& src, const Options& o) {
+  SetType       s;
+  std::set<int> model;
+  OpLog         log;
+  long          op_number = 0;
+
+  for (; op_number < o.ops_per_round && !src.exhausted(); ++op_number) {
+    int op = choose_op(src,set_ops,o);
+    int v  = set_value(src);
+    std::ostringstream entry;
+    entry << set_ops[op] << "(" << v << ")";
+    log.add(entry.str());
+
+    switch (op) {
+      case 0: {
+        int got = s.insert(v);
+        if (o.check) {
+          int expected = model.insert(v).second ? 1 : 0;
+          STRESS_EXPECT(got == expected, "insert returned " << got << ", expected " << expected);
+        }
+        break;
+      }
+      case 1: {
+        int got = s.erase(v);
+        if (o.check) {
+          int expected = model.erase(v);
+          STRESS_EXPECT(got == expected, "erase returned " << got << ", expected " << expected);
+        }
+        break;
+      }
+      case 2:
+        if (o.check)
+          STRESS_EXPECT(s.contains(v) == (model.count(v) == 1), "contains(" << v << ") disagrees");
+        else
+          s.contains(v);
+        break;
+      case 3:
+        s.clear();
+        model.clear();
+        break;
+      case 4: {
+        std::set<int> seen;
+        for (int x : s)
+          seen.insert(x);
+        if (o.check)
+          STRESS_EXPECT(seen == model, "iteration did not produce exactly the set's elements");
+        break;
+      }
+      case 5: {
+        int from = v, n = 3;
+        if (src.next(32) == 0) {                    //rarely (it is O(long_run)): a run that turns
+          from = v - (v & 0xFFFF);                  //  the array container of v's chunk into a bitmap
+          n    = long_run;
+        }
+        SetType other;
+        for (int x = from; x < from+n; ++x)
+          other.insert(x);
+        int got = s.insert_all(other);
+        if (o.check) {
+          int expected = 0;
+          for (int x = from; x < from+n; ++x)
+            expected += model.insert(x).second ? 1 : 0;
+          STRESS_EXPECT(got == expected, "insert_all returned " << got << ", expected " << expected);
+        }
+        break;
+      }
+      case 6: {
+        SetType keep({v, v/2, v/4, v/8});
+        s.retain_all(keep);
+        std::set<int> kept;
+        for (int x : model)
+          if (x == v || x == v/2 || x == v/4 || x == v/8)
+            kept.insert(x);
+        model.swap(kept);
+        break;
+      }
+      case 7: {
+        SetType copy(s);
+        if (o.check) {
+          STRESS_EXPECT(copy == s && copy <= s && copy >= s && !(copy < s) && !(copy > s), "relations with a copy");
+          copy.insert(1 << 30);                     //outside every set_value (and long_run)
+          STRESS_EXPECT(s < copy && s != copy && copy > s, "relations with a proper superset");
+        }
+        break;
+      }
+      case 8: {
+        SetType copy(s);
+        if (o.check)
+          STRESS_EXPECT(copy.size() == s.size() && copy.contains_all(s), "copy constructor result != original");
+        break;
+      }
+    }
+
+    if (o.check)
+      STRESS_EXPECT(s.size() == int(model.size()), "size() == " << s.size() << ", expected " << model.size());
+  }
+  return op_number;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Running rounds and reporting
+
+typedef long (*StressFunction)(OpSource& src, const Options& o);
+
+struct Target {
+  std::string                     name;
+  StressFunction                  run;
+  const std::vector<std::string>* ops;
+};
+
+const std::vector<Target> targets = {
+  {"queue",          stress_queue,                   &queue_ops},
+  {"priority_queue", stress_priority_queue,          &priority_queue_ops},
+  {"bst_map",        stress_map<BSTMapType>,         &map_ops},
+  {"hash_map",       stress_map<HashMapType>,        &map_ops},
+  {"flat_hash_map",  stress_map<FlatHashMapType>,    &map_ops},
+  {"hash_set",       stress_set<HashSetType>,        &set_ops},
+  {"roaring_set",    stress_set<RoaringSetType>,     &set_ops},
+};
+
+
+//Returns whether every round passed; a round reports its ops/sec either way
+bool run_rounds(const Target& t, const Options& o) {
+  OpSource src(o.seed);
+  for (int round=1; round<=o.rounds; ++round) {
+    live_allocations = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    long ops;
+    try {
+      ops = t.run(src,o);
+    } catch (StressFailure& f) {
+      std::cout << t.name << " FAILED in round " << round << " (seed " << o.seed << "): " << f.message;
+      return false;
+    } catch (ics::IcsError& e) {
+      std::cout << t.name << " FAILED in round " << round << " (seed " << o.seed << "): unexpected " << e.what() << std::endl;
+      return false;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+    std::cout << t.name << " round " << round << ": " << ops << " ops in " << seconds << "s = "
+              << long(ops/(seconds > 0 ? seconds : 1e-9)) << " ops/sec" << (o.check ? " (checked)" : " (bench)") << std::endl;
+    if (live_allocations != 0) {
+      std::cout << t.name << " FAILED in round " << round << " (seed " << o.seed << "): "
+                << live_allocations << " allocations leaked after destruction" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+
+#ifdef ICS_LIBFUZZER
+
+extern "C" int LLVMFuzzerTestOneInput(const std::uint8_t* data, std::size_t size) {
+  if (size < 2)
+    return 0;
+  const Target& t = targets[data[0] % targets.size()];
+  Options o;
+  o.ops_per_round = 1 << 20;             //bounded by the input size instead
+  OpSource src(data+1,size-1);
+  live_allocations = 0;
+  try {
+    t.run(src,o);
+  } catch (StressFailure& f) {
+    std::cerr << t.name << ": " << f.message;
+    std::abort();
+  } catch (ics::IcsError& e) {
+    std::cerr << t.name << ": unexpected " << e.what() << std::endl;
+    std::abort();
+  }
+  if (live_allocations != 0) {
+    std::cerr << t.name << ": " << live_allocations << " allocations leaked" << std::endl;
+    std::abort();
+  }
+  return 0;
+}
+
+#else
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cout << "usage: " << argv[0] << " queue|priority_queue|bst_map|hash_map|flat_hash_map|hash_set|roaring_set|all"
+              << " [ops_per_round [rounds [seed [check|bench [op,op,...]]]]]" << std::endl;
+    return 2;
+  }
+
+  std::string which = argv[1];
+  Options o;
+  o.seed = std::chrono::steady_clock::now().time_since_epoch().count();
+  if (argc > 2) o.ops_per_round = std::atoi(argv[2]);
+  if (argc > 3) o.rounds        = std::atoi(argv[3]);
+  if (argc > 4) o.seed          = std::strtoul(argv[4],nullptr,10);
+  if (argc > 5) o.check         = std::string(argv[5]) != "bench";
+  if (argc > 6) {
+    std::istringstream ops(argv[6]);
+    for (std::string op; std::getline(ops,op,',');)
+      o.only.insert(op);
+  }
+
+  bool ok = true, found = false;
+  for (const Target& t : targets)
+    if (which == "all" || which == t.name) {
+      found = true;
+      for (const std::string& op : o.only)
+        if (std::find(t.ops->begin(),t.ops->end(),op) == t.ops->end()) {
+          std::cout << t.name << ": unknown operation \"" << op << "\"" << std::endl;
+          return 2;
+        }
+      ok = run_rounds(t,o) && ok;
+    }
+
+  if (!found) {
+    std::cout << "unknown container \"" << which << "\"" << std::endl;
+    return 2;
+  }
+  return ok ? 0 : 1;
+}
+
+#endif
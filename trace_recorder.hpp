@@ -0,0 +1,416 @@
+#ifndef TRACE_RECORDER_HPP_
+#define TRACE_RECORDER_HPP_
+
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include <initializer_list>
+#include <atomic>
+#include "ics_exceptions.hpp"
+#include "command_trace.hpp"
+
+
+namespace ics {
+
+//Recording container operations so a production workload can be replayed against any backend.
+//
+//TraceRecorder keeps the most recent operations in a fixed-size in-memory ring of bytes (the
+//  oldest records are dropped when it fills), so recording costs a few stores per operation and
+//  never does I/O; flush() (also called by the destructor) writes the ring to a file.
+//Each operation is recorded as a Command (see command_trace.hpp) using the drivers' command
+//  letters, plus a timestamp: so a recording can also be converted to a script for the drivers'
+//  batch mode (write_command_trace(out,read_recording(file).commands)).
+//  Like command_trace.hpp, it lives in the repository root, for every project's containers.
+//
+//  queues/priority queues: e;v (enqueue)  d (dequeue)  p (peek)      x (clear)  s (size)  m (empty)
+//  maps:                   p;k;v (put)    e;k (erase)  g;k ([])      k;k (has_key)  v;v (has_value)  x  s  m
+//  sets:                   i;v (insert)   e;v (erase)  c;v (contains)  x  s  m
+//
+//Recording file: "ICSR", a version byte (1), then each record as
+//  varint length of the rest, varint nanoseconds since the recorder started, u8 name length, name,
+//  varint argument count, and for each argument a varint length and its bytes.
+//  (varint: 7 bits per byte, low bits first, high bit set on all but the last byte)
+class TraceRecorder {
+  public:
+    explicit TraceRecorder(const std::string& file_name, std::size_t capacity_bytes = 1 << 24);
+    ~TraceRecorder();
+
+    void record(const std::string& name, std::initializer_list<std::string> args = {});
+    void flush ();                          //(Re)write file_name with the ring's records, oldest first
+
+    long recorded () const {return recorded_count;}
+    long dropped  () const {return dropped_count;}   //Records overwritten because the ring was full
+    long oversized() const {return oversized_count;} //Records not kept: larger than the whole ring
+
+  private:
+    std::string                           file_name;
+    std::vector<char>                     ring;
+    std::size_t                           start = 0;    //Index of the oldest record's first byte
+    std::size_t                           used  = 0;    //Bytes of records in ring
+    long                                  recorded_count = 0;
+    long                                  dropped_count  = 0;
+    long                                  oversized_count = 0;
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    std::string                           scratch;      //Reused to build each record
+
+    void drop_oldest();
+};
+
+
+//A recording read back: commands[i] was issued nanos[i] nanoseconds after recording began
+struct Recording {
+  CommandScript              commands;
+  std::vector<std::uint64_t> nanos;
+};
+
+Recording read_recording(const std::string& file_name);
+
+
+//Recording wrappers: each holds the container (constructed from any extra constructor
+//  arguments) and forwards the recorded operations to it; everything else is reached through
+//  container(). A nullptr recorder records nothing, so recording can be switched off at run time.
+template<class Queue> class RecordingQueue;   //LinkedQueue, HeapPriorityQueue
+template<class Map>   class RecordingMap;     //HashMap, BSTMap
+template<class Set>   class RecordingSet;     //HashSet
+
+
+//Replay a recording's commands against a backend (any container with the ics interface),
+//  timing each command as the drivers' batch mode does
+template<class Queue> CommandLatency replay_queue(const CommandScript& script, Queue& q);
+template<class Map>   CommandLatency replay_map  (const CommandScript& script, Map&   m);
+template<class Set>   CommandLatency replay_set  (const CommandScript& script, Set&   s);
+
+
+//Values are recorded as text (via <<) and read back with >> (std::string values as-is)
+inline std::string trace_string(const std::string& v) {return v;}
+inline std::string trace_string(int v)                {return std::to_string(v);}
+template<class T> std::string trace_string(const T& v) {std::ostringstream answer; answer << v; return answer.str();}
+
+template<class T> T trace_value(const std::string& s, T* = nullptr) {
+  T answer;
+  std::istringstream in(s);
+  in >> answer;
+  return answer;
+}
+inline std::string trace_value(const std::string& s, std::string*) {return s;}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//TraceRecorder and read_recording
+
+namespace recording_detail {
+  inline void put_varint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+      out.push_back(char((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    out.push_back(char(value));
+  }
+
+  template<class Byte>      //Byte(i) returns the byte at offset i; i is advanced past the varint
+  std::uint64_t get_varint(Byte byte, std::size_t& i) {
+    std::uint64_t answer = 0;
+    for (int shift = 0; ; shift += 7) {
+      unsigned char b = byte(i++);
+      answer |= std::uint64_t(b & 0x7f) << shift;
+      if ((b & 0x80) == 0 || shift > 63)
+        return answer;
+    }
+  }
+}
+
+
+inline TraceRecorder::TraceRecorder(const std::string& file_name, std::size_t capacity_bytes)
+: file_name(file_name), ring(capacity_bytes < 64 ? 64 : capacity_bytes)
+{}
+
+
+inline TraceRecorder::~TraceRecorder() {
+  try {
+    flush();
+  } catch (...) {}            //Never throw from a destructor: a lost trace is better than terminate
+}
+
+
+inline void TraceRecorder::drop_oldest() {
+  std::size_t i = start;
+  std::size_t length = recording_detail::get_varint([this] (std::size_t i) {return ring[i % ring.size()];}, i);
+  std::size_t record_bytes = (i - start) + length;
+  start = (start + record_bytes) % ring.size();
+  used -= record_bytes;
+  ++dropped_count;
+}
+
+
+inline void TraceRecorder::record(const std::string& name, std::initializer_list<std::string> args) {
+  using namespace recording_detail;
+  std::uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-epoch).count();
+
+  std::string body;
+  body.swap(scratch);         //Reuse scratch's capacity: no allocation once it has grown
+  body.clear();
+  put_varint(body,ns);
+  body.push_back(char(name.size()));
+  body.append(name);
+  put_varint(body,args.size());
+  for (const std::string& a : args) {
+    put_varint(body,a.size());
+    body.append(a);
+  }
+  std::string length;
+  put_varint(length,body.size());
+
+  //Never throw from inside the recorded operation: a record that could not fit even in an
+  //  empty ring is counted and skipped (the older records are kept)
+  std::size_t record_bytes = length.size() + body.size();
+  if (record_bytes > ring.size()) {
+    ++oversized_count;
+    body.swap(scratch);
+    return;
+  }
+  while (ring.size() - used < record_bytes)
+    drop_oldest();
+
+  std::size_t end = (start + used) % ring.size();
+  for (const std::string* part : {&length, &body})
+    for (char c : *part) {
+      ring[end] = c;
+      end = (end + 1 == ring.size() ? 0 : end + 1);
+    }
+  used += record_bytes;
+  ++recorded_count;
+  body.swap(scratch);
+}
+
+
+inline void TraceRecorder::flush() {
+  std::ofstream out(file_name.c_str(), std::ios::binary | std::ios::trunc);
+  if (out.fail())
+    throw FileOpenError(file_name);
+  out.write("ICSR\1",5);
+  std::size_t first = std::min(used, ring.size()-start);    //The ring's bytes may wrap around its end
+  out.write(&ring[start], first);
+  out.write(&ring[0], used-first);
+}
+
+
+inline Recording read_recording(const std::string& file_name) {
+  using namespace recording_detail;
+  std::ifstream in(file_name.c_str(), std::ios::binary);
+  if (in.fail())
+    throw FileOpenError(file_name);
+  std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  if (contents.compare(0,5,std::string("ICSR\1",5)) != 0)
+    throw IcsError("read_recording: "+file_name+" is not a version 1 recording");
+
+  Recording answer;
+  std::size_t i = 5;
+  auto byte = [&contents,&file_name] (std::size_t i) -> char {
+    if (i >= contents.size())
+      throw IcsError("read_recording: "+file_name+" is truncated");
+    return contents[i];
+  };
+  auto bytes = [&contents,&file_name] (std::size_t& i, std::size_t n) -> std::string {
+    if (i+n > contents.size())
+      throw IcsError("read_recording: "+file_name+" is truncated");
+    i += n;
+    return contents.substr(i-n,n);
+  };
+
+  while (i < contents.size()) {
+    get_varint(byte,i);                 //Record length: only needed to skip records in the ring
+    answer.nanos.push_back(get_varint(byte,i));
+    Command c;
+    c.name = bytes(i,(unsigned char)byte(i++));
+    for (std::uint64_t argc = get_varint(byte,i); argc > 0; --argc) {
+      std::size_t length = get_varint(byte,i);
+      c.args.push_back(bytes(i,length));
+    }
+    answer.commands.push_back(c);
+  }
+  return answer;
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Recording wrappers
+
+template<class Queue> class RecordingQueue {
+  public:
+    typedef typename std::decay<decltype(std::declval<Queue&>().peek())>::type T;
+
+    template<class... Args>
+    explicit RecordingQueue(TraceRecorder* recorder, Args&&... args)
+    : recorder(recorder), q(std::forward<Args>(args)...) {}
+
+    bool empty   () const            {record("m");                   return q.empty();}
+    int  size    () const            {record("s");                   return q.size();}
+    T&   peek    () const            {record("p");                   return q.peek();}
+    int  enqueue (const T& element)  {record("e",{trace_string(element)}); return q.enqueue(element);}
+    T    dequeue ()                  {record("d");                   return q.dequeue();}
+    void clear   ()                  {record("x");                   q.clear();}
+
+    Queue&       container()       {return q;}
+    const Queue& container() const {return q;}
+
+  private:
+    TraceRecorder* recorder;
+    Queue          q;
+
+    void record(const char* name, std::initializer_list<std::string> args = {}) const {
+      if (recorder != nullptr)
+        recorder->record(name,args);
+    }
+};
+
+
+template<class Map> class RecordingMap {
+  public:
+    typedef typename std::decay<decltype(std::declval<typename Map::Entry&>().first)>::type  KEY;
+    typedef typename std::decay<decltype(std::declval<typename Map::Entry&>().second)>::type T;
+
+    template<class... Args>
+    explicit RecordingMap(TraceRecorder* recorder, Args&&... args)
+    : recorder(recorder), m(std::forward<Args>(args)...) {}
+
+    bool empty     () const                         {record("m");                                 return m.empty();}
+    int  size      () const                         {record("s");                                 return m.size();}
+    bool has_key   (const KEY& key) const           {record("k",{trace_string(key)});             return m.has_key(key);}
+    bool has_value (const T& value) const           {record("v",{trace_string(value)});           return m.has_value(value);}
+    T    put       (const KEY& key, const T& value) {record("p",{trace_string(key),trace_string(value)}); return m.put(key,value);}
+    T    erase     (const KEY& key)                 {record("e",{trace_string(key)});             return m.erase(key);}
+    void clear     ()                               {record("x");                                 m.clear();}
+    T&   operator [] (const KEY& key)               {record("g",{trace_string(key)});             return m[key];}
+
+    Map&       container()       {return m;}
+    const Map& container() const {return m;}
+
+  private:
+    TraceRecorder* recorder;
+    Map            m;
+
+    void record(const char* name, std::initializer_list<std::string> args = {}) const {
+      if (recorder != nullptr)
+        recorder->record(name,args);
+    }
+};
+
+
+template<class Set> class RecordingSet {
+  public:
+    typedef typename std::decay<decltype(*std::declval<Set&>().begin())>::type T;
+
+    template<class... Args>
+    explicit RecordingSet(TraceRecorder* recorder, Args&&... args)
+    : recorder(recorder), s(std::forward<Args>(args)...) {}
+
+    bool empty    () const            {record("m");                   return s.empty();}
+    int  size     () const            {record("s");                   return s.size();}
+    bool contains (const T& element) const {record("c",{trace_string(element)}); return s.contains(element);}
+    int  insert   (const T& element)  {record("i",{trace_string(element)}); return s.insert(element);}
+    int  erase    (const T& element)  {record("e",{trace_string(element)}); return s.erase(element);}
+    void clear    ()                  {record("x");                   s.clear();}
+
+    Set&       container()       {return s;}
+    const Set& container() const {return s;}
+
+  private:
+    TraceRecorder* recorder;
+    Set            s;
+
+    void record(const char* name, std::initializer_list<std::string> args = {}) const {
+      if (recorder != nullptr)
+        recorder->record(name,args);
+    }
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Replayers: results are folded into a checksum so the timed calls cannot be optimized away
+
+//Relaxed: the checksum's value never matters (only that the results go somewhere), and replayers
+//  may run on several threads at once
+namespace recording_detail {
+  inline void fold(std::size_t result) {
+    static std::atomic<std::size_t> sink(0);
+    sink.fetch_add(result, std::memory_order_relaxed);
+  }
+}
+
+
+template<class Queue>
+CommandLatency replay_queue(const CommandScript& script, Queue& q) {
+  typedef typename std::decay<decltype(q.peek())>::type T;
+  return run_commands(script, [&q] (const Command& c) {
+    using recording_detail::fold;
+    if      (c.name == "e") fold(q.enqueue(trace_value(command_arg(c,0),(T*)nullptr)));
+    else if (c.name == "d") {q.dequeue(); fold(1);}
+    else if (c.name == "p") {q.peek();    fold(1);}
+    else if (c.name == "x") q.clear();
+    else if (c.name == "s") fold(q.size());
+    else if (c.name == "m") fold(q.empty());
+    else
+      return false;
+    return true;
+  });
+}
+
+
+template<class Map>
+CommandLatency replay_map(const CommandScript& script, Map& m) {
+  typedef typename std::decay<decltype(std::declval<typename Map::Entry&>().first)>::type  KEY;
+  typedef typename std::decay<decltype(std::declval<typename Map::Entry&>().second)>::type T;
+  return run_commands(script, [&m] (const Command& c) {
+    using recording_detail::fold;
+    if      (c.name == "p") {m.put(trace_value(command_arg(c,0),(KEY*)nullptr), trace_value(command_arg(c,1),(T*)nullptr)); fold(1);}
+    else if (c.name == "e") {m.erase(trace_value(command_arg(c,0),(KEY*)nullptr)); fold(1);}
+    else if (c.name == "g") {m[trace_value(command_arg(c,0),(KEY*)nullptr)];       fold(1);}
+    else if (c.name == "k") fold(m.has_key  (trace_value(command_arg(c,0),(KEY*)nullptr)));
+    else if (c.name == "v") fold(m.has_value(trace_value(command_arg(c,0),(T*)nullptr)));
+    else if (c.name == "x") m.clear();
+    else if (c.name == "s") fold(m.size());
+    else if (c.name == "m") fold(m.empty());
+    else
+      return false;
+    return true;
+  });
+}
+
+
+template<class Set>
+CommandLatency replay_set(const CommandScript& script, Set& s) {
+  typedef typename std::decay<decltype(*s.begin())>::type T;
+  return run_commands(script, [&s] (const Command& c) {
+    using recording_detail::fold;
+    if      (c.name == "i") fold(s.insert  (trace_value(command_arg(c,0),(T*)nullptr)));
+    else if (c.name == "e") fold(s.erase   (trace_value(command_arg(c,0),(T*)nullptr)));
+    else if (c.name == "c") fold(s.contains(trace_value(command_arg(c,0),(T*)nullptr)));
+    else if (c.name == "x") s.clear();
+    else if (c.name == "s") fold(s.size());
+    else if (c.name == "m") fold(s.empty());
+    else
+      return false;
+    return true;
+  });
+}
+
+}
+
+#endif /* TRACE_RECORDER_HPP_ */
@@ -0,0 +1,264 @@
+#ifndef VALUE_INDEX_HPP_
+#define VALUE_INDEX_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <memory>             //For std::allocator/std::allocator_traits
+#include "ics_exceptions.hpp"
+
+
+namespace ics {
+
+
+//A map's reverse index: how many of its keys are associated with each value, so has_value is
+//  one hash probe (not a scan of every entry). HashMap (program4) and BSTMap (program3) keep one
+//  when asked to (see their index_values), updating it in put/erase/operator []; this one copy
+//  serves both, so each project's include path must reach this directory.
+//The index is hashed with vhash (the values' hash function: maps have none of their own) by
+//  open addressing with linear probing: one flat array of (value,count) slots, of which at most
+//  load_threshold are used (more slots: shorter probes, more memory; see bytes).
+//A T& from a map's operator [] may be written at any later time, without the map seeing it, so
+//  a map stops indexing its values once it has handed one out (see HashMap/BSTMap): the index
+//  only ever changes through add/remove/clear, and its queries write nothing (so a const map
+//  may be queried by several threads at once).
+//Alloc is any std::allocator-compatible allocator (rebound to allocate the slots).
+template<class T, class Alloc = std::allocator<T>> class ValueIndex {
+  public:
+    //Destructor/Constructors
+    ~ValueIndex ();
+    explicit ValueIndex (int (*vhash)(const T& v), double the_load_threshold = 0.5, const Alloc& alloc = Alloc());
+    ValueIndex (const ValueIndex<T,Alloc>& to_copy) = delete;
+    ValueIndex<T,Alloc>& operator = (const ValueIndex<T,Alloc>& rhs) = delete;
+
+
+    //Queries
+    bool contains (const T& v) const;
+    int  count    (const T& v) const;   //Number of keys associated with v
+    int  distinct () const;             //Number of different values indexed
+    int  bytes    () const;             //Memory used (this object and its slots)
+    std::string str () const; //supplies useful debugging information
+
+
+    //Commands
+    void add    (const T& v);           //One more key is associated with v
+    void remove (const T& v);           //One fewer (v must have been added)
+    void clear  ();
+
+
+  private:
+    class Slot {
+      public:
+        Slot () : value(), count(0) {}
+
+        T   value;
+        int count;                      //0: the slot is empty
+    };
+
+  typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Slot> SlotAlloc;
+  typedef std::allocator_traits<SlotAlloc>                                   SlotTraits;
+
+  int (*hash)(const T& v);
+  SlotAlloc slot_alloc;
+  double load_threshold;
+  Slot*  slots     = nullptr;
+  int    capacity  = 0;                 //A power of 2
+  int    shift     = 32;                //32 - log2(capacity): keeps the top bits of the mixed hash
+  int    used      = 0;                 //Slots with count > 0
+
+  //Helper methods
+  int   slot_of   (const T& v) const;   //v's slot if indexed; otherwise -1
+  int   home      (const T& v) const;   //The slot where v's probe starts
+  void  grow      ();                   //Double capacity (or allocate the first slots), reinserting every value
+  Slot* new_slots (int n);
+  void  delete_slots(Slot* s, int n);
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//ValueIndex class and related definitions
+
+//Destructor/Constructors
+
+template<class T, class Alloc>
+ValueIndex<T,Alloc>::~ValueIndex() {
+  delete_slots(slots, capacity);
+}
+
+
+template<class T, class Alloc>
+ValueIndex<T,Alloc>::ValueIndex(int (*vhash)(const T& v), double the_load_threshold, const Alloc& alloc)
+: hash(vhash), slot_alloc(alloc), load_threshold(the_load_threshold) {
+  if (hash == nullptr)
+    throw TemplateFunctionError("ValueIndex::constructor: vhash not specified");
+  if (load_threshold <= 0.0 || load_threshold >= 1.0)
+    throw IcsError("ValueIndex::constructor: load_threshold must be in (0,1)");
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T, class Alloc>
+bool ValueIndex<T,Alloc>::contains (const T& v) const {
+  return count(v) > 0;
+}
+
+
+template<class T, class Alloc>
+int ValueIndex<T,Alloc>::count (const T& v) const {
+  int s = slot_of(v);
+  return s == -1 ? 0 : slots[s].count;
+}
+
+
+template<class T, class Alloc>
+int ValueIndex<T,Alloc>::distinct () const {
+  return used;
+}
+
+
+template<class T, class Alloc>
+int ValueIndex<T,Alloc>::bytes () const {
+  return sizeof(ValueIndex<T,Alloc>) + capacity*sizeof(Slot);
+}
+
+
+template<class T, class Alloc>
+std::string ValueIndex<T,Alloc>::str() const {
+  std::ostringstream answer;
+  answer << "ValueIndex[";
+  for (int s = 0; s < capacity; ++s)
+    if (slots[s].count > 0)
+      answer << " " << s << ":" << slots[s].value << "*" << slots[s].count;
+  answer << "](distinct=" << used << ",capacity=" << capacity << ",bytes=" << bytes() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T, class Alloc>
+void ValueIndex<T,Alloc>::add (const T& v) {
+  int s = slot_of(v);
+  if (s != -1) {
+    ++slots[s].count;
+    return;
+  }
+  if (used+1 > capacity*load_threshold)
+    grow();
+  for (s = home(v); slots[s].count != 0; s = (s+1) & (capacity-1))
+    ;
+  slots[s].value = v;
+  slots[s].count = 1;
+  ++used;
+}
+
+
+//When v's last key goes, its slot is emptied by shifting later values of its probe run back
+//  (no tombstones, so probes never lengthen as values come and go)
+template<class T, class Alloc>
+void ValueIndex<T,Alloc>::remove (const T& v) {
+  int s = slot_of(v);
+  if (s == -1 || --slots[s].count > 0)
+    return;
+  --used;
+  for (int next = (s+1) & (capacity-1); slots[next].count != 0; next = (next+1) & (capacity-1)) {
+    int h = home(slots[next].value);
+    //Move next back into the hole unless its home is (cyclically) after the hole, up to next
+    if (((next - h) & (capacity-1)) >= ((next - s) & (capacity-1))) {
+      slots[s] = slots[next];
+      slots[next].count = 0;
+      s = next;
+    }
+  }
+  slots[s].value = T();
+  slots[s].count = 0;
+}
+
+
+template<class T, class Alloc>
+void ValueIndex<T,Alloc>::clear () {
+  for (int s = 0; s < capacity; ++s)
+    slots[s] = Slot();
+  used = 0;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T, class Alloc>
+int ValueIndex<T,Alloc>::slot_of (const T& v) const {
+  if (used == 0)
+    return -1;
+  for (int s = home(v); slots[s].count != 0; s = (s+1) & (capacity-1))
+    if (slots[s].value == v)
+      return s;
+  return -1;
+}
+
+
+//Fibonacci hashing: spreads even poor hash values (e.g., i for int i) over the slots
+template<class T, class Alloc>
+int ValueIndex<T,Alloc>::home (const T& v) const {
+  return int((unsigned(hash(v)) * 2654435769u) >> shift);
+}
+
+
+template<class T, class Alloc>
+void ValueIndex<T,Alloc>::grow () {
+  Slot* old_slots    = slots;
+  int   old_capacity = capacity;
+  capacity = capacity == 0 ? 16 : 2*capacity;
+  --shift;
+  if (old_capacity == 0)
+    shift = 28;
+  slots = new_slots(capacity);
+  for (int o = 0; o < old_capacity; ++o)
+    if (old_slots[o].count != 0) {
+      int s = home(old_slots[o].value);
+      while (slots[s].count != 0)
+        s = (s+1) & (capacity-1);
+      slots[s] = old_slots[o];
+    }
+  delete_slots(old_slots, old_capacity);
+}
+
+
+template<class T, class Alloc>
+auto ValueIndex<T,Alloc>::new_slots (int n) -> Slot* {
+  Slot* s = SlotTraits::allocate(slot_alloc, n);
+  int constructed = 0;
+  try {
+    for (; constructed < n; ++constructed)
+      SlotTraits::construct(slot_alloc, s+constructed);
+  } catch (...) {
+    while (constructed > 0)
+      SlotTraits::destroy(slot_alloc, s + --constructed);
+    SlotTraits::deallocate(slot_alloc, s, n);
+    throw;
+  }
+  return s;
+}
+
+
+template<class T, class Alloc>
+void ValueIndex<T,Alloc>::delete_slots (Slot* s, int n) {
+  if (s == nullptr)
+    return;
+  for (int i = 0; i < n; ++i)
+    SlotTraits::destroy(slot_alloc, s+i);
+  SlotTraits::deallocate(slot_alloc, s, n);
+}
+
+}
+
+#endif /* VALUE_INDEX_HPP_ */
@@ -0,0 +1,204 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+#ifndef WORK_STEALING_DEQUE_HPP_
+#define WORK_STEALING_DEQUE_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+
+namespace ics {
+
+
+//Chase-Lev work-stealing deque (Chase & Lev, SPAA 2005; memory orders from Le, Pop, Cohen &
+//  Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models", PPoPP 2013).
+//One owner thread pushes and pops at the bottom (LIFO: keeps its recent, cache-hot work);
+//  any number of thief threads steal from the top (FIFO: the oldest, usually largest, tasks).
+//  Only the owner may call push_bottom/pop_bottom; steal/size/empty may be called by any thread.
+//The circular array doubles when full; the arrays it outgrows are kept until the deque is
+//  destroyed, since a thief may still be reading one (so no hazard pointers/epochs are needed).
+//T is stored in std::atomic slots, so it must be trivially copyable (e.g., a Task*).
+template<class T> class WorkStealingDeque {
+  public:
+    //Destructor/Constructors
+    ~WorkStealingDeque();
+    explicit WorkStealingDeque(int initial_length = 64);   //Rounded up to a power of 2
+    WorkStealingDeque(const WorkStealingDeque<T>& to_copy)                 = delete;
+    WorkStealingDeque<T>& operator = (const WorkStealingDeque<T>& rhs)     = delete;
+
+
+    //Queries (a snapshot: other threads may change the deque at any time)
+    bool empty () const;
+    int  size  () const;
+    std::string str () const; //supplies useful debugging information
+
+
+    //Commands
+    void push_bottom (const T& element);   //Owner only
+    bool pop_bottom  (T& element);         //Owner only: false if empty
+    bool steal       (T& element);         //Any thread: false if empty or it lost a race for the top
+
+
+  private:
+    class Array {
+      public:
+        Array (int length) : mask(length-1), slots(new std::atomic<T>[length]) {}
+        ~Array()                                {delete[] slots;}
+
+        int  length ()                   const  {return mask+1;}
+        T    get    (std::int64_t i)     const  {return slots[i & mask].load(std::memory_order_relaxed);}
+        void put    (std::int64_t i, T v)       {slots[i & mask].store(v, std::memory_order_relaxed);}
+
+      private:
+        int             mask;          //length-1 (length is a power of 2)
+        std::atomic<T>* slots;
+    };
+
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque<T>: T must be trivially copyable");
+
+    //top/bottom are on different cache lines: thieves hammer top, the owner hammers bottom
+    //  (padding rather than alignas, since C++11 new ignores over-alignment)
+    std::atomic<std::int64_t> top;
+    char                      top_pad[64];
+    std::atomic<std::int64_t> bottom;
+    char                      bottom_pad[64];
+    std::atomic<Array*>       array;
+    std::vector<Array*>       retired;    //Outgrown arrays (owner only)
+
+    //Helper methods
+    Array* grow (Array* a, std::int64_t b, std::int64_t t);
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//WorkStealingDeque class and related definitions
+
+//Destructor/Constructors
+
+template<class T>
+WorkStealingDeque<T>::~WorkStealingDeque() {
+  delete array.load(std::memory_order_relaxed);
+  for (Array* a : retired)
+    delete a;
+}
+
+
+template<class T>
+WorkStealingDeque<T>::WorkStealingDeque(int initial_length)
+: top(0), bottom(0)
+{
+  int length = 2;
+  while (length < initial_length)
+    length *= 2;
+  array.store(new Array(length), std::memory_order_relaxed);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+template<class T>
+bool WorkStealingDeque<T>::empty() const {
+  return size() == 0;
+}
+
+
+template<class T>
+int WorkStealingDeque<T>::size() const {
+  std::int64_t b = bottom.load(std::memory_order_relaxed);
+  std::int64_t t = top.load(std::memory_order_relaxed);
+  return b > t ? int(b - t) : 0;
+}
+
+
+template<class T>
+std::string WorkStealingDeque<T>::str() const {
+  std::ostringstream answer;
+  answer << "WorkStealingDeque(top=" << top.load() << ",bottom=" << bottom.load()
+         << ",length=" << array.load()->length() << ",retired=" << retired.size() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+template<class T>
+void WorkStealingDeque<T>::push_bottom(const T& element) {
+  std::int64_t b = bottom.load(std::memory_order_relaxed);
+  std::int64_t t = top.load(std::memory_order_acquire);
+  Array* a = array.load(std::memory_order_relaxed);
+  if (b - t > a->length() - 1)
+    a = grow(a, b, t);
+  a->put(b, element);
+  std::atomic_thread_fence(std::memory_order_release);    //element is visible before the new bottom
+  bottom.store(b+1, std::memory_order_relaxed);
+}
+
+
+template<class T>
+bool WorkStealingDeque<T>::pop_bottom(T& element) {
+  std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+  Array* a = array.load(std::memory_order_relaxed);
+  bottom.store(b, std::memory_order_relaxed);             //Reserve the bottom element...
+  std::atomic_thread_fence(std::memory_order_seq_cst);    //...before looking at what thieves did
+  std::int64_t t = top.load(std::memory_order_relaxed);
+
+  if (t > b) {                                            //Was empty: undo the reservation
+    bottom.store(b+1, std::memory_order_relaxed);
+    return false;
+  }
+
+  element = a->get(b);
+  if (t < b)                                              //2+ elements: no thief can reach b
+    return true;
+
+  //Exactly one element: race the thieves for it by advancing top
+  bool won = top.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed);
+  bottom.store(b+1, std::memory_order_relaxed);
+  return won;
+}
+
+
+template<class T>
+bool WorkStealingDeque<T>::steal(T& element) {
+  std::int64_t t = top.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  std::int64_t b = bottom.load(std::memory_order_acquire);
+  if (t >= b)
+    return false;
+
+  Array* a = array.load(std::memory_order_acquire);      //(consume in the paper)
+  element = a->get(t);
+  return top.compare_exchange_strong(t, t+1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+template<class T>
+auto WorkStealingDeque<T>::grow(Array* a, std::int64_t b, std::int64_t t) -> Array* {
+  Array* bigger = new Array(2*a->length());
+  for (std::int64_t i = t; i < b; ++i)
+    bigger->put(i, a->get(i));
+  retired.push_back(a);                                   //A thief may still be reading a
+  array.store(bigger, std::memory_order_release);
+  return bigger;
+}
+
+}
+
+#endif /* WORK_STEALING_DEQUE_HPP_ */
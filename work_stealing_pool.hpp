@@ -0,0 +1,360 @@
+//Robert Wong (547710)
+//Kenneth Dy (419078)
+
+#ifndef WORK_STEALING_POOL_HPP_
+#define WORK_STEALING_POOL_HPP_
+
+#include <string>
+#include <iostream>
+#include <sstream>
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <chrono>
+#include <cstdint>
+#include "linked_queue.hpp"
+#include "work_stealing_deque.hpp"
+
+
+namespace ics {
+
+
+//A fixed set of worker threads, each owning a WorkStealingDeque of tasks.
+//A task submitted by a worker goes on the bottom of that worker's own deque (no lock, no
+//  sharing); a task submitted by any other thread goes on a small mutex-protected LinkedQueue
+//  (the "injection" queue). An idle worker pops its own deque, then the injection queue, then
+//  steals from the top of other workers' deques, starting at a random victim each time.
+//Workers that find nothing spin (yielding) briefly, then sleep until a submit wakes them.
+//Tasks should not throw: run them through a TaskGroup to carry exceptions back to wait().
+class WorkStealingPool {
+  public:
+    typedef std::function<void()> Task;
+
+    //Destructor/Constructors
+    ~WorkStealingPool();        //Runs all submitted tasks, then joins the workers
+    explicit WorkStealingPool(int threads = std::thread::hardware_concurrency());
+    WorkStealingPool(const WorkStealingPool& to_copy)              = delete;
+    WorkStealingPool& operator = (const WorkStealingPool& rhs)     = delete;
+
+
+    //Queries
+    int  size              () const;    //Number of worker threads
+    int  current_worker    () const;    //This thread's worker index, or -1 if not one of this pool's workers
+    long long steals       () const;    //Successful steals so far (for benchmarks)
+    std::string str        () const;    //supplies useful debugging information
+
+
+    //Commands
+    void submit   (const Task& task);
+    bool run_one  ();                   //Run one pending task on this thread (help while waiting); false if none found
+
+
+  private:
+    struct Worker {
+      WorkStealingDeque<Task*> deque;
+      std::uint64_t            seed;    //xorshift state for choosing victims (owner only)
+    };
+
+    std::vector<Worker*>      workers;
+    std::vector<std::thread>  threads;
+    std::mutex                injected_lock;
+    LinkedQueue<Task*>        injected;         //Submissions from non-worker threads
+    std::atomic<int>          injected_count;   //injected.size(), readable without the lock
+    std::atomic<int>          pending;          //Submitted but not yet started (for sleeping)
+    std::atomic<long long>    steal_count;
+    std::atomic<bool>         stopping;
+    std::mutex                sleep_lock;
+    std::condition_variable   wake;
+    int                       sleepers = 0;     //Protected by sleep_lock
+
+    //Helper methods
+    static const WorkStealingPool*& current_pool ();
+    static int&                     current_index();
+    Task* find_task    (int self);
+    Task* pop_injected ();
+    Task* steal_task   (int self);
+    void  run          (Task* task);
+    void  worker_loop  (int self);
+};
+
+
+//Runs a set of related tasks on a pool and waits for all of them (fork-join).
+//wait() does not block the calling thread: it runs pending tasks (its own children first,
+//  when called from a worker) until every task in the group has finished, so recursive
+//  fork-join on a pool with N workers never deadlocks. The first exception thrown by a task
+//  is rethrown by wait(); the destructor waits (but swallows exceptions).
+//Pool may be any type with submit(std::function<void()>) and bool run_one().
+template<class Pool = WorkStealingPool> class TaskGroup {
+  public:
+    ~TaskGroup();
+    explicit TaskGroup(Pool& pool);
+    TaskGroup(const TaskGroup& to_copy)               = delete;
+    TaskGroup& operator = (const TaskGroup& rhs)      = delete;
+
+    template<class Function>
+    void run  (Function f);
+    void wait ();
+
+  private:
+    Pool&               pool;
+    std::atomic<int>    outstanding;
+    std::mutex          error_lock;
+    std::exception_ptr  error;
+};
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//WorkStealingPool class and related definitions
+
+//Destructor/Constructors
+
+inline WorkStealingPool::~WorkStealingPool() {
+  stopping.store(true);
+  {
+    std::lock_guard<std::mutex> guard(sleep_lock);
+    wake.notify_all();
+  }
+  for (std::thread& t : threads)
+    t.join();
+  for (Worker* w : workers)
+    delete w;
+}
+
+
+inline WorkStealingPool::WorkStealingPool(int threads_wanted)
+: injected_count(0), pending(0), steal_count(0), stopping(false)
+{
+  if (threads_wanted < 1)
+    threads_wanted = 1;
+  for (int i = 0; i < threads_wanted; ++i) {
+    workers.push_back(new Worker());
+    workers[i]->seed = 0x9E3779B97F4A7C15ull * (i+1);
+  }
+  for (int i = 0; i < threads_wanted; ++i)
+    threads.push_back(std::thread(&WorkStealingPool::worker_loop, this, i));
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Queries
+
+inline int WorkStealingPool::size() const {
+  return workers.size();
+}
+
+
+inline int WorkStealingPool::current_worker() const {
+  return current_pool() == this ? current_index() : -1;
+}
+
+
+inline long long WorkStealingPool::steals() const {
+  return steal_count.load();
+}
+
+
+inline std::string WorkStealingPool::str() const {
+  std::ostringstream answer;
+  answer << "WorkStealingPool[";
+  for (int i = 0; i < size(); ++i)
+    answer << (i == 0 ? "" : ",") << workers[i]->deque.size();
+  answer << "](injected=" << injected_count.load() << ",pending=" << pending.load()
+         << ",steals=" << steal_count.load() << ")";
+  return answer.str();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Commands
+
+inline void WorkStealingPool::submit(const Task& task) {
+  Task* t = new Task(task);
+  pending.fetch_add(1);
+  int self = current_worker();
+  if (self != -1)
+    workers[self]->deque.push_bottom(t);
+  else {
+    std::lock_guard<std::mutex> guard(injected_lock);
+    injected.enqueue(t);
+    injected_count.fetch_add(1);
+  }
+
+  //Only take sleep_lock when someone may be asleep; a worker checks pending under
+  //  sleep_lock before waiting, so this notify cannot be lost
+  std::lock_guard<std::mutex> guard(sleep_lock);
+  if (sleepers > 0)
+    wake.notify_one();
+}
+
+
+inline bool WorkStealingPool::run_one() {
+  Task* t = find_task(current_worker());
+  if (t == nullptr)
+    return false;
+  run(t);
+  return true;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//Private helper methods
+
+inline const WorkStealingPool*& WorkStealingPool::current_pool() {
+  static thread_local const WorkStealingPool* pool = nullptr;
+  return pool;
+}
+
+
+inline int& WorkStealingPool::current_index() {
+  static thread_local int index = -1;
+  return index;
+}
+
+
+//self is -1 for a non-worker thread (helping in TaskGroup::wait): it can only take
+//  from the injection queue or steal
+inline auto WorkStealingPool::find_task(int self) -> Task* {
+  Task* t = nullptr;
+  if (self != -1 && workers[self]->deque.pop_bottom(t))
+    return t;
+  if ((t = pop_injected()) != nullptr)
+    return t;
+  return steal_task(self);
+}
+
+
+inline auto WorkStealingPool::pop_injected() -> Task* {
+  if (injected_count.load(std::memory_order_relaxed) == 0)
+    return nullptr;
+  std::lock_guard<std::mutex> guard(injected_lock);
+  if (injected.empty())
+    return nullptr;
+  injected_count.fetch_sub(1);
+  return injected.dequeue();
+}
+
+
+inline auto WorkStealingPool::steal_task(int self) -> Task* {
+  int n = size();
+  if (n == 1 && self == 0)
+    return nullptr;
+
+  //Randomized victim selection (Blumofe & Leiserson): start anywhere, try everyone once
+  std::uint64_t x = (self != -1 ? workers[self]->seed
+                                : std::hash<std::thread::id>()(std::this_thread::get_id()) | 1);
+  x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+  if (self != -1)
+    workers[self]->seed = x;
+
+  Task* t = nullptr;
+  int start = int(x % n);
+  for (int i = 0; i < n; ++i) {
+    int victim = (start + i) % n;
+    if (victim != self && workers[victim]->deque.steal(t)) {
+      steal_count.fetch_add(1, std::memory_order_relaxed);
+      return t;
+    }
+  }
+  return nullptr;
+}
+
+
+inline void WorkStealingPool::run(Task* task) {
+  pending.fetch_sub(1);
+  (*task)();
+  delete task;
+}
+
+
+inline void WorkStealingPool::worker_loop(int self) {
+  current_pool()  = this;
+  current_index() = self;
+  int idle = 0;
+  for (;;) {
+    Task* t = find_task(self);
+    if (t != nullptr) {
+      run(t);
+      idle = 0;
+      continue;
+    }
+    if (stopping.load() && pending.load() == 0)
+      return;
+    if (++idle < 64) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    //A steal can fail spuriously (lost race), so sleep with a timeout rather than forever
+    std::unique_lock<std::mutex> guard(sleep_lock);
+    ++sleepers;
+    wake.wait_for(guard, std::chrono::milliseconds(1),
+                  [this] () {return pending.load() > 0 || stopping.load();});
+    --sleepers;
+    idle = 0;
+  }
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//TaskGroup class and related definitions
+
+template<class Pool>
+TaskGroup<Pool>::~TaskGroup() {
+  try {
+    wait();
+  } catch (...) {}
+}
+
+
+template<class Pool>
+TaskGroup<Pool>::TaskGroup(Pool& pool)
+: pool(pool), outstanding(0)
+{}
+
+
+template<class Pool> template<class Function>
+void TaskGroup<Pool>::run(Function f) {
+  outstanding.fetch_add(1);
+  pool.submit([this,f] () {
+    try {
+      f();
+    } catch (...) {
+      std::lock_guard<std::mutex> guard(error_lock);
+      if (!error)
+        error = std::current_exception();
+    }
+    outstanding.fetch_sub(1, std::memory_order_release);
+  });
+}
+
+
+template<class Pool>
+void TaskGroup<Pool>::wait() {
+  while (outstanding.load(std::memory_order_acquire) > 0)
+    if (!pool.run_one())
+      std::this_thread::yield();
+
+  std::lock_guard<std::mutex> guard(error_lock);
+  if (error) {
+    std::exception_ptr e = error;
+    error = nullptr;
+    std::rethrow_exception(e);
+  }
+}
+
+}
+
+#endif /* WORK_STEALING_POOL_HPP_ */